@@ -25,8 +25,101 @@
 #pragma GCC optimize("O3")
 #endif
 
+/* writes back bytes that went through the bounce buffer, they start off
+ * bytes into chunk chp and may span several chunks */
+static_always_inline void
+aes_gcm_chained_copy_out (vnet_crypto_op_chunk_t *chp, u32 off, const u8 *buf,
+			  u32 n_bytes)
+{
+  while (n_bytes)
+    {
+      u32 n = clib_min (chp->len - off, n_bytes);
+      clib_memcpy_fast (chp->dst + off, buf, n);
+      buf += n;
+      n_bytes -= n;
+      off = 0;
+      chp++;
+    }
+}
+
+/* Chained buffers are not linearized, whole groups of 4 * N_AES_BYTES are
+ * processed in place in each chunk with the same kernels as flat buffers.
+ * Only a group spanning a chunk boundary, and the tail, is copied through
+ * a bounce buffer. */
+static_always_inline int
+aes_gcm_chained (vnet_crypto_op_t *op, vnet_crypto_op_chunk_t *chunks,
+		 const aes_gcm_key_data_t *kd, aes_key_size_t ks, u32 aad_len,
+		 u8 tag_len, aes_gcm_op_t gop)
+{
+  vnet_crypto_op_chunk_t *chp = chunks + op->chunk_index, *bchp = chp;
+  aes_gcm_ctx_t _ctx, *ctx = &_ctx;
+  u8 buf[4 * N_AES_BYTES];
+  aes_data_t d[4] = {};
+  u32 i, n, n_buf = 0, boff = 0, data_bytes = 0;
+
+  for (i = 0; i < op->n_chunks; i++)
+    data_bytes += chp[i].len;
+
+  aes_gcm_init (ctx, op->iv, data_bytes, aad_len, kd, AES_KEY_ROUNDS (ks),
+		gop);
+  aes_gcm_ghash (ctx, op->aad, aad_len);
+
+  for (i = 0; i < op->n_chunks; i++, chp++)
+    {
+      const u8 *src = chp->src;
+      u8 *dst = chp->dst;
+      u32 n_left = chp->len;
+
+      if (n_buf)
+	{
+	  n = clib_min (n_left, sizeof (buf) - n_buf);
+	  clib_memcpy_fast (buf + n_buf, src, n);
+	  n_buf += n;
+	  src += n;
+	  dst += n;
+	  n_left -= n;
+
+	  if (n_buf < sizeof (buf))
+	    continue;
+
+	  if (gop == AES_GCM_OP_ENCRYPT)
+	    aes_gcm_enc_update (ctx, d, buf, buf, sizeof (buf));
+	  else
+	    aes_gcm_dec_update (ctx, d, buf, buf, sizeof (buf));
+	  aes_gcm_chained_copy_out (bchp, boff, buf, sizeof (buf));
+	  n_buf = 0;
+	}
+
+      n = n_left & ~(sizeof (buf) - 1);
+      if (gop == AES_GCM_OP_ENCRYPT)
+	aes_gcm_enc_update (ctx, d, src, dst, n);
+      else
+	aes_gcm_dec_update (ctx, d, src, dst, n);
+      src += n;
+      dst += n;
+      n_left -= n;
+
+      if (n_left)
+	{
+	  clib_memcpy_fast (buf, src, n_left);
+	  n_buf = n_left;
+	  bchp = chp;
+	  boff = dst - chp->dst;
+	}
+    }
+
+  if (gop == AES_GCM_OP_ENCRYPT)
+    aes_gcm_enc_final (ctx, d, buf, buf, n_buf);
+  else
+    aes_gcm_dec_final (ctx, d, buf, buf, n_buf);
+  aes_gcm_chained_copy_out (bchp, boff, buf, n_buf);
+
+  return aes_gcm_tag (ctx, op->tag, tag_len);
+}
+
 static_always_inline u32
-aes_ops_enc_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops, aes_key_size_t ks,
+aes_ops_enc_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops,
+		     vnet_crypto_op_chunk_t *chunks, aes_key_size_t ks,
 		     u32 fixed, u32 aad_len)
 {
   crypto_native_main_t *cm = &crypto_native_main;
@@ -36,9 +129,13 @@ aes_ops_enc_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops, aes_key_size_t ks,
 
 next:
   kd = (aes_gcm_key_data_t *) cm->key_data[op->key_index];
-  aes_gcm (op->src, op->dst, op->aad, (u8 *) op->iv, op->tag, op->len,
-	   fixed ? aad_len : op->aad_len, fixed ? 16 : op->tag_len, kd,
-	   AES_KEY_ROUNDS (ks), AES_GCM_OP_ENCRYPT);
+  if (chunks && (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS))
+    aes_gcm_chained (op, chunks, kd, ks, fixed ? aad_len : op->aad_len,
+		     fixed ? 16 : op->tag_len, AES_GCM_OP_ENCRYPT);
+  else
+    aes_gcm (op->src, op->dst, op->aad, (u8 *) op->iv, op->tag, op->len,
+	     fixed ? aad_len : op->aad_len, fixed ? 16 : op->tag_len, kd,
+	     AES_KEY_ROUNDS (ks), AES_GCM_OP_ENCRYPT);
   op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
 
   if (--n_left)
@@ -51,7 +148,8 @@ next:
 }
 
 static_always_inline u32
-aes_ops_dec_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops, aes_key_size_t ks,
+aes_ops_dec_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops,
+		     vnet_crypto_op_chunk_t *chunks, aes_key_size_t ks,
 		     u32 fixed, u32 aad_len)
 {
   crypto_native_main_t *cm = &crypto_native_main;
@@ -62,9 +160,13 @@ aes_ops_dec_aes_gcm (vnet_crypto_op_t *ops[], u32 n_ops, aes_key_size_t ks,
 
 next:
   kd = (aes_gcm_key_data_t *) cm->key_data[op->key_index];
-  rv = aes_gcm (op->src, op->dst, op->aad, (u8 *) op->iv, op->tag, op->len,
-		fixed ? aad_len : op->aad_len, fixed ? 16 : op->tag_len, kd,
-		AES_KEY_ROUNDS (ks), AES_GCM_OP_DECRYPT);
+  if (chunks && (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS))
+    rv = aes_gcm_chained (op, chunks, kd, ks, fixed ? aad_len : op->aad_len,
+			  fixed ? 16 : op->tag_len, AES_GCM_OP_DECRYPT);
+  else
+    rv = aes_gcm (op->src, op->dst, op->aad, (u8 *) op->iv, op->tag, op->len,
+		  fixed ? aad_len : op->aad_len, fixed ? 16 : op->tag_len, kd,
+		  AES_KEY_ROUNDS (ks), AES_GCM_OP_DECRYPT);
 
   if (rv)
     {
@@ -100,35 +202,71 @@ aes_gcm_key_exp (vnet_crypto_key_t *key, aes_key_size_t ks)
 #define foreach_aes_gcm_handler_type _ (128) _ (192) _ (256)
 
 #define _(x)                                                                  \
-  static u32 aes_ops_dec_aes_gcm_##x (vlib_main_t *vm,                        \
-				      vnet_crypto_op_t *ops[], u32 n_ops)     \
+  static u32 aes_ops_dec_aes_gcm_##x (                                        \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
+  {                                                                           \
+    return aes_ops_dec_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 0, 0);            \
+  }                                                                           \
+  static u32 aes_ops_dec_aes_gcm_##x##_chained (                              \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return aes_ops_dec_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 0, 0);       \
+  }                                                                           \
+  static u32 aes_ops_enc_aes_gcm_##x (                                        \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
-    return aes_ops_dec_aes_gcm (ops, n_ops, AES_KEY_##x, 0, 0);               \
+    return aes_ops_enc_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 0, 0);            \
   }                                                                           \
-  static u32 aes_ops_enc_aes_gcm_##x (vlib_main_t *vm,                        \
-				      vnet_crypto_op_t *ops[], u32 n_ops)     \
+  static u32 aes_ops_enc_aes_gcm_##x##_chained (                              \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
   {                                                                           \
-    return aes_ops_enc_aes_gcm (ops, n_ops, AES_KEY_##x, 0, 0);               \
+    return aes_ops_enc_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 0, 0);       \
   }                                                                           \
   static u32 aes_ops_dec_aes_gcm_##x##_tag16_aad8 (                           \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
-    return aes_ops_dec_aes_gcm (ops, n_ops, AES_KEY_##x, 1, 8);               \
+    return aes_ops_dec_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 1, 8);            \
+  }                                                                           \
+  static u32 aes_ops_dec_aes_gcm_##x##_tag16_aad8_chained (                   \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return aes_ops_dec_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 1, 8);       \
   }                                                                           \
   static u32 aes_ops_enc_aes_gcm_##x##_tag16_aad8 (                           \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
-    return aes_ops_enc_aes_gcm (ops, n_ops, AES_KEY_##x, 1, 8);               \
+    return aes_ops_enc_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 1, 8);            \
+  }                                                                           \
+  static u32 aes_ops_enc_aes_gcm_##x##_tag16_aad8_chained (                   \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return aes_ops_enc_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 1, 8);       \
   }                                                                           \
   static u32 aes_ops_dec_aes_gcm_##x##_tag16_aad12 (                          \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
-    return aes_ops_dec_aes_gcm (ops, n_ops, AES_KEY_##x, 1, 12);              \
+    return aes_ops_dec_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 1, 12);           \
+  }                                                                           \
+  static u32 aes_ops_dec_aes_gcm_##x##_tag16_aad12_chained (                  \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return aes_ops_dec_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 1, 12);      \
   }                                                                           \
   static u32 aes_ops_enc_aes_gcm_##x##_tag16_aad12 (                          \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
-    return aes_ops_enc_aes_gcm (ops, n_ops, AES_KEY_##x, 1, 12);              \
+    return aes_ops_enc_aes_gcm (ops, n_ops, 0, AES_KEY_##x, 1, 12);           \
+  }                                                                           \
+  static u32 aes_ops_enc_aes_gcm_##x##_tag16_aad12_chained (                  \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return aes_ops_enc_aes_gcm (ops, n_ops, chunks, AES_KEY_##x, 1, 12);      \
   }                                                                           \
   static void *aes_gcm_key_exp_##x (vnet_crypto_key_t *key)                   \
   {                                                                           \
@@ -168,35 +306,41 @@ probe ()
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_enc) = {                            \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_ENC,                                \
     .fn = aes_ops_enc_aes_gcm_##b,                                            \
+    .cfn = aes_ops_enc_aes_gcm_##b##_chained,                                 \
     .probe = probe,                                                           \
   };                                                                          \
                                                                               \
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_dec) = {                            \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_DEC,                                \
     .fn = aes_ops_dec_aes_gcm_##b,                                            \
+    .cfn = aes_ops_dec_aes_gcm_##b##_chained,                                 \
     .probe = probe,                                                           \
   };                                                                          \
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_enc_tag16_aad8) = {                 \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_TAG16_AAD8_ENC,                     \
     .fn = aes_ops_enc_aes_gcm_##b##_tag16_aad8,                               \
+    .cfn = aes_ops_enc_aes_gcm_##b##_tag16_aad8_chained,                      \
     .probe = probe,                                                           \
   };                                                                          \
                                                                               \
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_dec_tag16_aad8) = {                 \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_TAG16_AAD8_DEC,                     \
     .fn = aes_ops_dec_aes_gcm_##b##_tag16_aad8,                               \
+    .cfn = aes_ops_dec_aes_gcm_##b##_tag16_aad8_chained,                      \
     .probe = probe,                                                           \
   };                                                                          \
                                                                               \
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_enc_tag16_aad12) = {                \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_TAG16_AAD12_ENC,                    \
     .fn = aes_ops_enc_aes_gcm_##b##_tag16_aad12,                              \
+    .cfn = aes_ops_enc_aes_gcm_##b##_tag16_aad12_chained,                     \
     .probe = probe,                                                           \
   };                                                                          \
                                                                               \
   CRYPTO_NATIVE_OP_HANDLER (aes_##b##_gcm_dec_tag16_aad12) = {                \
     .op_id = VNET_CRYPTO_OP_AES_##b##_GCM_TAG16_AAD12_DEC,                    \
     .fn = aes_ops_dec_aes_gcm_##b##_tag16_aad12,                              \
+    .cfn = aes_ops_dec_aes_gcm_##b##_tag16_aad12_chained,                     \
     .probe = probe,                                                           \
   };                                                                          \
                                                                               \
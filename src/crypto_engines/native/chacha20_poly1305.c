@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/crypto/crypto.h>
+#include <native/crypto_native.h>
+#include <vppinfra/crypto/chacha20.h>
+#include <vppinfra/crypto/poly1305.h>
+
+#if __GNUC__ > 4 && !__clang__ && CLIB_DEBUG == 0
+#pragma GCC optimize("O3")
+#endif
+
+/* Ops are processed in groups of CHACHA20_N_LANES. Poly1305 keys (block 0)
+ * of all ops in the group are computed in a single pass, after that
+ * keystream blocks of all ops in the group are packed into lanes back to
+ * back, so short packets don't leave lanes empty */
+
+typedef struct
+{
+  vnet_crypto_op_t *op;
+  const chacha20_key_t *key;
+  vnet_crypto_op_chunk_t *chp; /* current chunk of chained op */
+  u32 n_chunks_left;
+  const u8 *src;
+  u8 *dst;
+  u32 n_bytes_chunk; /* bytes left in current chunk */
+  u32 n_blocks;	     /* keystream blocks left */
+  u32 counter;
+  u8 poly_key[32];
+} chacha20_poly1305_ctx_t;
+
+static_always_inline void
+chacha20_poly1305_xor (chacha20_poly1305_ctx_t *c, chacha20_block_t *ks)
+{
+  u32 off = 0;
+
+  if (PREDICT_TRUE (c->n_bytes_chunk >= CHACHA20_BLOCK_BYTES))
+    {
+      clib_chacha20_xor (ks, 0, c->src, c->dst, CHACHA20_BLOCK_BYTES);
+      c->src += CHACHA20_BLOCK_BYTES;
+      c->dst += CHACHA20_BLOCK_BYTES;
+      c->n_bytes_chunk -= CHACHA20_BLOCK_BYTES;
+      return;
+    }
+
+  /* last block of the op or block spanning multiple chunks */
+  while (off < CHACHA20_BLOCK_BYTES)
+    {
+      u32 n = clib_min (CHACHA20_BLOCK_BYTES - off, c->n_bytes_chunk);
+      clib_chacha20_xor (ks, off, c->src, c->dst, n);
+      c->src += n;
+      c->dst += n;
+      c->n_bytes_chunk -= n;
+      off += n;
+
+      if (c->n_bytes_chunk == 0)
+	{
+	  if (c->n_chunks_left == 0)
+	    return;
+	  c->chp++;
+	  c->n_chunks_left--;
+	  c->src = c->chp->src;
+	  c->dst = c->chp->dst;
+	  c->n_bytes_chunk = c->chp->len;
+	}
+    }
+}
+
+static_always_inline void
+chacha20_poly1305_tag (chacha20_poly1305_ctx_t *c,
+		       vnet_crypto_op_chunk_t *chunks, u32 aad_len, int is_enc,
+		       u8 *tag)
+{
+  static const u8 zero[16] = {};
+  vnet_crypto_op_t *op = c->op;
+  clib_poly1305_ctx ctx;
+  u64 lengths[2];
+  u32 len = 0;
+
+  clib_poly1305_init (&ctx, c->poly_key);
+  clib_poly1305_update (&ctx, op->aad, aad_len);
+  clib_poly1305_update (&ctx, zero, -aad_len & 15);
+
+  /* tag is always computed over ciphertext */
+  if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+    {
+      vnet_crypto_op_chunk_t *chp = chunks + op->chunk_index;
+      for (int j = 0; j < op->n_chunks; j++, chp++)
+	{
+	  clib_poly1305_update (&ctx, is_enc ? chp->dst : chp->src, chp->len);
+	  len += chp->len;
+	}
+    }
+  else
+    {
+      clib_poly1305_update (&ctx, is_enc ? op->dst : op->src, op->len);
+      len = op->len;
+    }
+
+  clib_poly1305_update (&ctx, zero, -len & 15);
+  lengths[0] = clib_host_to_little_u64 (aad_len);
+  lengths[1] = clib_host_to_little_u64 (len);
+  clib_poly1305_update (&ctx, (u8 *) lengths, sizeof (lengths));
+  clib_poly1305_final (&ctx, tag);
+}
+
+static_always_inline u32
+chacha20_poly1305_ops (vnet_crypto_op_t *ops[], u32 n_ops,
+		       vnet_crypto_op_chunk_t *chunks, int is_enc, u32 fixed,
+		       u32 aad_len)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  chacha20_poly1305_ctx_t ctx[CHACHA20_N_LANES], *c;
+  chacha20_block_t b[CHACHA20_N_LANES];
+  u8 lane_ctx[CHACHA20_N_LANES];
+  u32 n_fail = 0;
+
+  for (u32 i = 0; i < n_ops; i += CHACHA20_N_LANES)
+    {
+      u32 n = clib_min (n_ops - i, CHACHA20_N_LANES);
+      u32 n_lanes = 0;
+
+      for (u32 j = 0; j < n; j++)
+	{
+	  vnet_crypto_op_t *op = ops[i + j];
+	  u32 len;
+
+	  c = ctx + j;
+	  c->op = op;
+	  c->key = cm->key_data[op->key_index];
+	  c->counter = 1;
+
+	  if (op->flags & VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS)
+	    {
+	      c->chp = chunks + op->chunk_index;
+	      c->n_chunks_left = op->n_chunks - 1;
+	      c->src = c->chp->src;
+	      c->dst = c->chp->dst;
+	      c->n_bytes_chunk = c->chp->len;
+	      len = 0;
+	      for (int k = 0; k < op->n_chunks; k++)
+		len += c->chp[k].len;
+	    }
+	  else
+	    {
+	      c->n_chunks_left = 0;
+	      c->src = op->src;
+	      c->dst = op->dst;
+	      c->n_bytes_chunk = len = op->len;
+	    }
+
+	  c->n_blocks = round_pow2 (len, CHACHA20_BLOCK_BYTES) /
+			CHACHA20_BLOCK_BYTES;
+
+	  /* block 0 is used as poly1305 key */
+	  clib_chacha20_block_init (b + j, c->key, op->iv, 0);
+	}
+
+      clib_chacha20_blocks (b);
+
+      for (u32 j = 0; j < n; j++)
+	clib_memcpy_fast (ctx[j].poly_key, b[j].as_u8, 32);
+
+      /* decrypt may be in place, so verify tag before ciphertext is gone */
+      if (!is_enc)
+	for (u32 j = 0; j < n; j++)
+	  {
+	    vnet_crypto_op_t *op = ctx[j].op;
+	    u32 tag_len = fixed ? 16 : op->tag_len;
+	    u8 tag[16], diff = 0;
+
+	    chacha20_poly1305_tag (ctx + j, chunks,
+				   fixed ? aad_len : op->aad_len, 0, tag);
+
+	    for (u32 k = 0; k < tag_len; k++)
+	      diff |= tag[k] ^ op->tag[k];
+
+	    if (diff)
+	      {
+		op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+		ctx[j].n_blocks = 0;
+		n_fail++;
+	      }
+	    else
+	      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+	  }
+
+      /* keystream */
+      for (u32 j = 0; j < n; j++)
+	{
+	  c = ctx + j;
+	  while (c->n_blocks)
+	    {
+	      clib_chacha20_block_init (b + n_lanes, c->key, c->op->iv,
+					c->counter++);
+	      c->n_blocks--;
+	      lane_ctx[n_lanes++] = j;
+
+	      if (n_lanes == CHACHA20_N_LANES)
+		{
+		  clib_chacha20_blocks (b);
+		  for (u32 l = 0; l < n_lanes; l++)
+		    chacha20_poly1305_xor (ctx + lane_ctx[l], b + l);
+		  n_lanes = 0;
+		}
+	    }
+	}
+
+      if (n_lanes)
+	{
+	  clib_chacha20_blocks (b);
+	  for (u32 l = 0; l < n_lanes; l++)
+	    chacha20_poly1305_xor (ctx + lane_ctx[l], b + l);
+	}
+
+      if (is_enc)
+	for (u32 j = 0; j < n; j++)
+	  {
+	    vnet_crypto_op_t *op = ctx[j].op;
+	    u8 tag[16];
+
+	    chacha20_poly1305_tag (ctx + j, chunks,
+				   fixed ? aad_len : op->aad_len, 1, tag);
+	    clib_memcpy_fast (op->tag, tag, fixed ? 16 : op->tag_len);
+	    op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+	  }
+    }
+
+  return n_ops - n_fail;
+}
+
+static void *
+chacha20_poly1305_key_exp (vnet_crypto_key_t *key)
+{
+  chacha20_key_t *kd;
+
+  kd = clib_mem_alloc_aligned (sizeof (*kd), CLIB_CACHE_LINE_BYTES);
+
+  clib_chacha20_key_init (kd, key->data);
+
+  return kd;
+}
+
+#define foreach_chacha20_poly1305_handler_type                                \
+  _ (, , 0, 0)                                                                \
+  _ (_tag16_aad0, _TAG16_AAD0, 1, 0)                                          \
+  _ (_tag16_aad8, _TAG16_AAD8, 1, 8)                                          \
+  _ (_tag16_aad12, _TAG16_AAD12, 1, 12)
+
+#define _(x, X, f, a)                                                         \
+  static u32 chacha20_poly1305_enc##x (vlib_main_t *vm,                       \
+				       vnet_crypto_op_t *ops[], u32 n_ops)    \
+  {                                                                           \
+    return chacha20_poly1305_ops (ops, n_ops, 0, 1, f, a);                    \
+  }                                                                           \
+  static u32 chacha20_poly1305_dec##x (vlib_main_t *vm,                       \
+				       vnet_crypto_op_t *ops[], u32 n_ops)    \
+  {                                                                           \
+    return chacha20_poly1305_ops (ops, n_ops, 0, 0, f, a);                    \
+  }                                                                           \
+  static u32 chacha20_poly1305_enc##x##_chained (                             \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return chacha20_poly1305_ops (ops, n_ops, chunks, 1, f, a);               \
+  }                                                                           \
+  static u32 chacha20_poly1305_dec##x##_chained (                             \
+    vlib_main_t *vm, vnet_crypto_op_t *ops[], vnet_crypto_op_chunk_t *chunks, \
+    u32 n_ops)                                                                \
+  {                                                                           \
+    return chacha20_poly1305_ops (ops, n_ops, chunks, 0, f, a);               \
+  }
+
+foreach_chacha20_poly1305_handler_type;
+#undef _
+
+static int
+probe ()
+{
+#if defined(CLIB_HAVE_VEC512)
+  if (clib_cpu_supports_avx512_bitalg ())
+    return 50;
+#elif defined(__AVX512F__)
+  if (clib_cpu_supports_avx512f ())
+    return 30;
+#elif defined(__AVX2__)
+  if (clib_cpu_supports_avx2 ())
+    return 20;
+#elif defined(__SSE4_2__)
+  if (clib_cpu_supports_sse42 ())
+    return 10;
+#elif __aarch64__
+  if (clib_cpu_supports_asimd ())
+    return 10;
+#endif
+  return -1;
+}
+
+#define _(x, X, f, a)                                                         \
+  CRYPTO_NATIVE_OP_HANDLER (chacha20_poly1305_enc##x) = {                     \
+    .op_id = VNET_CRYPTO_OP_CHACHA20_POLY1305##X##_ENC,                       \
+    .fn = chacha20_poly1305_enc##x,                                           \
+    .cfn = chacha20_poly1305_enc##x##_chained,                                \
+    .probe = probe,                                                           \
+  };                                                                          \
+                                                                              \
+  CRYPTO_NATIVE_OP_HANDLER (chacha20_poly1305_dec##x) = {                     \
+    .op_id = VNET_CRYPTO_OP_CHACHA20_POLY1305##X##_DEC,                       \
+    .fn = chacha20_poly1305_dec##x,                                           \
+    .cfn = chacha20_poly1305_dec##x##_chained,                                \
+    .probe = probe,                                                           \
+  };
+
+foreach_chacha20_poly1305_handler_type
+#undef _
+
+CRYPTO_NATIVE_KEY_HANDLER (chacha20_poly1305) = {
+  .alg_id = VNET_CRYPTO_ALG_CHACHA20_POLY1305,
+  .key_fn = chacha20_poly1305_key_exp,
+  .probe = probe,
+};
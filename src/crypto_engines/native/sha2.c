@@ -74,6 +74,39 @@ probe ()
   return -1;
 }
 
+/* multi-buffer hmac, sha-512 has no cpu extensions to compete with */
+static int
+probe_mb ()
+{
+#if defined(CLIB_SHA2_MB) && defined(__x86_64__)
+
+#if defined(CLIB_HAVE_VEC512)
+  if (clib_cpu_supports_avx512_bitalg ())
+    return 30;
+#elif defined(__AVX512F__)
+  if (clib_cpu_supports_avx512f ())
+    return 25;
+#else
+  if (clib_cpu_supports_avx2 ())
+    return 20;
+#endif
+
+#endif
+  return -1;
+}
+
+static int
+probe_hmac ()
+{
+  int p = probe ();
+
+  /* below any variant with sha extensions */
+  if (p < 0 && (p = probe_mb ()) >= 0)
+    p -= 10;
+
+  return p;
+}
+
 #define _(b)                                                                  \
   static u32 crypto_native_ops_hash_sha##b (                                  \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
@@ -89,6 +122,19 @@ probe ()
 					CLIB_SHA2_##b, 1);                    \
   }                                                                           \
                                                                               \
+  CRYPTO_NATIVE_OP_HANDLER (crypto_native_hash_sha##b) = {                    \
+    .op_id = VNET_CRYPTO_OP_SHA##b##_HASH,                                    \
+    .fn = crypto_native_ops_hash_sha##b,                                      \
+    .cfn = crypto_native_ops_chained_hash_sha##b,                             \
+    .probe = probe,                                                           \
+  };
+
+_ (224)
+_ (256)
+
+#undef _
+
+#define _(b, p)                                                               \
   static u32 crypto_native_ops_hmac_sha##b (                                  \
     vlib_main_t *vm, vnet_crypto_op_t *ops[], u32 n_ops)                      \
   {                                                                           \
@@ -108,25 +154,21 @@ probe ()
     return sha2_key_add (k, CLIB_SHA2_##b);                                   \
   }                                                                           \
                                                                               \
-  CRYPTO_NATIVE_OP_HANDLER (crypto_native_hash_sha##b) = {                    \
-    .op_id = VNET_CRYPTO_OP_SHA##b##_HASH,                                    \
-    .fn = crypto_native_ops_hash_sha##b,                                      \
-    .cfn = crypto_native_ops_chained_hash_sha##b,                             \
-    .probe = probe,                                                           \
-  };                                                                          \
   CRYPTO_NATIVE_OP_HANDLER (crypto_native_hmac_sha##b) = {                    \
     .op_id = VNET_CRYPTO_OP_SHA##b##_HMAC,                                    \
     .fn = crypto_native_ops_hmac_sha##b,                                      \
     .cfn = crypto_native_ops_chained_hmac_sha##b,                             \
-    .probe = probe,                                                           \
+    .probe = p,                                                               \
   };                                                                          \
   CRYPTO_NATIVE_KEY_HANDLER (crypto_native_hmac_sha##b) = {                   \
     .alg_id = VNET_CRYPTO_ALG_HMAC_SHA##b,                                    \
     .key_fn = sha2_##b##_key_add,                                             \
-    .probe = probe,                                                           \
+    .probe = p,                                                               \
   };
 
-_ (224)
-_ (256)
+_ (224, probe_hmac)
+_ (256, probe_hmac)
+_ (384, probe_mb)
+_ (512, probe_mb)
 
 #undef _
@@ -21,6 +21,68 @@
 #include <vnet/crypto/crypto.h>
 #include <native/crypto_native.h>
 
+/* ops handed to the multi-buffer code at once */
+#define CRYPTO_NATIVE_SHA2_MB_BATCH 64
+
+static_always_inline u32
+crypto_native_hmac_sha2_result (vnet_crypto_op_t *op, u8 *digest,
+				clib_sha2_type_t type)
+{
+  u32 sz = op->digest_len;
+
+  if (sz == 0)
+    sz = clib_sha2_variants[type].digest_size;
+
+  if (op->flags & VNET_CRYPTO_OP_FLAG_HMAC_CHECK)
+    {
+      if ((memcmp (op->digest, digest, sz)))
+	{
+	  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
+	  return 1;
+	}
+    }
+  else
+    clib_memcpy_fast (op->digest, digest, sz);
+
+  op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+  return 0;
+}
+
+#ifdef CLIB_SHA2_MB
+/* flat buffers, lanes are filled from the op vector as they free up */
+static_always_inline u32
+crypto_native_ops_hmac_sha2_mb (vnet_crypto_op_t *ops[], u32 n_ops,
+				clib_sha2_type_t type)
+{
+  crypto_native_main_t *cm = &crypto_native_main;
+  clib_sha2_hmac_key_data_t *kd[CRYPTO_NATIVE_SHA2_MB_BATCH];
+  const u8 *msg[CRYPTO_NATIVE_SHA2_MB_BATCH];
+  u32 len[CRYPTO_NATIVE_SHA2_MB_BATCH];
+  u8 *digest[CRYPTO_NATIVE_SHA2_MB_BATCH];
+  u8 buffer[CRYPTO_NATIVE_SHA2_MB_BATCH][SHA2_MAX_DIGEST_SIZE];
+  u32 n_fail = 0, n, i;
+
+  for (; n_ops; n_ops -= n, ops += n)
+    {
+      n = clib_min (n_ops, CRYPTO_NATIVE_SHA2_MB_BATCH);
+      for (i = 0; i < n; i++)
+	{
+	  kd[i] = cm->key_data[ops[i]->key_index];
+	  msg[i] = ops[i]->src;
+	  len[i] = ops[i]->len;
+	  digest[i] = buffer[i];
+	}
+
+      clib_sha2_hmac_mb (type, kd, msg, len, digest, n);
+
+      for (i = 0; i < n; i++)
+	n_fail += crypto_native_hmac_sha2_result (ops[i], buffer[i], type);
+    }
+
+  return n_fail;
+}
+#endif
+
 static_always_inline u32
 crypto_native_ops_hmac_sha2 (vlib_main_t *vm, vnet_crypto_op_t *ops[],
 			     u32 n_ops, vnet_crypto_op_chunk_t *chunks,
@@ -30,8 +92,13 @@ crypto_native_ops_hmac_sha2 (vlib_main_t *vm, vnet_crypto_op_t *ops[],
   vnet_crypto_op_t *op = ops[0];
   u32 n_left = n_ops;
   clib_sha2_hmac_ctx_t ctx;
-  u8 buffer[64];
-  u32 sz, n_fail = 0;
+  u8 buffer[SHA2_MAX_DIGEST_SIZE];
+  u32 n_fail = 0;
+
+#ifdef CLIB_SHA2_MB
+  if (chunks == 0)
+    return n_ops - crypto_native_ops_hmac_sha2_mb (ops, n_ops, type);
+#endif
 
   for (; n_left; n_left--, op++)
     {
@@ -47,39 +114,7 @@ crypto_native_ops_hmac_sha2 (vlib_main_t *vm, vnet_crypto_op_t *ops[],
 	clib_sha2_hmac_update (&ctx, op->src, op->len);
 
       clib_sha2_hmac_final (&ctx, buffer);
-
-      if (op->digest_len)
-	{
-	  sz = op->digest_len;
-	  if (op->flags & VNET_CRYPTO_OP_FLAG_HMAC_CHECK)
-	    {
-	      if ((memcmp (op->digest, buffer, sz)))
-		{
-		  n_fail++;
-		  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
-		  continue;
-		}
-	    }
-	  else
-	    clib_memcpy_fast (op->digest, buffer, sz);
-	}
-      else
-	{
-	  sz = clib_sha2_variants[type].digest_size;
-	  if (op->flags & VNET_CRYPTO_OP_FLAG_HMAC_CHECK)
-	    {
-	      if ((memcmp (op->digest, buffer, sz)))
-		{
-		  n_fail++;
-		  op->status = VNET_CRYPTO_OP_STATUS_FAIL_BAD_HMAC;
-		  continue;
-		}
-	    }
-	  else
-	    clib_memcpy_fast (op->digest, buffer, sz);
-	}
-
-      op->status = VNET_CRYPTO_OP_STATUS_COMPLETED;
+      n_fail += crypto_native_hmac_sha2_result (op, buffer, type);
     }
 
   return n_ops - n_fail;
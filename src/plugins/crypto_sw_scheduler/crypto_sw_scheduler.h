@@ -21,6 +21,12 @@
 #define CRYPTO_SW_SCHEDULER_QUEUE_SIZE 64
 #define CRYPTO_SW_SCHEDULER_QUEUE_MASK (CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1)
 
+/* most frames a thief takes in one go, it takes half of the backlog */
+#define CRYPTO_SW_SCHEDULER_STEAL_MAX 32
+
+/* own frames a worker processes in a row before it looks at others */
+#define CRYPTO_SW_SCHEDULER_LOCAL_BURST 16
+
 STATIC_ASSERT ((0 == (CRYPTO_SW_SCHEDULER_QUEUE_SIZE &
 		      (CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1))),
 	       "CRYPTO_SW_SCHEDULER_QUEUE_SIZE is not pow2");
@@ -44,7 +50,11 @@ typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   crypto_sw_scheduler_queue_t queue[CRYPTO_SW_SCHED_QUEUE_N_TYPES];
-  u32 last_serve_lcore_id;
+  /* threads to steal from, the ones on this thread's numa node first */
+  u32 *victims;
+  u32 n_local_victims;
+  u32 next_victim;
+  u32 local_burst;
   u8 last_serve_encrypt;
   u8 last_return_queue;
   vnet_crypto_op_t *crypto_ops;
@@ -53,6 +63,14 @@ typedef struct
   vnet_crypto_op_t *chained_integ_ops;
   vnet_crypto_op_chunk_t *chunks;
   u8 self_crypto_enabled;
+
+  /* counters, only written by the owning thread */
+  u64 n_enqueued;
+  u64 n_enqueue_full;
+  u64 n_local;
+  u64 n_stolen;
+  u64 n_steals;
+  u64 n_steal_attempts;
 } crypto_sw_scheduler_per_thread_data_t;
 
 typedef struct
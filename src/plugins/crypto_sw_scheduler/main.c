@@ -90,9 +90,11 @@ crypto_sw_scheduler_frame_enqueue (vlib_main_t *vm,
       u32 n_elts = frame->n_elts, i;
       for (i = 0; i < n_elts; i++)
 	frame->elts[i].status = VNET_CRYPTO_OP_STATUS_FAIL_ENGINE_ERR;
+      ptd->n_enqueue_full++;
       return -1;
     }
 
+  ptd->n_enqueued++;
   current_queue->jobs[head & cm->crypto_sw_scheduler_queue_mask] = frame;
   head += 1;
   CLIB_MEMORY_STORE_BARRIER ();
@@ -444,134 +446,200 @@ convert_async_crypto_id (vnet_crypto_op_id_t async_op_id, u32 *crypto_op,
   return -1;
 }
 
-static_always_inline vnet_crypto_async_frame_t *
-crypto_sw_scheduler_dequeue (vlib_main_t *vm, u32 *nb_elts_processed,
-			     clib_thread_index_t *enqueue_thread_idx)
+/* claim up to n_max pending frames of a queue, from the oldest for the
+ * owner, from the newest for a thief, so the two meet in the middle */
+static_always_inline u32
+crypto_sw_scheduler_claim (crypto_sw_scheduler_main_t *cm,
+			   crypto_sw_scheduler_queue_t *q,
+			   vnet_crypto_async_frame_t **claimed, u32 n_max,
+			   int from_head)
 {
-  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
-  crypto_sw_scheduler_per_thread_data_t *ptd =
-    cm->per_thread_data + vm->thread_index;
-  vnet_crypto_async_frame_t *f = 0;
-  crypto_sw_scheduler_queue_t *current_queue = 0;
-  u32 tail, head;
-  u8 found = 0;
-  u8 recheck_queues = 1;
+  u32 tail = q->tail, head = q->head, depth = head - tail, i, n = 0;
+  vnet_crypto_async_frame_t *f;
 
-run_next_queues:
-  /* get a pending frame to process */
-  if (ptd->self_crypto_enabled)
+  /* tail and head are read without a lock, skip a torn pair */
+  if (depth > cm->crypto_sw_scheduler_queue_mask + 1)
+    return 0;
+
+  for (i = 0; i < depth && n < n_max; i++)
     {
-      u32 i = ptd->last_serve_lcore_id + 1;
+      u32 j = from_head ? head - 1 - i : tail + i;
 
-      while (1)
-	{
-	  crypto_sw_scheduler_per_thread_data_t *st;
-	  u32 j;
+      f = q->jobs[j & cm->crypto_sw_scheduler_queue_mask];
+      if (f && clib_atomic_bool_cmp_and_swap (
+		 &f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
+		 VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
+	claimed[n++] = f;
+    }
 
-	  if (i >= vec_len (cm->per_thread_data))
-	    i = 0;
+  return n;
+}
 
-	  st = cm->per_thread_data + i;
+static_always_inline u32
+crypto_sw_scheduler_claim_local (crypto_sw_scheduler_main_t *cm,
+				 crypto_sw_scheduler_per_thread_data_t *ptd,
+				 vnet_crypto_async_frame_t **claimed)
+{
+  u32 q, n = 0;
 
-	  if (ptd->last_serve_encrypt)
-	    current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
-	  else
-	    current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
+  for (q = 0; q < CRYPTO_SW_SCHED_QUEUE_N_TYPES && n == 0; q++)
+    {
+      ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
+      n = crypto_sw_scheduler_claim (
+	cm,
+	&ptd->queue[ptd->last_serve_encrypt ?
+		      CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT :
+		      CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT],
+	claimed, 1, 0);
+    }
 
-	  tail = current_queue->tail;
-	  head = current_queue->head;
+  return n;
+}
 
-	  /* Skip this queue unless tail < head or head has overflowed
-	   * and tail has not. At the point where tail overflows (== 0),
-	   * the largest possible value of head is (queue size - 1).
-	   * Prior to that, the largest possible value of head is
-	   * (queue size - 2).
-	   */
-	  if ((tail > head) && (head >= cm->crypto_sw_scheduler_queue_mask))
-	    goto skip_queue;
+/* take half of the backlog of the first victim that has one, numa-local
+ * victims first, starting from a different one each time */
+static_always_inline u32
+crypto_sw_scheduler_steal (crypto_sw_scheduler_main_t *cm,
+			   crypto_sw_scheduler_per_thread_data_t *ptd,
+			   vnet_crypto_async_frame_t **claimed,
+			   clib_thread_index_t *owner)
+{
+  u32 g, i, q, n_victims, first, depth, n;
 
-	  for (j = tail; j != head; j++)
-	    {
+  ptd->n_steal_attempts++;
+  ptd->next_victim++;
 
-	      f = current_queue->jobs[j & cm->crypto_sw_scheduler_queue_mask];
+  for (g = 0; g < 2; g++)
+    {
+      first = g ? ptd->n_local_victims : 0;
+      n_victims = g ? vec_len (ptd->victims) - first : ptd->n_local_victims;
 
-	      if (!f)
+      for (i = 0; i < n_victims; i++)
+	{
+	  u32 v = ptd->victims[first + (ptd->next_victim + i) % n_victims];
+	  crypto_sw_scheduler_per_thread_data_t *st =
+	    cm->per_thread_data + v;
+
+	  for (q = 0; q < CRYPTO_SW_SCHED_QUEUE_N_TYPES; q++)
+	    {
+	      crypto_sw_scheduler_queue_t *sq = st->queue + q;
+
+	      depth = sq->head - sq->tail;
+	      if (depth == 0)
 		continue;
 
-	      if (clib_atomic_bool_cmp_and_swap (
-		    &f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
-		    VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
+	      n = crypto_sw_scheduler_claim (
+		cm, sq, claimed,
+		clib_min ((depth + 1) / 2, CRYPTO_SW_SCHEDULER_STEAL_MAX), 1);
+	      if (n)
 		{
-		  found = 1;
-		  break;
+		  ptd->n_steals++;
+		  ptd->n_stolen += n;
+		  *owner = v;
+		  return n;
 		}
 	    }
-
-	skip_queue:
-	  if (found || i == ptd->last_serve_lcore_id)
-	    {
-	      CLIB_MEMORY_STORE_BARRIER ();
-	      ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
-	      break;
-	    }
-
-	  i++;
 	}
-
-      ptd->last_serve_lcore_id = i;
     }
 
-  if (found)
-    {
-      u32 crypto_op, auth_op_or_aad_len;
-      u16 digest_len;
-      u8 is_enc;
-      int ret;
-
-      ret = convert_async_crypto_id (f->op, &crypto_op, &auth_op_or_aad_len,
-				     &digest_len, &is_enc);
+  return 0;
+}
 
-      if (ret == 1)
-	crypto_sw_scheduler_process_aead (vm, ptd, f, crypto_op,
-					  auth_op_or_aad_len, digest_len);
-      else if (ret == 0)
-	crypto_sw_scheduler_process_link (
-	  vm, cm, ptd, f, crypto_op, auth_op_or_aad_len, digest_len, is_enc);
+static_always_inline void
+crypto_sw_scheduler_process_frame (vlib_main_t *vm,
+				   crypto_sw_scheduler_main_t *cm,
+				   crypto_sw_scheduler_per_thread_data_t *ptd,
+				   vnet_crypto_async_frame_t *f)
+{
+  u32 crypto_op, auth_op_or_aad_len;
+  u16 digest_len;
+  u8 is_enc;
+  int ret;
+
+  ret = convert_async_crypto_id (f->op, &crypto_op, &auth_op_or_aad_len,
+				 &digest_len, &is_enc);
+
+  if (ret == 1)
+    crypto_sw_scheduler_process_aead (vm, ptd, f, crypto_op,
+				      auth_op_or_aad_len, digest_len);
+  else if (ret == 0)
+    crypto_sw_scheduler_process_link (vm, cm, ptd, f, crypto_op,
+				      auth_op_or_aad_len, digest_len, is_enc);
+}
 
-      *enqueue_thread_idx = f->enqueue_thread_index;
-      *nb_elts_processed = f->n_elts;
-    }
+/*
+ * Work stealing: a worker processes the frames of its own queues, oldest
+ * first, and only when it has none, or has done a burst of them, takes
+ * half of the backlog of another thread, newest first. Frames stay in
+ * their owner's ring, and are returned by the owner in order once
+ * processed, so a completion never crosses threads twice.
+ */
+static_always_inline vnet_crypto_async_frame_t *
+crypto_sw_scheduler_dequeue (vlib_main_t *vm, u32 *nb_elts_processed,
+			     clib_thread_index_t *enqueue_thread_idx)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_per_thread_data_t *ptd =
+    cm->per_thread_data + vm->thread_index;
+  vnet_crypto_async_frame_t *claimed[CRYPTO_SW_SCHEDULER_STEAL_MAX];
+  crypto_sw_scheduler_queue_t *current_queue = 0;
+  clib_thread_index_t owner = vm->thread_index;
+  vnet_crypto_async_frame_t *f;
+  u32 i, n = 0, tail;
 
-  if (ptd->last_return_queue)
+  if (ptd->self_crypto_enabled)
     {
-      current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
-      ptd->last_return_queue = 0;
+      if (ptd->local_burst < CRYPTO_SW_SCHEDULER_LOCAL_BURST)
+	n = crypto_sw_scheduler_claim_local (cm, ptd, claimed);
+
+      if (n)
+	{
+	  ptd->local_burst++;
+	  ptd->n_local++;
+	}
+      else
+	{
+	  ptd->local_burst = 0;
+	  n = crypto_sw_scheduler_steal (cm, ptd, claimed, &owner);
+	  /* nobody else had work, back to our own */
+	  if (n == 0 && (n = crypto_sw_scheduler_claim_local (cm, ptd,
+							      claimed)))
+	    ptd->n_local++;
+	}
     }
-  else
+
+  if (n)
     {
-      current_queue = &ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
-      ptd->last_return_queue = 1;
+      *nb_elts_processed = 0;
+      for (i = 0; i < n; i++)
+	{
+	  crypto_sw_scheduler_process_frame (vm, cm, ptd, claimed[i]);
+	  *nb_elts_processed += claimed[i]->n_elts;
+	}
+      *enqueue_thread_idx = owner;
     }
 
-  tail = current_queue->tail & cm->crypto_sw_scheduler_queue_mask;
-
-  if (current_queue->jobs[tail] &&
-      current_queue->jobs[tail]->state >= VNET_CRYPTO_FRAME_STATE_SUCCESS)
+  /* return our own processed frames, in order */
+  for (i = 0; i < CRYPTO_SW_SCHED_QUEUE_N_TYPES; i++)
     {
+      current_queue =
+	&ptd->queue[ptd->last_return_queue ?
+		      CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT :
+		      CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
+      ptd->last_return_queue = !ptd->last_return_queue;
 
-      CLIB_MEMORY_STORE_BARRIER ();
-      current_queue->tail++;
+      tail = current_queue->tail & cm->crypto_sw_scheduler_queue_mask;
       f = current_queue->jobs[tail];
-      current_queue->jobs[tail] = 0;
 
-      return f;
+      if (f && f->state >= VNET_CRYPTO_FRAME_STATE_SUCCESS)
+	{
+	  CLIB_MEMORY_STORE_BARRIER ();
+	  current_queue->tail++;
+	  current_queue->jobs[tail] = 0;
+	  return f;
+	}
     }
 
-  if (!found && recheck_queues)
-    {
-      recheck_queues = 0;
-      goto run_next_queues;
-    }
   return 0;
 }
 
@@ -646,13 +714,26 @@ sw_scheduler_show_workers (vlib_main_t * vm, unformat_input_t * input,
   crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
   u32 i;
 
-  vlib_cli_output (vm, "%-7s%-20s%-8s", "ID", "Name", "Crypto");
+  vlib_cli_output (vm, "%-7s%-20s%-8s%-7s%-12s%-12s%-12s%-10s%s", "ID",
+		   "Name", "Crypto", "Depth", "Enqueued", "Local", "Stolen",
+		   "Steals", "Steal-rate");
   for (i = 1; i < vlib_thread_main.n_vlib_mains; i++)
     {
-      vlib_cli_output (vm, "%-7d%-20s%-8s", vlib_get_worker_index (i),
+      crypto_sw_scheduler_per_thread_data_t *ptd = cm->per_thread_data + i;
+      u32 depth = 0, q;
+
+      for (q = 0; q < CRYPTO_SW_SCHED_QUEUE_N_TYPES; q++)
+	depth += ptd->queue[q].head - ptd->queue[q].tail;
+
+      vlib_cli_output (vm, "%-7d%-20s%-8s%-7u%-12lu%-12lu%-12lu%-10lu%.1f%%",
+		       vlib_get_worker_index (i),
 		       (vlib_worker_threads + i)->name,
-		       cm->
-		       per_thread_data[i].self_crypto_enabled ? "on" : "off");
+		       ptd->self_crypto_enabled ? "on" : "off", depth,
+		       ptd->n_enqueued, ptd->n_local, ptd->n_stolen,
+		       ptd->n_steals,
+		       ptd->n_steal_attempts ?
+			 100.0 * ptd->n_steals / ptd->n_steal_attempts :
+			 0.0);
     }
 
   return 0;
@@ -727,6 +808,41 @@ VLIB_INIT_FUNCTION (crypto_sw_scheduler_init) = {
   .runs_after = VLIB_INITS ("vnet_crypto_init"),
 };
 
+/* thread numa nodes are known once the workers are launched */
+static clib_error_t *
+crypto_sw_scheduler_main_loop_enter (vlib_main_t *vm)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  crypto_sw_scheduler_per_thread_data_t *ptd;
+  u32 n_threads = vec_len (cm->per_thread_data), i, j, pass;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      ptd = cm->per_thread_data + i;
+      vec_reset_length (ptd->victims);
+
+      /* threads on the same numa node first, then the others */
+      for (pass = 0; pass < 2; pass++)
+	{
+	  for (j = 1; j < n_threads; j++)
+	    {
+	      u32 v = (i + j) % n_threads;
+	      int is_local = vlib_worker_threads[v].numa_id ==
+			     vlib_worker_threads[i].numa_id;
+
+	      if (is_local == (pass == 0))
+		vec_add1 (ptd->victims, v);
+	    }
+	  if (pass == 0)
+	    ptd->n_local_victims = vec_len (ptd->victims);
+	}
+    }
+
+  return 0;
+}
+
+VLIB_MAIN_LOOP_ENTER_FUNCTION (crypto_sw_scheduler_main_loop_enter);
+
 VLIB_PLUGIN_REGISTER () = {
   .version = VPP_BUILD_VER,
   .description = "SW Scheduler Crypto Async Engine plugin",
@@ -778,7 +894,7 @@ crypto_sw_scheduler_config (vlib_main_t *vm, unformat_input_t *input)
 
       vec_validate_aligned (
 	ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT].jobs,
-	CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1, CLIB_CACHE_LINE_BYTES);
+	crypto_sw_scheduler_queue_size - 1, CLIB_CACHE_LINE_BYTES);
 
       ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT].head = 0;
       ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT].tail = 0;
@@ -788,7 +904,7 @@ crypto_sw_scheduler_config (vlib_main_t *vm, unformat_input_t *input)
 
       vec_validate_aligned (
 	ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT].jobs,
-	CRYPTO_SW_SCHEDULER_QUEUE_SIZE - 1, CLIB_CACHE_LINE_BYTES);
+	crypto_sw_scheduler_queue_size - 1, CLIB_CACHE_LINE_BYTES);
     }
 
   if (error)
@@ -0,0 +1,390 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/cli.h>
+#include <vnet/vnet.h>
+#include <hqos/hqos.h>
+
+/* Rates are given in bits per second and kept in bytes per second */
+uword
+unformat_hqos_rate (unformat_input_t *input, va_list *args)
+{
+  f64 *result = va_arg (*args, f64 *);
+  f64 tmp;
+
+  if (unformat (input, "%f gbps", &tmp))
+    *result = tmp * 1e9 / 8;
+  else if (unformat (input, "%f mbps", &tmp))
+    *result = tmp * 1e6 / 8;
+  else if (unformat (input, "%f kbps", &tmp))
+    *result = tmp * 1e3 / 8;
+  else if (unformat (input, "%f bps", &tmp))
+    *result = tmp / 8;
+  else
+    return 0;
+  return 1;
+}
+
+static u8 *
+format_hqos_rate (u8 *s, va_list *args)
+{
+  f64 bps = va_arg (*args, f64) * 8;
+
+  if (bps >= 1e9)
+    s = format (s, "%.2f gbps", bps / 1e9);
+  else if (bps >= 1e6)
+    s = format (s, "%.2f mbps", bps / 1e6);
+  else if (bps >= 1e3)
+    s = format (s, "%.2f kbps", bps / 1e3);
+  else
+    s = format (s, "%.0f bps", bps);
+
+  return s;
+}
+
+u8 *
+format_hqos_port (u8 *s, va_list *args)
+{
+  hqos_port_t *port = va_arg (*args, hqos_port_t *);
+  int verbose = va_arg (*args, int);
+  u32 indent = format_get_indent (s);
+  hqos_port_thread_t *pt;
+  int tc;
+
+  s = format (s, "%U rate %U\n", format_vnet_sw_if_index_name,
+	      vnet_get_main (), port->sw_if_index, format_hqos_rate,
+	      port->rate);
+  s = format (s, "%U%u subports at %U, %u pipes each at %U\n",
+	      format_white_space, indent + 2, port->n_subports,
+	      format_hqos_rate, port->subport_rate, port->n_pipes_per_subport,
+	      format_hqos_rate, port->pipe_rate);
+  s = format (s, "%Uqueue size %u, pipe shift %u\n", format_white_space,
+	      indent + 2, port->queue_size, port->pipe_shift);
+
+  vec_foreach (pt, port->per_thread)
+    {
+      u64 n_tx = 0, n_bytes = 0;
+      f64 dt;
+
+      for (tc = 0; tc < HQOS_N_TC; tc++)
+	{
+	  n_tx += pt->tx_packets[tc] + pt->drops[tc];
+	  n_bytes += pt->tx_bytes[tc];
+	}
+      if (!verbose && n_tx == 0 && pt->n_queued == 0)
+	continue;
+
+      s = format (s, "%Uthread %u: queued %u", format_white_space,
+		  indent + 2, pt - port->per_thread, pt->n_queued);
+
+      /* what went out after the initial burst, over the time it took */
+      dt = pt->last_tx_time - pt->first_tx_time;
+      if (dt > 0)
+	{
+	  f64 rate = (n_bytes - pt->first_tx_bytes) / dt;
+	  s = format (s, ", shaped at %U, %.2f%% of the port rate",
+		      format_hqos_rate, rate, rate * 100 / port->rate);
+	}
+      s = format (s, "\n");
+      for (tc = 0; tc < HQOS_N_TC; tc++)
+	s = format (s, "%Utc %u: tx %llu packets %llu bytes, drops %llu\n",
+		    format_white_space, indent + 4, tc, pt->tx_packets[tc],
+		    pt->tx_bytes[tc], pt->drops[tc]);
+    }
+
+  return s;
+}
+
+static clib_error_t *
+set_interface_hqos_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  hqos_port_config_t cfg = {
+    .n_subports = 1,
+    .n_pipes_per_subport = 1,
+    .queue_size = HQOS_DEFAULT_QUEUE_SIZE,
+  };
+  clib_error_t *error = 0;
+  u32 sw_if_index = ~0, pipe_shift = 0;
+  int is_add = 1, rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "subport-rate %U", unformat_hqos_rate,
+			 &cfg.subport_rate))
+	;
+      else if (unformat (line_input, "pipe-rate %U", unformat_hqos_rate,
+			 &cfg.pipe_rate))
+	;
+      else if (unformat (line_input, "rate %U", unformat_hqos_rate,
+			 &cfg.rate))
+	;
+      else if (unformat (line_input, "subports %u", &cfg.n_subports))
+	;
+      else if (unformat (line_input, "pipes %u", &cfg.n_pipes_per_subport))
+	;
+      else if (unformat (line_input, "queue-size %u", &cfg.queue_size))
+	;
+      else if (unformat (line_input, "pipe-shift %u", &pipe_shift))
+	;
+      else if (unformat (line_input, "disable"))
+	is_add = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "interface required");
+      goto done;
+    }
+  if (pipe_shift > 31)
+    {
+      error = clib_error_return (0, "pipe-shift must be less than 32");
+      goto done;
+    }
+
+  if (is_add && cfg.rate == 0)
+    {
+      error = clib_error_return (0, "rate required");
+      goto done;
+    }
+
+  cfg.pipe_shift = pipe_shift;
+  if (cfg.subport_rate == 0)
+    cfg.subport_rate = cfg.rate;
+  if (cfg.pipe_rate == 0)
+    cfg.pipe_rate = cfg.subport_rate;
+
+  rv = hqos_port_add_del (sw_if_index, &cfg, is_add);
+
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_INVALID_SW_IF_INDEX:
+      error = clib_error_return (0, "invalid interface");
+      break;
+    case VNET_API_ERROR_UNSUPPORTED:
+      error = clib_error_return (0,
+				 "%U is a sub-interface, shape the parent "
+				 "interface instead",
+				 format_vnet_sw_if_index_name, vnm,
+				 sw_if_index);
+      break;
+    case VNET_API_ERROR_INVALID_INTERFACE:
+      error = clib_error_return (0, "%U is not an ethernet interface",
+				 format_vnet_sw_if_index_name, vnm,
+				 sw_if_index);
+      break;
+    case VNET_API_ERROR_INVALID_VALUE:
+      error = clib_error_return (0, "rates must be non-zero");
+      break;
+    case VNET_API_ERROR_INVALID_VALUE_2:
+      error = clib_error_return (
+	0, "subports, pipes and queue-size must be non-zero");
+      break;
+    case VNET_API_ERROR_VALUE_EXIST:
+      error = clib_error_return (0, "already enabled, disable first");
+      break;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      error = clib_error_return (0, "not enabled");
+      break;
+    default:
+      error = clib_error_return (0, "failed: %d", rv);
+      break;
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Enable the hierarchical egress scheduler on an interface. Packets are
+ * spread over the pipes by destination address and over the traffic
+ * classes by DSCP. Rates default to the rate of the level above.
+ *
+ * Only ethernet hardware interfaces can be shaped. Sub-interfaces are
+ * rejected, and traffic sent through the sub-interfaces of a shaped
+ * interface bypasses the scheduler.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface hqos GigabitEthernet2/0/0 rate 10 gbps subports 16
+ * pipes 4096 pipe-rate 20 mbps}
+?*/
+VLIB_CLI_COMMAND (set_interface_hqos_command, static) = {
+  .path = "set interface hqos",
+  .short_help = "set interface hqos <interface> rate <rate> "
+		"[subports <n>] [pipes <n>] [subport-rate <rate>] "
+		"[pipe-rate <rate>] [queue-size <n>] [pipe-shift <n>] "
+		"[disable]",
+  .function = set_interface_hqos_command_fn,
+};
+
+static clib_error_t *
+set_interface_hqos_pipe_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				    vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  clib_error_t *error = 0;
+  u32 sw_if_index = ~0, pipe = ~0, weight = 1;
+  f64 rate = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "rate %U", unformat_hqos_rate, &rate))
+	;
+      else if (unformat (line_input, "weight %u", &weight))
+	;
+      else if (unformat (line_input, "%u", &pipe))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || pipe == ~0)
+    {
+      error = clib_error_return (0, "interface and pipe required");
+      goto done;
+    }
+  if (weight == 0 || weight > CLIB_U16_MAX)
+    {
+      error = clib_error_return (0, "invalid weight %u", weight);
+      goto done;
+    }
+
+  if (rate == 0)
+    {
+      error = clib_error_return (0, "rate required");
+      goto done;
+    }
+
+  rv = hqos_pipe_config (sw_if_index, pipe, rate, weight);
+
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      error = clib_error_return (0, "hqos not enabled on %U",
+				 format_vnet_sw_if_index_name, vnm,
+				 sw_if_index);
+      break;
+    case VNET_API_ERROR_INVALID_VALUE:
+      error = clib_error_return (0, "pipe %u out of range", pipe);
+      break;
+    case VNET_API_ERROR_INVALID_VALUE_2:
+      error = clib_error_return (0, "rate and weight must be non-zero");
+      break;
+    default:
+      error = clib_error_return (0, "failed: %d", rv);
+      break;
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Override the rate and round robin weight of a single pipe.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface hqos pipe GigabitEthernet2/0/0 7 rate 100 mbps
+ * weight 4}
+?*/
+VLIB_CLI_COMMAND (set_interface_hqos_pipe_command, static) = {
+  .path = "set interface hqos pipe",
+  .short_help = "set interface hqos pipe <interface> <pipe> rate <rate> "
+		"[weight <n>]",
+  .function = set_interface_hqos_pipe_command_fn,
+};
+
+static clib_error_t *
+set_hqos_dscp_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			  vlib_cli_command_t *cmd)
+{
+  u32 dscp = ~0, tc = ~0;
+
+  if (!unformat (input, "%u tc %u", &dscp, &tc))
+    return clib_error_return (0, "unknown input `%U'", format_unformat_error,
+			      input);
+
+  if (dscp > 63 || hqos_dscp_tc_set (dscp, tc))
+    return clib_error_return (0, "invalid dscp %u or traffic class %u", dscp,
+			      tc);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_hqos_dscp_command, static) = {
+  .path = "set hqos dscp",
+  .short_help = "set hqos dscp <dscp> tc <0-3>",
+  .function = set_hqos_dscp_command_fn,
+};
+
+static clib_error_t *
+show_hqos_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  hqos_main_t *hm = &hqos_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0;
+  hqos_port_t *port;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  pool_foreach (port, hm->ports)
+    {
+      if (sw_if_index != ~0 && port->sw_if_index != sw_if_index)
+	continue;
+      vlib_cli_output (vm, "%U", format_hqos_port, port, verbose);
+    }
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_hqos_command, static) = {
+  .path = "show hqos",
+  .short_help = "show hqos [<interface>] [verbose]",
+  .function = show_hqos_command_fn,
+};
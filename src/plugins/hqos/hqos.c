@@ -0,0 +1,268 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/plugin/plugin.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vpp/app/version.h>
+#include <hqos/hqos.h>
+
+hqos_main_t hqos_main;
+
+static void
+hqos_bucket_init (hqos_bucket_t *b, f64 rate, f64 now)
+{
+  b->rate = rate;
+  b->burst = clib_max (rate * HQOS_BURST_TIME, HQOS_BURST_MIN);
+  b->tokens = b->burst;
+  b->last_update = now;
+}
+
+static void
+hqos_port_thread_init (hqos_port_t *port, hqos_port_thread_t *pt, f64 now)
+{
+  hqos_subport_t *sp;
+  hqos_pipe_t *pp;
+
+  hqos_bucket_init (&pt->shaper, port->rate, now);
+
+  vec_validate_aligned (pt->subports, port->n_subports - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (sp, pt->subports)
+    {
+      hqos_bucket_init (&sp->shaper, port->subport_rate, now);
+      clib_bitmap_alloc (sp->active_pipes, port->n_pipes_per_subport);
+    }
+
+  vec_validate_aligned (pt->pipes,
+			port->n_subports * port->n_pipes_per_subport - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (pp, pt->pipes)
+    {
+      hqos_bucket_init (&pp->shaper, port->pipe_rate, now);
+      pp->weight = pp->credit = 1;
+    }
+
+  clib_bitmap_alloc (pt->active_subports, port->n_subports);
+}
+
+static void
+hqos_port_thread_free (vlib_main_t *vm, hqos_port_thread_t *pt)
+{
+  hqos_subport_t *sp;
+  hqos_pipe_t *pp;
+  u32 bi;
+  int tc;
+
+  vec_foreach (pp, pt->pipes)
+    for (tc = 0; tc < HQOS_N_TC; tc++)
+      {
+	while (clib_fifo_elts (pp->queues[tc]))
+	  {
+	    clib_fifo_sub1 (pp->queues[tc], bi);
+	    vlib_buffer_free_one (vm, bi);
+	  }
+	clib_fifo_free (pp->queues[tc]);
+      }
+
+  vec_foreach (sp, pt->subports)
+    clib_bitmap_free (sp->active_pipes);
+
+  vec_free (pt->subports);
+  vec_free (pt->pipes);
+  clib_bitmap_free (pt->active_subports);
+}
+
+/*
+ * The dequeue node runs on interrupts, raised by the enqueue node on the
+ * thread which queued the packets, so threads which never transmit on a
+ * port don't spin on it. While the shapers hold packets back it schedules
+ * itself on the timer wheel for when tokens are due.
+ */
+static void
+hqos_update_dequeue_state (hqos_main_t *hm)
+{
+  vlib_node_state_t state;
+
+  state = pool_elts (hm->ports) ? VLIB_NODE_STATE_INTERRUPT :
+				   VLIB_NODE_STATE_DISABLED;
+
+  foreach_vlib_main ()
+    vlib_node_set_state (this_vlib_main, hqos_dequeue_node.index, state);
+}
+
+int
+hqos_port_add_del (u32 sw_if_index, const hqos_port_config_t *cfg, int is_add)
+{
+  hqos_main_t *hm = &hqos_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vlib_main_t *vm = vlib_get_main ();
+  hqos_port_thread_t *pt;
+  vnet_sw_interface_t *sw;
+  hqos_port_t *port;
+  u32 port_index;
+  f64 now;
+
+  if (!vnet_sw_interface_is_api_valid (vnm, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  /*
+   * The classifier parses the ethernet header. Sub-interfaces have their
+   * own interface-output arc, so a port on one would only see part of the
+   * traffic of the wire it shapes.
+   */
+  sw = vnet_get_sw_interface (vnm, sw_if_index);
+  if (sw->type != VNET_SW_INTERFACE_TYPE_HARDWARE)
+    return VNET_API_ERROR_UNSUPPORTED;
+  if (!ethernet_get_interface (&ethernet_main, sw->hw_if_index))
+    return VNET_API_ERROR_INVALID_INTERFACE;
+
+  vec_validate_init_empty (hm->port_index_by_sw_if_index, sw_if_index, ~0);
+  port_index = hm->port_index_by_sw_if_index[sw_if_index];
+
+  if (is_add)
+    {
+      if (cfg->rate <= 0 || cfg->subport_rate <= 0 || cfg->pipe_rate <= 0)
+	return VNET_API_ERROR_INVALID_VALUE;
+      if (cfg->n_subports == 0 || cfg->n_pipes_per_subport == 0 ||
+	  cfg->queue_size == 0)
+	return VNET_API_ERROR_INVALID_VALUE_2;
+      if (port_index != ~0)
+	return VNET_API_ERROR_VALUE_EXIST;
+
+      vlib_worker_thread_barrier_sync (vm);
+
+      pool_get_zero (hm->ports, port);
+      port->sw_if_index = sw_if_index;
+      port->rate = cfg->rate;
+      port->subport_rate = clib_min (cfg->subport_rate, cfg->rate);
+      port->pipe_rate = clib_min (cfg->pipe_rate, port->subport_rate);
+      port->n_subports = cfg->n_subports;
+      port->n_pipes_per_subport = cfg->n_pipes_per_subport;
+      port->queue_size = cfg->queue_size;
+      port->pipe_shift = cfg->pipe_shift;
+
+      now = vlib_time_now (vm);
+      vec_validate_aligned (port->per_thread, vlib_get_n_threads () - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_foreach (pt, port->per_thread)
+	hqos_port_thread_init (port, pt, now);
+
+      hm->port_index_by_sw_if_index[sw_if_index] = port - hm->ports;
+      vnet_feature_enable_disable ("interface-output", "hqos-enqueue",
+				   sw_if_index, 1, 0, 0);
+    }
+  else
+    {
+      if (port_index == ~0)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+      vlib_worker_thread_barrier_sync (vm);
+
+      vnet_feature_enable_disable ("interface-output", "hqos-enqueue",
+				   sw_if_index, 0, 0, 0);
+      hm->port_index_by_sw_if_index[sw_if_index] = ~0;
+
+      /* queued packets are dropped with the port */
+      port = pool_elt_at_index (hm->ports, port_index);
+      vec_foreach (pt, port->per_thread)
+	hqos_port_thread_free (vm, pt);
+      vec_free (port->per_thread);
+      pool_put (hm->ports, port);
+    }
+
+  hqos_update_dequeue_state (hm);
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+int
+hqos_pipe_config (u32 sw_if_index, u32 pipe, f64 rate, u16 weight)
+{
+  hqos_main_t *hm = &hqos_main;
+  hqos_port_thread_t *pt;
+  hqos_port_t *port;
+  hqos_pipe_t *pp;
+  u32 port_index;
+
+  if (sw_if_index >= vec_len (hm->port_index_by_sw_if_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  port_index = hm->port_index_by_sw_if_index[sw_if_index];
+  if (port_index == ~0)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  port = pool_elt_at_index (hm->ports, port_index);
+  if (pipe >= port->n_subports * port->n_pipes_per_subport)
+    return VNET_API_ERROR_INVALID_VALUE;
+  if (rate <= 0 || weight == 0)
+    return VNET_API_ERROR_INVALID_VALUE_2;
+
+  vec_foreach (pt, port->per_thread)
+    {
+      pp = vec_elt_at_index (pt->pipes, pipe);
+      pp->shaper.rate = clib_min (rate, port->subport_rate);
+      pp->shaper.burst =
+	clib_max (pp->shaper.rate * HQOS_BURST_TIME, HQOS_BURST_MIN);
+      pp->shaper.tokens = clib_min (pp->shaper.tokens, pp->shaper.burst);
+      pp->weight = pp->credit = weight;
+    }
+
+  return 0;
+}
+
+int
+hqos_dscp_tc_set (u8 dscp, u8 tc)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  if (dscp >= ARRAY_LEN (hm->tc_by_dscp) || tc >= HQOS_N_TC)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  hm->tc_by_dscp[dscp] = tc;
+  return 0;
+}
+
+static clib_error_t *
+hqos_sw_interface_add_del (vnet_main_t *vnm, u32 sw_if_index, u32 is_add)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  if (!is_add && sw_if_index < vec_len (hm->port_index_by_sw_if_index) &&
+      hm->port_index_by_sw_if_index[sw_if_index] != ~0)
+    hqos_port_add_del (sw_if_index, 0, 0);
+
+  return 0;
+}
+
+VNET_SW_INTERFACE_ADD_DEL_FUNCTION (hqos_sw_interface_add_del);
+
+static clib_error_t *
+hqos_init (vlib_main_t *vm)
+{
+  hqos_main_t *hm = &hqos_main;
+  int dscp;
+
+  hm->log_class = vlib_log_register_class ("hqos", 0);
+
+  /* the class selector bits pick the class, network control first */
+  for (dscp = 0; dscp < ARRAY_LEN (hm->tc_by_dscp); dscp++)
+    hm->tc_by_dscp[dscp] = (HQOS_N_TC - 1) - (dscp >> 4);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (hqos_init);
+
+VNET_FEATURE_INIT (hqos_enqueue, static) = {
+  .arc_name = "interface-output",
+  .node_name = "hqos-enqueue",
+  .runs_before = VNET_FEATURES ("interface-output-arc-end"),
+};
+
+VLIB_PLUGIN_REGISTER () = {
+  .version = VPP_BUILD_VER,
+  .description = "Hierarchical QoS egress scheduler",
+};
@@ -0,0 +1,173 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#ifndef __included_hqos_h__
+#define __included_hqos_h__
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vppinfra/bitmap.h>
+#include <vppinfra/fifo.h>
+
+/*
+ * Hierarchical egress scheduler.
+ *
+ * Packets leaving an interface are classified to a pipe (a subscriber)
+ * and to one of HQOS_N_TC traffic classes, and queued. A dequeue node then
+ * serves the queues through three levels of token bucket shapers:
+ *
+ *   port -> subport -> pipe -> traffic class
+ *
+ * Subports of a port and pipes of a subport are served weighted round
+ * robin, traffic classes within a pipe in strict priority, TC 0 first.
+ *
+ * Each thread that transmits on the port runs its own instance of the
+ * hierarchy, just like it owns its own tx queue, so neither enqueue nor
+ * dequeue take a lock. Configured rates therefore apply per tx thread.
+ *
+ * A port is configured on an ethernet hardware interface. Packets sent
+ * through its sub-interfaces run the interface-output arc of the
+ * sub-interface and are not shaped.
+ */
+
+#define HQOS_N_TC 4
+
+/* preamble, start of frame delimiter, inter-frame gap and FCS */
+#define HQOS_FRAME_OVERHEAD 24
+
+#define HQOS_DEFAULT_QUEUE_SIZE 64
+
+/* token bucket depth, in seconds worth of rate, and its lower bound */
+#define HQOS_BURST_TIME	 1e-3
+#define HQOS_BURST_MIN	 (2 * 1514)
+
+typedef struct
+{
+  /* bytes, may go negative by up to one packet */
+  f64 tokens;
+  /* bytes per second */
+  f64 rate;
+  f64 burst;
+  f64 last_update;
+} hqos_bucket_t;
+
+typedef struct
+{
+  hqos_bucket_t shaper;
+  /* clib_fifo of buffer indices per traffic class */
+  u32 *queues[HQOS_N_TC];
+  /* packets served per round robin visit, and left in this visit */
+  u16 weight;
+  u16 credit;
+} hqos_pipe_t;
+
+typedef struct
+{
+  hqos_bucket_t shaper;
+  /* pipes, relative to the subport, with packets queued */
+  uword *active_pipes;
+  u32 pipe_cursor;
+} hqos_subport_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  hqos_bucket_t shaper;
+  hqos_subport_t *subports;
+  hqos_pipe_t *pipes;
+  uword *active_subports;
+  u32 subport_cursor;
+  u32 n_queued;
+
+  /* served packets and bytes per traffic class */
+  u64 tx_packets[HQOS_N_TC];
+  u64 tx_bytes[HQOS_N_TC];
+  u64 drops[HQOS_N_TC];
+
+  /*
+   * when the first and the last dequeue serving packets ran, and the bytes
+   * served by the first, which spent the initial burst, to tell the rate
+   * the shapers actually let through
+   */
+  f64 first_tx_time;
+  f64 last_tx_time;
+  u64 first_tx_bytes;
+} hqos_port_thread_t;
+
+typedef struct
+{
+  u32 sw_if_index;
+
+  /* bytes per second */
+  f64 rate;
+  f64 subport_rate;
+  f64 pipe_rate;
+
+  u32 n_subports;
+  u32 n_pipes_per_subport;
+  u32 queue_size;
+
+  /* pipe = (destination address >> pipe_shift) % number of pipes */
+  u8 pipe_shift;
+
+  hqos_port_thread_t *per_thread;
+} hqos_port_t;
+
+typedef struct
+{
+  hqos_port_t *ports;
+  u32 *port_index_by_sw_if_index;
+
+  /* DSCP to traffic class */
+  u8 tc_by_dscp[64];
+
+  vlib_log_class_t log_class;
+  u16 msg_id_base;
+} hqos_main_t;
+
+typedef struct
+{
+  f64 rate;
+  f64 subport_rate;
+  f64 pipe_rate;
+  u32 n_subports;
+  u32 n_pipes_per_subport;
+  u32 queue_size;
+  u8 pipe_shift;
+} hqos_port_config_t;
+
+extern hqos_main_t hqos_main;
+
+extern vlib_node_registration_t hqos_enqueue_node;
+extern vlib_node_registration_t hqos_dequeue_node;
+
+int hqos_port_add_del (u32 sw_if_index, const hqos_port_config_t *cfg,
+		       int is_add);
+int hqos_pipe_config (u32 sw_if_index, u32 pipe, f64 rate, u16 weight);
+int hqos_dscp_tc_set (u8 dscp, u8 tc);
+
+format_function_t format_hqos_port;
+unformat_function_t unformat_hqos_rate;
+
+static_always_inline void
+hqos_bucket_refill (hqos_bucket_t *b, f64 now)
+{
+  b->tokens += (now - b->last_update) * b->rate;
+  if (b->tokens > b->burst)
+    b->tokens = b->burst;
+  b->last_update = now;
+}
+
+/* lower *wait to the time until an overdrawn bucket holds tokens again */
+static_always_inline void
+hqos_bucket_wait (hqos_bucket_t *b, f64 *wait)
+{
+  f64 dt = -b->tokens / b->rate;
+
+  if (dt < *wait)
+    *wait = dt;
+}
+
+#endif /* __included_hqos_h__ */
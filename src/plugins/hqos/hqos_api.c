@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vnet/vnet.h>
+#include <vlibapi/api.h>
+#include <vlibmemory/api.h>
+#include <hqos/hqos.h>
+
+#include <hqos/hqos.api_enum.h>
+#include <hqos/hqos.api_types.h>
+
+#define REPLY_MSG_ID_BASE hm->msg_id_base
+#include <vlibapi/api_helper_macros.h>
+
+static void
+vl_api_hqos_port_enable_disable_t_handler (
+  vl_api_hqos_port_enable_disable_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_port_enable_disable_reply_t *rmp;
+  hqos_port_config_t cfg = {};
+  u32 sw_if_index;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  sw_if_index = ntohl (mp->sw_if_index);
+
+  /* rates are given in bits per second, the same defaults as the CLI */
+  cfg.rate = clib_net_to_host_u64 (mp->rate) / 8.0;
+  cfg.subport_rate = clib_net_to_host_u64 (mp->subport_rate) / 8.0;
+  cfg.pipe_rate = clib_net_to_host_u64 (mp->pipe_rate) / 8.0;
+  if (cfg.subport_rate == 0)
+    cfg.subport_rate = cfg.rate;
+  if (cfg.pipe_rate == 0)
+    cfg.pipe_rate = cfg.subport_rate;
+  cfg.n_subports = clib_max (ntohl (mp->n_subports), 1);
+  cfg.n_pipes_per_subport = clib_max (ntohl (mp->n_pipes_per_subport), 1);
+  cfg.queue_size = ntohl (mp->queue_size);
+  if (cfg.queue_size == 0)
+    cfg.queue_size = HQOS_DEFAULT_QUEUE_SIZE;
+  cfg.pipe_shift = mp->pipe_shift;
+
+  if (cfg.pipe_shift > 31)
+    rv = VNET_API_ERROR_INVALID_VALUE_3;
+  else
+    rv = hqos_port_add_del (sw_if_index, &cfg, mp->enable);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_HQOS_PORT_ENABLE_DISABLE_REPLY);
+}
+
+static void
+vl_api_hqos_pipe_config_t_handler (vl_api_hqos_pipe_config_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_pipe_config_reply_t *rmp;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = hqos_pipe_config (ntohl (mp->sw_if_index), ntohl (mp->pipe),
+			 clib_net_to_host_u64 (mp->rate) / 8.0,
+			 ntohs (mp->weight));
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_HQOS_PIPE_CONFIG_REPLY);
+}
+
+static void
+vl_api_hqos_dscp_tc_set_t_handler (vl_api_hqos_dscp_tc_set_t *mp)
+{
+  hqos_main_t *hm = &hqos_main;
+  vl_api_hqos_dscp_tc_set_reply_t *rmp;
+  int rv;
+
+  rv = hqos_dscp_tc_set (mp->dscp, mp->tc);
+
+  REPLY_MACRO (VL_API_HQOS_DSCP_TC_SET_REPLY);
+}
+
+#include <vnet/format_fns.h>
+#include <hqos/hqos.api.c>
+
+static clib_error_t *
+hqos_api_init (vlib_main_t *vm)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  hm->msg_id_base = setup_message_id_table ();
+  return 0;
+}
+
+VLIB_API_INIT_FUNCTION (hqos_api_init);
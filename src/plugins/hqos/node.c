@@ -0,0 +1,440 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip4_packet.h>
+#include <vnet/ip/ip6_packet.h>
+#include <hqos/hqos.h>
+
+#define foreach_hqos_enqueue_error                                            \
+  _ (QUEUED, queued, INFO, "packets queued")                                  \
+  _ (QUEUE_FULL, queue_full, ERROR, "traffic class queue full")
+
+typedef enum
+{
+#define _(f, n, s, d) HQOS_ENQUEUE_ERROR_##f,
+  foreach_hqos_enqueue_error
+#undef _
+    HQOS_ENQUEUE_N_ERROR,
+} hqos_enqueue_error_t;
+
+static vlib_error_desc_t hqos_enqueue_error_counters[] = {
+#define _(f, n, s, d) { #n, d, VL_COUNTER_SEVERITY_##s },
+  foreach_hqos_enqueue_error
+#undef _
+};
+
+typedef enum
+{
+  HQOS_ENQUEUE_NEXT_DROP,
+  HQOS_ENQUEUE_N_NEXT,
+} hqos_enqueue_next_t;
+
+#define foreach_hqos_dequeue_error                                            \
+  _ (SHAPER_WAIT, shaper_wait, INFO, "waits for shaper tokens")
+
+typedef enum
+{
+#define _(f, n, s, d) HQOS_DEQUEUE_ERROR_##f,
+  foreach_hqos_dequeue_error
+#undef _
+    HQOS_DEQUEUE_N_ERROR,
+} hqos_dequeue_error_t;
+
+static vlib_error_desc_t hqos_dequeue_error_counters[] = {
+#define _(f, n, s, d) { #n, d, VL_COUNTER_SEVERITY_##s },
+  foreach_hqos_dequeue_error
+#undef _
+};
+
+typedef enum
+{
+  HQOS_DEQUEUE_NEXT_TX,
+  HQOS_DEQUEUE_N_NEXT,
+} hqos_dequeue_next_t;
+
+typedef struct
+{
+  u32 sw_if_index;
+  u32 pipe;
+  u8 tc;
+  u8 dropped;
+} hqos_enqueue_trace_t;
+
+static u8 *
+format_hqos_enqueue_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  hqos_enqueue_trace_t *t = va_arg (*args, hqos_enqueue_trace_t *);
+
+  s = format (s, "HQOS: sw_if_index %d pipe %u tc %u%s", t->sw_if_index,
+	      t->pipe, t->tc, t->dropped ? " queue full" : "");
+  return s;
+}
+
+/*
+ * Pick the pipe from the destination address and the traffic class from
+ * the DSCP. Anything that is not IP goes to the lowest class of pipe 0.
+ */
+static_always_inline void
+hqos_classify (hqos_main_t *hm, hqos_port_t *port, vlib_buffer_t *b,
+	       u32 *pipe, u8 *tc)
+{
+  ethernet_header_t *eh = vlib_buffer_get_current (b);
+  u8 *l3 = (u8 *) (eh + 1);
+  u16 type = eh->type;
+  u32 addr;
+
+  if (type == clib_host_to_net_u16 (ETHERNET_TYPE_VLAN))
+    {
+      type = ((ethernet_vlan_header_t *) l3)->type;
+      l3 += sizeof (ethernet_vlan_header_t);
+    }
+
+  if (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP4))
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) l3;
+      addr = clib_net_to_host_u32 (ip4->dst_address.as_u32);
+      *tc = hm->tc_by_dscp[ip4_header_get_dscp (ip4)];
+    }
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP6))
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) l3;
+      addr = clib_net_to_host_u32 (ip6->dst_address.as_u32[3]);
+      *tc = hm->tc_by_dscp[ip6_traffic_class_network_order (ip6) >> 2];
+    }
+  else
+    {
+      *pipe = 0;
+      *tc = HQOS_N_TC - 1;
+      return;
+    }
+
+  *pipe = (addr >> port->pipe_shift) %
+	  (port->n_subports * port->n_pipes_per_subport);
+}
+
+VLIB_NODE_FN (hqos_enqueue_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  hqos_main_t *hm = &hqos_main;
+  clib_thread_index_t thread_index = vm->thread_index;
+  u32 drops[VLIB_FRAME_SIZE], n_drops = 0;
+  u32 *from, n_left, n_queued;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left > 0)
+    {
+      hqos_port_thread_t *pt;
+      hqos_port_t *port;
+      hqos_pipe_t *pp;
+      u32 sw_if_index, pipe, subport;
+      u8 tc, dropped = 0;
+
+      if (n_left > 2)
+	{
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  clib_prefetch_load (b[1]->data + b[1]->current_data);
+	}
+
+      sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_TX];
+      port = pool_elt_at_index (hm->ports,
+				hm->port_index_by_sw_if_index[sw_if_index]);
+      pt = vec_elt_at_index (port->per_thread, thread_index);
+
+      hqos_classify (hm, port, b[0], &pipe, &tc);
+      pp = vec_elt_at_index (pt->pipes, pipe);
+
+      if (PREDICT_FALSE (clib_fifo_elts (pp->queues[tc]) >= port->queue_size))
+	{
+	  b[0]->error = node->errors[HQOS_ENQUEUE_ERROR_QUEUE_FULL];
+	  drops[n_drops++] = from[0];
+	  pt->drops[tc]++;
+	  dropped = 1;
+	}
+      else
+	{
+	  clib_fifo_add1 (pp->queues[tc], from[0]);
+	  subport = pipe / port->n_pipes_per_subport;
+	  pt->subports[subport].active_pipes =
+	    clib_bitmap_set (pt->subports[subport].active_pipes,
+			     pipe % port->n_pipes_per_subport, 1);
+	  pt->active_subports =
+	    clib_bitmap_set (pt->active_subports, subport, 1);
+	  pt->n_queued++;
+	}
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  hqos_enqueue_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->sw_if_index = sw_if_index;
+	  t->pipe = pipe;
+	  t->tc = tc;
+	  t->dropped = dropped;
+	}
+
+      from++;
+      b++;
+      n_left--;
+    }
+
+  n_queued = frame->n_vectors - n_drops;
+  if (n_queued)
+    vlib_node_set_interrupt_pending (vm, hqos_dequeue_node.index);
+  if (n_drops)
+    vlib_buffer_enqueue_to_single_next (vm, node, drops,
+					HQOS_ENQUEUE_NEXT_DROP, n_drops);
+  vlib_node_increment_counter (vm, node->node_index, HQOS_ENQUEUE_ERROR_QUEUED,
+			       n_queued);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (hqos_enqueue_node) = {
+  .name = "hqos-enqueue",
+  .vector_size = sizeof (u32),
+  .format_trace = format_hqos_enqueue_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = HQOS_ENQUEUE_N_ERROR,
+  .error_counters = hqos_enqueue_error_counters,
+
+  .n_next_nodes = HQOS_ENQUEUE_N_NEXT,
+  .next_nodes = {
+    [HQOS_ENQUEUE_NEXT_DROP] = "error-drop",
+  },
+};
+
+/*
+ * Serve the pipes of one subport, round robin from where the last call
+ * left off. Returns 0 once the port shaper or the frame is exhausted, so
+ * the caller stops, and 1 if the next subport may be served. *wait is
+ * lowered to when the subport or a pipe left with packets has tokens again.
+ */
+static_always_inline int
+hqos_serve_subport (vlib_main_t *vm, hqos_port_t *port, hqos_port_thread_t *pt,
+		    u32 subport, f64 now, u32 *to, u32 *n_tx, u32 max_tx,
+		    f64 *wait)
+{
+  hqos_subport_t *sp = vec_elt_at_index (pt->subports, subport);
+  u32 first = subport * port->n_pipes_per_subport;
+  u32 start = sp->pipe_cursor, i;
+  int wrapped = 0;
+
+  hqos_bucket_refill (&sp->shaper, now);
+
+  i = clib_bitmap_next_set (sp->active_pipes, start);
+  while (1)
+    {
+      hqos_pipe_t *pp;
+      int tc;
+
+      if (i == ~0 && !wrapped)
+	{
+	  wrapped = 1;
+	  i = clib_bitmap_first_set (sp->active_pipes);
+	}
+      if (i == ~0 || (wrapped && i >= start))
+	break;
+
+      pp = vec_elt_at_index (pt->pipes, first + i);
+      hqos_bucket_refill (&pp->shaper, now);
+
+      while (pp->credit && pp->shaper.tokens > 0)
+	{
+	  vlib_buffer_t *b;
+	  u32 bi, len;
+
+	  if (sp->shaper.tokens <= 0 || pt->shaper.tokens <= 0 ||
+	      *n_tx == max_tx)
+	    {
+	      sp->pipe_cursor = i;
+	      if (sp->shaper.tokens <= 0)
+		hqos_bucket_wait (&sp->shaper, wait);
+	      return sp->shaper.tokens <= 0 && pt->shaper.tokens > 0 &&
+		     *n_tx < max_tx;
+	    }
+
+	  /* strict priority between the traffic classes */
+	  for (tc = 0; tc < HQOS_N_TC; tc++)
+	    if (clib_fifo_elts (pp->queues[tc]))
+	      break;
+	  if (tc == HQOS_N_TC)
+	    break;
+
+	  clib_fifo_sub1 (pp->queues[tc], bi);
+	  b = vlib_get_buffer (vm, bi);
+	  len = vlib_buffer_length_in_chain (vm, b) + HQOS_FRAME_OVERHEAD;
+
+	  pp->shaper.tokens -= len;
+	  sp->shaper.tokens -= len;
+	  pt->shaper.tokens -= len;
+	  pt->tx_packets[tc]++;
+	  pt->tx_bytes[tc] += len;
+	  pt->n_queued--;
+	  pp->credit--;
+	  to[(*n_tx)++] = bi;
+	}
+
+      /* the pipe used its weight, or ran dry, move on */
+      pp->credit = pp->weight;
+      for (tc = 0; tc < HQOS_N_TC; tc++)
+	if (clib_fifo_elts (pp->queues[tc]))
+	  break;
+      if (tc == HQOS_N_TC)
+	sp->active_pipes = clib_bitmap_set (sp->active_pipes, i, 0);
+      else if (pp->shaper.tokens <= 0)
+	hqos_bucket_wait (&pp->shaper, wait);
+
+      i = clib_bitmap_next_set (sp->active_pipes, i + 1);
+    }
+
+  sp->pipe_cursor = 0;
+  return 1;
+}
+
+/*
+ * Serve the subports of a port in passes, each pass visiting every active
+ * subport once from where the previous one left off, until the frame is
+ * full, the port shaper runs dry or a pass makes no progress.
+ */
+static_always_inline u32
+hqos_serve_port (vlib_main_t *vm, hqos_port_t *port, hqos_port_thread_t *pt,
+		 f64 now, u32 *to, u32 max_tx, f64 *wait)
+{
+  u32 start, i, n_tx = 0, n_last;
+  int wrapped;
+
+  hqos_bucket_refill (&pt->shaper, now);
+
+  do
+    {
+      n_last = n_tx;
+      start = pt->subport_cursor;
+      wrapped = 0;
+
+      i = clib_bitmap_next_set (pt->active_subports, start);
+      while (1)
+	{
+	  if (i == ~0 && !wrapped)
+	    {
+	      wrapped = 1;
+	      i = clib_bitmap_first_set (pt->active_subports);
+	    }
+	  if (i == ~0 || (wrapped && i >= start))
+	    break;
+
+	  if (!hqos_serve_subport (vm, port, pt, i, now, to, &n_tx, max_tx,
+				   wait))
+	    {
+	      /* resume this subport on the next call */
+	      pt->subport_cursor = i;
+	      goto done;
+	    }
+
+	  if (clib_bitmap_is_zero (pt->subports[i].active_pipes))
+	    pt->active_subports = clib_bitmap_set (pt->active_subports, i, 0);
+
+	  i = clib_bitmap_next_set (pt->active_subports, i + 1);
+	}
+
+      pt->subport_cursor = 0;
+    }
+  while (n_tx != n_last && n_tx < max_tx && pt->shaper.tokens > 0);
+
+done:
+  if (pt->shaper.tokens <= 0)
+    hqos_bucket_wait (&pt->shaper, wait);
+  return n_tx;
+}
+
+VLIB_NODE_FN (hqos_dequeue_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  hqos_main_t *hm = &hqos_main;
+  u32 to[VLIB_FRAME_SIZE], n_tx = 0, n_left = 0, n;
+  hqos_port_thread_t *pt;
+  hqos_port_t *port;
+  f64 now = 0, wait = CLIB_F64_MAX;
+
+  pool_foreach (port, hm->ports)
+    {
+      pt = vec_elt_at_index (port->per_thread, vm->thread_index);
+      if (pt->n_queued == 0)
+	continue;
+
+      if (now == 0)
+	now = vlib_time_now (vm);
+
+      n = 0;
+      if (n_tx < VLIB_FRAME_SIZE)
+	n = hqos_serve_port (vm, port, pt, now, to + n_tx,
+			     VLIB_FRAME_SIZE - n_tx, &wait);
+      if (n)
+	{
+	  if (pt->first_tx_time == 0)
+	    {
+	      int tc;
+
+	      pt->first_tx_time = now;
+	      for (tc = 0; tc < HQOS_N_TC; tc++)
+		pt->first_tx_bytes += pt->tx_bytes[tc];
+	    }
+	  pt->last_tx_time = now;
+	}
+      n_tx += n;
+      n_left += pt->n_queued;
+    }
+
+  /*
+   * Come back at once if packets are left because the frame filled up,
+   * otherwise when the first shaper holding packets back has tokens again,
+   * rather than spinning until it does. The extra tick keeps the rounding
+   * of the timer wheel from waking us up just before.
+   */
+  if (n_left)
+    {
+      if (n_tx == VLIB_FRAME_SIZE || wait == CLIB_F64_MAX)
+	vlib_node_set_interrupt_pending (vm, node->node_index);
+      else
+	{
+	  vlib_node_schedule (vm, node->node_index,
+			      wait + 1 / VLIB_TW_TICKS_PER_SECOND);
+	  vlib_node_increment_counter (vm, node->node_index,
+				       HQOS_DEQUEUE_ERROR_SHAPER_WAIT, 1);
+	}
+    }
+
+  if (n_tx)
+    vlib_buffer_enqueue_to_single_next (vm, node, to, HQOS_DEQUEUE_NEXT_TX,
+					n_tx);
+
+  return n_tx;
+}
+
+VLIB_REGISTER_NODE (hqos_dequeue_node) = {
+  .name = "hqos-dequeue",
+  .type = VLIB_NODE_TYPE_SCHED,
+
+  /* Interrupt driven or timed once a port is configured */
+  .state = VLIB_NODE_STATE_DISABLED,
+
+  .n_errors = HQOS_DEQUEUE_N_ERROR,
+  .error_counters = hqos_dequeue_error_counters,
+
+  .n_next_nodes = HQOS_DEQUEUE_N_NEXT,
+  .next_nodes = {
+    [HQOS_DEQUEUE_NEXT_TX] = "interface-output-arc-end",
+  },
+};
@@ -24,6 +24,7 @@
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 #include <vnet/tls/tls.h>
+#include <vnet/tls/tls_record.h>
 #include <ctype.h>
 #include <tlsopenssl/tls_openssl.h>
 #include <tlsopenssl/tls_bios.h>
@@ -75,14 +76,21 @@ openssl_ctx_free (tls_ctx_t * ctx)
       if (SSL_is_init_finished (oc->ssl) &&
 	  !(ctx->flags & TLS_CONN_F_PASSIVE_CLOSE))
 	{
-	  int rv = SSL_shutdown (oc->ssl);
-	  if (rv < 0)
-	    (void) SSL_get_error (oc->ssl, rv);
+	  if (openssl_records_active (oc))
+	    openssl_records_close (ctx);
+	  else
+	    {
+	      int rv = SSL_shutdown (oc->ssl);
+	      if (rv < 0)
+		(void) SSL_get_error (oc->ssl, rv);
+	    }
 	}
 
       if (openssl_main.async)
 	tls_async_evts_free_list (ctx);
 
+      openssl_records_free (oc);
+
       SSL_free (oc->ssl);
       vec_free (ctx->srv_hostname);
     }
@@ -227,15 +235,36 @@ openssl_write_from_fifo_into_ssl (svm_fifo_t *f, tls_ctx_t *ctx,
 				  transport_send_params_t *sp, u32 max_len)
 {
   int wrote = 0, rv, i = 0, len;
-  u32 n_segs = 2;
+  u32 n_segs = 2, rec_size, n_join;
   svm_fifo_seg_t fs[n_segs];
   openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
   SSL *ssl = oc->ssl;
+  u8 *buf;
 
   len = svm_fifo_segments (f, 0, fs, &n_segs, max_len);
   if (len <= 0)
     return 0;
 
+  /* A short first segment, where the fifo wraps, would be a short record.
+   * Write it together with the start of the next one from the thread's
+   * tx buffer. Not with async, that keeps the buffer past the call */
+  rec_size = openssl_record_size ();
+  if (n_segs == 2 && fs[0].len < rec_size && !openssl_main.async)
+    {
+      n_join = clib_min (rec_size - fs[0].len, fs[1].len);
+      buf = openssl_main.tx_bufs[ctx->c_thread_index];
+      vec_validate (buf, rec_size - 1);
+      openssl_main.tx_bufs[ctx->c_thread_index] = buf;
+      clib_memcpy_fast (buf, fs[0].data, fs[0].len);
+      clib_memcpy_fast (buf + fs[0].len, fs[1].data, n_join);
+      fs[0].data = buf;
+      fs[0].len += n_join;
+      fs[1].data += n_join;
+      fs[1].len -= n_join;
+      if (!fs[1].len)
+	n_segs = 1;
+    }
+
   while (wrote < len && i < n_segs)
     {
       rv = SSL_write (ssl, fs[i].data, fs[i].len);
@@ -354,6 +383,9 @@ openssl_ctx_handshake_rx (tls_ctx_t *ctx, session_t *tls_session)
   if (PREDICT_FALSE (ctx->flags & TLS_CONN_F_HS_DONE))
     return 0;
 
+  /* App data records from now on protected with vnet_crypto, if set up */
+  openssl_records_start (oc);
+
   /*
    * Handshake complete
    */
@@ -425,9 +457,14 @@ void
 openssl_confirm_app_close (tls_ctx_t *ctx)
 {
   openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
-  int rv = SSL_shutdown (oc->ssl);
-  if (rv < 0)
-    (void) SSL_get_error (oc->ssl, rv);
+  if (openssl_records_active (oc))
+    openssl_records_close (ctx);
+  else
+    {
+      int rv = SSL_shutdown (oc->ssl);
+      if (rv < 0)
+	(void) SSL_get_error (oc->ssl, rv);
+    }
   if (ctx->flags & TLS_CONN_F_SHUTDOWN_TRANSPORT)
     tls_shutdown_transport (ctx);
   else
@@ -453,6 +490,24 @@ openssl_ctx_write_tls (tls_ctx_t *ctx, session_t *app_session,
   f = app_session->tx_fifo;
 
   deq_max = svm_fifo_max_dequeue_cons (f);
+  if (!deq_max)
+    goto check_tls_fifo;
+
+  /* Hold the tail of short writes back while more may come to fill a
+   * record */
+  if (!(ctx->flags & TLS_CONN_F_APP_CLOSED))
+    {
+      deq_max = tls_record_coalesce (&oc->coalesce_start, deq_max,
+				     openssl_record_size (),
+				     openssl_main.coalesce_time,
+				     vlib_time_now (vlib_get_main ()));
+      if (!deq_max)
+	{
+	  app_session->flags |= SESSION_F_CUSTOM_TX;
+	  return 0;
+	}
+    }
+
   deq_max = clib_min (deq_max, space);
   if (!deq_max)
     goto check_tls_fifo;
@@ -466,7 +521,10 @@ openssl_ctx_write_tls (tls_ctx_t *ctx, session_t *app_session,
   if (svm_fifo_provision_chunks (ts->tx_fifo, 0, 0, deq_max + TLSO_CTRL_BYTES))
     goto check_tls_fifo;
 
-  wrote = openssl_write_from_fifo_into_ssl (f, ctx, sp, deq_max);
+  if (openssl_records_active (oc))
+    wrote = openssl_records_write (f, ctx, deq_max);
+  else
+    wrote = openssl_write_from_fifo_into_ssl (f, ctx, sp, deq_max);
 
   /* Unrecoverable protocol error. Reset connection */
   if (PREDICT_FALSE (wrote < 0))
@@ -597,7 +655,10 @@ openssl_ctx_read_tls (tls_ctx_t *ctx, session_t *tls_session)
   app_session = session_get_from_handle (ctx->app_session_handle);
   f = app_session->rx_fifo;
 
-  read = openssl_read_from_ssl_into_fifo (f, ctx, max_len);
+  if (openssl_records_active (oc))
+    read = openssl_records_read (f, ctx, max_len);
+  else
+    read = openssl_read_from_ssl_into_fifo (f, ctx, max_len);
 
   /* Unrecoverable protocol error. Reset connection */
   if (PREDICT_FALSE (read < 0))
@@ -904,7 +965,10 @@ openssl_init_client_ctx (clib_thread_index_t thread_index,
     }
 
   SSL_CTX_set_ecdh_auto (client_ssl_ctx, 1);
-  SSL_CTX_set_mode (client_ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE);
+  /* retried writes may come from the tx buffer or the fifo */
+  SSL_CTX_set_mode (client_ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE |
+		    SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  openssl_records_ssl_ctx_init (client_ssl_ctx);
 #ifdef HAVE_OPENSSL_ASYNC
   if (om->async)
     {
@@ -1084,6 +1148,7 @@ openssl_ctx_init_client (tls_ctx_t *ctx)
     }
 
   SSL_set_bio (oc->ssl, oc->wbio, oc->rbio);
+  openssl_records_alloc (oc);
   SSL_set_connect_state (oc->ssl);
 
   /*
@@ -1176,7 +1241,10 @@ openssl_start_listen (tls_ctx_t * lctx)
       return -1;
     }
 
-  SSL_CTX_set_mode (ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE);
+  /* retried writes may come from the tx buffer or the fifo */
+  SSL_CTX_set_mode (ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE |
+		    SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  openssl_records_ssl_ctx_init (ssl_ctx);
 #ifdef HAVE_OPENSSL_ASYNC
   if (om->async)
     {
@@ -1440,6 +1508,7 @@ openssl_ctx_init_server (tls_ctx_t * ctx)
     }
 
   SSL_set_bio (oc->ssl, oc->wbio, oc->rbio);
+  openssl_records_alloc (oc);
   SSL_set_accept_state (oc->ssl);
 
   TLS_DBG (1, "Initiating handshake for [%u]%u", ctx->c_thread_index,
@@ -1642,6 +1711,8 @@ tls_openssl_init (vlib_main_t * vm)
   vec_validate (om->ctx_pool, num_threads - 1);
   vec_validate (om->rx_bufs, num_threads - 1);
   vec_validate (om->tx_bufs, num_threads - 1);
+  vec_validate (om->records_bufs, num_threads - 1);
+  vec_validate (om->records_started, num_threads - 1);
   vec_validate (om->default_client_ssl_ctx, num_threads - 1);
   vec_validate (om->default_dtls_client_ssl_ctx, num_threads - 1);
 
@@ -1651,6 +1722,7 @@ tls_openssl_init (vlib_main_t * vm)
       vec_validate (om->tx_bufs[i], DTLSO_MAX_DGRAM);
     }
   tls_register_engine (&openssl_engine, CRYPTO_ENGINE_OPENSSL);
+  clib_rwlock_init (&om->crypto_keys_rw_lock);
 
   om->engine_init = 0;
 
@@ -1754,6 +1826,7 @@ tls_openssl_set_tls_fn (vlib_main_t *vm, unformat_input_t *input,
 			vlib_cli_command_t *cmd)
 {
   openssl_main_t *om = &openssl_main;
+  u32 usecs;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -1773,6 +1846,16 @@ tls_openssl_set_tls_fn (vlib_main_t *vm, unformat_input_t *input,
 	{
 	  clib_warning ("Using TLS max-pipelines of %d", om->max_pipelines);
 	}
+      else if (unformat (input, "coalesce-time %u", &usecs))
+	{
+	  om->coalesce_time = usecs * 1e-6;
+	  clib_warning ("Holding short TLS writes for up to %uus", usecs);
+	}
+      else if (unformat (input, "vnet-crypto-records"))
+	{
+	  om->records = 1;
+	  clib_warning ("Protecting TLS 1.3 records with vnet crypto");
+	}
       else
 	return clib_error_return (0, "failed: unknown input `%U'",
 				  format_unformat_error, input);
@@ -1784,10 +1867,35 @@ tls_openssl_set_tls_fn (vlib_main_t *vm, unformat_input_t *input,
 VLIB_CLI_COMMAND (tls_openssl_set_tls, static) = {
   .path = "tls openssl set-tls",
   .short_help = "tls openssl set-tls [record-size <size>] [record-split-size "
-		"<size>] [max-pipelines <size>]",
+		"<size>] [max-pipelines <size>] [coalesce-time <usec>] "
+		"[vnet-crypto-records]",
   .function = tls_openssl_set_tls_fn,
 };
 
+static clib_error_t *
+show_tls_openssl_records_fn (vlib_main_t *vm, unformat_input_t *input,
+			     vlib_cli_command_t *cmd)
+{
+  openssl_main_t *om = &openssl_main;
+  u64 n_started = 0;
+  u32 i;
+
+  vec_foreach_index (i, om->records_started)
+    n_started += om->records_started[i];
+
+  vlib_cli_output (vm, "vnet crypto records: %s",
+		   om->records ? "enabled" : "disabled");
+  vlib_cli_output (vm, "connections handed over: %lu", n_started);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_tls_openssl_records, static) = {
+  .path = "show tls openssl records",
+  .short_help = "show tls openssl records",
+  .function = show_tls_openssl_records_fn,
+};
+
 VLIB_PLUGIN_REGISTER () = {
     .version = VPP_BUILD_VER,
     .description = "Transport Layer Security (TLS) Engine, OpenSSL Based",
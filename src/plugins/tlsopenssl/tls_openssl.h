@@ -23,12 +23,16 @@
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 #include <vnet/tls/tls.h>
+#include <vnet/tls/tls_record.h>
 
 #define TLSO_CTRL_BYTES 1000
 #define TLSO_MIN_ENQ_SPACE (1 << 16)
 
 #define DTLSO_MAX_DGRAM 2000
 
+/** records decrypted per call, when protected with vnet_crypto */
+#define TLSO_RECORDS_BATCH 32
+
 #define ossl_check_err_is_fatal(_ssl, _rv)                                    \
   if (PREDICT_FALSE (_rv < 0 && SSL_get_error (_ssl, _rv) == SSL_ERROR_SSL))  \
     return -1;
@@ -50,6 +54,21 @@ typedef struct tls_async_ctx_
   u32 total_async_write;
 } tls_async_ctx_t;
 
+/** TLS 1.3 records protected with vnet_crypto, see tls_records.c */
+typedef struct openssl_records_
+{
+  tls_record_crypto_t tx;
+  tls_record_crypto_t rx;
+  vnet_crypto_alg_t alg;
+  const EVP_MD *md;
+  u8 tx_secret[EVP_MAX_MD_SIZE];
+  u8 rx_secret[EVP_MAX_MD_SIZE];
+  u8 secret_len;
+  u8 flags;
+  u8 is_active; /**< handed over, OpenSSL no longer sees app data */
+  u8 rx_closed; /**< peer sent close notify */
+} openssl_records_t;
+
 typedef struct tls_ctx_openssl_
 {
   tls_ctx_t ctx;			/**< First */
@@ -59,6 +78,8 @@ typedef struct tls_ctx_openssl_
   BIO *rbio;
   BIO *wbio;
   app_crypto_async_req_ticket_t req_ticket;
+  f64 coalesce_start; /**< since when short writes are held */
+  openssl_records_t *records;
 } openssl_ctx_t;
 
 typedef struct tls_listen_ctx_opensl_
@@ -77,6 +98,7 @@ typedef struct openssl_main_
 
   u8 **rx_bufs;
   u8 **tx_bufs;
+  u8 **records_bufs;
 
   /* API message ID base */
   u16 msg_id_base;
@@ -88,8 +110,27 @@ typedef struct openssl_main_
   u32 record_size;
   u32 record_split_size;
   u32 max_pipelines;
+  f64 coalesce_time; /**< how long short writes may be held, 0 is off */
+  u8 records;	      /**< protect TLS 1.3 records with vnet_crypto */
+  u64 *records_started; /**< per thread, connections handed over */
+  clib_rwlock_t crypto_keys_rw_lock;
 } openssl_main_t;
 
+extern openssl_main_t openssl_main;
+
+static inline u32
+openssl_record_size (void)
+{
+  return openssl_main.record_size ? openssl_main.record_size :
+				    TLS_FRAGMENT_MAX_LEN;
+}
+
+static inline u8
+openssl_records_active (openssl_ctx_t *oc)
+{
+  return oc->records && oc->records->is_active;
+}
+
 typedef int openssl_resume_handler (void *event, void *session);
 typedef int (*async_handlers) (void *event, void *session);
 
@@ -117,6 +158,14 @@ int tls_async_handshake_event_handler (void *event, void *session);
 int openssl_ctx_read_tls (tls_ctx_t *ctx, session_t *tls_session);
 void tls_async_evts_init_list (tls_async_ctx_t *ctx);
 void tls_async_evts_free_list (tls_ctx_t *ctx);
+
+void openssl_records_ssl_ctx_init (SSL_CTX *ssl_ctx);
+void openssl_records_alloc (openssl_ctx_t *oc);
+void openssl_records_start (openssl_ctx_t *oc);
+void openssl_records_free (openssl_ctx_t *oc);
+void openssl_records_close (tls_ctx_t *ctx);
+int openssl_records_read (svm_fifo_t *f, tls_ctx_t *ctx, u32 max_len);
+int openssl_records_write (svm_fifo_t *f, tls_ctx_t *ctx, u32 max_len);
 #endif /* SRC_PLUGINS_TLSOPENSSL_TLS_OPENSSL_H_ */
 
 /*
@@ -0,0 +1,532 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <openssl/ssl.h>
+#include <openssl/kdf.h>
+#include <vnet/session/application_interface.h>
+#include <vnet/tls/tls_record.h>
+#include <tlsopenssl/tls_openssl.h>
+
+/*
+ * TLS 1.3 record protection with vnet_crypto. OpenSSL does the handshake,
+ * its traffic secrets are taken from the key log callback, and once the
+ * handshake is done app data is protected with tls_record_encrypt/decrypt
+ * a batch of records at a time instead of through SSL_write/SSL_read.
+ * The sequence numbers at handover are counted with the message callback,
+ * e.g., the server may already have sent session tickets. Connections
+ * that can't be handed over, like TLS 1.2 or other ciphers, stay with
+ * OpenSSL.
+ */
+
+#define OPENSSL_RECORDS_F_TX_SECRET   (1 << 0)
+#define OPENSSL_RECORDS_F_RX_SECRET   (1 << 1)
+#define OPENSSL_RECORDS_F_TX_FINISHED (1 << 2)
+#define OPENSSL_RECORDS_F_RX_FINISHED (1 << 3)
+#define OPENSSL_RECORDS_F_HANDOVER                                            \
+  (OPENSSL_RECORDS_F_TX_SECRET | OPENSSL_RECORDS_F_RX_SECRET |              \
+   OPENSSL_RECORDS_F_TX_FINISHED | OPENSSL_RECORDS_F_RX_FINISHED)
+
+/* rfc8446#section-6, alerts are a level and a description */
+#define OPENSSL_RECORDS_ALERT_CLOSE_NOTIFY  0
+#define OPENSSL_RECORDS_ALERT_USER_CANCELED 90
+
+static void
+openssl_records_keylog_cb (const SSL *ssl, const char *line)
+{
+  openssl_records_t *rec = SSL_get_app_data (ssl);
+  unformat_input_t input;
+  u8 *random = 0, *secret = 0;
+  u8 is_server, is_client_secret, is_tx;
+
+  if (!rec)
+    return;
+
+  unformat_init_string (&input, (char *) line, strlen (line));
+  if (unformat (&input, "CLIENT_TRAFFIC_SECRET_0 %U %U", unformat_hex_string,
+		&random, unformat_hex_string, &secret))
+    is_client_secret = 1;
+  else if (unformat (&input, "SERVER_TRAFFIC_SECRET_0 %U %U",
+		     unformat_hex_string, &random, unformat_hex_string,
+		     &secret))
+    is_client_secret = 0;
+  else
+    goto done;
+
+  if (vec_len (secret) > sizeof (rec->tx_secret))
+    goto done;
+
+  is_server = SSL_is_server ((SSL *) ssl);
+  is_tx = is_server != is_client_secret;
+  clib_memcpy_fast (is_tx ? rec->tx_secret : rec->rx_secret, secret,
+		    vec_len (secret));
+  rec->secret_len = vec_len (secret);
+  rec->flags |=
+    is_tx ? OPENSSL_RECORDS_F_TX_SECRET : OPENSSL_RECORDS_F_RX_SECRET;
+
+done:
+  vec_free (random);
+  vec_free (secret);
+  unformat_free (&input);
+}
+
+/* Records after a side's finished message are protected with the traffic
+ * keys, count them to know where the sequence numbers are at handover */
+static void
+openssl_records_msg_cb (int write_p, int version, int content_type,
+			const void *buf, size_t len, SSL *ssl, void *arg)
+{
+  openssl_records_t *rec = SSL_get_app_data (ssl);
+  u32 finished;
+
+  if (!rec)
+    return;
+
+  finished =
+    write_p ? OPENSSL_RECORDS_F_TX_FINISHED : OPENSSL_RECORDS_F_RX_FINISHED;
+  if (content_type == SSL3_RT_HANDSHAKE && len &&
+      ((u8 *) buf)[0] == SSL3_MT_FINISHED)
+    rec->flags |= finished;
+  else if (content_type == SSL3_RT_HEADER && (rec->flags & finished))
+    {
+      if (write_p)
+	rec->tx.seq++;
+      else
+	rec->rx.seq++;
+    }
+}
+
+void
+openssl_records_ssl_ctx_init (SSL_CTX *ssl_ctx)
+{
+  if (openssl_main.records && !openssl_main.async)
+    SSL_CTX_set_keylog_callback (ssl_ctx, openssl_records_keylog_cb);
+}
+
+void
+openssl_records_alloc (openssl_ctx_t *oc)
+{
+  openssl_records_t *rec;
+
+  if (!openssl_main.records || openssl_main.async ||
+      oc->ctx.tls_type != TRANSPORT_PROTO_TLS)
+    return;
+
+  rec = clib_mem_alloc (sizeof (*rec));
+  clib_memset (rec, 0, sizeof (*rec));
+  oc->records = rec;
+  SSL_set_app_data (oc->ssl, rec);
+  SSL_set_msg_callback (oc->ssl, openssl_records_msg_cb);
+}
+
+static void
+openssl_records_detach (openssl_ctx_t *oc)
+{
+  SSL_set_msg_callback (oc->ssl, 0);
+  SSL_set_app_data (oc->ssl, 0);
+  clib_memset (oc->records, 0, sizeof (*oc->records));
+  clib_mem_free (oc->records);
+  oc->records = 0;
+}
+
+/* rfc8446#section-7.1, HKDF-Expand-Label with an empty context */
+static int
+openssl_records_expand_label (openssl_records_t *rec, u8 *secret,
+			      const char *label, u8 *out, u32 out_len)
+{
+  u8 info[2 + 1 + 255 + 1], *p = info;
+  u32 label_len = strlen (label);
+  size_t len = out_len;
+  EVP_PKEY_CTX *pctx;
+  int rv;
+
+  *p++ = out_len >> 8;
+  *p++ = out_len;
+  *p++ = 6 + label_len;
+  clib_memcpy_fast (p, "tls13 ", 6);
+  clib_memcpy_fast (p + 6, label, label_len);
+  p += 6 + label_len;
+  *p++ = 0;
+
+  pctx = EVP_PKEY_CTX_new_id (EVP_PKEY_HKDF, 0);
+  if (!pctx)
+    return -1;
+  rv = EVP_PKEY_derive_init (pctx) > 0 &&
+       EVP_PKEY_CTX_hkdf_mode (pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+       EVP_PKEY_CTX_set_hkdf_md (pctx, rec->md) > 0 &&
+       EVP_PKEY_CTX_set1_hkdf_key (pctx, secret, rec->secret_len) > 0 &&
+       EVP_PKEY_CTX_add1_hkdf_info (pctx, info, p - info) > 0 &&
+       EVP_PKEY_derive (pctx, out, &len) > 0;
+  EVP_PKEY_CTX_free (pctx);
+
+  return rv ? 0 : -1;
+}
+
+/* rfc8446#section-7.3, traffic keys of one direction */
+static int
+openssl_records_set_key (openssl_records_t *rec, u8 is_tx, u64 seq)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  tls_record_crypto_t *rc = is_tx ? &rec->tx : &rec->rx;
+  u8 *secret = is_tx ? rec->tx_secret : rec->rx_secret;
+  vlib_main_t *vm = vlib_get_main ();
+  u8 key[32], iv[TLS_RECORD_IV_LEN];
+  u32 key_len = cm->algs[rec->alg].key_length;
+  tls_record_error_t err;
+
+  if (openssl_records_expand_label (rec, secret, "key", key, key_len) ||
+      openssl_records_expand_label (rec, secret, "iv", iv, sizeof (iv)))
+    return -1;
+
+  clib_rwlock_writer_lock (&openssl_main.crypto_keys_rw_lock);
+  err = tls_record_crypto_init (vm, rc, rec->alg, is_tx, key, iv, seq);
+  clib_rwlock_writer_unlock (&openssl_main.crypto_keys_rw_lock);
+  clib_memset (key, 0, sizeof (key));
+
+  return err == TLS_RECORD_ERR_OK ? 0 : -1;
+}
+
+static void
+openssl_records_del_key (tls_record_crypto_t *rc)
+{
+  clib_rwlock_writer_lock (&openssl_main.crypto_keys_rw_lock);
+  tls_record_crypto_free (vlib_get_main (), rc);
+  clib_rwlock_writer_unlock (&openssl_main.crypto_keys_rw_lock);
+}
+
+void
+openssl_records_start (openssl_ctx_t *oc)
+{
+  openssl_records_t *rec = oc->records;
+  SSL *ssl = oc->ssl;
+
+  if (!rec)
+    return;
+
+  if ((rec->flags & OPENSSL_RECORDS_F_HANDOVER) !=
+	OPENSSL_RECORDS_F_HANDOVER ||
+      SSL_version (ssl) != TLS1_3_VERSION || SSL_has_pending (ssl))
+    goto no_handover;
+
+  switch (SSL_CIPHER_get_id (SSL_get_current_cipher (ssl)))
+    {
+    case TLS1_3_CK_AES_128_GCM_SHA256:
+      rec->alg = VNET_CRYPTO_ALG_AES_128_GCM;
+      rec->md = EVP_sha256 ();
+      break;
+    case TLS1_3_CK_AES_256_GCM_SHA384:
+      rec->alg = VNET_CRYPTO_ALG_AES_256_GCM;
+      rec->md = EVP_sha384 ();
+      break;
+    case TLS1_3_CK_CHACHA20_POLY1305_SHA256:
+      rec->alg = VNET_CRYPTO_ALG_CHACHA20_POLY1305;
+      rec->md = EVP_sha256 ();
+      break;
+    default:
+      goto no_handover;
+    }
+
+  if (rec->secret_len != EVP_MD_size (rec->md) ||
+      openssl_records_set_key (rec, 1 /* is_tx */, rec->tx.seq))
+    goto no_handover;
+  if (openssl_records_set_key (rec, 0 /* is_tx */, rec->rx.seq))
+    {
+      openssl_records_del_key (&rec->tx);
+      goto no_handover;
+    }
+
+  rec->is_active = 1;
+  SSL_set_msg_callback (ssl, 0);
+  openssl_main.records_started[oc->ctx.c_thread_index]++;
+  TLS_DBG (1, "Records of %u protected with %U", oc->openssl_ctx_index,
+	   format_vnet_crypto_alg, rec->alg);
+  return;
+
+no_handover:
+  openssl_records_detach (oc);
+}
+
+void
+openssl_records_free (openssl_ctx_t *oc)
+{
+  openssl_records_t *rec = oc->records;
+
+  if (!rec)
+    return;
+
+  if (rec->is_active)
+    {
+      openssl_records_del_key (&rec->tx);
+      openssl_records_del_key (&rec->rx);
+    }
+  openssl_records_detach (oc);
+}
+
+/* rfc8446#section-7.2, the next generation of a direction's secret */
+static int
+openssl_records_update_key (openssl_records_t *rec, u8 is_tx)
+{
+  u8 *secret = is_tx ? rec->tx_secret : rec->rx_secret;
+  u8 next[EVP_MAX_MD_SIZE];
+
+  if (openssl_records_expand_label (rec, secret, "traffic upd", next,
+				    rec->secret_len))
+    return -1;
+  clib_memcpy_fast (secret, next, rec->secret_len);
+  clib_memset (next, 0, sizeof (next));
+
+  openssl_records_del_key (is_tx ? &rec->tx : &rec->rx);
+  return openssl_records_set_key (rec, is_tx, 0);
+}
+
+static int
+openssl_records_send (tls_ctx_t *ctx, tls_record_type_t type, u8 *data,
+		      u32 len)
+{
+  openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
+  u8 buf[TLS13_RECORD_OVERHEAD + 8];
+  u32 n_read, n_written;
+  svm_msg_q_t *mq;
+  session_t *ts;
+
+  ASSERT (len <= 8);
+  ts = session_get_from_handle (ctx->tls_session_handle);
+  if (svm_fifo_max_enqueue_prod (ts->tx_fifo) < len + TLS13_RECORD_OVERHEAD)
+    return -1;
+
+  if (tls_record_encrypt (vlib_get_main (), &oc->records->tx, type, data,
+			  len, buf, sizeof (buf), len, &n_read, &n_written))
+    return -1;
+
+  mq = session_main_get_vpp_event_queue (ts->thread_index);
+  app_send_stream_raw (ts->tx_fifo, mq, buf, n_written, SESSION_IO_EVT_TX,
+		       1 /* do_evt */, 0 /* noblock */);
+  return 0;
+}
+
+void
+openssl_records_close (tls_ctx_t *ctx)
+{
+  u8 alert[2] = { 1 /* warning */, OPENSSL_RECORDS_ALERT_CLOSE_NOTIFY };
+
+  openssl_records_send (ctx, TLS_REC_ALERT, alert, sizeof (alert));
+}
+
+/*
+ * Handshake and alert records. After a session ticket, which is not kept,
+ * or a key update, decryption goes on. Returns 1 once the peer closed and
+ * -1 on errors.
+ */
+static int
+openssl_records_ctrl (tls_ctx_t *ctx, tls_record_desc_t *desc, u8 *data)
+{
+  openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
+  openssl_records_t *rec = oc->records;
+  u8 *p = data + desc->offset, *end = p + desc->len;
+  u8 key_update[5] = { TLS_HS_KEY_UPDATE, 0, 0, 1, 0 };
+  u32 len;
+
+  if (desc->type == TLS_REC_ALERT)
+    {
+      if (desc->len != 2)
+	return -1;
+      if (p[1] == OPENSSL_RECORDS_ALERT_CLOSE_NOTIFY)
+	{
+	  rec->rx_closed = 1;
+	  return 1;
+	}
+      return p[1] == OPENSSL_RECORDS_ALERT_USER_CANCELED ? 0 : -1;
+    }
+
+  if (desc->type != TLS_REC_HANDSHAKE)
+    return -1;
+
+  /* messages are not expected to span records */
+  while (p + sizeof (tls_handshake_msg_t) <= end)
+    {
+      len = tls_handshake_message_len ((tls_handshake_msg_t *) p);
+      if (p + sizeof (tls_handshake_msg_t) + len > end)
+	return -1;
+
+      switch (p[0])
+	{
+	case TLS_HS_NEW_SESSION_TICKET:
+	  break;
+	case TLS_HS_KEY_UPDATE:
+	  /* rfc8446#section-4.6.3, answer a request with our own update */
+	  if (len != 1 || p[4] > 1 ||
+	      openssl_records_update_key (rec, 0 /* is_tx */))
+	    return -1;
+	  if (p[4] &&
+	      (openssl_records_send (ctx, TLS_REC_HANDSHAKE, key_update,
+				     sizeof (key_update)) ||
+	       openssl_records_update_key (rec, 1 /* is_tx */)))
+	    return -1;
+	  break;
+	default:
+	  return -1;
+	}
+      p += sizeof (tls_handshake_msg_t) + len;
+    }
+
+  return p == end ? 0 : -1;
+}
+
+int
+openssl_records_read (svm_fifo_t *f, tls_ctx_t *ctx, u32 max_len)
+{
+  openssl_main_t *om = &openssl_main;
+  clib_thread_index_t thread_index = ctx->c_thread_index;
+  openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
+  openssl_records_t *rec = oc->records;
+  tls_record_desc_t descs[TLSO_RECORDS_BATCH];
+  u32 n, space, read = 0, wrote = 0, n_read, n_descs, i;
+  vlib_main_t *vm = vlib_get_main ();
+  u8 *src, *dst;
+  session_t *ts;
+
+  ts = session_get_from_handle (ctx->tls_session_handle);
+  n = clib_min (svm_fifo_max_dequeue_cons (ts->rx_fifo), max_len);
+  if (!n)
+    return 0;
+
+  /* nothing is delivered after the peer's close notify */
+  if (rec->rx_closed)
+    {
+      svm_fifo_dequeue_drop (ts->rx_fifo, n);
+      return 0;
+    }
+
+  space = svm_fifo_max_enqueue_prod (f);
+  if (!space)
+    return 0;
+
+  /* records may wrap in the fifo, decrypt from a linear copy */
+  src = om->rx_bufs[thread_index];
+  vec_validate (src, n - 1);
+  om->rx_bufs[thread_index] = src;
+  svm_fifo_peek (ts->rx_fifo, 0, n, src);
+
+  dst = om->records_bufs[thread_index];
+  vec_validate (dst, clib_min (n, space) - 1);
+  om->records_bufs[thread_index] = dst;
+
+  while (read < n && !rec->rx_closed)
+    {
+      n_descs = ARRAY_LEN (descs);
+      if (tls_record_decrypt (vm, &rec->rx, src + read, n - read, dst,
+			      clib_min (n, space - wrote), &n_read, descs,
+			      &n_descs))
+	return -1;
+      if (!n_descs)
+	break;
+
+      for (i = 0; i < n_descs; i++)
+	{
+	  if (descs[i].type == TLS_REC_APPLICATION_DATA)
+	    {
+	      svm_fifo_enqueue (f, descs[i].len, dst + descs[i].offset);
+	      wrote += descs[i].len;
+	    }
+	  else if (openssl_records_ctrl (ctx, descs + i, dst) < 0)
+	    return -1;
+	}
+      read += n_read;
+    }
+
+  svm_fifo_dequeue_drop (ts->rx_fifo, rec->rx_closed ? n : read);
+
+  if (svm_fifo_needs_deq_ntf (ts->rx_fifo, read))
+    {
+      svm_fifo_clear_deq_ntf (ts->rx_fifo);
+      session_program_transport_io_evt (ts->handle, SESSION_IO_EVT_RX);
+    }
+  if (svm_fifo_is_empty_cons (ts->rx_fifo))
+    svm_fifo_unset_event (ts->rx_fifo);
+
+  return wrote;
+}
+
+int
+openssl_records_write (svm_fifo_t *f, tls_ctx_t *ctx, u32 max_len)
+{
+  openssl_main_t *om = &openssl_main;
+  clib_thread_index_t thread_index = ctx->c_thread_index;
+  openssl_ctx_t *oc = (openssl_ctx_t *) ctx;
+  u32 n_segs = 2, n_bufs = 1, rec_size, n_join, n_read, n_written, buf_len;
+  u32 read = 0, wrote = 0, n, i;
+  vlib_main_t *vm = vlib_get_main ();
+  svm_fifo_seg_t fs[2], bufs[3];
+  svm_msg_q_t *mq;
+  u8 *join, *dst;
+  session_t *ts;
+  int len;
+
+  len = svm_fifo_segments (f, 0, fs, &n_segs, max_len);
+  if (len <= 0)
+    return 0;
+
+  /* Where the fifo wraps, the tail of the first segment goes in one record
+   * with the start of the next, as in openssl_write_from_fifo_into_ssl */
+  rec_size = openssl_record_size ();
+  bufs[0] = fs[0];
+  if (n_segs == 2)
+    {
+      n_join = fs[0].len % rec_size;
+      bufs[n_bufs++] = fs[1];
+      if (n_join)
+	{
+	  join = om->tx_bufs[thread_index];
+	  vec_validate (join, rec_size - 1);
+	  om->tx_bufs[thread_index] = join;
+	  bufs[0].len -= n_join;
+	  clib_memcpy_fast (join, bufs[0].data + bufs[0].len, n_join);
+	  n = clib_min (rec_size - n_join, fs[1].len);
+	  clib_memcpy_fast (join + n_join, fs[1].data, n);
+	  bufs[1].data = join;
+	  bufs[1].len = n_join + n;
+	  bufs[n_bufs].data = fs[1].data + n;
+	  bufs[n_bufs++].len = fs[1].len - n;
+	}
+    }
+
+  ts = session_get_from_handle (ctx->tls_session_handle);
+  buf_len = len + (len / rec_size + n_bufs) * TLS13_RECORD_OVERHEAD;
+  buf_len = clib_min (buf_len, svm_fifo_max_enqueue_prod (ts->tx_fifo));
+  dst = om->records_bufs[thread_index];
+  vec_validate (dst, buf_len);
+  om->records_bufs[thread_index] = dst;
+
+  for (i = 0; i < n_bufs; i++)
+    {
+      if (!bufs[i].len)
+	continue;
+      if (tls_record_encrypt (vm, &oc->records->tx, TLS_REC_APPLICATION_DATA,
+			      bufs[i].data, bufs[i].len, dst + wrote,
+			      buf_len - wrote, rec_size, &n_read, &n_written))
+	return -1;
+      read += n_read;
+      wrote += n_written;
+      if (n_read < bufs[i].len)
+	break;
+    }
+
+  if (!wrote)
+    return 0;
+
+  mq = session_main_get_vpp_event_queue (ts->thread_index);
+  app_send_stream_raw (ts->tx_fifo, mq, dst, wrote, SESSION_IO_EVT_TX,
+		       1 /* do_evt */, 0 /* noblock */);
+  svm_fifo_dequeue_drop (f, read);
+
+  return read;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/classify/vnet_classify.h>
+
+/* The tables match on the 4 bytes at this offset of the buffer data */
+#define CLASSIFY_TEST_KEY_OFFSET 12
+
+static u32
+classify_test_chain_create (vnet_classify_main_t *cm, u32 n_tables,
+			    u32 n_sessions)
+{
+  u32x4 mask = {}, key = {};
+  vnet_classify_table_t *t;
+  u32 i, head = ~0, *table_indices = 0;
+
+  mask[CLASSIFY_TEST_KEY_OFFSET / 4] = ~0;
+
+  for (i = 0; i < n_tables; i++)
+    {
+      t = vnet_classify_new_table (cm, (u8 *) &mask, 256, 4 << 20, 0, 1);
+      t->miss_next_index = ~0;
+      vec_add1 (table_indices, t - cm->tables);
+    }
+
+  /* link the chain back to front */
+  for (i = n_tables; i > 0; i--)
+    {
+      t = pool_elt_at_index (cm->tables, table_indices[i - 1]);
+      t->next_table_index = head;
+      head = table_indices[i - 1];
+    }
+
+  /* spread the sessions over the tables of the chain */
+  for (i = 0; i < n_sessions; i++)
+    {
+      key[CLASSIFY_TEST_KEY_OFFSET / 4] = i;
+      vnet_classify_add_del_session (cm, table_indices[i % n_tables],
+				     (u8 *) &key, 0, i, 0, 0, 0, 1);
+    }
+
+  vec_free (table_indices);
+  return head;
+}
+
+static clib_error_t *
+classify_test_chain (vlib_main_t *vm, u32 max_tables, u32 n_sessions,
+		     u32 n_iterations)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vlib_buffer_t *b[VLIB_FRAME_SIZE];
+  vnet_classify_entry_t *e[VLIB_FRAME_SIZE], *e0;
+  u32 bi[VLIB_FRAME_SIZE], table_index[VLIB_FRAME_SIZE];
+  u32 hash[VLIB_FRAME_SIZE];
+  clib_error_t *err = 0;
+  u32 n_tables, i, iter, head;
+  u64 t0, t1, walk, staged;
+
+  if (vlib_buffer_alloc (vm, bi, VLIB_FRAME_SIZE) != VLIB_FRAME_SIZE)
+    return clib_error_return (0, "buffer alloc failure");
+  vlib_get_buffers (vm, bi, b, VLIB_FRAME_SIZE);
+
+  /* every other packet hits, the rest walk the whole chain and miss */
+  for (i = 0; i < VLIB_FRAME_SIZE; i++)
+    {
+      clib_memset (b[i]->data, 0, 16);
+      *(u32 *) (b[i]->data + CLASSIFY_TEST_KEY_OFFSET) =
+	(i & 1) ? n_sessions + i : (i * 7) % n_sessions;
+    }
+
+  vlib_cli_output (vm, "%-8s%-16s%-16s", "tables", "walk clk/pkt",
+		   "staged clk/pkt");
+
+  for (n_tables = 1; n_tables <= max_tables; n_tables++)
+    {
+      head = classify_test_chain_create (cm, n_tables, n_sessions);
+
+      t0 = clib_cpu_time_now ();
+      for (iter = 0; iter < n_iterations; iter++)
+	for (i = 0; i < VLIB_FRAME_SIZE; i++)
+	  {
+	    vnet_classify_table_t *t = pool_elt_at_index (cm->tables, head);
+	    u8 *h;
+
+	    while (1)
+	      {
+		h = vnet_classify_get_packet_data (t, b[i]);
+		e[i] = vnet_classify_find_entry_inline (
+		  t, h, vnet_classify_hash_packet_inline (t, h), 0);
+		if (e[i] || t->next_table_index == ~0)
+		  break;
+		t = pool_elt_at_index (cm->tables, t->next_table_index);
+	      }
+	  }
+      t1 = clib_cpu_time_now ();
+      walk = t1 - t0;
+
+      t0 = clib_cpu_time_now ();
+      for (iter = 0; iter < n_iterations; iter++)
+	{
+	  for (i = 0; i < VLIB_FRAME_SIZE; i++)
+	    table_index[i] = head;
+	  vnet_classify_find_entries_chained (cm->tables, b, 0, table_index,
+					      hash, e, VLIB_FRAME_SIZE, 0);
+	}
+      t1 = clib_cpu_time_now ();
+      staged = t1 - t0;
+
+      /* both walks must agree, the packet's key says which one matches */
+      for (i = 0; i < VLIB_FRAME_SIZE; i++)
+	{
+	  u32 key = *(u32 *) (b[i]->data + CLASSIFY_TEST_KEY_OFFSET);
+
+	  e0 = e[i];
+	  if ((i & 1) ? e0 != 0 : (e0 == 0 || e0->opaque_index != key))
+	    {
+	      err = clib_error_return (0, "failed: %u tables, packet %u",
+				       n_tables, i);
+	      break;
+	    }
+	}
+
+      vnet_classify_delete_table_index (cm, head, 1 /* del_chain */);
+      if (err)
+	break;
+
+      vlib_cli_output (vm, "%-8u%-16.2f%-16.2f", n_tables,
+		       (f64) walk / (n_iterations * VLIB_FRAME_SIZE),
+		       (f64) staged / (n_iterations * VLIB_FRAME_SIZE));
+    }
+
+  vlib_buffer_free (vm, bi, VLIB_FRAME_SIZE);
+  return err;
+}
+
+static clib_error_t *
+classify_test (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd_arg)
+{
+  u32 max_tables = 16, n_sessions = 1024, n_iterations = 1000;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "tables %u", &max_tables))
+	;
+      else if (unformat (input, "sessions %u", &n_sessions))
+	;
+      else if (unformat (input, "iterations %u", &n_iterations))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (max_tables == 0 || n_sessions == 0 || n_iterations == 0)
+    return clib_error_return (0, "tables, sessions and iterations must be "
+				 "non-zero");
+
+  return classify_test_chain (vm, max_tables, n_sessions, n_iterations);
+}
+
+VLIB_CLI_COMMAND (test_classify_chain_command, static) = {
+  .path = "test classify chain",
+  .short_help = "test classify chain [tables <n>] [sessions <n>] "
+		"[iterations <n>]",
+  .function = classify_test,
+};
+
+clib_error_t *
+classify_test_init (vlib_main_t *vm)
+{
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (classify_test_init);
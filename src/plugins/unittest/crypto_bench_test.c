@@ -0,0 +1,612 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+
+/*
+ * Crypto engine benchmark: each op id is run through the handlers of every
+ * engine that registered one, bypassing the active handler selection, for
+ * a set of data and batch sizes, with flat and chained data, synchronously
+ * and through the async frame handlers. One CSV row is printed per
+ * measurement, so the output can be compared across engines and boxes.
+ */
+
+#define CRYPTO_BENCH_META_BYTES 128
+#define CRYPTO_BENCH_ASYNC_MAX_FRAMES 32
+#define CRYPTO_BENCH_ASYNC_TIMEOUT 1.0
+
+typedef struct
+{
+  u32 *sizes;
+  u32 *batches;
+  u32 chunk_size;
+  u32 n_bytes;		 /* data processed per measurement */
+  u32 engine_index;	 /* ~0 for all */
+  vnet_crypto_alg_t alg; /* ~0 for all */
+  u8 flat, chained, sync, async;
+  u32 n_failed;
+  u64 seed;
+} crypto_bench_t;
+
+typedef struct
+{
+  vnet_crypto_op_id_t id;
+  vnet_crypto_op_id_t enc_id; /* encrypt op of the same alg, for decrypt */
+  vnet_crypto_alg_t calg;     /* cipher or aead alg the key is for */
+  vnet_crypto_alg_t ialg;     /* integ alg of a linked async alg, else 0 */
+  u32 aad_len;
+  u32 key_index;
+  u32 keys[2];
+  u8 is_async;
+  u8 is_dec;
+} crypto_bench_op_t;
+
+/* sync ops use the alg of the op id. Async ops name an aead alg with a
+ * fixed aad length, or a cipher and an hmac alg linked together */
+static void
+crypto_bench_op_init (crypto_bench_op_t *o, vnet_crypto_op_id_t id)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *od = cm->opt_data + id;
+
+  clib_memset (o, 0, sizeof (*o));
+  o->id = id;
+  o->calg = od->alg;
+  o->aad_len = cm->algs[od->alg].is_aead ? 12 : 0;
+  o->key_index = o->keys[0] = o->keys[1] = ~0;
+  o->is_dec = od->type == VNET_CRYPTO_OP_TYPE_DECRYPT;
+  o->enc_id = cm->algs[od->alg].op_by_type[VNET_CRYPTO_OP_TYPE_ENCRYPT];
+
+  switch (id)
+    {
+#define _(n, s, k, t, a)                                                      \
+  case VNET_CRYPTO_OP_##n##_TAG##t##_AAD##a##_ENC:                            \
+  case VNET_CRYPTO_OP_##n##_TAG##t##_AAD##a##_DEC:                            \
+    o->calg = VNET_CRYPTO_ALG_##n;                                            \
+    o->aad_len = a;                                                           \
+    o->is_async = 1;                                                          \
+    break;
+      foreach_crypto_aead_async_alg
+#undef _
+#define _(c, h, s, k, d)                                                      \
+  case VNET_CRYPTO_OP_##c##_##h##_TAG##d##_ENC:                               \
+  case VNET_CRYPTO_OP_##c##_##h##_TAG##d##_DEC:                               \
+    o->calg = VNET_CRYPTO_ALG_##c;                                            \
+    o->ialg = VNET_CRYPTO_ALG_HMAC_##h;                                       \
+    o->is_async = 1;                                                          \
+    break;
+      foreach_crypto_link_async_alg
+#undef _
+    default:
+      break;
+    }
+}
+
+static u32
+crypto_bench_key_add_one (vlib_main_t *vm, vnet_crypto_alg_t alg)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  u8 key[64];
+  u32 i, len;
+
+  /* hmac keys may be of any length */
+  len = cm->algs[alg].key_length ? cm->algs[alg].key_length : 32;
+  for (i = 0; i < len; i++)
+    key[i] = i + 1;
+
+  return vnet_crypto_key_add (vm, alg, key, len);
+}
+
+static void
+crypto_bench_key_add (vlib_main_t *vm, crypto_bench_op_t *o)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+
+  /* plain hashes have no key */
+  if (cm->opt_data[o->id].type == VNET_CRYPTO_OP_TYPE_HASH)
+    return;
+
+  o->key_index = o->keys[0] = crypto_bench_key_add_one (vm, o->calg);
+  if (o->ialg)
+    {
+      o->keys[1] = crypto_bench_key_add_one (vm, o->ialg);
+      o->key_index = vnet_crypto_key_add_linked (vm, o->keys[0], o->keys[1]);
+    }
+}
+
+static void
+crypto_bench_key_del (vlib_main_t *vm, crypto_bench_op_t *o)
+{
+  if (o->ialg && o->key_index != ~0)
+    vnet_crypto_key_del (vm, o->key_index);
+  if (o->keys[1] != ~0)
+    vnet_crypto_key_del (vm, o->keys[1]);
+  if (o->keys[0] != ~0)
+    vnet_crypto_key_del (vm, o->keys[0]);
+}
+
+static void
+crypto_bench_row (vlib_main_t *vm, crypto_bench_t *b, u32 ei,
+		  crypto_bench_op_t *o, int chained, u32 size, u32 batch,
+		  u64 clocks, u64 n_bytes, int failed)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  f64 cpb = n_bytes ? (f64) clocks / n_bytes : 0;
+  f64 gbps = clocks ? n_bytes * 8 * vm->clib_time.clocks_per_second /
+			(f64) clocks * 1e-9 :
+		      0;
+
+  vlib_cli_output (vm, "%s,%U,%s,%s,%u,%u,%.3f,%.3f%s",
+		   cm->engines[ei].name, format_vnet_crypto_op, o->id,
+		   o->is_async ? "async" : "sync",
+		   chained ? "chained" : "flat", size, batch, gbps, cpb,
+		   failed ? ",failed" : "");
+  if (failed)
+    b->n_failed++;
+}
+
+/*
+ * sync: the data of each op lives in three regions, plaintext, ciphertext
+ * and a scratch area a decrypt writes to, so ciphertext and tags stay
+ * valid across rounds. Chained ops cut the same data in chunk-size pieces.
+ */
+static void
+crypto_bench_sync_ops (crypto_bench_t *b, crypto_bench_op_t *o,
+		       vnet_crypto_op_id_t id, u8 *mem, u32 size, u32 batch,
+		       int chained, vnet_crypto_op_t *ops,
+		       vnet_crypto_op_chunk_t **chunks)
+{
+  u32 stride = round_pow2 (size, CLIB_CACHE_LINE_BYTES);
+  u8 *pt = mem, *ct = pt + batch * stride, *scratch = ct + batch * stride;
+  u8 *meta = scratch + batch * stride;
+  int to_plain = id != o->enc_id && o->is_dec;
+  u32 i, off;
+
+  vec_reset_length (*chunks);
+
+  for (i = 0; i < batch; i++)
+    {
+      vnet_crypto_op_t *op = ops + i;
+      u8 *src, *dst, *m = meta + i * CRYPTO_BENCH_META_BYTES;
+
+      vnet_crypto_op_init (op, id);
+      op->key_index = o->key_index;
+      op->iv = m;
+      op->aad = m + 16;
+      op->aad_len = o->aad_len;
+      op->tag = m + 64;
+      op->tag_len = o->aad_len ? 16 : 0;
+      op->status = VNET_CRYPTO_OP_STATUS_IDLE;
+
+      src = (to_plain ? ct : pt) + i * stride;
+      dst = (to_plain ? scratch : ct) + i * stride;
+
+      if (!chained)
+	{
+	  op->src = src;
+	  op->dst = dst;
+	  op->len = size;
+	  continue;
+	}
+
+      op->flags |= VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS;
+      op->chunk_index = vec_len (*chunks);
+      op->n_chunks = 0;
+      for (off = 0; off < size; off += b->chunk_size)
+	{
+	  vnet_crypto_op_chunk_t *ch;
+
+	  vec_add2 (*chunks, ch, 1);
+	  ch->src = src + off;
+	  ch->dst = dst + off;
+	  ch->len = clib_min (b->chunk_size, size - off);
+	  op->n_chunks++;
+	}
+    }
+}
+
+static u32
+crypto_bench_sync_call (vlib_main_t *vm, vnet_crypto_engine_t *ce,
+			vnet_crypto_op_id_t id, vnet_crypto_op_t **op_ptrs,
+			vnet_crypto_op_chunk_t *chunks, u32 n_ops,
+			int chained)
+{
+  void *fn = ce->ops[id].handlers[chained ? VNET_CRYPTO_HANDLER_TYPE_CHAINED :
+					    VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+
+  if (chained)
+    return ((vnet_crypto_chained_op_fn_t *) fn) (vm, op_ptrs, chunks, n_ops);
+  return ((vnet_crypto_simple_op_fn_t *) fn) (vm, op_ptrs, n_ops);
+}
+
+static void
+crypto_bench_sync (vlib_main_t *vm, crypto_bench_t *b, u32 ei,
+		   crypto_bench_op_t *o, u32 size, u32 batch, int chained)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ce = cm->engines + ei;
+  vnet_crypto_op_chunk_t *chunks = 0;
+  vnet_crypto_op_t *ops = 0, **op_ptrs = 0;
+  u32 i, n_iter, stride, mem_size;
+  int failed = 0;
+  u64 t0, t1;
+  u8 *mem;
+
+  /* a decrypt needs a valid ciphertext and tag, made by this engine */
+  if (o->is_dec && !ce->ops[o->enc_id].handlers[chained])
+    return;
+
+  stride = round_pow2 (size, CLIB_CACHE_LINE_BYTES);
+  mem_size = batch * (3 * stride + CRYPTO_BENCH_META_BYTES);
+  mem = clib_mem_alloc_aligned (mem_size, CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < mem_size; i += 8)
+    *(u64 *) (mem + i) = random_u64 (&b->seed);
+
+  vec_validate_aligned (ops, batch - 1, CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < batch; i++)
+    vec_add1 (op_ptrs, ops + i);
+
+  if (o->is_dec)
+    {
+      crypto_bench_sync_ops (b, o, o->enc_id, mem, size, batch, chained, ops,
+			     &chunks);
+      crypto_bench_sync_call (vm, ce, o->enc_id, op_ptrs, chunks, batch,
+			      chained);
+    }
+
+  crypto_bench_sync_ops (b, o, o->id, mem, size, batch, chained, ops,
+			 &chunks);
+
+  /* warm up, and check the ops complete */
+  crypto_bench_sync_call (vm, ce, o->id, op_ptrs, chunks, batch, chained);
+  for (i = 0; i < batch; i++)
+    if (ops[i].status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+      failed = 1;
+
+  n_iter = clib_max (1, b->n_bytes / (batch * size));
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_iter; i++)
+    crypto_bench_sync_call (vm, ce, o->id, op_ptrs, chunks, batch, chained);
+  t1 = clib_cpu_time_now ();
+
+  crypto_bench_row (vm, b, ei, o, chained, size, batch, t1 - t0,
+		    (u64) n_iter * batch * size, failed);
+
+  clib_mem_free (mem);
+  vec_free (ops);
+  vec_free (op_ptrs);
+  vec_free (chunks);
+}
+
+/*
+ * async: each element is a buffer, or a chain of chunk-size buffers,
+ * with iv, tag and aad in the buffer's pre-data. Frames go straight to the
+ * engine's enqueue handler and are polled back from its dequeue handler.
+ */
+static int
+crypto_bench_async_round (vlib_main_t *vm, vnet_crypto_engine_t *ce,
+			  crypto_bench_op_t *o, vnet_crypto_op_id_t id,
+			  u32 *bis, u32 size, u32 batch, int chained)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_frame_enq_fn_t *enq =
+    ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_ASYNC];
+  vnet_crypto_async_frame_t *f;
+  clib_thread_index_t thread_index;
+  u32 i, j, n_elts, n_frames = 0, n_done = 0;
+  int failed = 0;
+  f64 t0;
+
+  for (i = 0; i < batch; i += VNET_CRYPTO_FRAME_SIZE)
+    {
+      f = vnet_crypto_async_get_frame (vm, id);
+      if (!f)
+	return -1;
+
+      for (j = i; j < clib_min (batch, i + VNET_CRYPTO_FRAME_SIZE); j++)
+	{
+	  vlib_buffer_t *bb = vlib_get_buffer (vm, bis[j]);
+
+	  vnet_crypto_async_add_to_frame (
+	    vm, f, o->key_index, size, 0, 0, 0, bis[j], 0, bb->data - 64,
+	    bb->data - 32, bb->data - VLIB_BUFFER_PRE_DATA_SIZE,
+	    chained ? VNET_CRYPTO_OP_FLAG_CHAINED_BUFFERS : 0);
+	}
+
+      f->state = VNET_CRYPTO_FRAME_STATE_PENDING;
+      f->enqueue_thread_index = vm->thread_index;
+      if (enq (vm, f))
+	{
+	  f->state = VNET_CRYPTO_FRAME_STATE_NOT_PROCESSED;
+	  vnet_crypto_async_free_frame (vm, f);
+	  failed = 1;
+	  break;
+	}
+      n_frames++;
+    }
+
+  /* workers may be the ones doing the crypto */
+  if (vlib_get_node (vm, cm->crypto_node_index)->state ==
+      VLIB_NODE_STATE_INTERRUPT)
+    for (i = 0; i < vlib_get_n_threads (); i++)
+      vlib_node_set_interrupt_pending (vlib_get_main_by_index (i),
+				       cm->crypto_node_index);
+
+  t0 = vlib_time_now (vm);
+  while (n_done < n_frames)
+    {
+      f = ce->dequeue_handler (vm, &n_elts, &thread_index);
+      if (!f)
+	{
+	  if (vlib_time_now (vm) - t0 > CRYPTO_BENCH_ASYNC_TIMEOUT)
+	    return -1;
+	  continue;
+	}
+      if (f->state != VNET_CRYPTO_FRAME_STATE_SUCCESS)
+	failed = 1;
+      vnet_crypto_async_free_frame (vm, f);
+      n_done++;
+    }
+
+  return failed;
+}
+
+static void
+crypto_bench_async (vlib_main_t *vm, crypto_bench_t *b, u32 ei,
+		    crypto_bench_op_t *o, u32 size, u32 batch, int chained)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ce = cm->engines + ei;
+  u32 data_size = vlib_buffer_get_default_data_size (vm);
+  u32 i, j, k, n_iter, n_bufs, n_alloc = 0, *bis = 0, *firsts = 0;
+  u64 clocks = 0, t0;
+  int l, rv = 0;
+
+  n_bufs = chained ? round_pow2 (size, b->chunk_size) / b->chunk_size : 1;
+  if ((!chained && size > data_size) || ce->dequeue_handler == 0 ||
+      (o->is_dec &&
+       !ce->ops[o->enc_id].handlers[VNET_CRYPTO_HANDLER_TYPE_ASYNC]) ||
+      batch > CRYPTO_BENCH_ASYNC_MAX_FRAMES * VNET_CRYPTO_FRAME_SIZE)
+    return;
+
+  vec_validate (bis, batch * n_bufs - 1);
+  n_alloc = vlib_buffer_alloc (vm, bis, batch * n_bufs);
+  if (n_alloc != batch * n_bufs)
+    {
+      crypto_bench_row (vm, b, ei, o, chained, size, batch, 0, 0, 1);
+      goto done;
+    }
+
+  for (i = 0, k = 0; i < batch; i++)
+    {
+      vlib_buffer_t *first = vlib_get_buffer (vm, bis[k]), *bb = first;
+      u32 left = size;
+
+      vec_add1 (firsts, bis[k]);
+      first->total_length_not_including_first_buffer = 0;
+      for (j = 0; j < n_bufs; j++, k++)
+	{
+	  u32 len = chained ? clib_min (b->chunk_size, left) : size;
+
+	  bb = vlib_get_buffer (vm, bis[k]);
+	  bb->current_data = 0;
+	  bb->current_length = len;
+	  bb->flags = 0;
+	  for (l = -VLIB_BUFFER_PRE_DATA_SIZE; l < (int) len; l += 8)
+	    *(u64 *) (bb->data + l) = random_u64 (&b->seed);
+	  if (j)
+	    first->total_length_not_including_first_buffer += len;
+	  if (j + 1 < n_bufs)
+	    {
+	      bb->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      bb->next_buffer = bis[k + 1];
+	    }
+	  left -= len;
+	}
+      if (n_bufs > 1)
+	first->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+    }
+
+  n_iter = clib_max (1, b->n_bytes / (batch * size));
+  for (i = 0; i <= n_iter && rv == 0; i++)
+    {
+      /* in place, so a decrypt needs fresh ciphertext every round */
+      if (o->is_dec)
+	rv = crypto_bench_async_round (vm, ce, o, o->enc_id, firsts, size,
+				       batch, chained);
+      t0 = clib_cpu_time_now ();
+      if (rv == 0)
+	rv = crypto_bench_async_round (vm, ce, o, o->id, firsts, size, batch,
+				       chained);
+      /* the first round is the warm up */
+      if (i)
+	clocks += clib_cpu_time_now () - t0;
+    }
+
+  if (rv < 0)
+    vlib_cli_output (vm, "%s,%U,async: no completion", ce->name,
+		     format_vnet_crypto_op, o->id);
+  crypto_bench_row (vm, b, ei, o, chained, size, batch, clocks,
+		    (u64) n_iter * batch * size, rv != 0);
+
+done:
+  if (n_alloc)
+    vlib_buffer_free_no_next (vm, bis, n_alloc);
+  vec_free (bis);
+  vec_free (firsts);
+}
+
+static void
+crypto_bench_op (vlib_main_t *vm, crypto_bench_t *b, vnet_crypto_op_id_t id)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_engine_t *ce;
+  crypto_bench_op_t _o, *o = &_o;
+  u32 *size, *batch, ei;
+  int chained, keyed = 0;
+
+  crypto_bench_op_init (o, id);
+
+  if (b->alg != ~0 && b->alg != o->calg && b->alg != cm->opt_data[id].alg)
+    return;
+
+  vec_foreach_index (ei, cm->engines)
+    {
+      ce = cm->engines + ei;
+      if (b->engine_index != ~0 && ei != b->engine_index)
+	continue;
+
+      for (chained = 0; chained < 2; chained++)
+	{
+	  vnet_crypto_handler_type_t t;
+
+	  if (!(chained ? b->chained : b->flat))
+	    continue;
+	  if (o->is_async)
+	    t = VNET_CRYPTO_HANDLER_TYPE_ASYNC;
+	  else
+	    t = chained ? VNET_CRYPTO_HANDLER_TYPE_CHAINED :
+			  VNET_CRYPTO_HANDLER_TYPE_SIMPLE;
+	  if (!(o->is_async ? b->async : b->sync) || !ce->ops[id].handlers[t])
+	    continue;
+
+	  if (!keyed)
+	    {
+	      crypto_bench_key_add (vm, o);
+	      keyed = 1;
+	    }
+
+	  vec_foreach (size, b->sizes)
+	    vec_foreach (batch, b->batches)
+	      {
+		if (o->is_async)
+		  crypto_bench_async (vm, b, ei, o, size[0], batch[0],
+				      chained);
+		else
+		  crypto_bench_sync (vm, b, ei, o, size[0], batch[0], chained);
+		/* let the rest of the system breathe */
+		vlib_process_suspend (vm, 1e-5);
+	      }
+	}
+    }
+
+  if (keyed)
+    crypto_bench_key_del (vm, o);
+}
+
+static clib_error_t *
+test_crypto_bench_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			      vlib_cli_command_t *cmd)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  crypto_bench_t _b = {
+    .chunk_size = 512,
+    .n_bytes = 1 << 20,
+    .engine_index = ~0,
+    .alg = ~0,
+    .flat = 1,
+    .chained = 1,
+    .sync = 1,
+  }, *b = &_b;
+  clib_error_t *err = 0;
+  u32 id, n, *p;
+  u8 *name;
+  uword *e;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "alg %U", unformat_vnet_crypto_alg, &b->alg))
+	;
+      else if (unformat (input, "engine %s", &name))
+	{
+	  e = hash_get_mem (cm->engine_index_by_name, name);
+	  vec_free (name);
+	  if (!e)
+	    {
+	      err = clib_error_return (0, "unknown engine");
+	      goto done;
+	    }
+	  b->engine_index = e[0];
+	}
+      else if (unformat (input, "size %u", &n))
+	vec_add1 (b->sizes, n);
+      else if (unformat (input, "batch %u", &n))
+	vec_add1 (b->batches, n);
+      else if (unformat (input, "chunk-size %u", &b->chunk_size))
+	;
+      else if (unformat (input, "bytes %u", &b->n_bytes))
+	;
+      else if (unformat (input, "no-flat"))
+	b->flat = 0;
+      else if (unformat (input, "no-chained"))
+	b->chained = 0;
+      else if (unformat (input, "no-sync"))
+	b->sync = 0;
+      else if (unformat (input, "async"))
+	b->async = 1;
+      else
+	{
+	  err = clib_error_return (0, "unknown input `%U'",
+				   format_unformat_error, input);
+	  goto done;
+	}
+    }
+
+  if (!b->sizes)
+    {
+      u32 sizes[] = { 64, 256, 1024, 1500, 4096 };
+      vec_add (b->sizes, sizes, ARRAY_LEN (sizes));
+    }
+  if (!b->batches)
+    {
+      u32 batches[] = { 1, 32, 256 };
+      vec_add (b->batches, batches, ARRAY_LEN (batches));
+    }
+  vec_foreach (p, b->sizes)
+    if (p[0] == 0)
+      {
+	err = clib_error_return (0, "sizes must be non-zero");
+	goto done;
+      }
+  vec_foreach (p, b->batches)
+    if (p[0] == 0 || p[0] > VLIB_FRAME_SIZE)
+      {
+	err = clib_error_return (0, "batch must be 1 to %u", VLIB_FRAME_SIZE);
+	goto done;
+      }
+  if (b->chunk_size == 0 ||
+      b->chunk_size > vlib_buffer_get_default_data_size (vm))
+    {
+      err = clib_error_return (0, "chunk-size out of range");
+      goto done;
+    }
+
+  b->seed = clib_cpu_time_now ();
+
+  vlib_cli_output (vm, "# cpu-freq %.2f GHz",
+		   vm->clib_time.clocks_per_second * 1e-9);
+  vlib_cli_output (vm, "engine,op,mode,data,size,batch,gbps,clocks_per_byte");
+
+  for (id = 1; id < VNET_CRYPTO_N_OP_IDS; id++)
+    crypto_bench_op (vm, b, id);
+
+  if (b->n_failed)
+    err = clib_error_return (0, "failed: %u measurements had op failures",
+			     b->n_failed);
+
+done:
+  vec_free (b->sizes);
+  vec_free (b->batches);
+  return err;
+}
+
+VLIB_CLI_COMMAND (test_crypto_bench_command, static) = {
+  .path = "test crypto bench",
+  .short_help = "test crypto bench [alg <alg>] [engine <name>] "
+		"[size <n>]... [batch <n>]... [chunk-size <n>] [bytes <n>] "
+		"[no-flat] [no-chained] [no-sync] [async]",
+  .function = test_crypto_bench_command_fn,
+};
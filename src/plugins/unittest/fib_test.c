@@ -7662,9 +7662,13 @@ static int
 fib_test_walk (void)
 {
     fib_node_back_walk_ctx_t high_ctx = {}, low_ctx = {};
+    fib_node_back_walk_ctx_t sync_ctx = {
+        .fnbw_reason = FIB_NODE_BW_REASON_FLAG_RESOLVE,
+        .fnbw_flags = FIB_NODE_BW_FLAG_FORCE_SYNC,
+    };
+    u32 ii, res, n_visits;
     fib_node_test_t *tc;
     vlib_main_t *vm;
-    u32 ii, res;
 
     res = 0;
     vm = vlib_get_main();
@@ -7940,6 +7944,60 @@ fib_test_walk (void)
              "Parent has %d children post 2nd zero qunta merge walk",
              fib_node_list_get_size(PARENT()->fn_children));
 
+    /*
+     * give sync walks a quota that is spent after the first child. a walk
+     * that is forced to be sync still visits all the children.
+     */
+    fib_walk_sync_quota_set(1e-12);
+
+    fib_walk_sync(test_node_type, PARENT_INDEX, &sync_ctx);
+
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        FIB_TEST(1 == vec_len(tc->ctxs),
+                 "%d child visitsed %d times in forced sync walk",
+                 ii, vec_len(tc->ctxs));
+        vec_free(tc->ctxs);
+    }
+    FIB_TEST(0 == fib_walk_queue_get_size(FIB_WALK_PRIORITY_HIGH),
+             "Queue is empty post forced sync walk");
+
+    /*
+     * any other sync walk leaves the children it did not get to for the
+     * async walk process.
+     */
+    fib_walk_sync(test_node_type, PARENT_INDEX, &high_ctx);
+
+    n_visits = 0;
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        n_visits += vec_len(tc->ctxs);
+    }
+    FIB_TEST(n_visits < N_TEST_CHILDREN,
+             "%d children visited before the sync walk is deferred", n_visits);
+    FIB_TEST(1 == fib_walk_queue_get_size(FIB_WALK_PRIORITY_HIGH),
+             "Queue has the deferred sync walk");
+    FIB_TEST(N_TEST_CHILDREN+1 == fib_node_list_get_size(PARENT()->fn_children),
+             "Parent has %d children pre deferred walk",
+             fib_node_list_get_size(PARENT()->fn_children));
+
+    fib_walk_process_queues(vm, 1);
+
+    FOR_EACH_TEST_CHILD(tc)
+    {
+        FIB_TEST(1 == vec_len(tc->ctxs),
+                 "%d child visitsed %d times in deferred sync walk",
+                 ii, vec_len(tc->ctxs));
+        vec_free(tc->ctxs);
+    }
+    FIB_TEST(0 == fib_walk_queue_get_size(FIB_WALK_PRIORITY_HIGH),
+             "Queue is empty post deferred sync walk");
+    FIB_TEST(N_TEST_CHILDREN == fib_node_list_get_size(PARENT()->fn_children),
+             "Parent has %d children post deferred sync walk",
+             fib_node_list_get_size(PARENT()->fn_children));
+
+    fib_walk_sync_quota_set(0);
+
     /*
      * make the parent a child of one of its children, thus inducing a routing loop.
      */
@@ -0,0 +1,379 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip.h>
+#include <vnet/udp/udp_packet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/dpo/replicate_dpo.h>
+#include <vnet/dpo/drop_dpo.h>
+
+/*
+ * Forwarding benchmark: frames of UDP packets are handed to the graph as
+ * if received on an interface, and the clocks every node spent on them
+ * are added up, like 'show runtime' does, for the full graph and for the
+ * ip4-fast-forward path.
+ * A second command measures ip4-replicate alone for a range of fan-outs.
+ */
+
+typedef struct
+{
+  u32 rx_sw_if_index;
+  ip4_address_t dst;
+  u32 n_dsts;
+  u32 n_frames;
+  u32 packet_size;
+  u32 verbose;
+
+  /* per node clocks and vectors at the start of a run */
+  u64 *clocks;
+  u64 *vectors;
+} ip4_fwd_perf_t;
+
+static void
+ip4_fwd_perf_fill (vlib_main_t *vm, ip4_fwd_perf_t *pm, vlib_buffer_t *b,
+		   u32 seq, int fast)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  ethernet_interface_t *ei;
+  ethernet_header_t *e;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  u32 next;
+
+  ei = ethernet_get_interface (
+    &ethernet_main, vnet_get_sup_hw_interface (vnm, pm->rx_sw_if_index)
+		      ->hw_if_index);
+
+  b->current_data = 0;
+  b->current_length = pm->packet_size;
+  b->flags = 0;
+  vnet_buffer (b)->sw_if_index[VLIB_RX] = pm->rx_sw_if_index;
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = ~0;
+
+  e = vlib_buffer_get_current (b);
+  mac_address_to_bytes (&ei->address.mac, e->dst_address);
+  clib_memset (e->src_address, 0, sizeof (e->src_address));
+  e->src_address[0] = 0x02;
+  e->src_address[5] = 0x01;
+  e->type = clib_host_to_net_u16 (ETHERNET_TYPE_IP4);
+
+  ip = (ip4_header_t *) (e + 1);
+  clib_memset (ip, 0, sizeof (*ip));
+  ip->ip_version_and_header_length = 0x45;
+  ip->ttl = 64;
+  ip->protocol = IP_PROTOCOL_UDP;
+  ip->length = clib_host_to_net_u16 (pm->packet_size - sizeof (*e));
+  ip->src_address.as_u32 = clib_host_to_net_u32 (0xc6120001);
+  ip->dst_address.as_u32 = clib_host_to_net_u32 (
+    clib_net_to_host_u32 (pm->dst.as_u32) + seq % pm->n_dsts);
+  ip->checksum = ip4_header_checksum (ip);
+
+  udp = (udp_header_t *) (ip + 1);
+  udp->src_port = udp->dst_port = clib_host_to_net_u16 (1234);
+  udp->length = clib_host_to_net_u16 (pm->packet_size - sizeof (*e) -
+				      sizeof (*ip));
+  udp->checksum = 0;
+
+  /* where ip4-fast-forward continues on the device-input arc */
+  if (fast)
+    vnet_feature_start_device_input (pm->rx_sw_if_index, &next, b);
+}
+
+static void
+ip4_fwd_perf_snapshot (vlib_main_t *vm, ip4_fwd_perf_t *pm)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_node_t *n;
+  u32 i;
+
+  vec_validate (pm->clocks, vec_len (nm->nodes) - 1);
+  vec_validate (pm->vectors, vec_len (nm->nodes) - 1);
+
+  vec_foreach_index (i, nm->nodes)
+    {
+      n = nm->nodes[i];
+      if (n->type != VLIB_NODE_TYPE_INTERNAL)
+	continue;
+      vlib_node_sync_stats (vm, n);
+      pm->clocks[i] = n->stats_total.clocks;
+      pm->vectors[i] = n->stats_total.vectors;
+    }
+}
+
+static clib_error_t *
+ip4_fwd_perf_run (vlib_main_t *vm, ip4_fwd_perf_t *pm, int fast)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  u32 node_index, n_packets = 0, i, j, n, *to;
+  u64 clocks = 0, n_drops = 0, *start_clocks, *start_vectors;
+  vlib_node_t *n_drop, *node;
+  vlib_frame_t *f;
+
+  node_index =
+    vlib_get_node_by_name (vm, (u8 *) (fast ? "ip4-fast-forward" :
+					      "ethernet-input"))
+      ->index;
+  n_drop = vlib_get_node_by_name (vm, (u8 *) "error-drop");
+
+  ip4_fwd_perf_snapshot (vm, pm);
+  start_clocks = vec_dup (pm->clocks);
+  start_vectors = vec_dup (pm->vectors);
+
+  for (i = 0; i < pm->n_frames; i++)
+    {
+      f = vlib_get_frame_to_node (vm, node_index);
+      to = vlib_frame_vector_args (f);
+      n = vlib_buffer_alloc (vm, to, VLIB_FRAME_SIZE);
+      for (j = 0; j < n; j++)
+	ip4_fwd_perf_fill (vm, pm, vlib_get_buffer (vm, to[j]), n_packets + j,
+			   fast);
+      f->n_vectors = n;
+      vlib_put_frame_to_node (vm, node_index, f);
+      n_packets += n;
+
+      /* let the graph run */
+      vlib_process_suspend (vm, 1e-5);
+    }
+  vlib_process_suspend (vm, 1e-3);
+
+  ip4_fwd_perf_snapshot (vm, pm);
+
+  vlib_cli_output (vm, "%s, %u packets:", fast ? "fast forward" : "full graph",
+		   n_packets);
+  vec_foreach_index (i, nm->nodes)
+    {
+      u64 dc, dv;
+
+      node = nm->nodes[i];
+      if (node->type != VLIB_NODE_TYPE_INTERNAL ||
+	  i >= vec_len (start_clocks))
+	continue;
+      dc = pm->clocks[i] - start_clocks[i];
+      dv = pm->vectors[i] - start_vectors[i];
+      if (dv == 0)
+	continue;
+      clocks += dc;
+      if (node == n_drop)
+	n_drops += dv;
+      if (pm->verbose)
+	vlib_cli_output (vm, "  %-30v%12.2f clk/pkt", node->name,
+			 (f64) dc / n_packets);
+    }
+  vlib_cli_output (vm, "  %-30s%12.2f clk/pkt", "total",
+		   n_packets ? (f64) clocks / n_packets : 0.0);
+
+  vec_free (start_clocks);
+  vec_free (start_vectors);
+
+  if (n_packets == 0)
+    return clib_error_return (0, "buffer alloc failure");
+  if (n_drops)
+    return clib_error_return (0, "failed: %s, %llu of %u packets dropped",
+			      fast ? "fast forward" : "full graph", n_drops,
+			      n_packets);
+  return 0;
+}
+
+static clib_error_t *
+ip4_fwd_perf_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			 vlib_cli_command_t *cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  ip4_fwd_perf_t _pm = {
+    .rx_sw_if_index = ~0,
+    .n_dsts = 1,
+    .n_frames = 100,
+    .packet_size = 128,
+  }, *pm = &_pm;
+  clib_error_t *err = 0;
+  int was_fast, fast = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rx %U", unformat_vnet_sw_interface, vnm,
+		    &pm->rx_sw_if_index))
+	;
+      else if (unformat (input, "dst %U", unformat_ip4_address, &pm->dst))
+	;
+      else if (unformat (input, "dsts %u", &pm->n_dsts))
+	;
+      else if (unformat (input, "frames %u", &pm->n_frames))
+	;
+      else if (unformat (input, "size %u", &pm->packet_size))
+	;
+      else if (unformat (input, "no-fast-forward"))
+	fast = 0;
+      else if (unformat (input, "verbose"))
+	pm->verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (pm->rx_sw_if_index == ~0 || pm->dst.as_u32 == 0)
+    return clib_error_return (0, "rx interface and dst address required");
+  if (!ethernet_get_interface (
+	&ethernet_main,
+	vnet_get_sup_hw_interface (vnm, pm->rx_sw_if_index)->hw_if_index))
+    return clib_error_return (0, "rx must be an ethernet interface");
+  if (pm->packet_size < sizeof (ethernet_header_t) + sizeof (ip4_header_t) +
+			  sizeof (udp_header_t) ||
+      pm->packet_size > vlib_buffer_get_default_data_size (vm))
+    return clib_error_return (0, "size out of range");
+  if (pm->n_dsts == 0 || pm->n_frames == 0)
+    return clib_error_return (0, "dsts and frames must be non-zero");
+
+  /* the full graph first, then the fast path, then as it was */
+  was_fast = vnet_feature_is_enabled ("device-input", "ip4-fast-forward",
+				      pm->rx_sw_if_index);
+  if (was_fast)
+    vnet_feature_enable_disable ("device-input", "ip4-fast-forward",
+				 pm->rx_sw_if_index, 0, 0, 0);
+
+  err = ip4_fwd_perf_run (vm, pm, 0);
+
+  if (fast)
+    vnet_feature_enable_disable ("device-input", "ip4-fast-forward",
+				 pm->rx_sw_if_index, 1, 0, 0);
+  if (!err && fast)
+    err = ip4_fwd_perf_run (vm, pm, 1);
+
+  if (fast != was_fast)
+    vnet_feature_enable_disable ("device-input", "ip4-fast-forward",
+				 pm->rx_sw_if_index, was_fast, 0, 0);
+
+  vec_free (pm->clocks);
+  vec_free (pm->vectors);
+  return err;
+}
+
+VLIB_CLI_COMMAND (ip4_fwd_perf_command, static) = {
+  .path = "test ip4 forward perf",
+  .short_help = "test ip4 forward perf rx <interface> dst <address> "
+		"[dsts <n>] [frames <n>] [size <n>] [no-fast-forward] "
+		"[verbose]",
+  .function = ip4_fwd_perf_command_fn,
+};
+
+/*
+ * Replicate benchmark: frames are handed straight to ip4-replicate with a
+ * replicate object whose buckets all point at the ip4 drop DPO, so only the
+ * cloning and the enqueue of the clones is measured.
+ */
+
+#define IP4_REP_PERF_MAX_CLONES 4096
+
+static clib_error_t *
+ip4_rep_perf_run (vlib_main_t *vm, u32 fanout, u32 n_frames, u32 size)
+{
+  vlib_node_t *node = vlib_get_node_by_name (vm, (u8 *) "ip4-replicate");
+  u32 i, j, n, *to, repi, n_per_frame, n_packets = 0;
+  u64 clocks, vectors;
+  dpo_id_t dpo = DPO_INVALID;
+  vlib_buffer_t *b;
+  vlib_frame_t *f;
+  f64 clk_per_pkt;
+
+  repi = replicate_create (fanout, DPO_PROTO_IP4);
+  for (i = 0; i < fanout; i++)
+    replicate_set_bucket (repi, i, drop_dpo_get (DPO_PROTO_IP4));
+  /* hold a lock for the duration of the run */
+  dpo_set (&dpo, DPO_REPLICATE, DPO_PROTO_IP4, repi);
+
+  /* all clones of a frame are held until the frame is done */
+  n_per_frame = clib_clamp (IP4_REP_PERF_MAX_CLONES / fanout, 1,
+			    VLIB_FRAME_SIZE);
+
+  vlib_node_sync_stats (vm, node);
+  clocks = node->stats_total.clocks;
+  vectors = node->stats_total.vectors;
+
+  for (i = 0; i < n_frames; i++)
+    {
+      f = vlib_get_frame_to_node (vm, node->index);
+      to = vlib_frame_vector_args (f);
+      n = vlib_buffer_alloc (vm, to, n_per_frame);
+      for (j = 0; j < n; j++)
+	{
+	  b = vlib_get_buffer (vm, to[j]);
+	  b->current_data = 0;
+	  b->current_length = size;
+	  b->flags = 0;
+	  vnet_buffer (b)->ip.adj_index[VLIB_TX] = repi;
+	}
+      f->n_vectors = n;
+      vlib_put_frame_to_node (vm, node->index, f);
+      n_packets += n;
+
+      vlib_process_suspend (vm, 1e-5);
+    }
+  vlib_process_suspend (vm, 1e-3);
+
+  vlib_node_sync_stats (vm, node);
+  clocks = node->stats_total.clocks - clocks;
+  vectors = node->stats_total.vectors - vectors;
+
+  dpo_reset (&dpo);
+
+  if (n_packets == 0 || vectors != n_packets)
+    return clib_error_return (0, "failed: fan-out %u, %llu of %u packets "
+			      "replicated", fanout, vectors, n_packets);
+
+  clk_per_pkt = (f64) clocks / n_packets;
+  vlib_cli_output (vm, "%8u%12.2f%12.2f%12.2f", fanout, clk_per_pkt,
+		   clk_per_pkt / fanout,
+		   vm->clib_time.clocks_per_second / clk_per_pkt * 1e-6);
+  return 0;
+}
+
+static clib_error_t *
+ip4_rep_perf_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			 vlib_cli_command_t *cmd)
+{
+  u32 fanout, max_fanout = 64, n_frames = 100, size = 256;
+  clib_error_t *err = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "fanout %u", &max_fanout))
+	;
+      else if (unformat (input, "frames %u", &n_frames))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (max_fanout == 0 || max_fanout > REP_MAX_BUCKETS)
+    return clib_error_return (0, "fanout must be 1 to %u", REP_MAX_BUCKETS);
+  if (n_frames == 0)
+    return clib_error_return (0, "frames must be non-zero");
+  if (size < sizeof (ip4_header_t) ||
+      size > vlib_buffer_get_default_data_size (vm))
+    return clib_error_return (0, "size out of range");
+
+  vlib_cli_output (vm, "%8s%12s%12s%12s", "fan-out", "clk/pkt", "clk/clone",
+		   "Mpps");
+
+  /* powers of two, then the requested fan-out if it isn't one */
+  for (fanout = 1; !err && fanout < max_fanout; fanout <<= 1)
+    err = ip4_rep_perf_run (vm, fanout, n_frames, size);
+  if (!err)
+    err = ip4_rep_perf_run (vm, max_fanout, n_frames, size);
+
+  return err;
+}
+
+VLIB_CLI_COMMAND (ip4_rep_perf_command, static) = {
+  .path = "test ip4 replicate perf",
+  .short_help = "test ip4 replicate perf [fanout <n>] [frames <n>] "
+		"[size <n>]",
+  .function = ip4_rep_perf_command_fn,
+};
@@ -16,6 +16,8 @@
 #include <vnet/ipsec/ipsec.h>
 #include <vnet/ipsec/ipsec_sa.h>
 #include <vnet/ipsec/ipsec_output.h>
+#include <vnet/ipsec/esp.h>
+#include <pthread.h>
 
 static clib_error_t *
 test_ipsec_command_fn (vlib_main_t *vm, unformat_input_t *input,
@@ -50,15 +52,25 @@ test_ipsec_command_fn (vlib_main_t *vm, unformat_input_t *input,
       ort = ipsec_sa_get_outb_rt (sa);
 
       if (ort)
-	ort->seq64 = seq_num;
+	{
+	  ipsec_sa_seq_block_t *sb;
+
+	  ort->seq64 = seq_num;
+	  /* drop the sequence numbers the workers reserved */
+	  vec_foreach (sb, ort->seq_blocks)
+	    sb->n_left = 0;
+	}
 
       if (irt)
 	{
 	  irt->seq64 = seq_num;
 
 	  /* clear the window */
-	  uword_bitmap_clear (irt->replay_window,
-			      irt->anti_replay_window_size / uword_bits);
+	  if (irt->is_multi_worker)
+	    ipsec_sa_anti_replay_mw_reset (irt);
+	  else
+	    uword_bitmap_clear (irt->replay_window,
+				irt->anti_replay_window_size / uword_bits);
 	}
 
       ipsec_sa_unlock (sa_index);
@@ -374,12 +386,821 @@ done:
   return (err);
 }
 
+/* The flow cache benchmark uses its own SPD, one flow per policy */
+#define TEST_IPSEC_FLOW_CACHE_SPD_ID 0xfc
+#define TEST_IPSEC_FLOW_CACHE_ADDR(i) (0x0a000000 + (i))
+
+/* Lookups between two policy changes, for each churn column */
+static const u32 test_ipsec_flow_cache_change_intervals[] = { 4096, 256, 16 };
+
+static u64
+test_ipsec_flow_cache_lookups (vlib_main_t *vm, ipsec_spd_t *spd,
+			       ipsec_policy_t *policies, u32 n_iterations,
+			       u8 flow_cache_enabled, u32 change_interval)
+{
+  ipsec_main_t *im = &ipsec_main;
+  u32 n_policies = vec_len (policies), iter, i, j, a, stat_index;
+  u32 n_since_change = 0, next_change = 0;
+  ipsec_policy_t *p0;
+  u64 t0;
+
+  t0 = clib_cpu_time_now ();
+  for (iter = 0; iter < n_iterations; iter++)
+    for (i = 0; i < VLIB_FRAME_SIZE; i++)
+      {
+	j = (i * 7 + iter) % n_policies;
+	a = TEST_IPSEC_FLOW_CACHE_ADDR (j);
+
+	p0 = 0;
+	if (flow_cache_enabled)
+	  p0 = ipsec4_out_spd_find_flow_cache_entry (
+	    im, IP_PROTOCOL_UDP, clib_host_to_net_u32 (a),
+	    clib_host_to_net_u32 (a), clib_host_to_net_u16 (1),
+	    clib_host_to_net_u16 (1));
+	if (p0 == 0)
+	  p0 = ipsec_output_policy_match (spd, IP_PROTOCOL_UDP, a, a, 1, 1,
+					  flow_cache_enabled);
+	ASSERT (p0 != 0);
+
+	/* re-adding a policy drops the flows cached against it */
+	if (change_interval && ++n_since_change == change_interval)
+	  {
+	    n_since_change = 0;
+	    ipsec_add_del_policy (vm, &policies[next_change], 0, &stat_index);
+	    ipsec_add_del_policy (vm, &policies[next_change], 1, &stat_index);
+	    next_change = (next_change + 1) % n_policies;
+	  }
+      }
+
+  return clib_cpu_time_now () - t0;
+}
+
+static clib_error_t *
+test_ipsec_flow_cache_measure (vlib_main_t *vm, u32 n_policies,
+			       u32 n_iterations)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_policy_t *policies = 0, *p, *p0, *p1;
+  clib_error_t *err = 0;
+  ipsec_spd_t *spd;
+  u32 i, a, stat_index, n_lookups = n_iterations * VLIB_FRAME_SIZE;
+  u64 churn[ARRAY_LEN (test_ipsec_flow_cache_change_intervals)];
+  u64 linear, cached;
+  uword *pp;
+  int rv;
+
+  rv = ipsec_add_del_spd (vm, TEST_IPSEC_FLOW_CACHE_SPD_ID, 1);
+  if (rv)
+    return clib_error_return (0, "create spd failure: %d", rv);
+  pp = hash_get (im->spd_index_by_spd_id, TEST_IPSEC_FLOW_CACHE_SPD_ID);
+  spd = pool_elt_at_index (im->spds, pp[0]);
+
+  vec_validate (policies, n_policies - 1);
+  vec_foreach_index (i, policies)
+    {
+      p = &policies[i];
+      a = clib_host_to_net_u32 (TEST_IPSEC_FLOW_CACHE_ADDR (i));
+      p->type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+      p->priority = n_policies - i;
+      p->policy = IPSEC_POLICY_ACTION_BYPASS;
+      p->id = TEST_IPSEC_FLOW_CACHE_SPD_ID;
+      p->protocol = IP_PROTOCOL_UDP;
+      p->lport.stop = p->rport.stop = 0xffff;
+      p->laddr.start.ip4.as_u32 = p->laddr.stop.ip4.as_u32 = a;
+      p->raddr.start.ip4.as_u32 = p->raddr.stop.ip4.as_u32 = a;
+
+      if ((rv = ipsec_add_del_policy (vm, p, 1, &stat_index)))
+	{
+	  vec_set_len (policies, i);
+	  err = clib_error_return (0, "add policy failure: %d", rv);
+	  goto done;
+	}
+    }
+
+  /* the cache must return what the linear search found */
+  vec_foreach_index (i, policies)
+    {
+      a = TEST_IPSEC_FLOW_CACHE_ADDR (i);
+      p0 = ipsec_output_policy_match (spd, IP_PROTOCOL_UDP, a, a, 1, 1, 1);
+      p1 = ipsec4_out_spd_find_flow_cache_entry (
+	im, IP_PROTOCOL_UDP, clib_host_to_net_u32 (a),
+	clib_host_to_net_u32 (a), clib_host_to_net_u16 (1),
+	clib_host_to_net_u16 (1));
+      if (p0 == 0 || p0->laddr.start.ip4.as_u32 != clib_host_to_net_u32 (a) ||
+	  (p1 && p1 != p0))
+	{
+	  err = clib_error_return (0, "failed: %u policies, flow %u",
+				   n_policies, i);
+	  goto done;
+	}
+    }
+
+  linear = test_ipsec_flow_cache_lookups (vm, spd, policies, n_iterations, 0,
+					  0);
+  cached = test_ipsec_flow_cache_lookups (vm, spd, policies, n_iterations, 1,
+					  0);
+  for (i = 0; i < ARRAY_LEN (churn); i++)
+    churn[i] = test_ipsec_flow_cache_lookups (
+      vm, spd, policies, n_iterations, 1,
+      test_ipsec_flow_cache_change_intervals[i]);
+
+  vlib_cli_output (vm, "%-10u%-12.2f%-12.2f%-12.2f%-12.2f%-12.2f", n_policies,
+		   (f64) linear / n_lookups, (f64) cached / n_lookups,
+		   (f64) churn[0] / n_lookups, (f64) churn[1] / n_lookups,
+		   (f64) churn[2] / n_lookups);
+
+done:
+  vec_foreach (p, policies)
+    ipsec_add_del_policy (vm, p, 0, &stat_index);
+  ipsec_add_del_spd (vm, TEST_IPSEC_FLOW_CACHE_SPD_ID, 0);
+  vec_free (policies);
+
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_spd_flow_cache_command_fn (vlib_main_t *vm,
+				      unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  u32 max_policies = 1024, n_iterations = 100, n_policies;
+  clib_error_t *err = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "policies %u", &max_policies))
+	;
+      else if (unformat (input, "iterations %u", &n_iterations))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!im->output_flow_cache_flag)
+    return clib_error_return (0, "ipv4 outbound spd flow cache not enabled");
+
+  if (max_policies == 0 || n_iterations == 0)
+    return clib_error_return (0, "policies and iterations must be non-zero");
+
+  vlib_cli_output (vm, "clocks per lookup, churn is one policy change per n");
+  vlib_cli_output (vm, "%-10s%-12s%-12s%-12s%-12s%-12s", "policies", "linear",
+		   "cached", "churn 4096", "churn 256", "churn 16");
+
+  for (n_policies = 1; n_policies <= max_policies && !err; n_policies <<= 1)
+    err = test_ipsec_flow_cache_measure (vm, n_policies, n_iterations);
+
+  return err;
+}
+
+/*
+ * The multi-worker anti-replay test drives inbound SA runtimes directly,
+ * the way the decrypt nodes do, so it needs neither SAs nor crypto.
+ */
+static ipsec_sa_inb_rt_t *
+test_ipsec_ar_irt_alloc (u32 window_size, int use_esn, int is_multi_worker,
+			 u64 seq64)
+{
+  ipsec_sa_inb_rt_t *irt;
+  u32 sz = sizeof (ipsec_sa_inb_rt_t);
+
+  if (is_multi_worker)
+    sz += ipsec_sa_anti_replay_mw_n_cells (window_size) * sizeof (u64);
+  else
+    sz += window_size / 8;
+  sz = round_pow2 (sz, CLIB_CACHE_LINE_BYTES);
+
+  irt = clib_mem_alloc_aligned (sz, CLIB_CACHE_LINE_BYTES);
+  *irt = (ipsec_sa_inb_rt_t){
+    .use_anti_replay = 1,
+    .use_esn = use_esn,
+    .is_multi_worker = is_multi_worker,
+    .anti_replay_window_size = window_size,
+    .seq64 = seq64,
+  };
+
+  if (is_multi_worker)
+    ipsec_sa_anti_replay_mw_reset (irt);
+  else
+    uword_bitmap_clear (irt->replay_window, window_size / uword_bits);
+
+  return irt;
+}
+
+/*
+ * the decrypt nodes' check, decrypt, check again and advance. a packet
+ * only decrypts with the high sequence number it was sent with.
+ */
+static_always_inline int
+test_ipsec_ar_accept (ipsec_sa_inb_rt_t *irt, u64 seq64)
+{
+  u32 seq = seq64, hi;
+
+  if (ipsec_sa_anti_replay_and_sn_advance (irt, seq, ~0, false, &hi))
+    return 0;
+  if (hi != seq64 >> 32)
+    return 0;
+  if (ipsec_sa_anti_replay_and_sn_advance (irt, seq, hi, true, NULL))
+    return 0;
+  if (irt->is_multi_worker)
+    return !ipsec_sa_anti_replay_mw_advance (irt, seq, hi);
+  ipsec_sa_anti_replay_advance (irt, 0, seq, hi);
+  return 1;
+}
+
+/*
+ * Sequence numbers from first on, reordered by less than half a window,
+ * with replays of recent and of long gone packets mixed in.
+ */
+static u64 *
+test_ipsec_ar_seqs (u64 first, u32 n_packets, u32 window_size, u32 *seed)
+{
+  u64 *seqs = 0, tmp;
+  u32 i, j, r;
+
+  for (i = 0; i < n_packets; i++)
+    vec_add1 (seqs, first + i);
+
+  for (i = 0; i + window_size < n_packets; i++)
+    {
+      r = random_u32 (seed);
+      if (r & 1)
+	{
+	  j = i + (r >> 8) % (window_size / 2);
+	  tmp = seqs[i];
+	  seqs[i] = seqs[j];
+	  seqs[j] = tmp;
+	}
+      if ((r & 0x70) == 0 && i > 2 * window_size)
+	/* a replay of a recent packet, or of one out of the window */
+	seqs[i] = seqs[i - ((r & 0x80) ? 2 * window_size : (r >> 8) % 16)];
+    }
+
+  return seqs;
+}
+
+typedef struct
+{
+  ipsec_sa_inb_rt_t *irt;
+  u64 *seqs;
+  u64 first;
+  u32 *n_accepted;
+  u32 *next_block;
+  u8 is_sharded;
+  volatile u32 *go;
+} test_ipsec_ar_thread_t;
+
+static void *
+test_ipsec_ar_thread_fn (void *arg)
+{
+  test_ipsec_ar_thread_t *t = arg;
+  u32 i, n_seqs = vec_len (t->seqs), first, last;
+
+  while (!*t->go)
+    CLIB_PAUSE ();
+
+  for (first = 0; first < n_seqs; first = last)
+    {
+      /* sharded, the threads take the packets a block at a time in the
+       * order they arrive, as the workers receive them */
+      if (t->is_sharded)
+	first = clib_atomic_fetch_add (t->next_block, 1) *
+		IPSEC_SA_SEQ_BLOCK_SIZE;
+      last = clib_min (first + IPSEC_SA_SEQ_BLOCK_SIZE, n_seqs);
+
+      for (i = first; i < last; i++)
+	if (test_ipsec_ar_accept (t->irt, t->seqs[i]))
+	  clib_atomic_fetch_add (&t->n_accepted[t->seqs[i] - t->first], 1);
+    }
+
+  return 0;
+}
+
+/*
+ * Run the packets on n_threads threads sharing a multi-worker window,
+ * every packet on every thread or each packet on one of them. A packet
+ * must never be accepted twice.
+ */
+static clib_error_t *
+test_ipsec_ar_threads (vlib_main_t *vm, u64 *seqs, u64 first,
+		       u32 window_size, int use_esn, u32 n_threads,
+		       u8 is_sharded)
+{
+  test_ipsec_ar_thread_t *threads = 0;
+  ipsec_sa_inb_rt_t *irt;
+  u32 *n_accepted = 0, i, n_total = 0, n_twice = 0, next_block = 0;
+  volatile u32 go = 0;
+  pthread_t *handles = 0;
+  clib_error_t *err = 0;
+  f64 t0, dt;
+
+  irt = test_ipsec_ar_irt_alloc (window_size, use_esn, 1, first - 1);
+  vec_validate (n_accepted, vec_len (seqs) - 1);
+  vec_validate (threads, n_threads - 1);
+  vec_validate (handles, n_threads - 1);
+
+  vec_foreach_index (i, threads)
+    {
+      threads[i] = (test_ipsec_ar_thread_t){
+	.irt = irt,
+	.seqs = seqs,
+	.first = first,
+	.n_accepted = n_accepted,
+	.next_block = &next_block,
+	.is_sharded = is_sharded,
+	.go = &go,
+      };
+      if (pthread_create (&handles[i], NULL, test_ipsec_ar_thread_fn,
+			  &threads[i]))
+	{
+	  vec_set_len (handles, i);
+	  err = clib_error_return_unix (0, "pthread_create");
+	  break;
+	}
+    }
+
+  t0 = unix_time_now ();
+  go = 1;
+  for (i = 0; i < vec_len (handles); i++)
+    pthread_join (handles[i], NULL);
+  dt = unix_time_now () - t0;
+
+  vec_foreach_index (i, n_accepted)
+    {
+      n_total += n_accepted[i];
+      n_twice += n_accepted[i] > 1;
+    }
+
+  if (!err)
+    vlib_cli_output (vm, "  %-10s%-10u%-12.2f%-12u",
+		     is_sharded ? "sharded" : "shared", n_threads,
+		     vec_len (seqs) * (is_sharded ? 1 : n_threads) / dt / 1e6,
+		     n_total);
+
+  if (!err && n_twice)
+    err = clib_error_return (0, "failed: %s, %u packets accepted twice",
+			     is_sharded ? "sharded" : "shared", n_twice);
+
+  vec_free (threads);
+  vec_free (handles);
+  vec_free (n_accepted);
+  clib_mem_free (irt);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_ar_run (vlib_main_t *vm, u64 first, u32 n_packets, u32 window_size,
+		   int use_esn, u32 n_threads, u32 *seed)
+{
+  ipsec_sa_inb_rt_t *irt[2];
+  u32 i, j, n_accepted[2] = {}, n_diff = 0;
+  u64 *seqs, t[2];
+  clib_error_t *err = 0;
+  int accepted[2];
+
+  seqs = test_ipsec_ar_seqs (first, n_packets, window_size, seed);
+
+  /*
+   * the multi-worker window must take the same decisions as the
+   * single worker one when the packets come one at a time
+   */
+  for (j = 0; j < 2; j++)
+    irt[j] = test_ipsec_ar_irt_alloc (window_size, use_esn, j, first - 1);
+
+  vec_foreach_index (i, seqs)
+    {
+      for (j = 0; j < 2; j++)
+	n_accepted[j] += accepted[j] = test_ipsec_ar_accept (irt[j], seqs[i]);
+      if (accepted[0] != accepted[1] && n_diff++ == 0)
+	err = clib_error_return (
+	  0, "failed: packet %u seq 0x%llx accepted %d by single worker, "
+	     "%d by multi-worker", i, seqs[i], accepted[0], accepted[1]);
+    }
+
+  /* the cost of the check and advance of in order packets */
+  for (j = 0; j < 2; j++)
+    {
+      clib_mem_free (irt[j]);
+      irt[j] = test_ipsec_ar_irt_alloc (window_size, use_esn, j, first - 1);
+      t[j] = clib_cpu_time_now ();
+      for (i = 0; i < n_packets; i++)
+	test_ipsec_ar_accept (irt[j], first + i);
+      t[j] = clib_cpu_time_now () - t[j];
+      clib_mem_free (irt[j]);
+    }
+
+  vlib_cli_output (vm, "%s window %u, %u packets from 0x%llx",
+		   use_esn ? "esn" : "no esn", window_size, n_packets, first);
+  vlib_cli_output (vm, "  %-14s%-12s%-12s", "", "clk/pkt", "accepted");
+  vlib_cli_output (vm, "  %-14s%-12.2f%-12u", "single worker",
+		   (f64) t[0] / n_packets, n_accepted[0]);
+  vlib_cli_output (vm, "  %-14s%-12.2f%-12u", "multi-worker",
+		   (f64) t[1] / n_packets, n_accepted[1]);
+
+  if (!err && n_threads)
+    {
+      vlib_cli_output (vm, "  %-10s%-10s%-12s%-12s", "packets", "threads",
+		       "Mpps", "accepted");
+      for (j = 0; j < 2 && !err; j++)
+	err = test_ipsec_ar_threads (vm, seqs, first, window_size, use_esn,
+				     n_threads, j);
+    }
+
+  vec_free (seqs);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_anti_replay_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  u32 n_packets = 1 << 20, window_size = 1024, n_threads = 4;
+  u32 seed = random_default_seed ();
+  clib_error_t *err;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "window %u", &window_size))
+	;
+      else if (unformat (input, "threads %u", &n_threads))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (window_size < 64 || !is_pow2 (window_size))
+    return clib_error_return (0, "window must be a power of 2, >= 64");
+  if (n_packets < 4 * window_size)
+    return clib_error_return (0, "packets must be at least 4 windows");
+
+  vlib_cli_output (vm, "seed %u", seed);
+
+  err = test_ipsec_ar_run (vm, 1, n_packets, window_size, 0, n_threads,
+			   &seed);
+  if (!err)
+    /* across the wrap of the low 32 bits of the sequence number */
+    err = test_ipsec_ar_run (vm, (1ULL << 32) - n_packets / 2, n_packets,
+			     window_size, 1, n_threads, &seed);
+
+  return err;
+}
+
+/*
+ * One frame's worth of decrypted packets through the post-decrypt replay
+ * check and advance, the frame's leading in order runs at once if batched.
+ */
+static_always_inline u64
+test_ipsec_ar_frame (ipsec_sa_inb_rt_t *irt, u32 *seqs, u32 n_seqs,
+		     int batched)
+{
+  u32 i = 0, n;
+  u64 n_lost = 0;
+
+  if (batched)
+    while ((n = ipsec_sa_anti_replay_run_len (irt, seqs + i, n_seqs - i,
+					      0)) > 1)
+      {
+	n_lost += ipsec_sa_anti_replay_advance_run (irt, seqs + i, n);
+	i += n;
+      }
+
+  for (; i < n_seqs; i++)
+    if (!ipsec_sa_anti_replay_and_sn_advance (irt, seqs[i], 0, true, NULL))
+      n_lost += ipsec_sa_anti_replay_advance (irt, 0, seqs[i], 0);
+
+  return n_lost;
+}
+
+static clib_error_t *
+test_ipsec_ar_batch (vlib_main_t *vm, u32 window_size, u32 n_frames,
+		     u32 loss, u32 *seed)
+{
+  ipsec_sa_inb_rt_t *irt[2];
+  u32 *seqs = 0, seq = 0, i, j, tmp;
+  u64 n_lost[2] = {}, t[2] = {}, t0;
+  clib_error_t *err = 0;
+
+  for (j = 0; j < 2; j++)
+    irt[j] = test_ipsec_ar_irt_alloc (window_size, 0, 0, 0);
+
+  vec_validate (seqs, VLIB_FRAME_SIZE - 1);
+
+  for (i = 0; i < n_frames; i++)
+    {
+      /* in order, loss percent of the packets lost, and every so often
+       * two packets swapped or one replayed */
+      for (j = 0; j < VLIB_FRAME_SIZE; j++)
+	{
+	  do
+	    seq++;
+	  while (random_u32 (seed) % 100 < loss);
+	  seqs[j] = seq;
+	}
+      j = random_u32 (seed) % (VLIB_FRAME_SIZE - 1);
+      if ((i & 15) == 0)
+	{
+	  tmp = seqs[j];
+	  seqs[j] = seqs[j + 1];
+	  seqs[j + 1] = tmp;
+	}
+      else if ((i & 15) == 1)
+	seqs[j + 1] = seqs[j];
+
+      for (j = 0; j < 2; j++)
+	{
+	  t0 = clib_cpu_time_now ();
+	  n_lost[j] +=
+	    test_ipsec_ar_frame (irt[j], seqs, VLIB_FRAME_SIZE, j);
+	  t[j] += clib_cpu_time_now () - t0;
+	}
+
+      if (irt[0]->seq64 != irt[1]->seq64 || n_lost[0] != n_lost[1] ||
+	  memcmp (irt[0]->replay_window, irt[1]->replay_window,
+		  window_size / 8))
+	{
+	  err = clib_error_return (0, "failed: window %u, frame %u differs",
+				   window_size, i);
+	  break;
+	}
+    }
+
+  if (!err)
+    vlib_cli_output (vm, "%-10u%-14.2f%-14.2f%-10llu", window_size,
+		     (f64) t[0] / n_frames / VLIB_FRAME_SIZE,
+		     (f64) t[1] / n_frames / VLIB_FRAME_SIZE, n_lost[0]);
+
+  for (j = 0; j < 2; j++)
+    clib_mem_free (irt[j]);
+  vec_free (seqs);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_anti_replay_batch_command_fn (vlib_main_t *vm,
+					 unformat_input_t *input,
+					 vlib_cli_command_t *cmd)
+{
+  u32 n_frames = 4096, loss = 1, window_size;
+  u32 seed = random_default_seed ();
+  clib_error_t *err = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "frames %u", &n_frames))
+	;
+      else if (unformat (input, "loss %u", &loss))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (loss >= 100)
+    return clib_error_return (0, "loss is a percentage, below 100");
+
+  vlib_cli_output (vm, "seed %u, %u frames, %u%% loss", seed, n_frames,
+		   loss);
+  vlib_cli_output (vm, "%-10s%-14s%-14s%-10s", "window", "per-packet",
+		   "batched", "lost");
+  vlib_cli_output (vm, "%-10s%-14s%-14s", "", "clk/pkt", "clk/pkt");
+
+  for (window_size = 64; window_size <= 4096 && !err; window_size *= 4)
+    err = test_ipsec_ar_batch (vm, window_size, n_frames, loss, &seed);
+
+  return err;
+}
+
+/*
+ * The outbound half of a multi-worker SA, driven the way the encrypt
+ * nodes do: a run of packets takes its numbers and the worker gives up
+ * the rest of its block at the end of the run.
+ */
+static ipsec_sa_outb_rt_t *
+test_ipsec_seq_ort_alloc (u32 n_workers, int use_esn, u64 seq64)
+{
+  ipsec_sa_outb_rt_t *ort;
+
+  ort = clib_mem_alloc_aligned (sizeof (*ort), CLIB_CACHE_LINE_BYTES);
+  *ort = (ipsec_sa_outb_rt_t){
+    .use_esn = use_esn,
+    .is_multi_worker = 1,
+    .seq64 = seq64,
+  };
+  vec_validate_aligned (ort->seq_blocks, n_workers - 1,
+			CLIB_CACHE_LINE_BYTES);
+  return ort;
+}
+
+static void
+test_ipsec_seq_ort_free (ipsec_sa_outb_rt_t *ort)
+{
+  vec_free (ort->seq_blocks);
+  clib_mem_free (ort);
+}
+
+/* numbers up to n_packets packets of a run, returns how many got one */
+static u32
+test_ipsec_seq_run (ipsec_sa_outb_rt_t *ort, u32 worker, u32 n_packets,
+		    u64 **seqs)
+{
+  u64 seq;
+  u32 i;
+
+  for (i = 0; i < n_packets; i++)
+    {
+      if (esp_seq_advance (ort, worker, &seq))
+	break;
+      vec_add1 (*seqs, seq);
+    }
+  return i;
+}
+
+static int
+test_ipsec_seq_cmp (void *a1, void *a2)
+{
+  u64 *s1 = a1, *s2 = a2;
+  return *s1 < *s2 ? -1 : *s1 > *s2;
+}
+
+/* a sequence number must never be sent twice */
+static u32
+test_ipsec_seq_n_dups (u64 *seqs)
+{
+  u64 *sorted = vec_dup (seqs);
+  u32 i, n_dups = 0;
+
+  vec_sort_with_function (sorted, test_ipsec_seq_cmp);
+  for (i = 1; i < vec_len (sorted); i++)
+    n_dups += sorted[i] == sorted[i - 1];
+  vec_free (sorted);
+  return n_dups;
+}
+
+static clib_error_t *
+test_ipsec_seq_idle_worker (vlib_main_t *vm, u32 n_workers, u32 n_runs,
+			    u32 *seed)
+{
+  ipsec_sa_outb_rt_t *ort;
+  u64 *seqs = 0, top = 0;
+  u32 i, w, n, first;
+  clib_error_t *err = 0;
+
+  ort = test_ipsec_seq_ort_alloc (n_workers, 0, 0);
+
+  /* worker 0 sends a packet, then idles while the others send */
+  test_ipsec_seq_run (ort, 0, 1, &seqs);
+  esp_seq_release (ort, 0);
+
+  for (i = 0; i < n_runs; i++)
+    {
+      w = 1 + random_u32 (seed) % (n_workers - 1);
+      n = 1 + random_u32 (seed) % VLIB_FRAME_SIZE;
+      test_ipsec_seq_run (ort, w, n, &seqs);
+      esp_seq_release (ort, w);
+    }
+
+  vec_foreach_index (i, seqs)
+    top = clib_max (top, seqs[i]);
+
+  /* when it wakes up its packets must be in the peer's window */
+  first = vec_len (seqs);
+  test_ipsec_seq_run (ort, 0, 1, &seqs);
+  esp_seq_release (ort, 0);
+
+  if (seqs[first] <= top)
+    err = clib_error_return (0, "failed: idle worker sent seq %llu after %llu",
+			     seqs[first], top);
+  else if ((n = test_ipsec_seq_n_dups (seqs)))
+    err = clib_error_return (0, "failed: %u sequence numbers sent twice", n);
+  else if (ort->seq64 != vec_len (seqs))
+    /* run after run on one thread no number is ever skipped */
+    err = clib_error_return (0, "failed: %llu numbers taken, %u sent",
+			     ort->seq64, vec_len (seqs));
+
+  if (!err)
+    vlib_cli_output (vm, "idle worker: %u packets on %u workers, ok",
+		     vec_len (seqs), n_workers);
+
+  vec_free (seqs);
+  test_ipsec_seq_ort_free (ort);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_seq_exhaust (vlib_main_t *vm, u32 n_workers, int use_esn)
+{
+  u64 max = use_esn ? CLIB_U64_MAX : CLIB_U32_MAX;
+  u64 start = max - 3 * IPSEC_SA_SEQ_BLOCK_SIZE / 2;
+  ipsec_sa_outb_rt_t *ort;
+  u64 *seqs = 0;
+  u32 i, n, n_active = n_workers;
+  clib_error_t *err = 0;
+
+  ort = test_ipsec_seq_ort_alloc (n_workers, use_esn, start);
+
+  /* all the workers hold blocks at once, none of them releases */
+  while (n_active)
+    for (i = n_active = 0; i < n_workers; i++)
+      n_active += test_ipsec_seq_run (ort, i, 1, &seqs);
+
+  for (i = 0; i < n_workers; i++)
+    esp_seq_release (ort, i);
+
+  if (ort->seq64 != max)
+    err = clib_error_return (0, "failed: %s seq64 0x%llx past 0x%llx",
+			     use_esn ? "esn" : "no esn", ort->seq64, max);
+  else if (vec_len (seqs) != max - start)
+    err = clib_error_return (0, "failed: %s %u packets sent, %llu expected",
+			     use_esn ? "esn" : "no esn", vec_len (seqs),
+			     max - start);
+  else if ((n = test_ipsec_seq_n_dups (seqs)))
+    err = clib_error_return (0, "failed: %u sequence numbers sent twice", n);
+
+  if (!err)
+    vlib_cli_output (vm, "%s exhaustion: %u packets on %u workers, ok",
+		     use_esn ? "esn" : "no esn", vec_len (seqs), n_workers);
+
+  vec_free (seqs);
+  test_ipsec_seq_ort_free (ort);
+  return err;
+}
+
+static clib_error_t *
+test_ipsec_seq_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			   vlib_cli_command_t *cmd)
+{
+  u32 n_workers = 4, n_runs = 4096;
+  u32 seed = random_default_seed ();
+  clib_error_t *err;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "workers %u", &n_workers))
+	;
+      else if (unformat (input, "runs %u", &n_runs))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_workers < 2)
+    return clib_error_return (0, "at least 2 workers needed");
+
+  vlib_cli_output (vm, "seed %u", seed);
+
+  err = test_ipsec_seq_idle_worker (vm, n_workers, n_runs, &seed);
+  if (!err)
+    err = test_ipsec_seq_exhaust (vm, n_workers, 0);
+  if (!err)
+    err = test_ipsec_seq_exhaust (vm, n_workers, 1);
+
+  return err;
+}
+
 VLIB_CLI_COMMAND (test_ipsec_spd_perf_command, static) = {
   .path = "test ipsec_spd_outbound_perf",
   .short_help = "test ipsec_spd_outbound_perf flows <n_flows>",
   .function = test_ipsec_spd_outbound_perf_command_fn,
 };
 
+VLIB_CLI_COMMAND (test_ipsec_spd_flow_cache_command, static) = {
+  .path = "test ipsec spd flow-cache",
+  .short_help = "test ipsec spd flow-cache [policies <n>] [iterations <n>]",
+  .function = test_ipsec_spd_flow_cache_command_fn,
+};
+
+VLIB_CLI_COMMAND (test_ipsec_anti_replay_command, static) = {
+  .path = "test ipsec anti-replay multi-worker",
+  .short_help = "test ipsec anti-replay multi-worker [packets <n>] "
+		"[window <n>] [threads <n>] [seed <n>]",
+  .function = test_ipsec_anti_replay_command_fn,
+};
+
+VLIB_CLI_COMMAND (test_ipsec_anti_replay_batch_command, static) = {
+  .path = "test ipsec anti-replay batch",
+  .short_help = "test ipsec anti-replay batch [frames <n>] [loss <percent>] "
+		"[seed <n>]",
+  .function = test_ipsec_anti_replay_batch_command_fn,
+};
+
+VLIB_CLI_COMMAND (test_ipsec_seq_command, static) = {
+  .path = "test ipsec seq multi-worker",
+  .short_help = "test ipsec seq multi-worker [workers <n>] [runs <n>] "
+		"[seed <n>]",
+  .function = test_ipsec_seq_command_fn,
+};
+
 VLIB_CLI_COMMAND (test_ipsec_command, static) = {
   .path = "test ipsec",
   .short_help = "test ipsec sa <ID> seq-num <VALUE>",
@@ -0,0 +1,301 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/l2/l2_input.h>
+#include <vnet/l2/l2_bd.h>
+
+/* The members are spread round robin over this many split horizon groups */
+#define L2_FLOOD_TEST_N_SHG 4
+
+/* Length of the flooded packet, long enough for header-only clones */
+#define L2_FLOOD_TEST_PACKET_LENGTH 1024
+
+/* Select the members the way l2-flood did, walking the member vector */
+static u32
+l2_flood_test_walk (l2_bridge_domain_t *bd_config, u32 sw_if_index, u8 shg,
+		    u32 *members)
+{
+  l2_flood_member_t *member;
+  u32 n_members = 0;
+  i32 mi;
+
+  for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
+    {
+      member = &bd_config->members[mi];
+      if ((member->sw_if_index != sw_if_index) &&
+	  (!shg || (member->shg != shg)))
+	members[n_members++] = member->sw_if_index;
+    }
+
+  return n_members;
+}
+
+/* Select the members the way l2-flood does, from the flood list */
+static u32
+l2_flood_test_list (l2_bridge_domain_t *bd_config, u32 sw_if_index, u8 shg,
+		    u32 *members)
+{
+  u32 *flood_list = bd_flood_list (bd_config, shg);
+  u32 mi, n_members = 0;
+
+  for (mi = 0; mi < vec_len (flood_list); mi++)
+    if (shg || flood_list[mi] != sw_if_index)
+      members[n_members++] = flood_list[mi];
+
+  return n_members;
+}
+
+/*
+ * What a packet from member i must be flooded to, from the test's own
+ * record of the members rather than from the bridge domain: every other
+ * member, less those in the source's split horizon group, and the BVI.
+ */
+static u32
+l2_flood_test_expect (u32 *sw_if_indices, u32 i, u32 bvi_sw_if_index,
+		      u32 *members)
+{
+  u32 k, n_members = 0;
+  u8 shg = i % L2_FLOOD_TEST_N_SHG;
+
+  for (k = 0; k < vec_len (sw_if_indices); k++)
+    if (k != i && (shg == 0 || k % L2_FLOOD_TEST_N_SHG != shg))
+      members[n_members++] = sw_if_indices[k];
+  members[n_members++] = bvi_sw_if_index;
+
+  return n_members;
+}
+
+static int
+l2_flood_test_cmp (const void *a1, const void *a2)
+{
+  const u32 *s1 = a1, *s2 = a2;
+  return *s1 < *s2 ? -1 : *s1 > *s2;
+}
+
+static clib_error_t *
+l2_flood_test_measure (vlib_main_t *vm, l2_bridge_domain_t *bd_config,
+		       u32 *sw_if_indices, u32 bvi_sw_if_index,
+		       u32 n_iterations, u32 *members, u32 *clones)
+{
+  u32 n_members = vec_len (sw_if_indices), i, j, iter, n, n_walk, n_list;
+  u64 t0, t1, walk, list, clone = 0, n_copies = 0;
+  u32 *flood_list, bi;
+  vlib_buffer_t *b;
+  u8 shg;
+
+  /* both selections must agree for a source in every group */
+  for (i = 0; i < n_members; i++)
+    {
+      shg = i % L2_FLOOD_TEST_N_SHG;
+      n_walk = l2_flood_test_walk (bd_config, sw_if_indices[i], shg, members);
+      n_list = l2_flood_test_list (bd_config, sw_if_indices[i], shg, clones);
+      if (n_walk != n_list ||
+	  memcmp (members, clones, n_walk * sizeof (members[0])))
+	return clib_error_return (0, "failed: %u members, source %u",
+				  n_members, i);
+
+      /* the BVI may change the packet, so it gets the last copy */
+      if (clones[n_list - 1] != bvi_sw_if_index)
+	return clib_error_return (0, "failed: %u members, source %u, BVI "
+				     "not last", n_members, i);
+
+      /* and both must flood to the members the configuration implies */
+      n = l2_flood_test_expect (sw_if_indices, i, bvi_sw_if_index, members);
+      qsort (members, n, sizeof (members[0]), l2_flood_test_cmp);
+      qsort (clones, n_list, sizeof (clones[0]), l2_flood_test_cmp);
+      if (n != n_list || memcmp (members, clones, n * sizeof (members[0])))
+	return clib_error_return (0, "failed: %u members, source %u in "
+				     "group %u, %u copies, %u expected",
+				  n_members, i, shg, n_list, n);
+    }
+
+  n = 0;
+  t0 = clib_cpu_time_now ();
+  for (iter = 0; iter < n_iterations; iter++)
+    for (i = 0; i < VLIB_FRAME_SIZE; i++)
+      {
+	j = i % n_members;
+	n += l2_flood_test_walk (bd_config, sw_if_indices[j],
+				 j % L2_FLOOD_TEST_N_SHG, members);
+      }
+  t1 = clib_cpu_time_now ();
+  walk = t1 - t0;
+
+  /* the lookup l2-flood does per packet before cloning */
+  t0 = clib_cpu_time_now ();
+  for (iter = 0; iter < n_iterations; iter++)
+    for (i = 0; i < VLIB_FRAME_SIZE; i++)
+      {
+	j = i % n_members;
+	shg = j % L2_FLOOD_TEST_N_SHG;
+	flood_list = bd_flood_list (bd_config, shg);
+	n_list = vec_len (flood_list);
+	if (0 == shg)
+	  for (n_walk = 0; n_walk < n_list; n_walk++)
+	    if (flood_list[n_walk] == sw_if_indices[j])
+	      {
+		n_list -= 1;
+		break;
+	      }
+	n -= n_list;
+      }
+  t1 = clib_cpu_time_now ();
+  list = t1 - t0;
+
+  if (n != 0)
+    return clib_error_return (0, "failed: %u members, fanout mismatch",
+			      n_members);
+
+  /* clone one packet to every member of group 0 */
+  n_list = vec_len (bd_flood_list (bd_config, 0));
+  for (iter = 0; iter < n_iterations; iter++)
+    {
+      if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+	return clib_error_return (0, "buffer alloc failure");
+      b = vlib_get_buffer (vm, bi);
+      b->current_length = L2_FLOOD_TEST_PACKET_LENGTH;
+
+      t0 = clib_cpu_time_now ();
+      n = vlib_buffer_clone (vm, bi, clones, n_list,
+			     VLIB_BUFFER_CLONE_HEAD_SIZE);
+      t1 = clib_cpu_time_now ();
+      clone += t1 - t0;
+      n_copies += n;
+
+      vlib_buffer_free (vm, clones, n);
+      if (n == 0)
+	vlib_buffer_free_one (vm, bi);
+    }
+
+  vlib_cli_output (vm, "%-10u%-16.2f%-16.2f%-16.2f", n_members,
+		   (f64) walk / (n_iterations * VLIB_FRAME_SIZE),
+		   (f64) list / (n_iterations * VLIB_FRAME_SIZE),
+		   n_copies ? (f64) clone / n_copies : 0.0);
+  return 0;
+}
+
+static clib_error_t *
+l2_flood_test_fanout (vlib_main_t *vm, u32 max_members, u32 n_iterations)
+{
+  l2_bridge_domain_add_del_args_t a = {
+    .flood = 1,
+    .uu_flood = 1,
+    .forward = 1,
+    .is_add = 1,
+  };
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 *sw_if_indices = 0, *members = 0, *clones = 0;
+  u32 bd_index, sw_if_index, bvi_sw_if_index = ~0, i;
+  clib_error_t *err = 0;
+  int rv;
+
+  a.bd_id = bd_get_unused_id ();
+  if ((rv = bd_add_del (&a)))
+    return clib_error_return (0, "bridge domain create failed: %d", rv);
+  bd_index = bd_find_index (&bd_main, a.bd_id);
+
+  vec_validate (members, max_members + 1);
+  vec_validate (clones, max_members + 1);
+
+  /* a BVI joins first, it must still be flooded to last */
+  if (vnet_create_loopback_interface (&bvi_sw_if_index, 0, 0, 0))
+    err = clib_error_return (0, "loopback create failed");
+  else if (set_int_l2_mode (vm, vnm, MODE_L2_BRIDGE, bvi_sw_if_index,
+			    bd_index, L2_BD_PORT_TYPE_BVI, 0, 0))
+    err = clib_error_return (0, "failed: bridge mode on BVI");
+
+  vlib_cli_output (vm, "%-10s%-16s%-16s%-16s", "members", "walk clk/pkt",
+		   "list clk/pkt", "clone clk/copy");
+
+  for (i = 0; i < max_members && !err; i++)
+    {
+      if (vnet_create_loopback_interface (&sw_if_index, 0, 0, 0))
+	{
+	  err = clib_error_return (0, "loopback create failed");
+	  break;
+	}
+      vec_add1 (sw_if_indices, sw_if_index);
+
+      if (set_int_l2_mode (vm, vnm, MODE_L2_BRIDGE, sw_if_index, bd_index,
+			   L2_BD_PORT_TYPE_NORMAL, i % L2_FLOOD_TEST_N_SHG,
+			   0))
+	{
+	  err = clib_error_return (0, "failed: bridge mode on member %u", i);
+	  break;
+	}
+
+      /* report the fanouts that are powers of two, and the last one */
+      if (i > 0 && (is_pow2 (i + 1) || i + 1 == max_members))
+	{
+	  err = l2_flood_test_measure (vm, l2input_bd_config (bd_index),
+				       sw_if_indices, bvi_sw_if_index,
+				       n_iterations, members, clones);
+	  if (err)
+	    break;
+	}
+    }
+
+  vec_foreach_index (i, sw_if_indices)
+    {
+      set_int_l2_mode (vm, vnm, MODE_L3, sw_if_indices[i], 0,
+		       L2_BD_PORT_TYPE_NORMAL, 0, 0);
+      vnet_delete_loopback_interface (sw_if_indices[i]);
+    }
+  if (bvi_sw_if_index != ~0)
+    {
+      set_int_l2_mode (vm, vnm, MODE_L3, bvi_sw_if_index, 0,
+		       L2_BD_PORT_TYPE_NORMAL, 0, 0);
+      vnet_delete_loopback_interface (bvi_sw_if_index);
+    }
+
+  a.is_add = 0;
+  bd_add_del (&a);
+
+  vec_free (sw_if_indices);
+  vec_free (members);
+  vec_free (clones);
+  return err;
+}
+
+static clib_error_t *
+l2_flood_test (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd_arg)
+{
+  u32 max_members = 256, n_iterations = 1000;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "members %u", &max_members))
+	;
+      else if (unformat (input, "iterations %u", &n_iterations))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (max_members < 2 || n_iterations == 0)
+    return clib_error_return (0, "at least 2 members and 1 iteration "
+				 "required");
+
+  return l2_flood_test_fanout (vm, max_members, n_iterations);
+}
+
+VLIB_CLI_COMMAND (test_l2_flood_fanout_command, static) = {
+  .path = "test l2 flood fanout",
+  .short_help = "test l2 flood fanout [members <n>] [iterations <n>]",
+  .function = l2_flood_test,
+};
+
+clib_error_t *
+l2_flood_test_init (vlib_main_t *vm)
+{
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (l2_flood_test_init);
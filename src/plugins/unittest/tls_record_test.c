@@ -0,0 +1,412 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+#include <vnet/tls/tls_record.h>
+
+/*
+ * TLS record protection benchmark: the same data is protected with records
+ * handed to the crypto engines a batch at a time, the way
+ * tls_record_encrypt/decrypt do it, and one record per call, the way the
+ * engines get them from a TLS library. Both must produce the same records,
+ * and the batch must decrypt back to the data. One CSV row is printed per
+ * measurement, throughput is for a single core.
+ *
+ * Then the data is written as app writes of mixed sizes, one record per
+ * write, or held and coalesced into full records the way
+ * tls_record_coalesce () decides, with writes TLS_RECORD_TEST_GAP
+ * apart.
+ */
+
+#define TLS_RECORD_TEST_ROUNDS 16
+#define TLS_RECORD_TEST_GAP    1e-6
+#define TLS_RECORD_TEST_DESCS  64
+
+typedef struct
+{
+  vnet_crypto_alg_t *algs;
+  u32 n_bytes;
+  u32 record_size;
+  u32 *write_sizes;
+  f64 coalesce_time;
+  u32 n_failed;
+  u8 *data, *records, *records_one, *out;
+  u32 records_len;
+} tls_record_test_t;
+
+static void
+tls_record_test_fail (vlib_main_t *vm, tls_record_test_t *t,
+		      vnet_crypto_alg_t alg, char *what, tls_record_error_t err)
+{
+  vlib_cli_output (vm, "# %U: %s failed: %U", format_vnet_crypto_alg, alg,
+		   what, format_tls_record_error, err);
+  t->n_failed++;
+}
+
+/* protect n_bytes of data, in one call or in one call per record */
+static tls_record_error_t
+tls_record_test_encrypt (vlib_main_t *vm, tls_record_test_t *t,
+			 tls_record_crypto_t *rc, u8 *dst, int one)
+{
+  u32 read = 0, wrote = 0, n_read, n_written, len;
+  tls_record_error_t err;
+
+  rc->seq = 0;
+  while (read < t->n_bytes)
+    {
+      len = one ? clib_min (t->record_size, t->n_bytes - read) :
+		  t->n_bytes - read;
+      err = tls_record_encrypt (vm, rc, TLS_REC_APPLICATION_DATA,
+				t->data + read, len, dst + wrote,
+				vec_len (t->records) - wrote, t->record_size,
+				&n_read, &n_written);
+      if (err || !n_read)
+	return err ? err : TLS_RECORD_ERR_INVALID;
+      read += n_read;
+      wrote += n_written;
+    }
+
+  t->records_len = wrote;
+  return TLS_RECORD_ERR_OK;
+}
+
+static tls_record_error_t
+tls_record_test_decrypt (vlib_main_t *vm, tls_record_test_t *t,
+			 tls_record_crypto_t *rc, u8 *src, int one)
+{
+  u32 read = 0, wrote = 0, n_read, n_descs, len, off, i;
+  tls_record_desc_t descs[TLS_RECORD_TEST_DESCS];
+  tls_record_error_t err;
+
+  rc->seq = 0;
+  while (read < t->records_len)
+    {
+      len = t->records_len - read;
+      if (one)
+	len = clib_min (len, TLS13_RECORD_OVERHEAD + t->record_size);
+      n_descs = ARRAY_LEN (descs);
+      err = tls_record_decrypt (vm, rc, src + read, len, t->out + wrote,
+				vec_len (t->out) - wrote, &n_read, descs,
+				&n_descs);
+      if (err || !n_descs)
+	return err ? err : TLS_RECORD_ERR_INVALID;
+      /* content is packed in record order */
+      for (i = 0, off = 0; i < n_descs; i++)
+	{
+	  if (descs[i].type != TLS_REC_APPLICATION_DATA ||
+	      descs[i].offset != off)
+	    return TLS_RECORD_ERR_INVALID;
+	  off += descs[i].len;
+	}
+      read += n_read;
+      wrote += off;
+    }
+
+  return wrote == t->n_bytes ? TLS_RECORD_ERR_OK : TLS_RECORD_ERR_INVALID;
+}
+
+static void
+tls_record_test_report (vlib_main_t *vm, tls_record_test_t *t,
+			vnet_crypto_alg_t alg, char *mode, char *dir,
+			u64 clocks)
+{
+  f64 bytes = (f64) t->n_bytes * TLS_RECORD_TEST_ROUNDS;
+  f64 secs = clocks / vm->clib_time.clocks_per_second;
+
+  vlib_cli_output (vm, "%U,%s,%s,%u,%u,%.2f,%.3f", format_vnet_crypto_alg,
+		   alg, mode, dir, t->record_size,
+		   (t->n_bytes + t->record_size - 1) / t->record_size,
+		   bytes * 8 / secs * 1e-9, clocks / bytes);
+}
+
+/* returns the number of records the writes made */
+static u32
+tls_record_test_writes (vlib_main_t *vm, tls_record_test_t *t,
+			tls_record_crypto_t *rc, int coalesce)
+{
+  u32 off = 0, len, w = 0, pending = 0, n_send, wrote = 0, n_read;
+  u32 n_written;
+  f64 now = 0, hold_start = 0;
+
+  rc->seq = 0;
+  while (off + pending < t->n_bytes)
+    {
+      len = t->write_sizes[w++ % vec_len (t->write_sizes)];
+      pending += clib_min (len, t->n_bytes - off - pending);
+      now += TLS_RECORD_TEST_GAP;
+
+      /* the last write goes out whatever its size */
+      n_send = pending;
+      if (coalesce && off + pending < t->n_bytes)
+	n_send = tls_record_coalesce (&hold_start, pending, t->record_size,
+				      t->coalesce_time, now);
+
+      while (n_send)
+	{
+	  if (tls_record_encrypt (vm, rc, TLS_REC_APPLICATION_DATA,
+				  t->data + off, n_send, t->records + wrote,
+				  vec_len (t->records) - wrote, t->record_size,
+				  &n_read, &n_written) ||
+	      !n_read)
+	    return 0;
+	  off += n_read;
+	  pending -= n_read;
+	  n_send -= n_read;
+	  wrote += n_written;
+	}
+    }
+
+  return rc->seq;
+}
+
+static void
+tls_record_test_alg_writes (vlib_main_t *vm, tls_record_test_t *t,
+			    vnet_crypto_alg_t alg, tls_record_crypto_t *rc)
+{
+  f64 secs, bytes = (f64) t->n_bytes * TLS_RECORD_TEST_ROUNDS;
+  u32 r, n_records = 0;
+  u64 t0, clocks;
+  int coalesce;
+
+  for (coalesce = 0; coalesce < 2; coalesce++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (r = 0; r < TLS_RECORD_TEST_ROUNDS; r++)
+	n_records = tls_record_test_writes (vm, t, rc, coalesce);
+      clocks = clib_cpu_time_now () - t0;
+
+      if (!n_records)
+	{
+	  tls_record_test_fail (vm, t, alg, "writes", TLS_RECORD_ERR_INVALID);
+	  return;
+	}
+
+      secs = clocks / vm->clib_time.clocks_per_second;
+      vlib_cli_output (vm, "%U,%s,%u,%.2f,%.2f,%.3f", format_vnet_crypto_alg,
+		       alg, coalesce ? "coalesce" : "write", n_records,
+		       (f64) t->n_bytes / n_records, bytes * 8 / secs * 1e-9,
+		       n_records * TLS_RECORD_TEST_ROUNDS / secs * 1e-6);
+    }
+}
+
+static void
+tls_record_test_alg (vlib_main_t *vm, tls_record_test_t *t,
+		     vnet_crypto_alg_t alg)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  tls_record_crypto_t enc = {}, dec = {};
+  vnet_crypto_op_id_t id;
+  tls_record_error_t err;
+  u8 key[32], iv[TLS_RECORD_IV_LEN];
+  u64 t0, clocks;
+  u32 i, r;
+  int one;
+
+  for (i = 0; i < VNET_CRYPTO_OP_N_TYPES; i++)
+    {
+      id = cm->algs[alg].op_by_type[i];
+      if (id != VNET_CRYPTO_OP_NONE &&
+	  !cm->opt_data[id].handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE])
+	{
+	  vlib_cli_output (vm, "# %U: no handler", format_vnet_crypto_alg,
+			   alg);
+	  return;
+	}
+    }
+
+  for (i = 0; i < sizeof (key); i++)
+    key[i] = i * 7 + 1;
+  for (i = 0; i < sizeof (iv); i++)
+    iv[i] = i * 13 + 2;
+
+  if ((err = tls_record_crypto_init (vm, &enc, alg, 1, key, iv, 0)))
+    {
+      tls_record_test_fail (vm, t, alg, "key", err);
+      return;
+    }
+  if ((err = tls_record_crypto_init (vm, &dec, alg, 0, key, iv, 0)))
+    {
+      tls_record_test_fail (vm, t, alg, "key", err);
+      tls_record_crypto_free (vm, &enc);
+      return;
+    }
+
+  /* batched and one by one records must be the same, and decrypt back */
+  if ((err = tls_record_test_encrypt (vm, t, &enc, t->records_one, 1)) ||
+      (err = tls_record_test_encrypt (vm, t, &enc, t->records, 0)))
+    {
+      tls_record_test_fail (vm, t, alg, "encrypt", err);
+      goto done;
+    }
+  if (memcmp (t->records, t->records_one, t->records_len))
+    {
+      tls_record_test_fail (vm, t, alg, "batch compare", TLS_RECORD_ERR_OK);
+      goto done;
+    }
+  if ((err = tls_record_test_decrypt (vm, t, &dec, t->records, 0)) ||
+      memcmp (t->out, t->data, t->n_bytes))
+    {
+      tls_record_test_fail (vm, t, alg, "decrypt", err);
+      goto done;
+    }
+
+  /* a modified record does not authenticate */
+  t->records_one[t->records_len - 1] ^= 1;
+  err = tls_record_test_decrypt (vm, t, &dec, t->records_one, 0);
+  t->records_one[t->records_len - 1] ^= 1;
+  if (err != TLS_RECORD_ERR_BAD_RECORD_MAC)
+    {
+      tls_record_test_fail (vm, t, alg, "tamper", err);
+      goto done;
+    }
+
+  for (one = 0; one < 2; one++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (r = 0; r < TLS_RECORD_TEST_ROUNDS; r++)
+	tls_record_test_encrypt (vm, t, &enc, t->records_one, one);
+      clocks = clib_cpu_time_now () - t0;
+      tls_record_test_report (vm, t, alg, one ? "record" : "batch",
+			      "encrypt", clocks);
+
+      t0 = clib_cpu_time_now ();
+      for (r = 0; r < TLS_RECORD_TEST_ROUNDS; r++)
+	tls_record_test_decrypt (vm, t, &dec, t->records, one);
+      clocks = clib_cpu_time_now () - t0;
+      tls_record_test_report (vm, t, alg, one ? "record" : "batch",
+			      "decrypt", clocks);
+
+      /* let the rest of the system breathe */
+      vlib_process_suspend (vm, 1e-5);
+    }
+
+  if (t->write_sizes)
+    tls_record_test_alg_writes (vm, t, alg, &enc);
+
+done:
+  tls_record_crypto_free (vm, &enc);
+  tls_record_crypto_free (vm, &dec);
+}
+
+static clib_error_t *
+test_tls_record_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  tls_record_test_t _t = {
+    .n_bytes = 1 << 20,
+    .record_size = TLS_FRAGMENT_MAX_LEN,
+  }, *t = &_t;
+  vnet_crypto_alg_t alg, *a;
+  clib_error_t *err = 0;
+  u32 i, n, n_records, min_write = ~0, coalesce_us = 50;
+  u8 writes = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "alg %U", unformat_vnet_crypto_alg, &alg))
+	vec_add1 (t->algs, alg);
+      else if (unformat (input, "bytes %u", &t->n_bytes))
+	;
+      else if (unformat (input, "record-size %u", &t->record_size))
+	;
+      else if (unformat (input, "write-size %u", &n))
+	vec_add1 (t->write_sizes, n);
+      else if (unformat (input, "coalesce-time %u", &coalesce_us))
+	;
+      else if (unformat (input, "no-writes"))
+	writes = 0;
+      else
+	{
+	  err = clib_error_return (0, "unknown input `%U'",
+				   format_unformat_error, input);
+	  goto done;
+	}
+    }
+
+  if (!t->n_bytes)
+    {
+      err = clib_error_return (0, "bytes must be non-zero");
+      goto done;
+    }
+  if (!t->record_size || t->record_size > TLS_FRAGMENT_MAX_LEN)
+    {
+      err = clib_error_return (0, "record-size must be 1 to %u",
+			       TLS_FRAGMENT_MAX_LEN);
+      goto done;
+    }
+
+  if (!t->algs)
+    {
+      vnet_crypto_alg_t algs[] = {
+	VNET_CRYPTO_ALG_AES_128_GCM,
+	VNET_CRYPTO_ALG_AES_256_GCM,
+	VNET_CRYPTO_ALG_CHACHA20_POLY1305,
+      };
+      vec_add (t->algs, algs, ARRAY_LEN (algs));
+    }
+
+  if (writes && !t->write_sizes)
+    {
+      u32 sizes[] = { 64, 300, 1460, 4096, 9000 };
+      vec_add (t->write_sizes, sizes, ARRAY_LEN (sizes));
+    }
+  if (!writes)
+    vec_free (t->write_sizes);
+  vec_foreach_index (i, t->write_sizes)
+    {
+      if (!t->write_sizes[i])
+	{
+	  err = clib_error_return (0, "write-size must be non-zero");
+	  goto done;
+	}
+      min_write = clib_min (min_write, t->write_sizes[i]);
+    }
+  t->coalesce_time = coalesce_us * 1e-6;
+
+  n_records = (t->n_bytes + t->record_size - 1) / t->record_size;
+  /* with a record per write, each write adds at most one short record */
+  if (t->write_sizes)
+    n_records += t->n_bytes / min_write + 1;
+  vec_validate (t->data, t->n_bytes - 1);
+  vec_validate (t->records, t->n_bytes + n_records * TLS13_RECORD_OVERHEAD);
+  vec_validate (t->records_one, vec_len (t->records) - 1);
+  /* records are decrypted with their inner type */
+  vec_validate (t->out, t->n_bytes + n_records - 1);
+  for (i = 0; i < t->n_bytes; i++)
+    t->data[i] = i * 31 + (i >> 8);
+
+  vlib_cli_output (vm, "# cpu-freq %.2f GHz",
+		   vm->clib_time.clocks_per_second * 1e-9);
+  vlib_cli_output (vm, "alg,mode,dir,record_size,records,gbps,"
+		       "clocks_per_byte");
+
+  if (t->write_sizes)
+    vlib_cli_output (vm, "# writes: alg,mode,records,bytes_per_record,gbps,"
+			 "mrecords_per_sec");
+
+  vec_foreach (a, t->algs)
+    tls_record_test_alg (vm, t, a[0]);
+
+  if (t->n_failed)
+    err = clib_error_return (0, "failed: %u checks", t->n_failed);
+
+done:
+  vec_free (t->algs);
+  vec_free (t->write_sizes);
+  vec_free (t->data);
+  vec_free (t->records);
+  vec_free (t->records_one);
+  vec_free (t->out);
+  return err;
+}
+
+VLIB_CLI_COMMAND (test_tls_record_command, static) = {
+  .path = "test tls record",
+  .short_help = "test tls record [alg <alg>]... [bytes <n>] "
+		"[record-size <n>] [write-size <n>]... [coalesce-time <us>] "
+		"[no-writes]",
+  .function = test_tls_record_command_fn,
+};
@@ -36,6 +36,21 @@ wg_set_async_mode (u32 is_enabled)
     wg_op_mode_unset_ASYNC ();
 }
 
+/*
+ * In multi-worker mode data packets are encrypted and decrypted on the
+ * worker they arrive on, instead of being handed off to the worker the
+ * peer is pinned to. A peer's packets may then leave slightly out of
+ * order, which the receive window absorbs.
+ */
+void
+wg_set_multi_worker_mode (u32 is_enabled)
+{
+  if (is_enabled)
+    wg_op_mode_set_MULTI_WORKER ();
+  else
+    wg_op_mode_unset_MULTI_WORKER ();
+}
+
 static void
 wireguard_register_post_node (vlib_main_t *vm)
 
@@ -19,6 +19,7 @@
 #include <wireguard/wireguard_messages.h>
 #include <wireguard/wireguard_timer.h>
 #include <vnet/buffer.h>
+#include <vppinfra/fifo.h>
 
 #define WG_DEFAULT_DATA_SIZE 2048
 
@@ -37,6 +38,39 @@ typedef struct wg_per_thread_data_t_
   u8 data[WG_DEFAULT_DATA_SIZE];
 } wg_per_thread_data_t;
 
+/*
+ * Handshake packets are not processed by the input nodes. They are queued
+ * on the main thread, where the keypairs they make must be installed, and
+ * a process handles them a batch at a time, so a burst of handshakes does
+ * not hold up the main thread's packet processing. Once the queue is
+ * WG_HANDSHAKE_QUEUE_UNDER_LOAD deep the interfaces are under load and
+ * answer with cookie replies instead of doing the DH.
+ */
+#define WG_HANDSHAKE_QUEUE_SIZE	      4096
+#define WG_HANDSHAKE_QUEUE_UNDER_LOAD 256
+#define WG_HANDSHAKE_BATCH	      64
+
+typedef struct
+{
+  u32 bi;
+  u8 is_ip4;
+  f64 enqueue_time;
+} wg_handshake_elt_t;
+
+typedef struct
+{
+  /* fifo of queued packets, main thread only */
+  wg_handshake_elt_t *fifo;
+  u32 max_depth;
+  u64 n_enqueued;
+  u64 n_processed;
+  u64 n_queue_full;
+  u64 n_expired;
+  /* time from enqueue to processing */
+  f64 latency_sum;
+  f64 latency_max;
+} wg_handshake_queue_t;
+
 typedef struct
 {
   /* convenience */
@@ -58,6 +92,8 @@ typedef struct
 
   /* operation mode flags (e.g. async) */
   u8 op_mode_flags;
+
+  wg_handshake_queue_t handshake_queue;
 } wg_main_t;
 
 typedef struct
@@ -74,7 +110,9 @@ extern wg_main_t wg_main;
 /**
  * Wireguard operation mode
  **/
-#define foreach_wg_op_mode_flags _ (0, ASYNC, "async")
+#define foreach_wg_op_mode_flags                                              \
+  _ (0, ASYNC, "async")                                                       \
+  _ (1, MULTI_WORKER, "multi-worker")
 
 /**
  * Helper function to set/unset and check op modes
@@ -119,6 +157,7 @@ STATIC_ASSERT (sizeof (wg_post_data_t) <=
 #define WG_START_EVENT	1
 void wg_feature_init (wg_main_t * wmp);
 void wg_set_async_mode (u32 is_enabled);
+void wg_set_multi_worker_mode (u32 is_enabled);
 
 void wg_secure_zero_memory (void *v, size_t n);
 
@@ -18,6 +18,7 @@
 #include <wireguard/wireguard_key.h>
 #include <wireguard/wireguard_peer.h>
 #include <wireguard/wireguard_if.h>
+#include <pthread.h>
 
 static clib_error_t *
 wg_if_create_cli (vlib_main_t * vm,
@@ -385,6 +386,39 @@ VLIB_CLI_COMMAND (wg_set_async_mode_command, static) = {
   .function = wg_set_async_mode_command_fn,
 };
 
+static clib_error_t *
+wg_set_multi_worker_mode_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				     vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  int multi_worker_enable = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "on"))
+	multi_worker_enable = 1;
+      else if (unformat (line_input, "off"))
+	multi_worker_enable = 0;
+      else
+	return (clib_error_return (0, "unknown input '%U'",
+				   format_unformat_error, line_input));
+    }
+
+  wg_set_multi_worker_mode (multi_worker_enable);
+
+  unformat_free (line_input);
+  return (NULL);
+}
+
+VLIB_CLI_COMMAND (wg_set_multi_worker_mode_command, static) = {
+  .path = "set wireguard multi-worker mode",
+  .short_help = "set wireguard multi-worker mode on|off",
+  .function = wg_set_multi_worker_mode_command_fn,
+};
+
 static clib_error_t *
 wg_show_mode_command_fn (vlib_main_t *vm, unformat_input_t *input,
 			 vlib_cli_command_t *cmd)
@@ -406,6 +440,351 @@ VLIB_CLI_COMMAND (wg_show_modemode_command, static) = {
   .function = wg_show_mode_command_fn,
 };
 
+static clib_error_t *
+wg_show_handshake_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			      vlib_cli_command_t *cmd)
+{
+  wg_handshake_queue_t *hq = &wg_main.handshake_queue;
+
+  vlib_cli_output (vm, "Wireguard handshake queue");
+  vlib_cli_output (vm, "\tdepth: %u (max %u, limit %u, under load at %u)",
+		   clib_fifo_elts (hq->fifo), hq->max_depth,
+		   WG_HANDSHAKE_QUEUE_SIZE, WG_HANDSHAKE_QUEUE_UNDER_LOAD);
+  vlib_cli_output (vm, "\tenqueued: %lu", hq->n_enqueued);
+  vlib_cli_output (vm, "\tprocessed: %lu", hq->n_processed);
+  vlib_cli_output (vm, "\tdropped, queue full: %lu", hq->n_queue_full);
+  vlib_cli_output (vm, "\tdropped, expired: %lu", hq->n_expired);
+  vlib_cli_output (vm, "\tlatency: avg %.2fus max %.2fus",
+		   hq->n_processed ? hq->latency_sum / hq->n_processed * 1e6 :
+				     0,
+		   hq->latency_max * 1e6);
+
+  return (NULL);
+}
+
+VLIB_CLI_COMMAND (wg_show_handshake_command, static) = {
+  .path = "show wireguard handshake",
+  .short_help = "show wireguard handshake",
+  .function = wg_show_handshake_command_fn,
+};
+
+/*
+ * The receive window test drives keypair counters directly, the way the
+ * input nodes do after decryption, so it needs neither peers nor crypto.
+ * The reference is the single worker window the shared one replaced.
+ */
+typedef struct
+{
+  u64 c_recv;
+  u64 c_backtrack[COUNTER_BITS_TOTAL / 64];
+} wg_test_ref_counter_t;
+
+static int
+wg_test_ref_counter_recv (wg_test_ref_counter_t *ctr, u64 recv)
+{
+  u64 i, top, index_recv, index_ctr, bit;
+  u32 n = ARRAY_LEN (ctr->c_backtrack);
+
+  if (ctr->c_recv >= REJECT_AFTER_MESSAGES || recv >= REJECT_AFTER_MESSAGES)
+    return 0;
+  if (recv + COUNTER_WINDOW_SIZE < ctr->c_recv)
+    return 0;
+
+  index_recv = recv / 64;
+  index_ctr = ctr->c_recv / 64;
+
+  if (recv > ctr->c_recv)
+    {
+      top = clib_min (index_recv - index_ctr, n);
+      for (i = 1; i <= top; i++)
+	ctr->c_backtrack[(i + index_ctr) & (n - 1)] = 0;
+      ctr->c_recv = recv;
+    }
+
+  index_recv %= n;
+  bit = 1ULL << (recv % 64);
+
+  if (ctr->c_backtrack[index_recv] & bit)
+    return 0;
+
+  ctr->c_backtrack[index_recv] |= bit;
+  return 1;
+}
+
+/*
+ * A counter which has seen everything up to first - 1. Each cell is given
+ * the block one lap of the cells behind, with no counters seen.
+ */
+static noise_counter_t *
+wg_test_counter_alloc (u64 first)
+{
+  noise_counter_t *ctr;
+  u32 blk = (first - 1) >> COUNTER_BLOCK_LOG2, i;
+
+  ctr = clib_mem_alloc_aligned (sizeof (*ctr), CLIB_CACHE_LINE_BYTES);
+  clib_memset (ctr, 0, sizeof (*ctr));
+  ctr->c_recv = first - 1;
+
+  for (i = 0; i < COUNTER_NUM; i++, blk--)
+    ctr->c_backtrack[blk & (COUNTER_NUM - 1)] = (u64) (blk - COUNTER_NUM)
+						<< 32;
+  return ctr;
+}
+
+/*
+ * Counters from first on, reordered by less than half a window, with
+ * replays of recent and of long gone packets mixed in.
+ */
+static u64 *
+wg_test_counter_seqs (u64 first, u32 n_packets, u32 *seed)
+{
+  u64 *seqs = 0, tmp;
+  u32 i, j, r;
+
+  for (i = 0; i < n_packets; i++)
+    vec_add1 (seqs, first + i);
+
+  for (i = 0; i + COUNTER_WINDOW_SIZE < n_packets; i++)
+    {
+      r = random_u32 (seed);
+      if (r & 1)
+	{
+	  j = i + (r >> 8) % (COUNTER_WINDOW_SIZE / 2);
+	  tmp = seqs[i];
+	  seqs[i] = seqs[j];
+	  seqs[j] = tmp;
+	}
+      if ((r & 0x70) == 0 && i > 2 * COUNTER_BITS_TOTAL)
+	/* a replay of a recent packet, or of one out of the window */
+	seqs[i] = seqs[i - ((r & 0x80) ? 2 * COUNTER_BITS_TOTAL :
+					  (r >> 8) % 16)];
+    }
+
+  return seqs;
+}
+
+/* packets a thread takes at once, as a worker receives them in a frame */
+#define WG_TEST_COUNTER_BURST 32
+
+typedef struct
+{
+  noise_counter_t *ctr;
+  u64 *seqs;
+  u64 first;
+  u32 *n_accepted;
+  u32 *next_burst;
+  u8 is_sharded;
+  volatile u32 *go;
+} wg_test_counter_thread_t;
+
+static void *
+wg_test_counter_thread_fn (void *arg)
+{
+  wg_test_counter_thread_t *t = arg;
+  u32 i, n_seqs = vec_len (t->seqs), first, last;
+
+  while (!*t->go)
+    CLIB_PAUSE ();
+
+  for (first = 0; first < n_seqs; first = last)
+    {
+      /* sharded, the threads take the packets a burst at a time in the
+       * order they arrive, as the workers receive them */
+      if (t->is_sharded)
+	first =
+	  clib_atomic_fetch_add (t->next_burst, 1) * WG_TEST_COUNTER_BURST;
+      last = clib_min (first + WG_TEST_COUNTER_BURST, n_seqs);
+
+      for (i = first; i < last; i++)
+	if (noise_counter_recv (t->ctr, t->seqs[i]))
+	  clib_atomic_fetch_add (&t->n_accepted[t->seqs[i] - t->first], 1);
+    }
+
+  return 0;
+}
+
+/*
+ * Run the packets on n_threads threads sharing a window, every packet on
+ * every thread or each packet on one of them. A packet must never be
+ * accepted twice.
+ */
+static clib_error_t *
+wg_test_counter_threads (vlib_main_t *vm, u64 *seqs, u64 first,
+			 u32 n_threads, u8 is_sharded)
+{
+  wg_test_counter_thread_t *threads = 0;
+  noise_counter_t *ctr;
+  u32 *n_accepted = 0, i, n_total = 0, n_twice = 0, next_burst = 0;
+  volatile u32 go = 0;
+  pthread_t *handles = 0;
+  clib_error_t *err = 0;
+  f64 t0, dt;
+
+  ctr = wg_test_counter_alloc (first);
+  vec_validate (n_accepted, vec_len (seqs) - 1);
+  vec_validate (threads, n_threads - 1);
+  vec_validate (handles, n_threads - 1);
+
+  vec_foreach_index (i, threads)
+    {
+      threads[i] = (wg_test_counter_thread_t){
+	.ctr = ctr,
+	.seqs = seqs,
+	.first = first,
+	.n_accepted = n_accepted,
+	.next_burst = &next_burst,
+	.is_sharded = is_sharded,
+	.go = &go,
+      };
+      if (pthread_create (&handles[i], NULL, wg_test_counter_thread_fn,
+			  &threads[i]))
+	{
+	  vec_set_len (handles, i);
+	  err = clib_error_return_unix (0, "pthread_create");
+	  break;
+	}
+    }
+
+  t0 = unix_time_now ();
+  go = 1;
+  for (i = 0; i < vec_len (handles); i++)
+    pthread_join (handles[i], NULL);
+  dt = unix_time_now () - t0;
+
+  vec_foreach_index (i, n_accepted)
+    {
+      n_total += n_accepted[i];
+      n_twice += n_accepted[i] > 1;
+    }
+
+  if (!err)
+    vlib_cli_output (vm, "  %-10s%-10u%-12.2f%-12u",
+		     is_sharded ? "sharded" : "shared", n_threads,
+		     vec_len (seqs) * (is_sharded ? 1 : n_threads) / dt / 1e6,
+		     n_total);
+
+  if (!err && n_twice)
+    err = clib_error_return (0, "failed: %s, %u packets accepted twice",
+			     is_sharded ? "sharded" : "shared", n_twice);
+
+  vec_free (threads);
+  vec_free (handles);
+  vec_free (n_accepted);
+  clib_mem_free (ctr);
+  return err;
+}
+
+static clib_error_t *
+wg_test_counter_run (vlib_main_t *vm, u64 first, u32 n_packets,
+		     u32 n_threads, u32 *seed)
+{
+  wg_test_ref_counter_t *ref;
+  noise_counter_t *ctr;
+  u32 i, n_accepted[2] = {}, n_diff = 0;
+  u64 *seqs, t[2];
+  clib_error_t *err = 0;
+  int accepted[2];
+
+  seqs = wg_test_counter_seqs (first, n_packets, seed);
+
+  /* the shared window must take the same decisions as the reference one
+   * when the packets come one at a time */
+  ref = clib_mem_alloc (sizeof (*ref));
+  clib_memset (ref, 0, sizeof (*ref));
+  ref->c_recv = first - 1;
+  ctr = wg_test_counter_alloc (first);
+
+  vec_foreach_index (i, seqs)
+    {
+      n_accepted[0] += accepted[0] = wg_test_ref_counter_recv (ref, seqs[i]);
+      n_accepted[1] += accepted[1] = noise_counter_recv (ctr, seqs[i]);
+      if (accepted[0] != accepted[1] && n_diff++ == 0)
+	err = clib_error_return (
+	  0, "failed: packet %u counter 0x%llx accepted %d by reference, "
+	     "%d by shared window", i, seqs[i], accepted[0], accepted[1]);
+    }
+
+  /* the cost of the check and update of in order packets */
+  clib_memset (ref, 0, sizeof (*ref));
+  ref->c_recv = first - 1;
+  t[0] = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    wg_test_ref_counter_recv (ref, first + i);
+  t[0] = clib_cpu_time_now () - t[0];
+
+  clib_mem_free (ctr);
+  ctr = wg_test_counter_alloc (first);
+  t[1] = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    noise_counter_recv (ctr, first + i);
+  t[1] = clib_cpu_time_now () - t[1];
+
+  vlib_cli_output (vm, "%u packets from 0x%llx", n_packets, first);
+  vlib_cli_output (vm, "  %-14s%-12s%-12s", "", "clk/pkt", "accepted");
+  vlib_cli_output (vm, "  %-14s%-12.2f%-12u", "reference",
+		   (f64) t[0] / n_packets, n_accepted[0]);
+  vlib_cli_output (vm, "  %-14s%-12.2f%-12u", "shared",
+		   (f64) t[1] / n_packets, n_accepted[1]);
+
+  if (!err && n_threads)
+    {
+      vlib_cli_output (vm, "  %-10s%-10s%-12s%-12s", "packets", "threads",
+		       "Mpps", "accepted");
+      for (i = 1; i <= n_threads && !err; i *= 2)
+	err = wg_test_counter_threads (vm, seqs, first, i, 1);
+      if (!err)
+	err = wg_test_counter_threads (vm, seqs, first, n_threads, 0);
+    }
+
+  clib_mem_free (ref);
+  clib_mem_free (ctr);
+  vec_free (seqs);
+  return err;
+}
+
+static clib_error_t *
+wg_test_counter_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  u32 n_packets = 1 << 20, n_threads = 4;
+  u32 seed = random_default_seed ();
+  clib_error_t *err;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "threads %u", &n_threads))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_packets < 4 * COUNTER_BITS_TOTAL)
+    return clib_error_return (0, "packets must be at least %u",
+			      4 * COUNTER_BITS_TOTAL);
+
+  vlib_cli_output (vm, "seed %u", seed);
+
+  err = wg_test_counter_run (vm, 1, n_packets, n_threads, &seed);
+  if (!err)
+    /* across the wrap of the block index kept in the cells */
+    err = wg_test_counter_run (
+      vm, (1ULL << (32 + COUNTER_BLOCK_LOG2)) - n_packets / 2, n_packets,
+      n_threads, &seed);
+
+  return err;
+}
+
+VLIB_CLI_COMMAND (wg_test_counter_command, static) = {
+  .path = "test wireguard replay-window",
+  .short_help = "test wireguard replay-window [packets <n>] [threads <n>] "
+		"[seed <n>]",
+  .function = wg_test_counter_command_fn,
+};
 
 /*
  * fd.io coding-style-patch-verification: ON
@@ -26,6 +26,8 @@
   _ (NONE, "No error")                                                        \
   _ (HANDSHAKE_MAC, "Invalid MAC handshake")                                  \
   _ (HANDSHAKE_RATELIMITED, "Handshake ratelimited")                          \
+  _ (HANDSHAKE_QUEUE_FULL, "Handshake queue full")                            \
+  _ (HANDSHAKE_EXPIRED, "Handshake expired in queue")                         \
   _ (PEER, "Peer error")                                                      \
   _ (INTERFACE, "Interface error")                                            \
   _ (DECRYPTION, "Failed during decryption")                                  \
@@ -202,7 +204,9 @@ wg_handshake_process (vlib_main_t *vm, wg_main_t *wmp, vlib_buffer_t *b,
       if (NULL == wg_if)
 	continue;
 
-      under_load = wg_if_is_under_load (vm, wg_if);
+      under_load = wg_if_is_under_load (vm, wg_if) ||
+		   clib_fifo_elts (wmp->handshake_queue.fifo) >=
+		     WG_HANDSHAKE_QUEUE_UNDER_LOAD;
       mac_state = cookie_checker_validate_macs (
 	vm, &wg_if->cookie_checker, macs, current_b_data, len, under_load,
 	&src_ip, udp_src_port);
@@ -570,26 +574,34 @@ wg_input_process (vlib_main_t *vm, wg_per_thread_data_t *ptd,
 		  vnet_crypto_op_t **crypto_ops,
 		  vnet_crypto_async_frame_t **async_frame, vlib_buffer_t *b,
 		  vlib_buffer_t *lb, u32 buf_idx, noise_remote_t *r,
-		  uint32_t r_idx, uint64_t nonce, uint8_t *src, size_t srclen,
-		  size_t srclen_total, uint8_t *dst, u32 from_idx, u8 *iv,
-		  f64 time, u8 is_async, u16 async_next_node)
+		  noise_keypair_t **last_kp, uint32_t r_idx, uint64_t nonce,
+		  uint8_t *src, size_t srclen, size_t srclen_total,
+		  uint8_t *dst, u32 from_idx, u8 *iv, f64 time, u8 is_async,
+		  u16 async_next_node)
 {
-  noise_keypair_t *kp;
+  noise_keypair_t *kp = *last_kp;
   enum noise_state_crypt ret = SC_FAILED;
 
-  if ((kp = wg_get_active_keypair (r, r_idx)) == NULL)
+  /* the keypair and its tolerances are checked once for a run of packets
+   * of the same keypair in the frame */
+  if (kp == NULL || kp->kp_local_index != r_idx)
     {
-      goto error;
-    }
+      *last_kp = NULL;
 
-  /* We confirm that our values are within our tolerances. These values
-   * are the same as the encrypt routine.
-   *
-   * kp_ctr isn't locked here, we're happy to accept a racy read. */
-  if (wg_birthdate_has_expired_opt (kp->kp_birthdate, REJECT_AFTER_TIME,
-				    time) ||
-      kp->kp_ctr.c_recv >= REJECT_AFTER_MESSAGES)
-    goto error;
+      if ((kp = wg_get_active_keypair (r, r_idx)) == NULL)
+	goto error;
+
+      /* We confirm that our values are within our tolerances. These
+       * values are the same as the encrypt routine.
+       *
+       * kp_ctr isn't locked here, we're happy to accept a racy read. */
+      if (wg_birthdate_has_expired_opt (kp->kp_birthdate, REJECT_AFTER_TIME,
+					time) ||
+	  kp->kp_ctr.c_recv >= REJECT_AFTER_MESSAGES)
+	goto error;
+
+      *last_kp = kp;
+    }
 
   /* Decrypt, then validate the counter. We don't want to validate the
    * counter before decrypting as we do not know the message is authentic
@@ -684,6 +696,108 @@ wg_find_outer_addr_port (vlib_buffer_t *b, ip46_address_t *addr, u16 *port,
     }
 }
 
+/* time the handshake process yields for between batches */
+#define WG_HANDSHAKE_YIELD_TIME 10e-6
+
+typedef enum
+{
+  WG_HANDSHAKE_EVENT_ENQUEUED = 1,
+} wg_handshake_event_t;
+
+static vlib_node_registration_t wg_handshake_process_node;
+
+static_always_inline int
+wg_handshake_enqueue (vlib_main_t *vm, wg_main_t *wmp, u32 bi, u8 is_ip4)
+{
+  wg_handshake_queue_t *hq = &wmp->handshake_queue;
+  wg_handshake_elt_t *e;
+  u32 depth = clib_fifo_elts (hq->fifo);
+
+  if (depth >= WG_HANDSHAKE_QUEUE_SIZE)
+    {
+      hq->n_queue_full++;
+      return 0;
+    }
+
+  clib_fifo_add2 (hq->fifo, e);
+  e->bi = bi;
+  e->is_ip4 = is_ip4;
+  e->enqueue_time = vlib_time_now (vm);
+  hq->n_enqueued++;
+  hq->max_depth = clib_max (hq->max_depth, depth + 1);
+
+  /* the process waits for an event only once it has emptied the queue */
+  if (depth == 0)
+    vlib_process_signal_event (vm, wg_handshake_process_node.index,
+			       WG_HANDSHAKE_EVENT_ENQUEUED, 0);
+  return 1;
+}
+
+static uword
+wg_handshake_process_fn (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			 vlib_frame_t *f)
+{
+  wg_main_t *wmp = &wg_main;
+  wg_handshake_queue_t *hq = &wmp->handshake_queue;
+  u32 bis[WG_HANDSHAKE_BATCH];
+  wg_handshake_elt_t e;
+  wg_input_error_t ret;
+  u32 n, node_index;
+  f64 now, latency;
+
+  while (1)
+    {
+      if (clib_fifo_elts (hq->fifo) == 0)
+	{
+	  vlib_process_wait_for_event (vm);
+	  vlib_process_get_events (vm, NULL);
+	}
+
+      now = vlib_time_now (vm);
+      for (n = 0; n < WG_HANDSHAKE_BATCH && clib_fifo_elts (hq->fifo); n++)
+	{
+	  clib_fifo_sub1 (hq->fifo, e);
+	  bis[n] = e.bi;
+	  node_index = e.is_ip4 ? wg4_input_node.index : wg6_input_node.index;
+	  latency = now - e.enqueue_time;
+
+	  /* the initiator has given up on it and retransmitted already */
+	  if (latency > REKEY_TIMEOUT)
+	    {
+	      hq->n_expired++;
+	      ret = WG_INPUT_ERROR_HANDSHAKE_EXPIRED;
+	    }
+	  else
+	    {
+	      hq->n_processed++;
+	      hq->latency_sum += latency;
+	      hq->latency_max = clib_max (hq->latency_max, latency);
+	      ret = wg_handshake_process (vm, wmp, vlib_get_buffer (vm, e.bi),
+					  node_index, e.is_ip4);
+	    }
+
+	  if (ret != WG_INPUT_ERROR_NONE)
+	    vlib_node_increment_counter (vm, node_index, ret, 1);
+	}
+
+      vlib_buffer_free (vm, bis, n);
+
+      /* let the main thread's packet processing run between batches */
+      if (clib_fifo_elts (hq->fifo))
+	vlib_process_suspend (vm, WG_HANDSHAKE_YIELD_TIME);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (wg_handshake_process_node, static) = {
+  .function = wg_handshake_process_fn,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "wg-handshake-process",
+  /* noise_remote_begin_session () keeps a keypair on the stack */
+  .process_log2_n_stack_bytes = 17,
+};
+
 always_inline uword
 wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 		 vlib_frame_t *frame, u8 is_ip4, u16 async_next_node)
@@ -709,6 +823,7 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u16 data_nexts[VLIB_FRAME_SIZE], *data_next = data_nexts, n_data = 0;
   u16 n_async = 0;
   const u8 is_async = wg_op_mode_is_set_ASYNC ();
+  const u8 is_multi_worker = wg_op_mode_is_set_MULTI_WORKER ();
   vnet_crypto_async_frame_t *async_frame = NULL;
 
   vlib_get_buffers (vm, from, bufs, n_left_from);
@@ -720,6 +835,7 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   f64 time = clib_time_now (&vm->clib_time) + vm->time_offset;
 
   wg_peer_t *peer = NULL;
+  noise_keypair_t *last_kp = NULL;
   u32 *last_peer_time_idx = NULL;
   u32 last_rec_idx = ~0;
 
@@ -751,8 +867,6 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  u8 *iv_data = b[0]->pre_data;
 	  u32 buf_idx = from[b - bufs];
 	  u32 n_bufs;
-	  peer_idx = wg_index_table_lookup (&wmp->index_table,
-					    data->receiver_index);
 
 	  if (data->receiver_index != last_rec_idx)
 	    {
@@ -780,7 +894,10 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      goto out;
 	    }
 
-	  if (PREDICT_FALSE (~0 == peer->input_thread_index))
+	  /* in multi-worker mode the packet is decrypted here, on any
+	   * worker, the receive window is shared by all of them */
+	  if (PREDICT_FALSE (!is_multi_worker &&
+			     ~0 == peer->input_thread_index))
 	    {
 	      /* this is the first packet to use this peer, claim the peer
 	       * for this thread.
@@ -789,7 +906,7 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 					wg_peer_assign_thread (thread_index));
 	    }
 
-	  if (PREDICT_TRUE (thread_index != peer->input_thread_index))
+	  if (!is_multi_worker && thread_index != peer->input_thread_index)
 	    {
 	      other_next[n_other] = WG_INPUT_NEXT_HANDOFF_DATA;
 	      other_bi[n_other] = buf_idx;
@@ -850,10 +967,11 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
 	  enum noise_state_crypt state_cr =
 	    wg_input_process (vm, ptd, crypto_ops, &async_frame, b[0], lb,
-			      buf_idx, &peer->remote, data->receiver_index,
-			      data->counter, data->encrypted_data, decr_len,
-			      decr_len_total, data->encrypted_data, n_data,
-			      iv_data, time, is_async, async_next_node);
+			      buf_idx, &peer->remote, &last_kp,
+			      data->receiver_index, data->counter,
+			      data->encrypted_data, decr_len, decr_len_total,
+			      data->encrypted_data, n_data, iv_data, time,
+			      is_async, async_next_node);
 
 	  if (PREDICT_FALSE (state_cr == SC_FAILED))
 	    {
@@ -899,17 +1017,11 @@ wg_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      goto next;
 	    }
 
-	  wg_input_error_t ret =
-	    wg_handshake_process (vm, wmp, b[0], node->node_index, is_ip4);
-	  if (ret != WG_INPUT_ERROR_NONE)
+	  /* and they are handled by the handshake process, in batches */
+	  if (!wg_handshake_enqueue (vm, wmp, from[b - bufs], is_ip4))
 	    {
 	      other_next[n_other] = WG_INPUT_NEXT_ERROR;
-	      b[0]->error = node->errors[ret];
-	      other_bi[n_other] = from[b - bufs];
-	      n_other += 1;
-	    }
-	  else
-	    {
+	      b[0]->error = node->errors[WG_INPUT_ERROR_HANDSHAKE_QUEUE_FULL];
 	      other_bi[n_other] = from[b - bufs];
 	      n_other += 1;
 	    }
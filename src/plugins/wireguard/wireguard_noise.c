@@ -39,7 +39,6 @@ static void noise_remote_handshake_index_drop (vlib_main_t *vm,
 					       noise_remote_t *);
 
 static uint64_t noise_counter_send (noise_counter_t *);
-bool noise_counter_recv (noise_counter_t *, uint64_t);
 
 static void noise_kdf (uint8_t *, uint8_t *, uint8_t *, const uint8_t *,
 		       size_t, size_t, size_t, size_t,
@@ -558,7 +557,7 @@ static noise_keypair_t *
 noise_remote_keypair_allocate (noise_remote_t * r)
 {
   noise_keypair_t *kp;
-  kp = clib_mem_alloc (sizeof (*kp));
+  kp = clib_mem_alloc_aligned (sizeof (*kp), CLIB_CACHE_LINE_BYTES);
   return kp;
 }
 
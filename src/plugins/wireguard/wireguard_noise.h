@@ -35,9 +35,21 @@
 
 /* Constants for the counter */
 #define COUNTER_BITS_TOTAL	8192
-#define COUNTER_BITS		(sizeof(unsigned long) * 8)
-#define COUNTER_NUM		(COUNTER_BITS_TOTAL / COUNTER_BITS)
-#define COUNTER_WINDOW_SIZE	(COUNTER_BITS_TOTAL - COUNTER_BITS)
+#define COUNTER_WINDOW_SIZE	(COUNTER_BITS_TOTAL - 64)
+
+/*
+ * The receive window is shared by all the workers decrypting for the
+ * keypair and is updated lock-free. It is an array of 64 bit cells, each
+ * holding the index of a block of COUNTER_BITS counters (modulo 2^32) in
+ * its upper half and the bitmap of the block's counters seen so far in
+ * its lower half. The first packet of a later block that maps onto a cell
+ * recycles it with a single compare-and-swap. There are twice as many
+ * cells as the window needs, so a block still in the window is never
+ * recycled.
+ */
+#define COUNTER_BLOCK_LOG2	5
+#define COUNTER_BITS		(1 << COUNTER_BLOCK_LOG2)
+#define COUNTER_NUM		(2 * COUNTER_BITS_TOTAL / COUNTER_BITS)
 
 /* Constants for the keypair */
 #define REKEY_AFTER_MESSAGES	(1ull << 60)
@@ -78,9 +90,11 @@ typedef struct noise_handshake
 
 typedef struct noise_counter
 {
+  /* taken with an atomic add, packets may be encrypted on any worker */
   uint64_t c_send;
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
   uint64_t c_recv;
-  unsigned long c_backtrack[COUNTER_NUM];
+  uint64_t c_backtrack[COUNTER_NUM];
 } noise_counter_t;
 
 typedef struct noise_keypair
@@ -139,9 +153,7 @@ noise_local_get (uint32_t locali)
 static_always_inline uint64_t
 noise_counter_send (noise_counter_t *ctr)
 {
-  uint64_t ret;
-  ret = ctr->c_send++;
-  return ret;
+  return clib_atomic_fetch_add_relax (&ctr->c_send, 1);
 }
 
 void noise_local_init (noise_local_t *, struct noise_upcall *);
@@ -217,45 +229,62 @@ wg_get_active_keypair (noise_remote_t *r, uint32_t r_idx)
     }
 }
 
-inline bool
+/*
+ * Validate a decrypted packet's counter against the receive window and
+ * record it. Testing and setting the counter's bit is a single atomic
+ * step, so of the packets with the same counter decrypted concurrently on
+ * several workers only one is accepted.
+ */
+static_always_inline bool
 noise_counter_recv (noise_counter_t *ctr, uint64_t recv)
 {
-  uint64_t i, top, index_recv, index_ctr;
-  unsigned long bit;
-  bool ret = false;
+  uint64_t *cell, old, new, top, bit;
+  uint32_t blk = recv >> COUNTER_BLOCK_LOG2;
 
   /* Check that the recv counter is valid */
-  if (ctr->c_recv >= REJECT_AFTER_MESSAGES || recv >= REJECT_AFTER_MESSAGES)
-    goto error;
+  top = clib_atomic_load_relax_n (&ctr->c_recv);
+  if (top >= REJECT_AFTER_MESSAGES || recv >= REJECT_AFTER_MESSAGES)
+    return false;
 
   /* If the packet is out of the window, invalid */
-  if (recv + COUNTER_WINDOW_SIZE < ctr->c_recv)
-    goto error;
+  if (recv + COUNTER_WINDOW_SIZE < top)
+    return false;
 
-  /* If the new counter is ahead of the current counter, we'll need to
-   * zero out the bitmap that has previously been used */
-  index_recv = recv / COUNTER_BITS;
-  index_ctr = ctr->c_recv / COUNTER_BITS;
+  cell = ctr->c_backtrack + (blk & (COUNTER_NUM - 1));
+  bit = 1ULL << (recv & (COUNTER_BITS - 1));
+  old = clib_atomic_load_relax_n (cell);
 
-  if (recv > ctr->c_recv)
+  while (1)
     {
-      top = clib_min (index_recv - index_ctr, COUNTER_NUM);
-      for (i = 1; i <= top; i++)
-	ctr->c_backtrack[(i + index_ctr) & (COUNTER_NUM - 1)] = 0;
-      ctr->c_recv = recv;
+      if ((uint32_t) (old >> 32) == blk)
+	{
+	  if (old & bit)
+	    return false;
+	  new = old | bit;
+	}
+      /* the cell has moved on to a later block, out of the window */
+      else if ((int32_t) (blk - (uint32_t) (old >> 32)) < 0)
+	return false;
+      else
+	new = (uint64_t) blk << 32 | bit;
+
+      top = clib_atomic_cmp_and_swap (cell, old, new);
+      if (top == old)
+	break;
+      old = top;
     }
 
-  index_recv %= COUNTER_NUM;
-  bit = 1ul << (recv % COUNTER_BITS);
-
-  if (ctr->c_backtrack[index_recv] & bit)
-    goto error;
-
-  ctr->c_backtrack[index_recv] |= bit;
+  /* the highest counter seen only moves forward */
+  top = clib_atomic_load_relax_n (&ctr->c_recv);
+  while (recv > top)
+    {
+      old = clib_atomic_cmp_and_swap (&ctr->c_recv, top, recv);
+      if (old == top)
+	break;
+      top = old;
+    }
 
-  ret = true;
-error:
-  return ret;
+  return true;
 }
 
 static_always_inline void
@@ -440,6 +440,7 @@ wg_output_tun_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u16 n_sync = 0;
   const u16 drop_next = WG_OUTPUT_NEXT_ERROR;
   const u8 is_async = wg_op_mode_is_set_ASYNC ();
+  const u8 is_multi_worker = wg_op_mode_is_set_MULTI_WORKER ();
   vnet_crypto_async_frame_t *async_frame = NULL;
   u16 n_async = 0;
   u16 noop_nexts[VLIB_FRAME_SIZE], *noop_next = noop_nexts, n_noop = 0;
@@ -502,7 +503,10 @@ wg_output_tun_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  b[0]->error = node->errors[WG_OUTPUT_ERROR_PEER];
 	  goto out;
 	}
-      if (PREDICT_FALSE (~0 == peer->output_thread_index))
+      /* in multi-worker mode the packet is encrypted here, on any worker,
+       * the send counter is taken atomically */
+      if (PREDICT_FALSE (!is_multi_worker &&
+			 ~0 == peer->output_thread_index))
 	{
 	  /* this is the first packet to use this peer, claim the peer
 	   * for this thread.
@@ -511,7 +515,8 @@ wg_output_tun_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 				    wg_peer_assign_thread (thread_index));
 	}
 
-      if (PREDICT_FALSE (thread_index != peer->output_thread_index))
+      if (PREDICT_FALSE (!is_multi_worker &&
+			 thread_index != peer->output_thread_index))
 	{
 	  noop_next[0] = WG_OUTPUT_NEXT_HANDOFF;
 	  err = WG_OUTPUT_NEXT_HANDOFF;
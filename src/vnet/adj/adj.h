@@ -462,6 +462,20 @@ adj_get (adj_index_t adj_index)
     return (pool_elt_at_index(adj_pool, adj_index));
 }
 
+/**
+ * @brief
+ * Prefetch the rewrite (header and string) of an adjacency, which is
+ * all the data-plane reads and copies into the packet
+ */
+static inline void
+adj_prefetch_rewrite (adj_index_t adj_index)
+{
+    ip_adjacency_t *adj = adj_get(adj_index);
+
+    clib_prefetch_load (&adj->rewrite_header);
+    clib_prefetch_load ((u8 *) &adj->rewrite_header + CLIB_CACHE_LINE_BYTES);
+}
+
 static inline int
 adj_is_valid(adj_index_t adj_index)
 {
@@ -332,6 +332,39 @@ out:
 }
 
 
+static int
+classify_add_del_table_api (bool is_add, bool del_chain, u32 *table_index,
+			    u32 nbuckets, u32 memory_size, u32 skip_n_vectors,
+			    u32 match_n_vectors, u32 next_table_index,
+			    u32 miss_next_index, u8 current_data_flag,
+			    i16 current_data_offset,
+			    vnet_classify_table_type_t type, u32 mask_len,
+			    u8 *mask)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+
+  if (mask_len != match_n_vectors * sizeof (u32x4))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* The underlying API fails silently, on purpose, so check here */
+  if (is_add == 0)		/* delete */
+    {
+      if (pool_is_free_index (cm->tables, *table_index))
+	return VNET_API_ERROR_NO_SUCH_TABLE;
+    }
+  else				/* add or update */
+    {
+      if (*table_index != ~0 && pool_is_free_index (cm->tables, *table_index))
+	*table_index = ~0;
+    }
+
+  return vnet_classify_add_del_table
+    (cm, mask, nbuckets, memory_size,
+     skip_n_vectors, match_n_vectors,
+     next_table_index, miss_next_index, table_index,
+     current_data_flag, current_data_offset, type, is_add, del_chain);
+}
+
 static void vl_api_classify_add_del_table_t_handler
   (vl_api_classify_add_del_table_t * mp)
 {
@@ -348,37 +381,12 @@ static void vl_api_classify_add_del_table_t_handler
   foreach_classify_add_del_table_field;
 #undef _
 
-  if (mask_len != match_n_vectors * sizeof (u32x4))
-    {
-      rv = VNET_API_ERROR_INVALID_VALUE;
-      goto out;
-    }
+  rv = classify_add_del_table_api
+    (mp->is_add, mp->del_chain, &table_index, nbuckets, memory_size,
+     skip_n_vectors, match_n_vectors, next_table_index, miss_next_index,
+     mp->current_data_flag, clib_net_to_host_i16 (mp->current_data_offset),
+     CLASSIFY_TABLE_TYPE_PAGED, mask_len, mp->mask);
 
-  /* The underlying API fails silently, on purpose, so check here */
-  if (mp->is_add == 0)		/* delete */
-    {
-      if (pool_is_free_index (cm->tables, table_index))
-	{
-	  rv = VNET_API_ERROR_NO_SUCH_TABLE;
-	  goto out;
-	}
-    }
-  else				/* add or update */
-    {
-      if (table_index != ~0 && pool_is_free_index (cm->tables, table_index))
-	table_index = ~0;
-    }
-
-  u8 current_data_flag = mp->current_data_flag;
-  i16 current_data_offset = clib_net_to_host_i16 (mp->current_data_offset);
-
-  rv = vnet_classify_add_del_table
-    (cm, mp->mask, nbuckets, memory_size,
-     skip_n_vectors, match_n_vectors,
-     next_table_index, miss_next_index, &table_index,
-     current_data_flag, current_data_offset, mp->is_add, mp->del_chain);
-
-out:
   REPLY_MACRO2(VL_API_CLASSIFY_ADD_DEL_TABLE_REPLY,
   ({
     if (rv == 0 && mp->is_add)
@@ -397,6 +405,46 @@ out:
   }));
 }
 
+static void
+vl_api_classify_add_del_table_v2_t_handler (
+  vl_api_classify_add_del_table_v2_t *mp)
+{
+  vl_api_classify_add_del_table_v2_reply_t *rmp;
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_table_t *t;
+  int rv;
+
+#define _(a) u32 a;
+  foreach_classify_add_del_table_field;
+#undef _
+
+#define _(a) a = ntohl (mp->a);
+  foreach_classify_add_del_table_field;
+#undef _
+
+  rv = classify_add_del_table_api (
+    mp->is_add, mp->del_chain, &table_index, nbuckets, memory_size,
+    skip_n_vectors, match_n_vectors, next_table_index, miss_next_index,
+    mp->current_data_flag, clib_net_to_host_i16 (mp->current_data_offset),
+    (vnet_classify_table_type_t) mp->table_type, mask_len, mp->mask);
+
+  REPLY_MACRO2 (VL_API_CLASSIFY_ADD_DEL_TABLE_V2_REPLY, ({
+		  if (rv == 0 && mp->is_add)
+		    {
+		      t = pool_elt_at_index (cm->tables, table_index);
+		      rmp->skip_n_vectors = htonl (t->skip_n_vectors);
+		      rmp->match_n_vectors = htonl (t->match_n_vectors);
+		      rmp->new_table_index = htonl (table_index);
+		    }
+		  else
+		    {
+		      rmp->skip_n_vectors = ~0;
+		      rmp->match_n_vectors = ~0;
+		      rmp->new_table_index = ~0;
+		    }
+		}));
+}
+
 static void vl_api_classify_add_del_session_t_handler
   (vl_api_classify_add_del_session_t * mp)
 {
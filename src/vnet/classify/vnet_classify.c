@@ -414,6 +414,280 @@ vnet_classify_entry_release_resource (vnet_classify_entry_t * e)
     }
 }
 
+static vnet_classify_entry_t *
+vnet_classify_cuckoo_bucket_alloc (vnet_classify_table_t *t)
+{
+  u32 entry_size;
+  void *oldheap;
+  u8 *block;
+
+  CLIB_SPINLOCK_ASSERT_LOCKED (&t->writer_lock);
+  entry_size =
+    sizeof (vnet_classify_entry_t) + t->match_n_vectors * sizeof (u32x4);
+
+  oldheap = clib_mem_set_heap (t->mheap);
+  block = clib_mem_alloc_aligned (VNET_CLASSIFY_CUCKOO_SIG_BYTES +
+				    VNET_CLASSIFY_CUCKOO_SLOTS * entry_size,
+				  CLIB_CACHE_LINE_BYTES);
+  clib_mem_set_heap (oldheap);
+
+  clib_memset (block, 0, VNET_CLASSIFY_CUCKOO_SIG_BYTES);
+  block += VNET_CLASSIFY_CUCKOO_SIG_BYTES;
+  clib_memset (block, 0xff, VNET_CLASSIFY_CUCKOO_SLOTS * entry_size);
+
+  return (vnet_classify_entry_t *) block;
+}
+
+/*
+ * Return the entries of a cuckoo bucket, allocating them on first use,
+ * and the index of a free slot in *slot, or ~0 if the bucket is full.
+ */
+static vnet_classify_entry_t *
+vnet_classify_cuckoo_bucket_get (vnet_classify_table_t *t, u32 bucket_index,
+				 u32 *slot)
+{
+  vnet_classify_bucket_t *b = &t->buckets[bucket_index];
+  vnet_classify_entry_t *v;
+  u16 *sigs;
+  u32 i;
+
+  if (b->offset == 0)
+    {
+      v = vnet_classify_cuckoo_bucket_alloc (t);
+      CLIB_MEMORY_BARRIER ();
+      b->offset = vnet_classify_get_offset (t, v);
+    }
+
+  v = vnet_classify_get_entry (t, b->offset);
+  sigs = vnet_classify_cuckoo_sigs (v);
+
+  *slot = ~0;
+  for (i = 0; i < VNET_CLASSIFY_CUCKOO_SLOTS; i++)
+    if (sigs[i] == 0)
+      {
+	*slot = i;
+	break;
+      }
+
+  return v;
+}
+
+/*
+ * Move a session between slots: it is published in its new slot before it
+ * is withdrawn from the old one. That alone doesn't keep lookups from
+ * missing it, a lookup may look in the new bucket too early and in the
+ * old one too late, so the moves are bracketed by cuckoo_version.
+ */
+static void
+vnet_classify_cuckoo_move (vnet_classify_table_t *t, u32 from_bucket,
+			   u32 from_slot, u32 to_bucket, u32 to_slot)
+{
+  vnet_classify_entry_t *from, *to;
+  u16 *from_sigs, *to_sigs;
+  u32 entry_size;
+
+  entry_size =
+    sizeof (vnet_classify_entry_t) + t->match_n_vectors * sizeof (u32x4);
+  from = vnet_classify_get_entry (t, t->buckets[from_bucket].offset);
+  to = vnet_classify_get_entry (t, t->buckets[to_bucket].offset);
+  from_sigs = vnet_classify_cuckoo_sigs (from);
+  to_sigs = vnet_classify_cuckoo_sigs (to);
+  from = vnet_classify_entry_at_index (t, from, from_slot);
+  to = vnet_classify_entry_at_index (t, to, to_slot);
+
+  clib_memcpy_fast (to, from, entry_size);
+  CLIB_MEMORY_BARRIER ();
+  to_sigs[to_slot] = from_sigs[from_slot];
+  CLIB_MEMORY_BARRIER ();
+  from_sigs[from_slot] = 0;
+  clib_memset (from, 0xff, entry_size);
+}
+
+typedef struct
+{
+  u32 bucket_index;
+  /* node we came from and the slot whose session moves here */
+  u16 parent;
+  u16 slot;
+} vnet_classify_cuckoo_path_t;
+
+/* Breadth first search bound, roughly 4 levels of displacement */
+#define VNET_CLASSIFY_CUCKOO_MAX_SEARCH 512
+
+/*
+ * Both candidate buckets are full: search, breadth first, for the
+ * shortest chain of sessions that can each move to their other bucket
+ * and end in a free slot, then shift the chain from its tail. Returns
+ * the free slot made in one of the two buckets, or ~0.
+ */
+static u32
+vnet_classify_cuckoo_make_room (vnet_classify_table_t *t, u32 bi0, u32 bi1,
+				u32 *bucket_index)
+{
+  vnet_classify_cuckoo_path_t path[VNET_CLASSIFY_CUCKOO_MAX_SEARCH];
+  vnet_classify_entry_t *v;
+  u32 head, n_path = 0, slot, other, free_slot, node, depth, ancestor;
+  u16 *sigs;
+
+  path[n_path++] = (vnet_classify_cuckoo_path_t){ bi0, ~0, 0 };
+  if (bi1 != bi0)
+    path[n_path++] = (vnet_classify_cuckoo_path_t){ bi1, ~0, 0 };
+
+  for (head = 0; head < n_path; head++)
+    {
+      v = vnet_classify_get_entry (t, t->buckets[path[head].bucket_index]
+					.offset);
+      sigs = vnet_classify_cuckoo_sigs (v);
+
+      for (slot = 0; slot < VNET_CLASSIFY_CUCKOO_SLOTS; slot++)
+	{
+	  other = vnet_classify_cuckoo_alt_bucket (
+	    t, path[head].bucket_index, sigs[slot]);
+
+	  /* don't go round in circles */
+	  for (ancestor = head; ancestor != (u16) ~0;
+	       ancestor = path[ancestor].parent)
+	    if (path[ancestor].bucket_index == other)
+	      break;
+	  if (ancestor != (u16) ~0)
+	    continue;
+
+	  vnet_classify_cuckoo_bucket_get (t, other, &free_slot);
+	  if (free_slot != ~0)
+	    goto found;
+
+	  if (n_path < VNET_CLASSIFY_CUCKOO_MAX_SEARCH)
+	    path[n_path++] = (vnet_classify_cuckoo_path_t){ other, head, slot };
+	}
+    }
+
+  t->cuckoo_insert_failures++;
+  return ~0;
+
+found:
+  /* lookups wait and look again until the chain has moved */
+  clib_atomic_store_rel_n (&t->cuckoo_version, t->cuckoo_version + 1);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  /* move the tail session into the free slot, then work back up */
+  vnet_classify_cuckoo_move (t, path[head].bucket_index, slot, other,
+			     free_slot);
+  depth = 1;
+  for (node = head; path[node].parent != (u16) ~0; node = path[node].parent)
+    {
+      vnet_classify_cuckoo_move (t, path[path[node].parent].bucket_index,
+				 path[node].slot, path[node].bucket_index,
+				 slot);
+      slot = path[node].slot;
+      depth++;
+    }
+
+  clib_atomic_store_rel_n (&t->cuckoo_version, t->cuckoo_version + 1);
+
+  t->cuckoo_displacements += depth;
+  t->cuckoo_longest_path = clib_max (t->cuckoo_longest_path, depth);
+  *bucket_index = path[node].bucket_index;
+  return slot;
+}
+
+static int
+vnet_classify_cuckoo_add_del (vnet_classify_table_t *t,
+			      vnet_classify_entry_t *add_v, int is_add)
+{
+  u32 hash, bucket_index[2], entry_size, slot, i, j;
+  vnet_classify_entry_t *v;
+  u8 *key_minus_skip;
+  u16 sig, *sigs;
+  int rv = 0;
+
+  entry_size =
+    sizeof (vnet_classify_entry_t) + t->match_n_vectors * sizeof (u32x4);
+  key_minus_skip = (u8 *) add_v->key;
+  key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
+
+  hash = vnet_classify_hash_packet (t, key_minus_skip);
+  sig = vnet_classify_cuckoo_sig (hash);
+  bucket_index[0] = hash & (t->nbuckets - 1);
+  bucket_index[1] = vnet_classify_cuckoo_alt_bucket (t, bucket_index[0], sig);
+
+  clib_spinlock_lock (&t->writer_lock);
+
+  /* Replace or delete an existing session */
+  for (i = 0; i < 2; i++)
+    {
+      if (t->buckets[bucket_index[i]].offset == 0)
+	continue;
+
+      v = vnet_classify_get_entry (t, t->buckets[bucket_index[i]].offset);
+      sigs = vnet_classify_cuckoo_sigs (v);
+
+      for (j = 0; j < VNET_CLASSIFY_CUCKOO_SLOTS; j++)
+	{
+	  vnet_classify_entry_t *e = vnet_classify_entry_at_index (t, v, j);
+
+	  if (sigs[j] != sig ||
+	      memcmp (e->key, add_v->key, t->match_n_vectors * sizeof (u32x4)))
+	    continue;
+
+	  if (is_add)
+	    {
+	      clib_memcpy_fast (e, add_v, entry_size);
+	      e->flags &= ~(VNET_CLASSIFY_ENTRY_FREE);
+	      vnet_classify_entry_claim_resource (e);
+	    }
+	  else
+	    {
+	      sigs[j] = 0;
+	      CLIB_MEMORY_BARRIER ();
+	      vnet_classify_entry_release_resource (e);
+	      clib_memset (e, 0xff, entry_size);
+	      t->active_elements--;
+	    }
+	  goto unlock;
+	}
+    }
+
+  if (is_add == 0)
+    {
+      rv = -3;
+      goto unlock;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      vnet_classify_cuckoo_bucket_get (t, bucket_index[i], &slot);
+      if (slot != ~0)
+	break;
+    }
+
+  if (i == 2)
+    {
+      slot = vnet_classify_cuckoo_make_room (t, bucket_index[0],
+					     bucket_index[1], &bucket_index[0]);
+      if (slot == ~0)
+	{
+	  rv = VNET_API_ERROR_TABLE_TOO_BIG;
+	  goto unlock;
+	}
+      i = 0;
+    }
+
+  v = vnet_classify_get_entry (t, t->buckets[bucket_index[i]].offset);
+  sigs = vnet_classify_cuckoo_sigs (v);
+  v = vnet_classify_entry_at_index (t, v, slot);
+
+  clib_memcpy_fast (v, add_v, entry_size);
+  v->flags &= ~(VNET_CLASSIFY_ENTRY_FREE);
+  vnet_classify_entry_claim_resource (v);
+  CLIB_MEMORY_BARRIER ();
+  sigs[slot] = sig;
+  t->active_elements++;
+
+unlock:
+  clib_spinlock_unlock (&t->writer_lock);
+  return rv;
+}
+
 static int
 vnet_classify_add_del (vnet_classify_table_t *t, vnet_classify_entry_t *add_v,
 		       int is_add)
@@ -434,6 +708,9 @@ vnet_classify_add_del (vnet_classify_table_t *t, vnet_classify_entry_t *add_v,
 
   ASSERT ((add_v->flags & VNET_CLASSIFY_ENTRY_FREE) == 0);
 
+  if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+    return vnet_classify_cuckoo_add_del (t, add_v, is_add);
+
   key_minus_skip = (u8 *) add_v->key;
   key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
 
@@ -689,7 +966,8 @@ format_classify_table (u8 * s, va_list * args)
   vnet_classify_bucket_t *b;
   vnet_classify_entry_t *v, *save_v;
   int i, j, k;
-  u64 active_elements = 0;
+  u64 active_elements = 0, n_slots = 0, n_alt = 0;
+  u32 longest_probe = 0;
 
   for (i = 0; i < t->nbuckets; i++)
     {
@@ -701,6 +979,13 @@ format_classify_table (u8 * s, va_list * args)
 	  continue;
 	}
 
+      n_slots += (1 << b->log2_pages) * t->entries_per_page;
+      if (t->type == CLASSIFY_TABLE_TYPE_PAGED)
+	longest_probe = clib_max (longest_probe,
+				  b->linear_search ?
+				    (1 << b->log2_pages) * t->entries_per_page :
+				    t->entries_per_page);
+
       if (verbose)
 	{
 	  s = format (s, "[%d]: heap offset %d, elts %d, %s\n", i,
@@ -731,23 +1016,67 @@ format_classify_table (u8 * s, va_list * args)
 			      format_classify_entry, t, v);
 		}
 	      active_elements++;
+
+	      /* count the sessions pushed out of their first bucket */
+	      if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+		{
+		  u8 *key_minus_skip = (u8 *) v->key;
+
+		  key_minus_skip -= t->skip_n_vectors * sizeof (u32x4);
+		  if ((vnet_classify_hash_packet (t, key_minus_skip) &
+		       (t->nbuckets - 1)) != i)
+		    n_alt++;
+		}
 	    }
 	}
     }
 
   s = format (s, "    %lld active elements\n", active_elements);
-  s = format (s, "    %d free lists\n", vec_len (t->freelists));
-  s = format (s, "    %d linear-search buckets\n", t->linear_buckets);
+  s = format (s, "    %lld slots allocated, occupancy %.1f%%\n", n_slots,
+	      n_slots ? 100.0 * active_elements / n_slots : 0.0);
+  if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+    {
+      s = format (s, "    %lld in their alternate bucket, mean probe "
+		  "%.2f buckets\n",
+		  n_alt,
+		  active_elements ? 1.0 + (f64) n_alt / active_elements : 0.0);
+      s = format (s, "    %lld displacements, longest path %u, %u failed "
+		  "inserts\n",
+		  t->cuckoo_displacements, t->cuckoo_longest_path,
+		  t->cuckoo_insert_failures);
+    }
+  else
+    {
+      s = format (s, "    longest probe %u entries\n", longest_probe);
+      s = format (s, "    %d free lists\n", vec_len (t->freelists));
+      s = format (s, "    %d linear-search buckets\n", t->linear_buckets);
+    }
   return s;
 }
 
+u8 *
+format_classify_table_type (u8 *s, va_list *args)
+{
+  vnet_classify_table_type_t type = va_arg (*args, int);
+
+  switch (type)
+    {
+    case CLASSIFY_TABLE_TYPE_PAGED:
+      return format (s, "paged");
+    case CLASSIFY_TABLE_TYPE_CUCKOO:
+      return format (s, "cuckoo");
+    }
+  return format (s, "unknown %d", type);
+}
+
 int
 vnet_classify_add_del_table (vnet_classify_main_t *cm, const u8 *mask,
 			     u32 nbuckets, u32 memory_size, u32 skip,
 			     u32 match, u32 next_table_index,
 			     u32 miss_next_index, u32 *table_index,
 			     u8 current_data_flag, i16 current_data_offset,
-			     int is_add, int del_chain)
+			     vnet_classify_table_type_t type, int is_add,
+			     int del_chain)
 {
   vnet_classify_table_t *t;
 
@@ -764,8 +1093,15 @@ vnet_classify_add_del_table (vnet_classify_main_t *cm, const u8 *mask,
 	  if (match < 1 || match > 5)
 	    return VNET_API_ERROR_INVALID_VALUE;
 
+	  if (type > CLASSIFY_TABLE_TYPE_CUCKOO)
+	    return VNET_API_ERROR_INVALID_VALUE_2;
+
 	  t = vnet_classify_new_table (cm, mask, nbuckets, memory_size,
 				       skip, match);
+	  /* a cuckoo bucket is a single fixed size page */
+	  if (type == CLASSIFY_TABLE_TYPE_CUCKOO)
+	    t->entries_per_page = VNET_CLASSIFY_CUCKOO_SLOTS;
+	  t->type = type;
 	  t->next_table_index = next_table_index;
 	  t->miss_next_index = miss_next_index;
 	  t->current_data_flag = current_data_flag;
@@ -1549,6 +1885,7 @@ classify_table_command_fn (vlib_main_t * vm,
   u32 tmp;
   u32 current_data_flag = 0;
   int current_data_offset = 0;
+  vnet_classify_table_type_t type = CLASSIFY_TABLE_TYPE_PAGED;
 
   u8 *mask = 0;
   vnet_classify_main_t *cm = &vnet_classify_main;
@@ -1565,6 +1902,8 @@ classify_table_command_fn (vlib_main_t * vm,
 	}
       else if (unformat (input, "buckets %d", &nbuckets))
 	;
+      else if (unformat (input, "cuckoo"))
+	type = CLASSIFY_TABLE_TYPE_CUCKOO;
       else if (unformat (input, "skip %d", &skip))
 	;
       else if (unformat (input, "match %d", &match))
@@ -1622,7 +1961,7 @@ classify_table_command_fn (vlib_main_t * vm,
 				    skip, match, next_table_index,
 				    miss_next_index, &table_index,
 				    current_data_flag, current_data_offset,
-				    is_add, del_chain);
+				    type, is_add, del_chain);
   switch (rv)
     {
     case 0:
@@ -1642,7 +1981,7 @@ VLIB_CLI_COMMAND (classify_table, static) =
   "classify table [miss-next|l2-miss_next|acl-miss-next <next_index>]"
   "\n mask <mask-value> buckets <nn> [skip <n>] [match <n>]"
   "\n [current-data-flag <n>] [current-data-offset <n>] [table <n>]"
-  "\n [memory-size <nn>[M][G]] [next-table <n>]"
+  "\n [memory-size <nn>[M][G]] [next-table <n>] [cuckoo]"
   "\n [del] [del-chain]",
   .function = classify_table_command_fn,
 };
@@ -1979,8 +2318,8 @@ classify_filter_command_fn (vlib_main_t * vm,
       rv = vnet_classify_add_del_table (cm, mask, nbuckets, memory_size,
 					skip, match, next_table_index,
 					miss_next_index, &table_index,
-					current_data_flag,
-					current_data_offset, 1, 0);
+					current_data_flag, current_data_offset,
+					CLASSIFY_TABLE_TYPE_PAGED, 1, 0);
 
       if (rv != 0)
 	{
@@ -2238,9 +2577,10 @@ format_vnet_classify_table (u8 *s, va_list *args)
   s = format (s, "\n  Heap: %U", format_clib_mem_heap, t->mheap,
 	      0 /*verbose */ );
 
-  s = format (s, "\n  nbuckets %d, skip %d match %d flag %d offset %d",
-	      t->nbuckets, t->skip_n_vectors, t->match_n_vectors,
-	      t->current_data_flag, t->current_data_offset);
+  s = format (s, "\n  nbuckets %d, %U, skip %d match %d flag %d offset %d",
+	      t->nbuckets, format_classify_table_type, t->type,
+	      t->skip_n_vectors, t->match_n_vectors, t->current_data_flag,
+	      t->current_data_offset);
   s = format (s, "\n  mask %U", format_hex_bytes, t->mask,
 	      t->match_n_vectors * sizeof (u32x4));
   s = format (s, "\n  linear-search buckets %d\n", t->linear_buckets);
@@ -2819,6 +3159,8 @@ vnet_classify_add_del_session (vnet_classify_main_t *cm, u32 table_index,
 
   vnet_classify_entry_release_resource (e);
 
+  if (rv == VNET_API_ERROR_TABLE_TOO_BIG)
+    return rv;
   if (rv)
     return VNET_API_ERROR_NO_SUCH_ENTRY;
   return 0;
@@ -40,6 +40,22 @@ typedef enum vnet_classify_flags_t_
   CLASSIFY_FLAG_USE_CURR_DATA = (1 << 0),
 } __clib_packed vnet_classify_flags_t;
 
+/*
+ * Classify table session storage
+ *  CLASSIFY_TABLE_TYPE_PAGED:
+ *   - colliding sessions split a bucket into pages, then fall back
+ *     to a linear search of the bucket
+ *  CLASSIFY_TABLE_TYPE_CUCKOO:
+ *   - a session lives in one of two fixed size buckets and is found
+ *     by a signature compare; inserts into a full pair of buckets move
+ *     sessions to their other bucket, so a lookup probes at most two
+ */
+typedef enum vnet_classify_table_type_t_
+{
+  CLASSIFY_TABLE_TYPE_PAGED = 0,
+  CLASSIFY_TABLE_TYPE_CUCKOO = 1,
+} __clib_packed vnet_classify_table_type_t;
+
 /*
  * Classify session action
  *  CLASSIFY_ACTION_SET_IP4_FIB_INDEX:
@@ -172,8 +188,11 @@ typedef struct
   /* packet offsets */
   i16 current_data_offset;
   vnet_classify_flags_t current_data_flag;
+  vnet_classify_table_type_t type;
   /* Miss next index, return if next_table_index = 0 */
   u32 miss_next_index;
+  /* Odd while cuckoo sessions are being moved, bumped by every move */
+  u32 cuckoo_version;
 
   /**
    * All members accessed in the DP above here
@@ -183,6 +202,12 @@ typedef struct
   /* Config parameters */
   u32 linear_buckets;
   u32 active_elements;
+
+  /* Cuckoo storage statistics */
+  u64 cuckoo_displacements;
+  u32 cuckoo_longest_path;
+  u32 cuckoo_insert_failures;
+
   u32 data_offset;
 
   /* Per-bucket working copies, one per thread */
@@ -244,6 +269,7 @@ extern vnet_classify_main_t vnet_classify_main;
 u8 *format_classify_entry (u8 *s, va_list *args);
 u8 *format_classify_table (u8 * s, va_list * args);
 u8 *format_vnet_classify_table (u8 *s, va_list *args);
+u8 *format_classify_table_type (u8 *s, va_list *args);
 
 u32 vnet_classify_hash_packet (const vnet_classify_table_t *t, u8 *h);
 
@@ -350,6 +376,38 @@ vnet_classify_hash_packet_inline (const vnet_classify_table_t *t, const u8 *h)
 #endif
 }
 
+/* Sessions per cuckoo bucket, one signature lane each */
+#define VNET_CLASSIFY_CUCKOO_SLOTS 8
+#define VNET_CLASSIFY_CUCKOO_SIG_BYTES                                        \
+  (VNET_CLASSIFY_CUCKOO_SLOTS * sizeof (u16))
+
+STATIC_ASSERT (VNET_CLASSIFY_CUCKOO_SIG_BYTES == sizeof (u16x8),
+	       "cuckoo signatures must fill a u16x8");
+
+/**
+ * The signature of a session, taken from the hash bits above those
+ * that pick the bucket in small tables. 0 marks a free slot.
+ */
+static_always_inline u16
+vnet_classify_cuckoo_sig (u32 hash)
+{
+  u16 sig = hash >> 16;
+
+  return sig ? sig : 1;
+}
+
+/**
+ * The other bucket a session may live in. Depends only on the signature
+ * so it can be found from either bucket without the key.
+ */
+static_always_inline u32
+vnet_classify_cuckoo_alt_bucket (const vnet_classify_table_t *t,
+				 u32 bucket_index, u16 sig)
+{
+  return (bucket_index ^ (((u32) sig * 0x5bd1e995u) | 1)) &
+	 (t->nbuckets - 1);
+}
+
 static inline void
 vnet_classify_prefetch_bucket (vnet_classify_table_t * t, u64 hash)
 {
@@ -360,6 +418,10 @@ vnet_classify_prefetch_bucket (vnet_classify_table_t * t, u64 hash)
   bucket_index = hash & (t->nbuckets - 1);
 
   clib_prefetch_load (&t->buckets[bucket_index]);
+
+  if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+    clib_prefetch_load (&t->buckets[vnet_classify_cuckoo_alt_bucket (
+      t, bucket_index, vnet_classify_cuckoo_sig (hash))]);
 }
 
 static inline vnet_classify_entry_t *
@@ -398,6 +460,13 @@ vnet_classify_entry_at_index (const vnet_classify_table_t *t,
   return (vnet_classify_entry_t *) eu8;
 }
 
+/* The signatures sit in front of the first entry of a cuckoo bucket */
+static_always_inline u16 *
+vnet_classify_cuckoo_sigs (vnet_classify_entry_t *v)
+{
+  return (u16 *) ((u8 *) v - VNET_CLASSIFY_CUCKOO_SIG_BYTES);
+}
+
 static inline void
 vnet_classify_prefetch_entry (vnet_classify_table_t * t, u64 hash)
 {
@@ -410,6 +479,21 @@ vnet_classify_prefetch_entry (vnet_classify_table_t * t, u64 hash)
 
   b = &t->buckets[bucket_index];
 
+  if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+    {
+      vnet_classify_bucket_t *b2;
+
+      b2 = &t->buckets[vnet_classify_cuckoo_alt_bucket (
+	t, bucket_index, vnet_classify_cuckoo_sig (hash))];
+      if (b->offset)
+	clib_prefetch_load (
+	  vnet_classify_cuckoo_sigs (vnet_classify_get_entry (t, b->offset)));
+      if (b2->offset)
+	clib_prefetch_load (
+	  vnet_classify_cuckoo_sigs (vnet_classify_get_entry (t, b2->offset)));
+      return;
+    }
+
   if (b->offset == 0)
     return;
 
@@ -531,6 +615,89 @@ vnet_classify_entry_is_equal (vnet_classify_entry_t *v, const u8 *d, u8 *m,
   return 0;
 }
 
+/**
+ * Compare the key of the sessions whose signature matches, in one bucket
+ */
+static_always_inline vnet_classify_entry_t *
+vnet_classify_cuckoo_find_in_bucket (const vnet_classify_table_t *t,
+				     const vnet_classify_bucket_t *b,
+				     const u8 *h, u16 sig)
+{
+  vnet_classify_entry_t *v, *e;
+  u16 *sigs;
+  u32 match = 0;
+  int i;
+
+  if (b->offset == 0)
+    return 0;
+
+  v = vnet_classify_get_entry (t, b->offset);
+  sigs = vnet_classify_cuckoo_sigs (v);
+
+#ifdef CLIB_HAVE_VEC128_MSB_MASK
+  /* two mask bits per 16 bit lane, keep the low one */
+  match = u8x16_msb_mask ((u8x16) (*(u16x8 *) sigs == u16x8_splat (sig)));
+  match &= 0x5555;
+#else
+  for (i = 0; i < VNET_CLASSIFY_CUCKOO_SLOTS; i++)
+    match |= (sigs[i] == sig) << (2 * i);
+#endif
+
+  while (match)
+    {
+      i = count_trailing_zeros (match) / 2;
+      e = vnet_classify_entry_at_index (t, v, i);
+      if (vnet_classify_entry_is_equal (e, h, (u8 *) t->mask,
+					t->match_n_vectors, t->load_mask))
+	return e;
+      match &= match - 1;
+    }
+
+  return 0;
+}
+
+static_always_inline vnet_classify_entry_t *
+vnet_classify_cuckoo_find_entry (const vnet_classify_table_t *t, const u8 *h,
+				 u32 hash, f64 now)
+{
+  vnet_classify_entry_t *v;
+  u32 bucket_index, version;
+  u16 sig = vnet_classify_cuckoo_sig (hash);
+
+  h += t->skip_n_vectors * 16;
+  bucket_index = hash & (t->nbuckets - 1);
+
+  /*
+   * A session being moved can be missed in both of its buckets, and a
+   * slot being refilled can be read half written, so a lookup which
+   * overlapped a move is done again.
+   */
+  do
+    {
+      while ((version = clib_atomic_load_acq_n (&t->cuckoo_version)) & 1)
+	CLIB_PAUSE ();
+
+      v = vnet_classify_cuckoo_find_in_bucket (t, &t->buckets[bucket_index],
+					       h, sig);
+      if (!v)
+	v = vnet_classify_cuckoo_find_in_bucket (
+	  t,
+	  &t->buckets[vnet_classify_cuckoo_alt_bucket (t, bucket_index, sig)],
+	  h, sig);
+
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    }
+  while (PREDICT_FALSE (clib_atomic_load_relax_n (&t->cuckoo_version) !=
+			version));
+
+  if (v && PREDICT_TRUE (now))
+    {
+      v->hits++;
+      v->last_heard = now;
+    }
+  return v;
+}
+
 static inline vnet_classify_entry_t *
 vnet_classify_find_entry_inline (const vnet_classify_table_t *t, const u8 *h,
 				 u32 hash, f64 now)
@@ -542,6 +709,9 @@ vnet_classify_find_entry_inline (const vnet_classify_table_t *t, const u8 *h,
   u8 *mask = (u8 *) t->mask;
   int i;
 
+  if (t->type == CLASSIFY_TABLE_TYPE_CUCKOO)
+    return vnet_classify_cuckoo_find_entry (t, h, hash, now);
+
   bucket_index = hash & (t->nbuckets - 1);
   b = &t->buckets[bucket_index];
 
@@ -581,6 +751,100 @@ vnet_classify_find_entry_inline (const vnet_classify_table_t *t, const u8 *h,
   return 0;
 }
 
+/**
+ * The start of the data a table matches on, before skipping any vectors
+ */
+static_always_inline u8 *
+vnet_classify_get_packet_data (const vnet_classify_table_t *t,
+			       vlib_buffer_t *b)
+{
+  if (t->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
+    return (u8 *) vlib_buffer_get_current (b) + t->current_data_offset;
+  return b->data;
+}
+
+/**
+ * Look up a vector of packets, each in its own chain of tables.
+ *
+ * Instead of walking one packet down its chain before starting on the
+ * next, all packets are looked up in their current table in three passes
+ * - hash and prefetch the bucket, prefetch the entry, compare - and those
+ * that miss move on to the next table of their chain for another round.
+ * Each round keeps the bucket and entry fetches of the whole vector in
+ * flight, rather than paying for them one miss at a time.
+ *
+ * @param h_offset per packet offset added to the match data, e.g. the
+ *        rewrite length on output, may be 0
+ * @param table_index in: the head of each packet's chain, ~0 for none;
+ *        out: the table that matched or, on a miss, the last one tried
+ * @param hash out: the hash of each packet in its head table
+ * @param e out: the matching entry or 0
+ * @return the number of hits in a table other than the head
+ */
+static_always_inline u32
+vnet_classify_find_entries_chained (vnet_classify_table_t *tables,
+				    vlib_buffer_t **b, const u16 *h_offset,
+				    u32 *table_index, u32 *hash,
+				    vnet_classify_entry_t **e, u32 n_packets,
+				    f64 now)
+{
+  vnet_classify_table_t *t[VLIB_FRAME_SIZE];
+  u8 *h[VLIB_FRAME_SIZE];
+  u32 hashes[VLIB_FRAME_SIZE];
+  u16 active[VLIB_FRAME_SIZE];
+  u32 i, j, n_active = 0, n_next, n_chain_hits = 0;
+  int is_head = 1;
+
+  ASSERT (n_packets <= VLIB_FRAME_SIZE);
+
+  for (i = 0; i < n_packets; i++)
+    {
+      e[i] = 0;
+      if (PREDICT_TRUE (table_index[i] != ~0))
+	active[n_active++] = i;
+    }
+
+  while (n_active)
+    {
+      for (j = 0; j < n_active; j++)
+	{
+	  i = active[j];
+	  t[i] = pool_elt_at_index (tables, table_index[i]);
+	  h[i] = vnet_classify_get_packet_data (t[i], b[i]);
+	  if (h_offset)
+	    h[i] += h_offset[i];
+	  hashes[i] = vnet_classify_hash_packet_inline (t[i], h[i]);
+	  vnet_classify_prefetch_bucket (t[i], hashes[i]);
+	  if (is_head)
+	    hash[i] = hashes[i];
+	}
+
+      for (j = 0; j < n_active; j++)
+	{
+	  i = active[j];
+	  vnet_classify_prefetch_entry (t[i], hashes[i]);
+	}
+
+      for (j = 0, n_next = 0; j < n_active; j++)
+	{
+	  i = active[j];
+	  e[i] = vnet_classify_find_entry_inline (t[i], h[i], hashes[i], now);
+	  if (e[i])
+	    n_chain_hits += !is_head;
+	  else if (t[i]->next_table_index != ~0)
+	    {
+	      table_index[i] = t[i]->next_table_index;
+	      active[n_next++] = i;
+	    }
+	}
+
+      n_active = n_next;
+      is_head = 0;
+    }
+
+  return n_chain_hits;
+}
+
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t *cm,
 						const u8 *mask, u32 nbuckets,
 						u32 memory_size,
@@ -597,7 +861,8 @@ int vnet_classify_add_del_table (vnet_classify_main_t *cm, const u8 *mask,
 				 u32 match, u32 next_table_index,
 				 u32 miss_next_index, u32 *table_index,
 				 u8 current_data_flag, i16 current_data_offset,
-				 int is_add, int del_chain);
+				 vnet_classify_table_type_t type, int is_add,
+				 int del_chain);
 void vnet_classify_delete_table_index (vnet_classify_main_t *cm,
 				       u32 table_index, int del_chain);
 
@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2026 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/crypto/crypto.h>
+#include <vlib/log.h>
+
+/*
+ * Startup calibration, enabled with "crypto-engines { calibrate }": the
+ * simple handler of every engine is timed for each op at a small and a
+ * large packet size, and the engine with the lowest clocks per byte over
+ * both becomes the active one, instead of the one with the highest static
+ * priority. With "calibrate per-size", ops shorter than
+ * VNET_CRYPTO_SMALL_OP_LEN go to the engine fastest on small packets when
+ * that is a different one.
+ */
+
+VLIB_REGISTER_LOG_CLASS (crypto_calib_log, static) = {
+  .class_name = "crypto",
+  .subclass_name = "calibrate",
+};
+
+#define log_debug(f, ...)                                                     \
+  vlib_log (VLIB_LOG_LEVEL_DEBUG, crypto_calib_log.class, f, ##__VA_ARGS__)
+#define log_notice(f, ...)                                                    \
+  vlib_log (VLIB_LOG_LEVEL_NOTICE, crypto_calib_log.class, f, ##__VA_ARGS__)
+
+#define CRYPTO_CALIB_N_OPS  32
+#define CRYPTO_CALIB_ROUNDS 8
+#define CRYPTO_CALIB_TRIES  3
+#define CRYPTO_CALIB_META   128
+
+static const u16 crypto_calib_len[] = {
+#define _(n, s, l) [VNET_CRYPTO_SIZE_CLASS_##n] = l,
+  foreach_crypto_size_class
+#undef _
+};
+
+typedef struct
+{
+  u8 *src, *dst, *meta;
+  u32 stride;
+  vnet_crypto_op_t ops[CRYPTO_CALIB_N_OPS];
+  vnet_crypto_op_t *op_ptrs[CRYPTO_CALIB_N_OPS];
+} crypto_calib_t;
+
+static void
+crypto_calib_ops_init (crypto_calib_t *c, vnet_crypto_op_id_t id,
+		       u32 key_index, u32 len, int reverse)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  int is_aead = cm->algs[cm->opt_data[id].alg].is_aead;
+  u32 i;
+
+  for (i = 0; i < CRYPTO_CALIB_N_OPS; i++)
+    {
+      vnet_crypto_op_t *op = c->ops + i;
+      u8 *m = c->meta + i * CRYPTO_CALIB_META;
+
+      vnet_crypto_op_init (op, id);
+      op->key_index = key_index;
+      op->src = (reverse ? c->dst : c->src) + i * c->stride;
+      op->dst = (reverse ? c->src : c->dst) + i * c->stride;
+      op->len = len;
+      op->iv = m;
+      op->aad = m + 16;
+      op->aad_len = is_aead ? 12 : 0;
+      /* digest_len 0 is the full digest */
+      op->tag = m + 64;
+      op->tag_len = is_aead ? 16 : 0;
+      c->op_ptrs[i] = op;
+    }
+}
+
+/* best of a few tries, in clocks per byte, or 0 if the ops fail */
+static f32
+crypto_calib_one (vlib_main_t *vm, crypto_calib_t *c,
+		  vnet_crypto_engine_t *ce, vnet_crypto_op_id_t id,
+		  u32 key_index, u32 len)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *od = cm->opt_data + id;
+  vnet_crypto_simple_op_fn_t *fn, *enc_fn;
+  vnet_crypto_op_id_t enc_id;
+  u64 t0, best = ~0ULL;
+  u32 i, j;
+
+  fn = ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+
+  /* decrypt the engine's own ciphertext, so tags verify and no engine
+   * gets to skip the work */
+  if (od->type == VNET_CRYPTO_OP_TYPE_DECRYPT)
+    {
+      enc_id = cm->algs[od->alg].op_by_type[VNET_CRYPTO_OP_TYPE_ENCRYPT];
+      enc_fn = ce->ops[enc_id].handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+      if (!enc_fn)
+	return 0;
+      crypto_calib_ops_init (c, enc_id, key_index, len, 0);
+      enc_fn (vm, c->op_ptrs, CRYPTO_CALIB_N_OPS);
+      crypto_calib_ops_init (c, id, key_index, len, 1);
+    }
+  else
+    crypto_calib_ops_init (c, id, key_index, len, 0);
+
+  fn (vm, c->op_ptrs, CRYPTO_CALIB_N_OPS);
+  for (i = 0; i < CRYPTO_CALIB_N_OPS; i++)
+    if (c->ops[i].status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+      return 0;
+
+  for (i = 0; i < CRYPTO_CALIB_TRIES; i++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (j = 0; j < CRYPTO_CALIB_ROUNDS; j++)
+	fn (vm, c->op_ptrs, CRYPTO_CALIB_N_OPS);
+      best = clib_min (best, clib_cpu_time_now () - t0);
+    }
+
+  return (f32) best / (CRYPTO_CALIB_ROUNDS * CRYPTO_CALIB_N_OPS * len);
+}
+
+static void
+crypto_calib_op (vlib_main_t *vm, crypto_calib_t *c, vnet_crypto_op_id_t id,
+		 u32 key_index)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_data_t *od = cm->opt_data + id;
+  vnet_crypto_engine_t *ce;
+  u32 ei, best = ~0, best_small = ~0, n_engines = 0;
+  f32 total, best_total = 0, best_small_cpb = 0;
+  vnet_crypto_size_class_t sc;
+
+  vec_foreach (ce, cm->engines)
+    if (ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE])
+      n_engines++;
+
+  /* nothing to choose from */
+  if (n_engines < 2)
+    return;
+
+  vec_foreach_index (ei, cm->engines)
+    {
+      vnet_crypto_engine_op_t *eo;
+
+      ce = cm->engines + ei;
+      eo = ce->ops + id;
+      if (!eo->handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE])
+	continue;
+
+      total = 0;
+      for (sc = 0; sc < VNET_CRYPTO_N_SIZE_CLASSES; sc++)
+	{
+	  eo->clocks_per_byte[sc] =
+	    crypto_calib_one (vm, c, ce, id, key_index, crypto_calib_len[sc]);
+	  if (eo->clocks_per_byte[sc] == 0)
+	    break;
+	  total += eo->clocks_per_byte[sc];
+	}
+
+      if (sc < VNET_CRYPTO_N_SIZE_CLASSES)
+	{
+	  log_debug ("%U: %s failed", format_vnet_crypto_op, id, ce->name);
+	  clib_memset (eo->clocks_per_byte, 0, sizeof (eo->clocks_per_byte));
+	  continue;
+	}
+
+      if (best == ~0 || total < best_total)
+	{
+	  best = ei;
+	  best_total = total;
+	}
+      if (best_small == ~0 ||
+	  eo->clocks_per_byte[VNET_CRYPTO_SIZE_CLASS_SMALL] < best_small_cpb)
+	{
+	  best_small = ei;
+	  best_small_cpb = eo->clocks_per_byte[VNET_CRYPTO_SIZE_CLASS_SMALL];
+	}
+    }
+
+  if (best == ~0)
+    return;
+
+  ce = cm->engines + best;
+  od->active_engine_index[VNET_CRYPTO_HANDLER_TYPE_SIMPLE] = best;
+  od->handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE] =
+    ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+  /* keep chained ops on the same engine where it has them */
+  if (ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_CHAINED])
+    {
+      od->active_engine_index[VNET_CRYPTO_HANDLER_TYPE_CHAINED] = best;
+      od->handlers[VNET_CRYPTO_HANDLER_TYPE_CHAINED] =
+	ce->ops[id].handlers[VNET_CRYPTO_HANDLER_TYPE_CHAINED];
+    }
+
+  od->small_handler = 0;
+  if (cm->per_size_handlers && best_small != best)
+    {
+      od->small_engine_index = best_small;
+      od->small_handler = cm->engines[best_small]
+			    .ops[id]
+			    .handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+    }
+
+  log_notice ("%U: %s%s%s", format_vnet_crypto_op, id, ce->name,
+	      od->small_handler ? ", small ops " : "",
+	      od->small_handler ? cm->engines[best_small].name : "");
+}
+
+void
+vnet_crypto_calibrate (vlib_main_t *vm)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  crypto_calib_t _c = {}, *c = &_c;
+  u32 i, max_len = 0, mem_size;
+  u8 key[32];
+  u8 *mem;
+
+  for (i = 0; i < VNET_CRYPTO_N_SIZE_CLASSES; i++)
+    max_len = clib_max (max_len, crypto_calib_len[i]);
+
+  c->stride = round_pow2 (max_len, CLIB_CACHE_LINE_BYTES);
+  mem_size = CRYPTO_CALIB_N_OPS * (2 * c->stride + CRYPTO_CALIB_META);
+  mem = clib_mem_alloc_aligned (mem_size, CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < mem_size; i++)
+    mem[i] = i;
+  c->src = mem;
+  c->dst = c->src + CRYPTO_CALIB_N_OPS * c->stride;
+  c->meta = c->dst + CRYPTO_CALIB_N_OPS * c->stride;
+
+  for (i = 0; i < sizeof (key); i++)
+    key[i] = i + 1;
+
+  FOREACH_ARRAY_ELT (ad, cm->algs)
+    {
+      u32 key_index = ~0, t;
+
+      if (ad == cm->algs)
+	continue;
+
+      /* hash ops are keyless, hmac keys may be of any length. Async algs
+       * have no key length of their own, their ops are not dispatched
+       * through the simple handlers */
+      if (ad->op_by_type[VNET_CRYPTO_OP_TYPE_HASH] == VNET_CRYPTO_OP_NONE)
+	{
+	  key_index = vnet_crypto_key_add (
+	    vm, ad - cm->algs, key,
+	    ad->variable_key_length ? sizeof (key) : ad->key_length);
+	  if (key_index == ~0)
+	    continue;
+	}
+
+      for (t = 0; t < VNET_CRYPTO_OP_N_TYPES; t++)
+	if (ad->op_by_type[t] != VNET_CRYPTO_OP_NONE)
+	  crypto_calib_op (vm, c, ad->op_by_type[t], key_index);
+
+      if (key_index != ~0)
+	vnet_crypto_key_del (vm, key_index);
+    }
+
+  clib_mem_free (mem);
+}
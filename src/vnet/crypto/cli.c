@@ -39,6 +39,16 @@ VLIB_CLI_COMMAND (show_crypto_engines_command, static) =
   .function = show_crypto_engines_command_fn,
 };
 
+static u8 *
+format_crypto_calib (u8 *s, va_list *args)
+{
+  f32 *clocks_per_byte = va_arg (*args, f32 *);
+
+  for (u32 i = 0; i < VNET_CRYPTO_N_SIZE_CLASSES; i++)
+    s = format (s, "%c%.2f", i ? '/' : '(', clocks_per_byte[i]);
+  return format (s, ")");
+}
+
 static clib_error_t *
 show_crypto_handlers_command_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -54,6 +64,18 @@ show_crypto_handlers_command_fn (vlib_main_t * vm,
   if (unformat_user (input, unformat_line_input, line_input))
     unformat_free (line_input);
 
+  if (cm->calibrate)
+    {
+#define _(n, str, l) s = format (s, "%s%u", s ? "/" : "", l);
+      foreach_crypto_size_class
+#undef _
+      vlib_cli_output (vm,
+		       "calibrated, simple handler clocks/byte at %v "
+		       "bytes in brackets",
+		       s);
+      vec_reset_length (s);
+    }
+
   FOREACH_ARRAY_ELT (a, cm->algs)
     {
       if (a == cm->algs)
@@ -77,12 +99,21 @@ show_crypto_handlers_command_fn (vlib_main_t * vm,
 			s = format (s, " %s", e->name);
 			if (e->ops[id].handlers[i] == od->handlers[i])
 			  s = format (s, "*");
+			if (i == VNET_CRYPTO_HANDLER_TYPE_SIMPLE &&
+			    e->ops[id].clocks_per_byte[0])
+			  s = format (s, "%U", format_crypto_calib,
+				      e->ops[id].clocks_per_byte);
 		      }
 		  }
 
 		vlib_cli_output (vm, "    %s:%v", handler_type_str[i], s);
 		vec_reset_length (s);
 	      }
+
+	    if (od->small_handler)
+	      vlib_cli_output (
+		vm, "    simple < %u bytes: %s", VNET_CRYPTO_SMALL_OP_LEN,
+		cm->engines[od->small_engine_index].name);
 	  }
     }
   vec_free (s);
@@ -78,6 +78,10 @@ crypto_engines_config (vlib_main_t *vm, unformat_input_t *input)
 	  cm->default_disabled = unformat (&sub_input, "disable") ? 1 : 0;
 	  unformat_free (&sub_input);
 	}
+      else if (unformat (input, "calibrate per-size"))
+	cm->calibrate = cm->per_size_handlers = 1;
+      else if (unformat (input, "calibrate"))
+	cm->calibrate = 1;
       else if (unformat (input, "%s %U", &s, unformat_vlib_cli_sub_input,
 			 &sub_input))
 	{
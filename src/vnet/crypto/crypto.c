@@ -39,7 +39,7 @@ vnet_crypto_process_ops_call_handler (vlib_main_t * vm,
 				      vnet_crypto_op_id_t opt,
 				      vnet_crypto_op_t * ops[],
 				      vnet_crypto_op_chunk_t * chunks,
-				      u32 n_ops)
+				      u32 n_ops, int is_small)
 {
   vnet_crypto_op_data_t *od = cm->opt_data + opt;
   u32 rv = 0;
@@ -61,6 +61,8 @@ vnet_crypto_process_ops_call_handler (vlib_main_t * vm,
     {
       vnet_crypto_simple_op_fn_t *fn =
 	od->handlers[VNET_CRYPTO_HANDLER_TYPE_SIMPLE];
+      if (is_small && od->small_handler)
+	fn = od->small_handler;
       if (fn == 0)
 	crypto_set_op_status (ops, n_ops,
 			      VNET_CRYPTO_OP_STATUS_FAIL_NO_HANDLER);
@@ -80,6 +82,7 @@ vnet_crypto_process_ops_inline (vlib_main_t * vm, vnet_crypto_op_t ops[],
   vnet_crypto_op_id_t opt, current_op_type = ~0;
   u32 n_op_queue = 0;
   u32 rv = 0, i;
+  int is_small = 0, current_is_small = 0;
 
   ASSERT (n_ops >= 1);
 
@@ -87,20 +90,27 @@ vnet_crypto_process_ops_inline (vlib_main_t * vm, vnet_crypto_op_t ops[],
     {
       opt = ops[i].op;
 
-      if (current_op_type != opt || n_op_queue >= op_q_size)
+      /* small and large ops may go to different engines */
+      if (cm->per_size_handlers && !chunks)
+	is_small = ops[i].len < VNET_CRYPTO_SMALL_OP_LEN;
+
+      if (current_op_type != opt || current_is_small != is_small ||
+	  n_op_queue >= op_q_size)
 	{
-	  rv += vnet_crypto_process_ops_call_handler (vm, cm, current_op_type,
-						      op_queue, chunks,
-						      n_op_queue);
+	  rv += vnet_crypto_process_ops_call_handler (
+	    vm, cm, current_op_type, op_queue, chunks, n_op_queue,
+	    current_is_small);
 	  n_op_queue = 0;
 	  current_op_type = opt;
+	  current_is_small = is_small;
 	}
 
       op_queue[n_op_queue++] = &ops[i];
     }
 
   rv += vnet_crypto_process_ops_call_handler (vm, cm, current_op_type,
-					      op_queue, chunks, n_op_queue);
+					      op_queue, chunks, n_op_queue,
+					      current_is_small);
   return rv;
 }
 
@@ -145,6 +155,9 @@ crypto_set_active_engine (vnet_crypto_op_data_t *od, vnet_crypto_op_id_t id,
     {
       od->active_engine_index[t] = ei;
       cm->opt_data[id].handlers[t] = ce->ops[id].handlers[t];
+      /* an explicit choice overrides the calibrated one for small ops */
+      if (t == VNET_CRYPTO_HANDLER_TYPE_SIMPLE)
+	od->small_handler = 0;
     }
 }
 
@@ -726,6 +739,9 @@ vnet_crypto_init (vlib_main_t * vm)
 
   vnet_crypto_load_engines (vm);
 
+  if (cm->calibrate)
+    vnet_crypto_calibrate (vm);
+
   return 0;
 }
 
@@ -389,9 +389,27 @@ void
 vnet_crypto_register_dequeue_handler (vlib_main_t *vm, u32 engine_index,
 				      vnet_crypto_frame_dequeue_t *deq_fn);
 
+/* packet sizes the startup calibration times handlers at. Ops shorter
+ * than VNET_CRYPTO_SMALL_OP_LEN are dispatched as small */
+#define VNET_CRYPTO_SMALL_OP_LEN 256
+
+#define foreach_crypto_size_class                                             \
+  _ (SMALL, "small", 64)                                                      \
+  _ (LARGE, "large", 1500)
+
+typedef enum
+{
+#define _(n, s, l) VNET_CRYPTO_SIZE_CLASS_##n,
+  foreach_crypto_size_class
+#undef _
+    VNET_CRYPTO_N_SIZE_CLASSES,
+} vnet_crypto_size_class_t;
+
 typedef struct
 {
   void *handlers[VNET_CRYPTO_HANDLER_N_TYPES];
+  /* simple handler calibration result, 0 if not measured */
+  f32 clocks_per_byte[VNET_CRYPTO_N_SIZE_CLASSES];
 } vnet_crypto_engine_op_t;
 
 typedef struct
@@ -416,6 +434,10 @@ typedef struct
   vnet_crypto_alg_t alg;
   u8 active_engine_index[VNET_CRYPTO_HANDLER_N_TYPES];
   void *handlers[VNET_CRYPTO_HANDLER_N_TYPES];
+  /* simple handler for small ops, set when calibration per size class
+   * found another engine faster for them */
+  u8 small_engine_index;
+  void *small_handler;
 } vnet_crypto_op_data_t;
 
 typedef struct
@@ -442,6 +464,8 @@ typedef struct
   vnet_crypto_alg_data_t algs[VNET_CRYPTO_N_ALGS];
   vnet_crypto_op_data_t opt_data[VNET_CRYPTO_N_OP_IDS];
   u8 default_disabled;
+  u8 calibrate;
+  u8 per_size_handlers;
 } vnet_crypto_main_t;
 
 extern vnet_crypto_main_t crypto_main;
@@ -453,6 +477,7 @@ u32 vnet_crypto_process_ops (vlib_main_t * vm, vnet_crypto_op_t ops[],
 			     u32 n_ops);
 
 void vnet_crypto_set_async_dispatch (u8 mode, u8 adaptive);
+void vnet_crypto_calibrate (vlib_main_t *vm);
 
 typedef struct
 {
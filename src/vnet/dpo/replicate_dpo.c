@@ -741,88 +741,104 @@ replicate_inline (vlib_main_t * vm,
 {
     vlib_combined_counter_main_t * cm = &replicate_main.repm_counters;
     replicate_main_t * rm = &replicate_main;
-    u32 n_left_from, * from, * to_next, next_index;
+    u32 n_left_from, * from, **clones;
     clib_thread_index_t thread_index = vlib_get_thread_index ();
+    u16 **nexts;
 
     from = vlib_frame_vector_args (frame);
     n_left_from = frame->n_vectors;
-    next_index = node->cached_next_index;
-  
+
+    /*
+     * the clones of all packets in the frame are collected, with their
+     * next nodes, and then enqueued in bulk. Clones only copy the first
+     * VLIB_BUFFER_CLONE_HEAD_SIZE bytes; the rest of the payload is shared
+     * by reference with the original.
+     */
+    clones = &rm->clones[thread_index];
+    nexts = &rm->clone_nexts[thread_index];
+
     while (n_left_from > 0)
     {
-        u32 n_left_to_next;
-
-        vlib_get_next_frame (vm, node, next_index,
-                             to_next, n_left_to_next);
+        u32 ci0, bi0, bucket, repi0, n_clones;
+        const replicate_t *rep0;
+        vlib_buffer_t * b0, *c0;
+        const dpo_id_t *dpo0;
+        u32 *to_clone;
+        u16 *to_next;
+        u16 num_cloned;
+
+        bi0 = from[0];
+        from += 1;
+        n_left_from -= 1;
+
+        if (n_left_from > 0)
+        {
+            vlib_buffer_t *p1 = vlib_get_buffer (vm, from[0]);
+            vlib_prefetch_buffer_header (p1, LOAD);
+        }
 
-        while (n_left_from > 0 && n_left_to_next > 0)
-	{
-            u32 next0, ci0, bi0, bucket, repi0;
-            const replicate_t *rep0;
-            vlib_buffer_t * b0, *c0;
-            const dpo_id_t *dpo0;
-	    u8 num_cloned;
+        b0 = vlib_get_buffer (vm, bi0);
+        repi0 = vnet_buffer (b0)->ip.adj_index[VLIB_TX];
+        rep0 = replicate_get(repi0);
 
-            bi0 = from[0];
-            from += 1;
-            n_left_from -= 1;
+        vlib_increment_combined_counter(
+            cm, thread_index, repi0, 1,
+            vlib_buffer_length_in_chain(vm, b0));
 
-            b0 = vlib_get_buffer (vm, bi0);
-            repi0 = vnet_buffer (b0)->ip.adj_index[VLIB_TX];
-            rep0 = replicate_get(repi0);
+        n_clones = vec_len (*clones);
+        vec_add2 (*clones, to_clone, rep0->rep_n_buckets);
+        vec_add2 (*nexts, to_next, rep0->rep_n_buckets);
 
-            vlib_increment_combined_counter(
-                cm, thread_index, repi0, 1,
-                vlib_buffer_length_in_chain(vm, b0));
+        num_cloned = vlib_buffer_clone (vm, bi0, to_clone,
+                                        rep0->rep_n_buckets,
+                                        VLIB_BUFFER_CLONE_HEAD_SIZE);
 
-	    vec_validate (rm->clones[thread_index], rep0->rep_n_buckets - 1);
+        if (num_cloned != rep0->rep_n_buckets)
+          {
+            vlib_node_increment_counter
+              (vm, node->node_index,
+               REPLICATE_DPO_ERROR_BUFFER_ALLOCATION_FAILURE, 1);
+            vec_set_len (*clones, n_clones + num_cloned);
+            vec_set_len (*nexts, n_clones + num_cloned);
+          }
 
-	    num_cloned = vlib_buffer_clone (vm, bi0, rm->clones[thread_index],
-                                            rep0->rep_n_buckets,
-					    VLIB_BUFFER_CLONE_HEAD_SIZE);
+        for (bucket = 0; bucket < num_cloned; bucket++)
+        {
+            ci0 = to_clone[bucket];
+            c0 = vlib_get_buffer(vm, ci0);
 
-	    if (num_cloned != rep0->rep_n_buckets)
-	      {
-		vlib_node_increment_counter
-		  (vm, node->node_index,
-		   REPLICATE_DPO_ERROR_BUFFER_ALLOCATION_FAILURE, 1);
-	      }
+            dpo0 = replicate_get_bucket_i(rep0, bucket);
+            to_next[bucket] = dpo0->dpoi_next_node;
+            vnet_buffer (c0)->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
 
-            for (bucket = 0; bucket < num_cloned; bucket++)
+            if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
             {
-                ci0 = rm->clones[thread_index][bucket];
-                c0 = vlib_get_buffer(vm, ci0);
-
-                to_next[0] = ci0;
-                to_next += 1;
-                n_left_to_next -= 1;
+                replicate_trace_t *t;
 
-                dpo0 = replicate_get_bucket_i(rep0, bucket);
-                next0 = dpo0->dpoi_next_node;
-                vnet_buffer (c0)->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
-
-                if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
-                {
-                    replicate_trace_t *t;
-
-                    t = vlib_add_trace (vm, node, c0, sizeof (*t));
-                    t->rep_index = repi0;
-                    t->dpo = *dpo0;
-                }
-
-                vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-                                                 to_next, n_left_to_next,
-                                                 ci0, next0);
-		if (PREDICT_FALSE (n_left_to_next == 0))
-		  {
-		    vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-		    vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-		  }
+                t = vlib_add_trace (vm, node, c0, sizeof (*t));
+                t->rep_index = repi0;
+                t->dpo = *dpo0;
             }
-	    vec_reset_length (rm->clones[thread_index]);
         }
 
-        vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+        /*
+         * don't let the pending set grow unbounded for high fan-out groups
+         */
+        if (vec_len (*clones) >= VLIB_FRAME_SIZE)
+        {
+            vlib_buffer_enqueue_to_next_vec (vm, node, clones, nexts,
+                                             vec_len (*clones));
+            vec_reset_length (*clones);
+            vec_reset_length (*nexts);
+        }
+    }
+
+    if (vec_len (*clones))
+    {
+        vlib_buffer_enqueue_to_next_vec (vm, node, clones, nexts,
+                                         vec_len (*clones));
+        vec_reset_length (*clones);
+        vec_reset_length (*nexts);
     }
 
     return frame->n_vectors;
@@ -925,6 +941,7 @@ replicate_dpo_init (vlib_main_t * vm)
   replicate_main_t * rm = &replicate_main;
 
   vec_validate (rm->clones, vlib_num_workers());
+  vec_validate (rm->clone_nexts, vlib_num_workers());
 
   return 0;
 }
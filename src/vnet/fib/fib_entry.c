@@ -194,13 +194,13 @@ format_fib_entry (u8 * s, va_list * args)
 
         if (level >= FIB_ENTRY_FORMAT_DETAIL2)
         {
-            index_t *fedi;
+            index_t fedi;
 
             s = format (s, " Delegates:\n");
-            vec_foreach(fedi, fib_entry->fe_delegates)
+            FOR_EACH_DELEGATE(fib_entry, fedi,
             {
-                s = format(s, "  %U\n", format_fib_entry_delegate, *fedi);
-            }
+                s = format(s, "  %U\n", format_fib_entry_delegate, fedi);
+            });
         }
     }
 
@@ -241,8 +241,7 @@ fib_entry_last_lock_gone (fib_node_t *node)
 
     fib_node_deinit(&fib_entry->fe_node);
 
-    ASSERT(0 == vec_len(fib_entry->fe_delegates));
-    vec_free(fib_entry->fe_delegates);
+    ASSERT(INDEX_INVALID == fib_entry->fe_delegate);
     vec_free(fib_entry->fe_srcs);
     pool_put(fib_entry_pool, fib_entry);
 }
@@ -297,6 +296,7 @@ static void
 fib_entry_show_memory (void)
 {
     u32 n_srcs = 0, n_exts = 0;
+    u32 n_srcs_alloc = 0, n_exts_alloc = 0;
     fib_entry_src_t *esrc;
     fib_entry_t *entry;
 
@@ -305,20 +305,27 @@ fib_entry_show_memory (void)
 			  pool_len(fib_entry_pool),
 			  sizeof(fib_entry_t));
 
+    /*
+     * the per-entry vectors are accounted by their allocated capacity,
+     * not just their length, since it's the capacity that is consumed
+     */
     pool_foreach (entry, fib_entry_pool)
      {
 	n_srcs += vec_len(entry->fe_srcs);
+	n_srcs_alloc += vec_max_len(entry->fe_srcs);
 	vec_foreach(esrc, entry->fe_srcs)
 	{
 	    n_exts += fib_path_ext_list_length(&esrc->fes_path_exts);
+	    n_exts_alloc += vec_max_len(esrc->fes_path_exts.fpel_exts);
 	}
     }
 
     fib_show_memory_usage("Entry Source",
-			  n_srcs, n_srcs, sizeof(fib_entry_src_t));
+			  n_srcs, n_srcs_alloc, sizeof(fib_entry_src_t));
     fib_show_memory_usage("Entry Path-Extensions",
-			  n_exts, n_exts,
+			  n_exts, n_exts_alloc,
 			  sizeof(fib_path_ext_t));
+    fib_entry_delegate_show_memory();
 }
 
 /**
@@ -555,6 +562,7 @@ fib_entry_alloc (u32 fib_index,
 		  FIB_NODE_TYPE_ENTRY);
 
     fib_entry->fe_fib_index = fib_index;
+    fib_entry->fe_delegate = INDEX_INVALID;
 
     /*
      * the one time we need to update the const prefix is when
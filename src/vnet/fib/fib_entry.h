@@ -322,6 +322,13 @@ typedef struct fib_entry_t_ {
      * The index of the FIB table this entry is in
      */
     u32 fe_fib_index;
+    /**
+     * The first of the entry's delegates, INDEX_INVALID if it has none.
+     * The delegates are linked, in type order, through their fd_next.
+     * Most entries have none or one, so a list costs less than a vector
+     * per entry, and the head fits in what would otherwise be padding.
+     */
+    index_t fe_delegate;
     /**
      * The load-balance used for forwarding.
      *
@@ -352,11 +359,6 @@ typedef struct fib_entry_t_ {
      * be changed by the parent as it manages its list.
      */
     u32 fe_sibling;
-
-    /**
-     * A vector of delegate indices.
-     */
-    index_t *fe_delegates;
 } fib_entry_t;
 
 #define FOR_EACH_FIB_ENTRY_FLAG(_item) \
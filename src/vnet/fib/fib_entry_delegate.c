@@ -31,33 +31,45 @@ fib_entry_delegate_get_index (const fib_entry_delegate_t *fed)
     return (fed - fib_entry_delegate_pool);
 }
 
+/**
+ * Find the delegate of the given type, and the one before it in the
+ * entry's list (INDEX_INVALID if it is the first)
+ */
 static fib_entry_delegate_t *
 fib_entry_delegate_find_i (const fib_entry_t *fib_entry,
                            fib_entry_delegate_type_t type,
-                           u32 *index)
+                           index_t *prev)
 {
     fib_entry_delegate_t *delegate;
-    index_t *fedi;
-    int ii;
-
-    ii = 0;
-    vec_foreach(fedi, fib_entry->fe_delegates)
-    {
-        delegate = fib_entry_delegate_get(*fedi);
+    index_t fedi, previ;
 
-	if (delegate->fd_type == type)
-	{
-            if (NULL != index)
-                *index = ii;
+    previ = INDEX_INVALID;
 
-	    return (delegate);
-	}
-	else
-	{
-	    ii++;
-	}
+    for (fedi = fib_entry->fe_delegate;
+         INDEX_INVALID != fedi;
+         fedi = delegate->fd_next)
+    {
+        delegate = fib_entry_delegate_get(fedi);
+
+        if (delegate->fd_type == type)
+        {
+            if (NULL != prev)
+                *prev = previ;
+
+            return (delegate);
+        }
+        /*
+         * the list is in type order
+         */
+        if (delegate->fd_type > type)
+            break;
+
+        previ = fedi;
     }
 
+    if (NULL != prev)
+        *prev = previ;
+
     return (NULL);
 }
 
@@ -73,45 +85,51 @@ fib_entry_delegate_remove (fib_entry_t *fib_entry,
                            fib_entry_delegate_type_t type)
 {
     fib_entry_delegate_t *fed;
-    u32 index = ~0;
+    index_t prev;
 
-    fed = fib_entry_delegate_find_i(fib_entry, type, &index);
+    fed = fib_entry_delegate_find_i(fib_entry, type, &prev);
 
     ASSERT(NULL != fed);
 
-    vec_del1(fib_entry->fe_delegates, index);
+    if (INDEX_INVALID == prev)
+    {
+        fib_entry->fe_delegate = fed->fd_next;
+    }
+    else
+    {
+        fib_entry_delegate_get(prev)->fd_next = fed->fd_next;
+    }
 
     pool_put(fib_entry_delegate_pool, fed);
 }
 
-static int
-fib_entry_delegate_cmp_for_sort (void * v1,
-                                 void * v2)
-{
-    fib_entry_delegate_t *delegate1, *delegate2;
-    index_t *fedi1 = v1, *fedi2 = v2;
-
-    delegate1 = fib_entry_delegate_get(*fedi1);
-    delegate2 = fib_entry_delegate_get(*fedi2);
-
-    return (delegate1->fd_type - delegate2->fd_type);
-}
-
 static void
 fib_entry_delegate_init (fib_entry_t *fib_entry,
-                         fib_entry_delegate_type_t type)
+                         fib_entry_delegate_type_t type,
+                         index_t prev)
 
 {
     fib_entry_delegate_t *delegate;
+    index_t *next;
 
     pool_get_zero(fib_entry_delegate_pool, delegate);
 
     delegate->fd_entry_index = fib_entry_get_index(fib_entry);
     delegate->fd_type = type;
 
-    vec_add1(fib_entry->fe_delegates, delegate - fib_entry_delegate_pool);
-    vec_sort_with_function(fib_entry->fe_delegates,
-			   fib_entry_delegate_cmp_for_sort);
+    /*
+     * insert after prev, which keeps the list in type order
+     */
+    if (INDEX_INVALID == prev)
+    {
+        next = &fib_entry->fe_delegate;
+    }
+    else
+    {
+        next = &fib_entry_delegate_get(prev)->fd_next;
+    }
+    delegate->fd_next = *next;
+    *next = delegate - fib_entry_delegate_pool;
 }
 
 fib_entry_delegate_t *
@@ -119,12 +137,13 @@ fib_entry_delegate_find_or_add (fib_entry_t *fib_entry,
                                 fib_entry_delegate_type_t fdt)
 {
     fib_entry_delegate_t *delegate;
+    index_t prev;
 
-    delegate = fib_entry_delegate_find(fib_entry, fdt);
+    delegate = fib_entry_delegate_find_i(fib_entry, fdt, &prev);
 
     if (NULL == delegate)
     {
-	fib_entry_delegate_init(fib_entry, fdt);
+	fib_entry_delegate_init(fib_entry, fdt, prev);
     }
 
     return (fib_entry_delegate_find(fib_entry, fdt));
@@ -304,6 +323,15 @@ format_fib_entry_delegate (u8 * s, va_list * args)
     return (fed_formatters[fed->fd_type](fed, s));
 }
 
+void
+fib_entry_delegate_show_memory (void)
+{
+    fib_show_memory_usage("Entry Delegate",
+			  pool_elts(fib_entry_delegate_pool),
+			  pool_len(fib_entry_delegate_pool),
+			  sizeof(fib_entry_delegate_t));
+}
+
 static clib_error_t *
 show_fib_entry_delegate_command (vlib_main_t * vm,
                                  unformat_input_t * input,
@@ -71,6 +71,20 @@ typedef enum fib_entry_delegate_type_t_ {
     }                                                         \
 }
 
+/**
+ * Walk all the delegates of an entry, in type order. The body must not
+ * remove the delegate it is given.
+ */
+#define FOR_EACH_DELEGATE(_entry, _fedi, _body)               \
+{                                                             \
+    for (_fedi = (_entry)->fe_delegate;                       \
+         INDEX_INVALID != _fedi;                              \
+         _fedi = fib_entry_delegate_get(_fedi)->fd_next)      \
+    {                                                         \
+        _body;                                                \
+    }                                                         \
+}
+
 /**
  * Distillation of the BFD session states into a go/no-go for using
  * the associated tracked FIB entry
@@ -108,9 +122,14 @@ typedef struct fib_entry_delegate_t_
      */
     fib_entry_delegate_type_t fd_type;
 
+    /**
+     * The entry's next delegate, INDEX_INVALID for the last
+     */
+    index_t fd_next;
+
     /**
      * A union of data for the different delegate types
-     * These delegates are stored in a sparse vector on the entry, so they
+     * These delegates are allocated from a single pool, so they
      * must all be of the same size. We could use indirection here for all types,
      * i.e. store an index, that's ok for large delegates, like the attached export
      * but for the chain delegates it's excessive
@@ -165,4 +184,9 @@ extern u8 *format_fib_entry_delegate(u8 * s, va_list * args);
 extern fib_node_index_t fib_entry_delegate_get_index (const fib_entry_delegate_t *fed);
 extern fib_entry_delegate_t * fib_entry_delegate_get (fib_node_index_t fedi);
 
+/**
+ * Display the memory used by the delegate pool
+ */
+extern void fib_entry_delegate_show_memory (void);
+
 #endif
@@ -284,11 +284,13 @@ fib_memory_show (vlib_main_t * vm,
  *       IPv6 multicast            2      ???
  * Nodes:
  *            Name               Size  in-use /allocated   totals
- *            Entry               96     20   /    20      1920/1920
+ *            Entry               64     20   /    20      1280/1280
  *        Entry Source            32      0   /    0       0/0
  *    Entry Path-Extensions       60      0   /    0       0/0
+ *       Entry Delegate          32      2   /    2        64/64
  *       multicast-Entry         192     12   /    12      2304/2304
  *          Path-list             40     28   /    28      1120/1120
+ *      Path-list shared         16      4   /    32       64/512
  *          uRPF-list             16     20   /    20      320/320
  *            Path                72     28   /    28      2016/2016
  *     Node-list elements         20     28   /    28      560/560
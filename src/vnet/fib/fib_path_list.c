@@ -527,6 +527,14 @@ fib_path_list_memory_show (void)
 			  pool_elts(fib_path_list_pool),
 			  pool_len(fib_path_list_pool),
 			  sizeof(fib_path_list_t));
+    /*
+     * the shared path-lists are those interned in the DB, i.e. one
+     * instance per unique set of paths no matter how many entries use it
+     */
+    fib_show_memory_usage("Path-list shared",
+			  hash_elts(fib_path_list_db),
+			  vec_len(fib_path_list_db),
+			  sizeof(hash_pair_t));
     fib_urpf_list_show_mem();
 }
 
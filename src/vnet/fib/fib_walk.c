@@ -104,12 +104,14 @@ typedef enum fib_walk_queue_stats_t_
 {
     FIB_WALK_SCHEDULED,
     FIB_WALK_COMPLETED,
+    FIB_WALK_DEFERRED,
 } fib_walk_queue_stats_t;
-#define FIB_WALK_QUEUE_STATS_NUM ((fib_walk_queue_stats_t)(FIB_WALK_COMPLETED+1))
+#define FIB_WALK_QUEUE_STATS_NUM ((fib_walk_queue_stats_t)(FIB_WALK_DEFERRED+1))
 
 #define FIB_WALK_QUEUE_STATS {           \
     [FIB_WALK_SCHEDULED] = "scheduled",  \
     [FIB_WALK_COMPLETED] = "completed",  \
+    [FIB_WALK_DEFERRED] = "deferred",    \
 }
 
 #define FOR_EACH_FIB_WALK_QUEUE_STATS(_wqs)   \
@@ -186,6 +188,20 @@ typedef struct fib_walk_history_t_ {
 } fib_walk_history_t;
 static fib_walk_history_t fib_walk_history[HISTORY_N_WALKS];
 
+/**
+ * @brief log2 histograms, exported to the stats segment, of the duration
+ * (in usecs) and of the number of elements visited, for each completed
+ * walk. Walks are always run on the main thread.
+ */
+#define FIB_WALK_HIST_N_BINS 32
+#define USEC 1000000
+static vlib_log2_histogram_main_t fib_walk_duration_hist = {
+    .name = "/sys/fib/walk/duration-usec",
+};
+static vlib_log2_histogram_main_t fib_walk_visits_hist = {
+    .name = "/sys/fib/walk/visits",
+};
+
 static u8* format_fib_walk (u8* s, va_list *ap);
 
 #define FIB_WALK_DBG(_walk, _fmt, _args...)                     \
@@ -303,6 +319,18 @@ fib_walk_destroy (index_t fwi)
         }
     }
 
+    vlib_increment_log2_histogram_bin(
+        &fib_walk_duration_hist, 0,
+        vlib_log2_histogram_bin_index(
+            &fib_walk_duration_hist,
+            fib_walk_history[history_last_walk_pos].fwh_duration * USEC),
+        1);
+    vlib_increment_log2_histogram_bin(
+        &fib_walk_visits_hist, 0,
+        vlib_log2_histogram_bin_index(&fib_walk_visits_hist,
+                                      fwalk->fw_n_visits),
+        1);
+
     history_last_walk_pos = (history_last_walk_pos + 1) % HISTORY_N_WALKS;
 
     fib_node_deinit(&fwalk->fw_node);
@@ -434,6 +462,16 @@ static f64 fib_walk_sleep_duration[] = {
  */
 static f64 quota = 1e-4;
 
+/**
+ * @brief The time quota for a synchronous walk. A sync walk that has not
+ * reached the end of the dependency list when this is spent is moved to the
+ * high priority queue and completed by the fib-walk process, which runs on
+ * the main thread outside of the barrier, so the workers continue to forward
+ * while it does. Walks requested with FIB_NODE_BW_FLAG_FORCE_SYNC are always
+ * completed. Zero, the default, means sync walks always run to completion.
+ */
+static f64 sync_quota;
+
 /**
  * Histogram on the amount of work done (in msecs) in each walk
  */
@@ -732,6 +770,68 @@ fib_walk_async (fib_node_type_t parent_type,
                  format_fib_node_bw_reason, ctx->fnbw_reason);
 }
 
+/**
+ * @brief Has a sync walk, started at start_time, spent its quota and can
+ * the rest of it be deferred to the async queue.
+ */
+static int
+fib_walk_sync_quota_spent (index_t fwi,
+                           f64 start_time)
+{
+    fib_walk_t *fwalk;
+    u32 ii;
+
+    if (0 == sync_quota ||
+        (vlib_time_now(vlib_get_main()) - start_time) < sync_quota)
+    {
+        return (0);
+    }
+
+    fwalk = fib_walk_get(fwi);
+
+    vec_foreach_index(ii, fwalk->fw_ctx)
+    {
+        if (fwalk->fw_ctx[ii].fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC)
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+/**
+ * @brief Leave the remainder of a sync walk to the fib-walk process.
+ * The walk object stays where it is in the parent's dependency list, so
+ * the async walk resumes from the next child to visit.
+ */
+static void
+fib_walk_defer (index_t fwi)
+{
+    fib_walk_queue_t *fwq;
+    fib_walk_t *fwalk;
+
+    fwalk = fib_walk_get(fwi);
+    fwalk->fw_flags &= ~FIB_WALK_FLAG_EXECUTING;
+
+    if (FIB_NODE_INDEX_INVALID != fwalk->fw_prio_sibling)
+    {
+        /*
+         * this is an async walk the sync walk merged with, it is already
+         * queued.
+         */
+        return;
+    }
+
+    fwalk->fw_flags |= FIB_WALK_FLAG_ASYNC;
+    fwalk->fw_prio_sibling =
+        fib_walk_prio_queue_enquue(FIB_WALK_PRIORITY_HIGH, fwalk);
+    fwq = &fib_walk_queues.fwqs_queues[FIB_WALK_PRIORITY_HIGH];
+    fwq->fwq_stats[FIB_WALK_DEFERRED]++;
+
+    FIB_WALK_DBG(fwalk, "sync-deferred");
+}
+
 /**
  * @brief Back walk all the children of a FIB node.
  *
@@ -747,6 +847,7 @@ fib_walk_sync (fib_node_type_t parent_type,
     fib_walk_advance_rc_t rc;
     fib_node_index_t fwi;
     fib_walk_t *fwalk;
+    f64 start_time;
 
     if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
     {
@@ -765,6 +866,7 @@ fib_walk_sync (fib_node_type_t parent_type,
         return;
     }
 
+    start_time = (0 != sync_quota ? vlib_time_now(vlib_get_main()) : 0);
     fwalk = fib_walk_alloc(parent_type,
 			   parent_index,
 			   FIB_WALK_FLAG_SYNC,
@@ -788,7 +890,8 @@ fib_walk_sync (fib_node_type_t parent_type,
 	do
 	{
 	    rc = fib_walk_advance(fwi);
-	} while (FIB_WALK_ADVANCE_MORE == rc);
+	} while ((FIB_WALK_ADVANCE_MORE == rc) &&
+                 !fib_walk_sync_quota_spent(fwi, start_time));
 
 
 	/*
@@ -798,7 +901,17 @@ fib_walk_sync (fib_node_type_t parent_type,
 	 */
 	fwalk = fib_walk_get(fwi);
 
-	if (FIB_WALK_ADVANCE_MERGE == rc)
+	if (FIB_WALK_ADVANCE_MORE == rc)
+	{
+	    /*
+	     * out of time. the children not yet visited are walked
+	     * asynchronously.
+	     */
+	    fib_walk_defer(fwi);
+	    fwalk = NULL;
+	    break;
+	}
+	else if (FIB_WALK_ADVANCE_MERGE == rc)
 	{
 	    /*
 	     * this sync walk merged with an walk in front.
@@ -950,6 +1063,11 @@ fib_walk_module_init (void)
 
     fib_node_register_type(FIB_NODE_TYPE_WALK, &fib_walk_vft);
     fib_walk_logger = vlib_log_register_class("fib", "walk");
+
+    vlib_validate_log2_histogram(&fib_walk_duration_hist,
+                                 FIB_WALK_HIST_N_BINS);
+    vlib_validate_log2_histogram(&fib_walk_visits_hist,
+                                 FIB_WALK_HIST_N_BINS);
 }
 
 static u8*
@@ -994,8 +1112,8 @@ fib_walk_show (vlib_main_t * vm,
     int more_elts, ii;
     u8 *s = NULL;
 
-#define USEC 1000000
     vlib_cli_output(vm, "FIB Walk Quota = %.2fusec:", quota * USEC);
+    vlib_cli_output(vm, "FIB Sync Walk Quota = %.2fusec:", sync_quota * USEC);
     vlib_cli_output(vm, "FIB Walk queues:");
 
     FOR_EACH_FIB_WALK_PRIORITY(prio)
@@ -1150,6 +1268,46 @@ VLIB_CLI_COMMAND (fib_walk_set_quota_command, static) = {
     .function = fib_walk_set_quota,
 };
 
+void
+fib_walk_sync_quota_set (f64 new_quota)
+{
+    sync_quota = new_quota;
+}
+
+static clib_error_t *
+fib_walk_set_sync_quota (vlib_main_t * vm,
+                         unformat_input_t * input,
+                         vlib_cli_command_t * cmd)
+{
+    clib_error_t * error = NULL;
+    f64 new_quota;
+
+    if (unformat (input, "%f", &new_quota) && new_quota >= 0)
+    {
+	fib_walk_sync_quota_set(new_quota);
+    }
+    else
+    {
+	error = clib_error_return(0 , "Pass a positive float value, or 0");
+    }
+
+    return (error);
+}
+
+/*?
+ * Set the time, in seconds, after which a synchronous back walk leaves the
+ * children it has not yet visited to the fib-walk process. 0, the default,
+ * lets sync walks run to completion.
+ *
+ * @cliexpar
+ * @cliexcmd{set fib walk sync-quota 0.001}
+ ?*/
+VLIB_CLI_COMMAND (fib_walk_set_sync_quota_command, static) = {
+    .path = "set fib walk sync-quota",
+    .short_help = "set fib walk sync-quota <seconds>",
+    .function = fib_walk_set_sync_quota,
+};
+
 static clib_error_t *
 fib_walk_set_histogram_elements_size (vlib_main_t * vm,
 				      unformat_input_t * input,
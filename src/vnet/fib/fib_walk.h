@@ -52,6 +52,12 @@ extern void fib_walk_sync(fib_node_type_t parent_type,
                           fib_node_index_t parent_index,
                           fib_node_back_walk_ctx_t *ctx);
 
+/**
+ * @brief Set the time a sync walk may run before the rest of it is done
+ * asynchronously. 0 disables this.
+ */
+extern void fib_walk_sync_quota_set(f64 quota);
+
 extern u8* format_fib_walk_priority(u8 *s, va_list *ap);
 
 extern void fib_walk_process_enable(void);
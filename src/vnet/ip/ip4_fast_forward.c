@@ -0,0 +1,379 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (c) 2026 Cisco Systems, Inc.
+ */
+
+/**
+ * @file
+ * @brief IPv4 fast forward.
+ *
+ * An opt-in feature on the device-input arc that forwards the common case,
+ * a plain unicast IPv4 packet without options arriving on an L3 ethernet
+ * interface with no input features and resolving to a single, complete
+ * adjacency without output features, in one pass. It does the work of
+ * ethernet-input, ip4-input, ip4-lookup and ip4-rewrite and sends the
+ * packet straight to interface-output. Every other packet continues on the
+ * device-input arc to ethernet-input, i.e. through the full graph.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/fib/ip4_fib.h>
+#include <vnet/dpo/load_balance.h>
+#include <vnet/adj/adj.h>
+#include <vnet/l2/l2_input.h>
+
+typedef enum
+{
+  IP4_FAST_FWD_NEXT_INTERFACE_OUTPUT,
+  IP4_FAST_FWD_N_NEXT,
+} ip4_fast_fwd_next_t;
+
+#define foreach_ip4_fast_fwd_error                                            \
+  _ (FORWARDED, forwarded, INFO, "fast forwarded")                            \
+  _ (SLOW_PATH, slow-path, INFO, "passed to the full graph")
+
+typedef enum
+{
+#define _(f, n, s, d) IP4_FAST_FWD_ERROR_##f,
+  foreach_ip4_fast_fwd_error
+#undef _
+    IP4_FAST_FWD_N_ERROR,
+} ip4_fast_fwd_error_t;
+
+static vlib_error_desc_t ip4_fast_fwd_error_counters[] = {
+#define _(f, n, s, d) { #n, d, VL_COUNTER_SEVERITY_##s },
+  foreach_ip4_fast_fwd_error
+#undef _
+};
+
+typedef struct ip4_fast_fwd_trace_t_
+{
+  u32 adj_index;
+  u8 forwarded;
+} ip4_fast_fwd_trace_t;
+
+static u8 *
+format_ip4_fast_fwd_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  ip4_fast_fwd_trace_t *t = va_arg (*args, ip4_fast_fwd_trace_t *);
+
+  if (t->forwarded)
+    s = format (s, "fast forwarded via adj:%d", t->adj_index);
+  else
+    s = format (s, "slow path");
+
+  return s;
+}
+
+#define IP4_FAST_FWD_DMAC_MASK clib_net_to_host_u64 (0xFFFFFFFFFFFF0000)
+
+/**
+ * The per-interface state needed by the fast path, computed once for each
+ * run of packets from the same interface.
+ */
+typedef struct ip4_fast_fwd_if_t_
+{
+  u32 sw_if_index;
+  u32 fib_index;
+  u64 hwaddr;
+  u8 is_eligible;
+} ip4_fast_fwd_if_t;
+
+static_always_inline void
+ip4_fast_fwd_if_update (ip4_fast_fwd_if_t *fif, u32 sw_if_index)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  ip4_main_t *im = &ip4_main;
+  const ethernet_interface_t *ei;
+  const l2_input_config_t *l2i;
+  vnet_sw_interface_t *si;
+
+  fif->sw_if_index = sw_if_index;
+  fif->is_eligible = 0;
+
+  si = vnet_get_sw_interface (vnm, sw_if_index);
+  ei = ethernet_get_interface (&ethernet_main, si->hw_if_index);
+
+  /*
+   * only L3 ethernet interfaces on which the ip4-unicast arc has no
+   * features, which also excludes those on which IPv4 is not enabled.
+   */
+  if (NULL == ei || sw_if_index >= vec_len (im->fib_index_by_sw_if_index) ||
+      vnet_have_features (im->lookup_main.ucast_feature_arc_index,
+			  sw_if_index))
+    return;
+
+  /*
+   * and on which this is the only device-input feature, the others, like
+   * span or p2p ethernet, expect to see every packet before it is sent.
+   */
+  if (vnet_get_feature_count (feature_main.device_input_feature_arc_index,
+			      sw_if_index) != 1)
+    return;
+
+  l2i = l2input_intf_config (sw_if_index);
+
+  if (l2_input_is_bridge (l2i) || l2_input_is_xconnect (l2i))
+    return;
+
+  fif->hwaddr = ei->address.as_u64;
+  fif->fib_index = vec_elt (im->fib_index_by_sw_if_index, sw_if_index);
+  fif->is_eligible = 1;
+}
+
+/**
+ * @brief Forward the packet if it is the simple case.
+ * @return the adjacency used, or ADJ_INDEX_INVALID if the packet must
+ * take the slow path.
+ */
+static_always_inline adj_index_t
+ip4_fast_fwd_one (vlib_main_t *vm, const ip4_fast_fwd_if_t *fif,
+		  vlib_buffer_t *b, clib_thread_index_t thread_index)
+{
+  const ip_adjacency_t *adj;
+  const load_balance_t *lb;
+  ethernet_header_t *eh;
+  const dpo_id_t *dpo;
+  ip4_header_t *ip;
+  u32 lbi, checksum;
+  u16 len;
+
+  if (!fif->is_eligible ||
+      (b->flags & (VLIB_BUFFER_NEXT_PRESENT | VNET_BUFFER_F_GSO)) ||
+      b->current_length < sizeof (*eh) + sizeof (*ip))
+    return (ADJ_INDEX_INVALID);
+
+  eh = vlib_buffer_get_current (b);
+  ip = (ip4_header_t *) (eh + 1);
+
+  if (eh->type != clib_host_to_net_u16 (ETHERNET_TYPE_IP4) ||
+      ((*(u64 *) eh->dst_address & IP4_FAST_FWD_DMAC_MASK) != fif->hwaddr))
+    return (ADJ_INDEX_INVALID);
+
+  /*
+   * no options, no fragments, a TTL that survives the decrement, a valid
+   * checksum and a length that matches the buffer.
+   */
+  len = clib_net_to_host_u16 (ip->length);
+
+  if (ip->ip_version_and_header_length != 0x45 || ip->ttl <= 1 ||
+      ip4_is_fragment (ip) || len < sizeof (*ip) ||
+      len > b->current_length - sizeof (*eh) ||
+      !ip4_header_checksum_is_valid (ip) ||
+      ip4_address_is_multicast (&ip->dst_address) ||
+      ip->dst_address.as_u32 == 0xffffffff)
+    return (ADJ_INDEX_INVALID);
+
+  lbi = ip4_fib_forwarding_lookup (fif->fib_index, &ip->dst_address);
+  lb = load_balance_get (lbi);
+
+  if (lb->lb_n_buckets != 1)
+    return (ADJ_INDEX_INVALID);
+
+  dpo = load_balance_get_bucket_i (lb, 0);
+
+  if (dpo->dpoi_type != DPO_ADJACENCY)
+    return (ADJ_INDEX_INVALID);
+
+  adj = adj_get (dpo->dpoi_index);
+
+  /*
+   * the rewrite must replace exactly the ethernet header the packet
+   * arrived with, so no buffer adjustment is needed.
+   */
+  if (adj->lookup_next_index != IP_LOOKUP_NEXT_REWRITE ||
+      adj->rewrite_header.data_bytes != sizeof (*eh) ||
+      (adj->rewrite_header.flags & VNET_REWRITE_HAS_FEATURES) ||
+      len > adj->rewrite_header.max_l3_packet_bytes)
+    return (ADJ_INDEX_INVALID);
+
+  /* Decrement TTL & update checksum, as ip4-rewrite does */
+  checksum = ip->checksum + clib_host_to_net_u16 (0x0100);
+  checksum += checksum >= 0xffff;
+  ip->checksum = checksum;
+  ip->ttl -= 1;
+
+  vnet_rewrite_one_header (adj[0], ip, sizeof (ethernet_header_t));
+
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = adj->rewrite_header.sw_if_index;
+  vnet_buffer (b)->ip.adj_index[VLIB_TX] = dpo->dpoi_index;
+  vnet_buffer (b)->l3_hdr_offset = b->current_data + sizeof (*eh);
+  b->flags |= VNET_BUFFER_F_IS_IP4 | VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+
+  vlib_increment_combined_counter (&load_balance_main.lbm_to_counters,
+				   thread_index, lbi, 1, len);
+  if (adj_are_counters_enabled ())
+    vlib_increment_combined_counter (&adjacency_counters, thread_index,
+				     dpo->dpoi_index, 1,
+				     len + sizeof (*eh));
+
+  return (dpo->dpoi_index);
+}
+
+VLIB_NODE_FN (ip4_fast_forward_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  clib_thread_index_t thread_index = vm->thread_index;
+  ip4_fast_fwd_if_t fif = {
+    .sw_if_index = ~0,
+  };
+  u32 n_left, *from, n_fwd = 0;
+  adj_index_t ai;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left > 0)
+    {
+      u32 sw_if_index;
+
+      if (n_left > 2)
+	{
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  vlib_prefetch_buffer_data (b[1], STORE);
+	}
+
+      sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
+
+      if (PREDICT_FALSE (sw_if_index != fif.sw_if_index))
+	ip4_fast_fwd_if_update (&fif, sw_if_index);
+
+      ai = ip4_fast_fwd_one (vm, &fif, b[0], thread_index);
+
+      if (PREDICT_TRUE (ADJ_INDEX_INVALID != ai))
+	{
+	  next[0] = IP4_FAST_FWD_NEXT_INTERFACE_OUTPUT;
+	  n_fwd++;
+	}
+      else
+	vnet_feature_next_u16 (next, b[0]);
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  ip4_fast_fwd_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->forwarded = (ADJ_INDEX_INVALID != ai);
+	  t->adj_index = ai;
+	}
+
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP4_FAST_FWD_ERROR_FORWARDED, n_fwd);
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP4_FAST_FWD_ERROR_SLOW_PATH,
+			       frame->n_vectors - n_fwd);
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (ip4_fast_forward_node) = {
+  .name = "ip4-fast-forward",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip4_fast_fwd_trace,
+  .n_errors = IP4_FAST_FWD_N_ERROR,
+  .error_counters = ip4_fast_fwd_error_counters,
+  .n_next_nodes = IP4_FAST_FWD_N_NEXT,
+  .next_nodes = {
+    [IP4_FAST_FWD_NEXT_INTERFACE_OUTPUT] = "interface-output",
+  },
+};
+
+VNET_FEATURE_INIT (ip4_fast_forward_node, static) = {
+  .arc_name = "device-input",
+  .node_name = "ip4-fast-forward",
+  .runs_after = VNET_FEATURES ("span-input", "worker-handoff", "l2-patch",
+			       "p2p-ethernet-input"),
+  .runs_before = VNET_FEATURES ("ethernet-input"),
+};
+
+#ifndef CLIB_MARCH_VARIANT
+int
+ip4_fast_forward_enable_disable (u32 sw_if_index, u8 enable)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_sw_interface_t *si;
+
+  if (!vnet_sw_interface_is_api_valid (vnm, sw_if_index))
+    return (VNET_API_ERROR_INVALID_SW_IF_INDEX);
+
+  si = vnet_get_sw_interface (vnm, sw_if_index);
+
+  /* only ethernet HW interfaces, the fast path does not parse tags */
+  if (si->type != VNET_SW_INTERFACE_TYPE_HARDWARE ||
+      NULL == ethernet_get_interface (&ethernet_main, si->hw_if_index))
+    return (VNET_API_ERROR_INVALID_INTERFACE);
+
+  return (vnet_feature_enable_disable ("device-input", "ip4-fast-forward",
+				       sw_if_index, enable, 0, 0));
+}
+
+static clib_error_t *
+ip4_fast_forward_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			     vlib_cli_command_t *cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0;
+  u8 enable = 1;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "disable"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (~0 == sw_if_index)
+    return clib_error_return (0, "interface required");
+
+  rv = ip4_fast_forward_enable_disable (sw_if_index, enable);
+
+  if (rv)
+    return clib_error_return (0, "failed: %U", format_vnet_api_errno, rv);
+
+  return (NULL);
+}
+
+/*?
+ * Enable or disable the IPv4 fast forward path on an interface. Plain
+ * unicast IPv4 packets received on the interface that need neither
+ * input nor output features are forwarded in a single node; everything
+ * else takes the usual path through ethernet-input and ip4-input.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface ip4-fast-forward GigabitEthernet2/0/0}
+ * @cliexcmd{set interface ip4-fast-forward GigabitEthernet2/0/0 disable}
+?*/
+VLIB_CLI_COMMAND (ip4_fast_forward_command, static) = {
+  .path = "set interface ip4-fast-forward",
+  .function = ip4_fast_forward_command_fn,
+  .short_help = "set interface ip4-fast-forward <interface> [disable]",
+};
+#endif /* CLIB_MARCH_VARIANT */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
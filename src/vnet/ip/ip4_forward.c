@@ -2127,6 +2127,8 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       int i;
       for (i = 2; i < 6; i++)
 	vlib_prefetch_buffer_header (bufs[i], LOAD);
+      adj_prefetch_rewrite (vnet_buffer (bufs[0])->ip.adj_index[VLIB_TX]);
+      adj_prefetch_rewrite (vnet_buffer (bufs[1])->ip.adj_index[VLIB_TX]);
     }
 
   next = nexts;
@@ -2172,7 +2174,7 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       adj0 = adj_get (adj_index0);
       adj1 = adj_get (adj_index1);
 
-      /* Worth pipelining. No guarantee that adj0,1 are hot... */
+      /* the rewrites were prefetched by the previous iteration */
       rw_len0 = adj0[0].rewrite_header.data_bytes;
       rw_len1 = adj1[0].rewrite_header.data_bytes;
       vnet_buffer (b[0])->ip.save_rewrite_length = rw_len0;
@@ -2186,6 +2188,13 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       clib_prefetch_store (p - CLIB_CACHE_LINE_BYTES);
       clib_prefetch_load (p);
 
+      /*
+       * the rewrites of the next pair are read and copied in the next
+       * iteration, fetch them now rather than stall on them then.
+       */
+      adj_prefetch_rewrite (vnet_buffer (b[2])->ip.adj_index[VLIB_TX]);
+      adj_prefetch_rewrite (vnet_buffer (b[3])->ip.adj_index[VLIB_TX]);
+
       /* Check MTU of outgoing interface. */
       u16 ip0_len = clib_net_to_host_u16 (ip0->length);
       u16 ip1_len = clib_net_to_host_u16 (ip1->length);
@@ -1819,6 +1819,21 @@ ip6_rewrite_inline_with_gso (vlib_main_t * vm,
 
 	    CLIB_PREFETCH (p2->data, sizeof (ip0[0]), STORE);
 	    CLIB_PREFETCH (p3->data, sizeof (ip0[0]), STORE);
+
+	    /*
+	     * the rewrites of the next pair are read and copied in the next
+	     * iteration, fetch them now rather than stall on them then. Their
+	     * buffer headers were fetched by the previous iteration.
+	     */
+	    if (n_left_from >= 6)
+	      {
+		vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[4]),
+					     LOAD);
+		vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[5]),
+					     LOAD);
+	      }
+	    adj_prefetch_rewrite (vnet_buffer (p2)->ip.adj_index[VLIB_TX]);
+	    adj_prefetch_rewrite (vnet_buffer (p3)->ip.adj_index[VLIB_TX]);
 	  }
 
 	  pi0 = to_next[0] = from[0];
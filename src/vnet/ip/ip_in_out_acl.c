@@ -124,615 +124,122 @@ ip_in_out_acl_inline_trace (
   f64 now = vlib_time_now (vm);
   u32 hits = 0;
   u32 misses = 0;
-  u32 chain_hits = 0;
   u32 n_next_nodes = node->n_next_nodes;
-  u8 *h[4];
-  u32 sw_if_index[4];
-  u32 table_index[4];
-  vnet_classify_table_t *t[4] = { 0, 0 };
-  u32 hash[4];
-
-  /* calculate hashes for b[0] & b[1] */
-  if (n_left >= 2)
+  u32 table_index[VLIB_FRAME_SIZE];
+  u32 hash[VLIB_FRAME_SIZE];
+  u16 l2_len[VLIB_FRAME_SIZE];
+  vnet_classify_entry_t *e[VLIB_FRAME_SIZE];
+  u32 i, n_packets = n_left;
+
+  /* find each packet's chain and its feature arc next */
+  for (i = 0; i < n_packets; i++)
     {
-      /* ~0 is used as a wildcard to say 'always use sw_if_index 0'
-       * aka local0. It is used when we do not care about the sw_if_index, as
-       * when punting */
-      sw_if_index[2] = ~0 == way ? 0 : vnet_buffer (b[0])->sw_if_index[way];
-      sw_if_index[3] = ~0 == way ? 0 : vnet_buffer (b[1])->sw_if_index[way];
-
-      table_index[2] = table_index_by_sw_if_index[sw_if_index[2]];
-      table_index[3] = table_index_by_sw_if_index[sw_if_index[3]];
-
-      t[2] = pool_elt_at_index (tables, table_index[2]);
-      t[3] = pool_elt_at_index (tables, table_index[3]);
+      u32 sw_if_index, _next = ACL_NEXT_INDEX_DENY;
 
-      if (t[2]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	h[2] =
-	  (void *) vlib_buffer_get_current (b[0]) + t[2]->current_data_offset;
-      else
-	h[2] = b[0]->data;
-
-      if (t[3]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	h[3] =
-	  (void *) vlib_buffer_get_current (b[1]) + t[3]->current_data_offset;
-      else
-	h[3] = b[1]->data;
-
-      if (is_output)
+      if (i + 4 < n_packets)
 	{
-	  /* Save the rewrite length, since we are using the l2_classify struct */
-	  vnet_buffer (b[0])->l2.l2_len =
-	    vnet_buffer (b[0])->ip.save_rewrite_length;
-	  /* advance the match pointer so the matching happens on IP header */
-	  h[2] += vnet_buffer (b[0])->l2.l2_len;
-
-	  /* Save the rewrite length, since we are using the l2_classify struct */
-	  vnet_buffer (b[1])->l2.l2_len =
-	    vnet_buffer (b[1])->ip.save_rewrite_length;
-	  /* advance the match pointer so the matching happens on IP header */
-	  h[3] += vnet_buffer (b[1])->l2.l2_len;
+	  vlib_prefetch_buffer_header (b[i + 4], LOAD);
+	  clib_prefetch_load (b[i + 4]->data);
 	}
 
-      hash[2] = vnet_classify_hash_packet_inline (t[2], (u8 *) h[2]);
-      hash[3] = vnet_classify_hash_packet_inline (t[3], (u8 *) h[3]);
-
-      vnet_buffer (b[0])->l2_classify.hash = hash[2];
-      vnet_buffer (b[1])->l2_classify.hash = hash[3];
+      /* ~0 is used as a wildcard to say 'always use sw_if_index 0'
+       * aka local0. It is used when we do not care about the sw_if_index, as
+       * when punting */
+      sw_if_index = ~0 == way ? 0 : vnet_buffer (b[i])->sw_if_index[way];
+      table_index[i] = table_index_by_sw_if_index[sw_if_index];
 
-      vnet_buffer (b[0])->l2_classify.table_index = table_index[2];
-      vnet_buffer (b[1])->l2_classify.table_index = table_index[3];
+      if (is_output)
+	/* Save the rewrite length, since we are using the l2_classify struct,
+	 * the match happens on the IP header */
+	vnet_buffer (b[i])->l2.l2_len =
+	  vnet_buffer (b[i])->ip.save_rewrite_length;
+      l2_len[i] = is_output ? vnet_buffer (b[i])->l2.l2_len : 0;
 
-      vnet_buffer (b[0])->l2_classify.opaque_index = ~0;
-      vnet_buffer (b[1])->l2_classify.opaque_index = ~0;
+      vnet_buffer (b[i])->l2_classify.table_index = table_index[i];
+      vnet_buffer (b[i])->l2_classify.opaque_index = ~0;
 
-      vnet_classify_prefetch_bucket (t[2],
-				     vnet_buffer (b[0])->l2_classify.hash);
-      vnet_classify_prefetch_bucket (t[3],
-				     vnet_buffer (b[1])->l2_classify.hash);
+      vnet_get_config_data (cm, &b[i]->current_config_index, &_next,
+			    /* # bytes of config data */ 0);
+      next[i] = _next;
     }
 
-  while (n_left >= 2)
-    {
-      vnet_classify_entry_t *e[2] = { 0, 0 };
-      u32 _next[2] = { ACL_NEXT_INDEX_DENY, ACL_NEXT_INDEX_DENY };
-
-      h[0] = h[2];
-      h[1] = h[3];
-      t[0] = t[2];
-      t[1] = t[3];
-
-      sw_if_index[0] = sw_if_index[2];
-      sw_if_index[1] = sw_if_index[3];
-
-      table_index[0] = table_index[2];
-      table_index[1] = table_index[3];
-
-      hash[0] = hash[2];
-      hash[1] = hash[3];
-
-      /* prefetch next iteration */
-      if (n_left >= 6)
-	{
-	  vlib_prefetch_buffer_header (b[4], LOAD);
-	  vlib_prefetch_buffer_header (b[5], LOAD);
-
-	  clib_prefetch_load (b[4]->data);
-	  clib_prefetch_load (b[5]->data);
-	}
-
-      /* calculate hashes for b[2] & b[3] */
-      if (n_left >= 4)
-	{
-	  sw_if_index[2] =
-	    ~0 == way ? 0 : vnet_buffer (b[2])->sw_if_index[way];
-	  sw_if_index[3] =
-	    ~0 == way ? 0 : vnet_buffer (b[3])->sw_if_index[way];
-
-	  table_index[2] = table_index_by_sw_if_index[sw_if_index[2]];
-	  table_index[3] = table_index_by_sw_if_index[sw_if_index[3]];
-
-	  t[2] = pool_elt_at_index (tables, table_index[2]);
-	  t[3] = pool_elt_at_index (tables, table_index[3]);
-
-	  if (t[2]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	    h[2] =
-	      (void *) vlib_buffer_get_current (b[2]) +
-	      t[2]->current_data_offset;
-	  else
-	    h[2] = b[2]->data;
-
-	  if (t[3]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	    h[3] =
-	      (void *) vlib_buffer_get_current (b[3]) +
-	      t[3]->current_data_offset;
-	  else
-	    h[3] = b[3]->data;
-
-	  if (is_output)
-	    {
-	      /* Save the rewrite length, since we are using the l2_classify struct */
-	      vnet_buffer (b[2])->l2.l2_len =
-		vnet_buffer (b[2])->ip.save_rewrite_length;
-	      /* advance the match pointer so the matching happens on IP header */
-	      h[2] += vnet_buffer (b[2])->l2.l2_len;
-
-	      /* Save the rewrite length, since we are using the l2_classify struct */
-	      vnet_buffer (b[3])->l2.l2_len =
-		vnet_buffer (b[3])->ip.save_rewrite_length;
-	      /* advance the match pointer so the matching happens on IP header */
-	      h[3] += vnet_buffer (b[3])->l2.l2_len;
-	    }
-
-	  hash[2] = vnet_classify_hash_packet_inline (t[2], (u8 *) h[2]);
-	  hash[3] = vnet_classify_hash_packet_inline (t[3], (u8 *) h[3]);
-
-	  vnet_buffer (b[2])->l2_classify.hash = hash[2];
-	  vnet_buffer (b[3])->l2_classify.hash = hash[3];
+  /* look the whole frame up, one table of the chains at a time */
+  *chain_hits__ = vnet_classify_find_entries_chained (
+    tables, b, l2_len, table_index, hash, e, n_packets, now);
 
-	  vnet_buffer (b[2])->l2_classify.table_index = table_index[2];
-	  vnet_buffer (b[3])->l2_classify.table_index = table_index[3];
-
-	  vnet_buffer (b[2])->l2_classify.opaque_index = ~0;
-	  vnet_buffer (b[3])->l2_classify.opaque_index = ~0;
-
-	  vnet_classify_prefetch_bucket (t[2],
-					 vnet_buffer (b[2])->
-					 l2_classify.hash);
-	  vnet_classify_prefetch_bucket (t[3],
-					 vnet_buffer (b[3])->
-					 l2_classify.hash);
-	}
-
-      /* find entry for b[0] & b[1] */
-      vnet_get_config_data (cm, &b[0]->current_config_index, &_next[0],
-			    /* # bytes of config data */ 0);
-      vnet_get_config_data (cm, &b[1]->current_config_index, &_next[1],
-			    /* # bytes of config data */ 0);
+  for (i = 0; i < n_packets; i++)
+    {
+      vnet_classify_table_t *t = 0;
+      u32 _next = next[i];
 
-      if (PREDICT_TRUE (table_index[0] != ~0))
+      if (PREDICT_TRUE (table_index[i] != ~0))
 	{
-	  e[0] =
-	    vnet_classify_find_entry_inline (t[0], (u8 *) h[0], hash[0], now);
-	  if (e[0])
-	    {
-	      vnet_buffer (b[0])->l2_classify.opaque_index
-		= e[0]->opaque_index;
-	      vlib_buffer_advance (b[0], e[0]->advance);
-
-	      _next[0] = (e[0]->next_index < n_next_nodes) ?
-		e[0]->next_index : _next[0];
-
-	      hits++;
-
-	      b[0]->error =
-		(_next[0] == ACL_NEXT_INDEX_DENY) ? error_deny : error_none;
-
-	      if (!is_output)
-		{
-		  if (e[0]->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
-		      e[0]->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-		    vnet_buffer (b[0])->sw_if_index[VLIB_TX] = e[0]->metadata;
-		  else if (e[0]->action == CLASSIFY_ACTION_SET_METADATA)
-		    {
-		      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] =
-			e[0]->metadata;
-		      /* For source check in case we skip the lookup node */
-		      ip_lookup_set_buffer_fib_index (fib_index_by_sw_if_index,
-						      b[0]);
-		    }
-		}
-	    }
-	  else
-	    {
-	      while (1)
-		{
-		  table_index[0] = t[0]->next_table_index;
-		  if (PREDICT_TRUE (table_index[0] != ~0))
-		    t[0] = pool_elt_at_index (tables, table_index[0]);
-		  else
-		    {
-		      _next[0] = (t[0]->miss_next_index < n_next_nodes) ?
-			t[0]->miss_next_index : _next[0];
-
-		      misses++;
-
-		      b[0]->error = (_next[0] == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
+	  t = pool_elt_at_index (tables, table_index[i]);
+	  vnet_buffer (b[i])->l2_classify.hash = hash[i];
 
-		  if (t[0]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h[0] =
-		      (void *) vlib_buffer_get_current (b[0]) +
-		      t[0]->current_data_offset;
-		  else
-		    h[0] = b[0]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h[0] += vnet_buffer (b[0])->l2.l2_len;
-
-		  hash[0] =
-		    vnet_classify_hash_packet_inline (t[0], (u8 *) h[0]);
-		  e[0] =
-		    vnet_classify_find_entry_inline (t[0], (u8 *) h[0],
-						     hash[0], now);
-		  if (e[0])
-		    {
-		      vnet_buffer (b[0])->l2_classify.opaque_index
-			= e[0]->opaque_index;
-		      vlib_buffer_advance (b[0], e[0]->advance);
-		      _next[0] = (e[0]->next_index < n_next_nodes) ?
-			e[0]->next_index : _next[0];
-		      hits++;
-		      chain_hits++;
-
-		      b[0]->error = (_next[0] == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e[0]->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e[0]->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[0])->sw_if_index[VLIB_TX] =
-			      e[0]->metadata;
-			  else if (e[0]->action ==
-				   CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] =
-				e[0]->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[0]);
-			    }
-			}
-		      break;
-		    }
-		}
-	    }
-	}
-
-      if (PREDICT_TRUE (table_index[1] != ~0))
-	{
-	  e[1] =
-	    vnet_classify_find_entry_inline (t[1], (u8 *) h[1], hash[1], now);
-	  if (e[1])
+	  if (e[i])
 	    {
-	      vnet_buffer (b[1])->l2_classify.opaque_index
-		= e[1]->opaque_index;
-	      vlib_buffer_advance (b[1], e[1]->advance);
+	      vnet_buffer (b[i])->l2_classify.opaque_index = e[i]->opaque_index;
+	      vlib_buffer_advance (b[i], e[i]->advance);
 
-	      _next[1] = (e[1]->next_index < n_next_nodes) ?
-		e[1]->next_index : _next[1];
+	      _next = (e[i]->next_index < n_next_nodes) ? e[i]->next_index :
+							  _next;
 
 	      hits++;
 
-	      b[1]->error =
-		(_next[1] == ACL_NEXT_INDEX_DENY) ? error_deny : error_none;
+	      b[i]->error =
+		(_next == ACL_NEXT_INDEX_DENY) ? error_deny : error_none;
 
 	      if (!is_output)
 		{
-		  if (e[1]->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
-		      e[1]->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-		    vnet_buffer (b[1])->sw_if_index[VLIB_TX] = e[1]->metadata;
-		  else if (e[1]->action == CLASSIFY_ACTION_SET_METADATA)
+		  if (e[i]->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
+		      e[i]->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
+		    vnet_buffer (b[i])->sw_if_index[VLIB_TX] = e[i]->metadata;
+		  else if (e[i]->action == CLASSIFY_ACTION_SET_METADATA)
 		    {
-		      vnet_buffer (b[1])->ip.adj_index[VLIB_TX] =
-			e[1]->metadata;
+		      vnet_buffer (b[i])->ip.adj_index[VLIB_TX] =
+			e[i]->metadata;
 		      /* For source check in case we skip the lookup node */
 		      ip_lookup_set_buffer_fib_index (fib_index_by_sw_if_index,
-						      b[1]);
+						      b[i]);
 		    }
 		}
 	    }
 	  else
 	    {
-	      while (1)
-		{
-		  table_index[1] = t[1]->next_table_index;
-		  if (PREDICT_TRUE (table_index[1] != ~0))
-		    t[1] = pool_elt_at_index (tables, table_index[1]);
-		  else
-		    {
-		      _next[1] = (t[1]->miss_next_index < n_next_nodes) ?
-			t[1]->miss_next_index : _next[1];
-
-		      misses++;
+	      _next = (t->miss_next_index < n_next_nodes) ?
+			t->miss_next_index :
+			_next;
 
-		      b[1]->error = (_next[1] == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
+	      misses++;
 
-		  if (t[1]->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h[1] =
-		      (void *) vlib_buffer_get_current (b[1]) +
-		      t[1]->current_data_offset;
-		  else
-		    h[1] = b[1]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h[1] += vnet_buffer (b[1])->l2.l2_len;
-
-		  hash[1] =
-		    vnet_classify_hash_packet_inline (t[1], (u8 *) h[1]);
-		  e[1] =
-		    vnet_classify_find_entry_inline (t[1], (u8 *) h[1],
-						     hash[1], now);
-		  if (e[1])
-		    {
-		      vnet_buffer (b[1])->l2_classify.opaque_index
-			= e[1]->opaque_index;
-		      vlib_buffer_advance (b[1], e[1]->advance);
-		      _next[1] = (e[1]->next_index < n_next_nodes) ?
-			e[1]->next_index : _next[1];
-		      hits++;
-		      chain_hits++;
-
-		      b[1]->error = (_next[1] == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e[1]->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e[1]->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[1])->sw_if_index[VLIB_TX] =
-			      e[1]->metadata;
-			  else if (e[1]->action ==
-				   CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[1])->ip.adj_index[VLIB_TX] =
-				e[1]->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[1]);
-			    }
-			}
-		      break;
-		    }
-		}
+	      b[i]->error =
+		(_next == ACL_NEXT_INDEX_DENY) ? error_miss : error_none;
 	    }
 	}
 
-      if (do_trace && b[0]->flags & VLIB_BUFFER_IS_TRACED)
-	{
-	  ip_in_out_acl_trace_t *_t =
-	    vlib_add_trace (vm, node, b[0], sizeof (*_t));
-	  _t->sw_if_index =
-	    ~0 == way ? 0 : vnet_buffer (b[0])->sw_if_index[way];
-	  _t->next_index = _next[0];
-	  _t->table_index = table_index[0];
-	  _t->offset = (e[0]
-			&& t[0]) ? vnet_classify_get_offset (t[0], e[0]) : ~0;
-	}
-
-      if (do_trace && b[1]->flags & VLIB_BUFFER_IS_TRACED)
+      if (do_trace && b[i]->flags & VLIB_BUFFER_IS_TRACED)
 	{
 	  ip_in_out_acl_trace_t *_t =
-	    vlib_add_trace (vm, node, b[1], sizeof (*_t));
+	    vlib_add_trace (vm, node, b[i], sizeof (*_t));
 	  _t->sw_if_index =
-	    ~0 == way ? 0 : vnet_buffer (b[1])->sw_if_index[way];
-	  _t->next_index = _next[1];
-	  _t->table_index = table_index[1];
-	  _t->offset = (e[1]
-			&& t[1]) ? vnet_classify_get_offset (t[1], e[1]) : ~0;
-	}
-
-      if ((_next[0] == ACL_NEXT_INDEX_DENY) && is_output)
-	{
-	  /* on output, for the drop node to work properly, go back to ip header */
-	  vlib_buffer_advance (b[0], vnet_buffer (b[0])->l2.l2_len);
-	}
-
-      if ((_next[1] == ACL_NEXT_INDEX_DENY) && is_output)
-	{
-	  /* on output, for the drop node to work properly, go back to ip header */
-	  vlib_buffer_advance (b[1], vnet_buffer (b[1])->l2.l2_len);
-	}
-
-      next[0] = _next[0];
-      next[1] = _next[1];
-
-      /* _next */
-      next += 2;
-      b += 2;
-      n_left -= 2;
-    }
-
-  while (n_left > 0)
-    {
-      u8 *h0;
-      u32 sw_if_index0;
-      u32 table_index0;
-      vnet_classify_table_t *t0 = 0;
-      vnet_classify_entry_t *e0 = 0;
-      u32 next0 = ACL_NEXT_INDEX_DENY;
-      u32 hash0;
-
-      sw_if_index0 = ~0 == way ? 0 : vnet_buffer (b[0])->sw_if_index[way];
-      table_index0 = table_index_by_sw_if_index[sw_if_index0];
-
-      t0 = pool_elt_at_index (tables, table_index0);
-
-      if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	h0 =
-	  (void *) vlib_buffer_get_current (b[0]) + t0->current_data_offset;
-      else
-	h0 = b[0]->data;
-
-      if (is_output)
-	{
-	  /* Save the rewrite length, since we are using the l2_classify struct */
-	  vnet_buffer (b[0])->l2.l2_len =
-	    vnet_buffer (b[0])->ip.save_rewrite_length;
-	  /* advance the match pointer so the matching happens on IP header */
-	  h0 += vnet_buffer (b[0])->l2.l2_len;
-	}
-
-      vnet_buffer (b[0])->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
-
-      vnet_buffer (b[0])->l2_classify.table_index = table_index0;
-      vnet_buffer (b[0])->l2_classify.opaque_index = ~0;
-
-      vnet_get_config_data (cm, &b[0]->current_config_index, &next0,
-			    /* # bytes of config data */ 0);
-
-      if (PREDICT_TRUE (table_index0 != ~0))
-	{
-	  hash0 = vnet_buffer (b[0])->l2_classify.hash;
-	  t0 = pool_elt_at_index (tables, table_index0);
-
-	  if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-	    h0 =
-	      (void *) vlib_buffer_get_current (b[0]) +
-	      t0->current_data_offset;
-	  else
-	    h0 = b[0]->data;
-
-	  /* advance the match pointer so the matching happens on IP header */
-	  if (is_output)
-	    h0 += vnet_buffer (b[0])->l2.l2_len;
-
-	  e0 = vnet_classify_find_entry_inline (t0, (u8 *) h0, hash0, now);
-	  if (e0)
-	    {
-	      vnet_buffer (b[0])->l2_classify.opaque_index = e0->opaque_index;
-	      vlib_buffer_advance (b[0], e0->advance);
-
-	      next0 = (e0->next_index < n_next_nodes) ?
-		e0->next_index : next0;
-
-	      hits++;
-
-	      b[0]->error =
-		(next0 == ACL_NEXT_INDEX_DENY) ? error_deny : error_none;
-
-	      if (!is_output)
-		{
-		  if (e0->action == CLASSIFY_ACTION_SET_IP4_FIB_INDEX ||
-		      e0->action == CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-		    vnet_buffer (b[0])->sw_if_index[VLIB_TX] = e0->metadata;
-		  else if (e0->action == CLASSIFY_ACTION_SET_METADATA)
-		    {
-		      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] = e0->metadata;
-		      /* For source check in case we skip the lookup node */
-		      ip_lookup_set_buffer_fib_index (fib_index_by_sw_if_index,
-						      b[0]);
-		    }
-		}
-	    }
-	  else
-	    {
-	      while (1)
-		{
-		  table_index0 = t0->next_table_index;
-		  if (PREDICT_TRUE (table_index0 != ~0))
-		    t0 = pool_elt_at_index (tables, table_index0);
-		  else
-		    {
-		      next0 = (t0->miss_next_index < n_next_nodes) ?
-			t0->miss_next_index : next0;
-
-		      misses++;
-
-		      b[0]->error = (next0 == ACL_NEXT_INDEX_DENY) ?
-				      error_miss :
-				      error_none;
-		      break;
-		    }
-
-		  if (t0->current_data_flag == CLASSIFY_FLAG_USE_CURR_DATA)
-		    h0 =
-		      (void *) vlib_buffer_get_current (b[0]) +
-		      t0->current_data_offset;
-		  else
-		    h0 = b[0]->data;
-
-		  /* advance the match pointer so the matching happens on IP header */
-		  if (is_output)
-		    h0 += vnet_buffer (b[0])->l2.l2_len;
-
-		  hash0 = vnet_classify_hash_packet_inline (t0, (u8 *) h0);
-		  e0 = vnet_classify_find_entry_inline
-		    (t0, (u8 *) h0, hash0, now);
-		  if (e0)
-		    {
-		      vnet_buffer (b[0])->l2_classify.opaque_index
-			= e0->opaque_index;
-		      vlib_buffer_advance (b[0], e0->advance);
-		      next0 = (e0->next_index < n_next_nodes) ?
-			e0->next_index : next0;
-		      hits++;
-
-		      b[0]->error = (next0 == ACL_NEXT_INDEX_DENY) ?
-				      error_deny :
-				      error_none;
-
-		      if (!is_output)
-			{
-			  if (e0->action ==
-			      CLASSIFY_ACTION_SET_IP4_FIB_INDEX
-			      || e0->action ==
-			      CLASSIFY_ACTION_SET_IP6_FIB_INDEX)
-			    vnet_buffer (b[0])->sw_if_index[VLIB_TX] =
-			      e0->metadata;
-			  else if (e0->action == CLASSIFY_ACTION_SET_METADATA)
-			    {
-			      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] =
-				e0->metadata;
-			      /* For source check in case we skip the lookup
-			       * node */
-			      ip_lookup_set_buffer_fib_index (
-				fib_index_by_sw_if_index, b[0]);
-			    }
-			}
-		      break;
-		    }
-		}
-	    }
+	    ~0 == way ? 0 : vnet_buffer (b[i])->sw_if_index[way];
+	  _t->next_index = _next;
+	  _t->table_index = table_index[i];
+	  _t->offset = (e[i] && t) ? vnet_classify_get_offset (t, e[i]) : ~0;
 	}
 
-      if (do_trace && b[0]->flags & VLIB_BUFFER_IS_TRACED)
-	{
-	  ip_in_out_acl_trace_t *t =
-	    vlib_add_trace (vm, node, b[0], sizeof (*t));
-	  t->sw_if_index =
-	    ~0 == way ? 0 : vnet_buffer (b[0])->sw_if_index[way];
-	  t->next_index = next0;
-	  t->table_index = table_index0;
-	  t->offset = (e0 && t0) ? vnet_classify_get_offset (t0, e0) : ~0;
-	}
-
-      if ((next0 == ACL_NEXT_INDEX_DENY) && is_output)
+      if ((_next == ACL_NEXT_INDEX_DENY) && is_output)
 	{
 	  /* on output, for the drop node to work properly, go back to ip header */
-	  vlib_buffer_advance (b[0], vnet_buffer (b[0])->l2.l2_len);
+	  vlib_buffer_advance (b[i], vnet_buffer (b[i])->l2.l2_len);
 	}
 
-      next[0] = next0;
-
-      /* next */
-      next++;
-      b++;
-      n_left--;
+      next[i] = _next;
     }
 
   *hits__ = hits;
   *misses__ = misses;
-  *chain_hits__ = chain_hits;
 }
 
 static_always_inline uword
@@ -156,7 +156,8 @@ ah_decrypt_inline (vlib_main_t * vm,
 					  thread_index, current_sa_index);
 	}
 
-      if (PREDICT_FALSE ((u16) ~0 == irt->thread_index))
+      if (PREDICT_FALSE ((u16) ~0 == irt->thread_index &&
+			 !irt->is_multi_worker))
 	{
 	  /* this is the first packet to use this SA, claim the SA
 	   * for this thread. this could happen simultaneously on
@@ -165,7 +166,9 @@ ah_decrypt_inline (vlib_main_t * vm,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_TRUE (thread_index != irt->thread_index))
+      /* a multi-worker SA is used by all the workers, there's no handoff */
+      if (PREDICT_TRUE (thread_index != irt->thread_index &&
+			!irt->is_multi_worker))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = irt->thread_index;
 	  next[0] = AH_DECRYPT_NEXT_HANDOFF;
@@ -310,15 +313,18 @@ ah_decrypt_inline (vlib_main_t * vm,
 	{
 	  /* redo the anti-reply check. see esp_decrypt for details */
 	  if (ipsec_sa_anti_replay_and_sn_advance (irt, pd->seq, pd->seq_hi,
-						   true, NULL))
+						   true, NULL) ||
+	      (irt->is_multi_worker &&
+	       ipsec_sa_anti_replay_mw_advance (irt, pd->seq, pd->seq_hi)))
 	    {
 	      ah_decrypt_set_next_index (b[0], node, vm->thread_index,
 					 AH_DECRYPT_ERROR_REPLAY, 0, next,
 					 AH_DECRYPT_NEXT_DROP, pd->sa_index);
 	      goto trace;
 	    }
-	  n_lost = ipsec_sa_anti_replay_advance (irt, thread_index, pd->seq,
-						 pd->seq_hi);
+	  if (!irt->is_multi_worker)
+	    n_lost = ipsec_sa_anti_replay_advance (irt, thread_index, pd->seq,
+						   pd->seq_hi);
 	  vlib_prefetch_simple_counter (
 	    &ipsec_sa_err_counters[IPSEC_SA_ERROR_LOST], thread_index,
 	    pd->sa_index);
@@ -149,6 +149,7 @@ ah_encrypt_inline (vlib_main_t * vm,
     {
       u8 ip_hdr_size;
       u8 next_hdr_type;
+      u64 seq64 = 0;
 
       if (vnet_buffer (b[0])->ipsec.sad_index != current_sa_index)
 	{
@@ -156,6 +157,8 @@ ah_encrypt_inline (vlib_main_t * vm,
 	    vlib_increment_combined_counter (&ipsec_sa_counters, thread_index,
 					     current_sa_index, current_sa_pkts,
 					     current_sa_bytes);
+	  if (ort)
+	    esp_seq_release (ort, thread_index);
 	  current_sa_index = vnet_buffer (b[0])->ipsec.sad_index;
 	  ort = ipsec_sa_get_outb_rt_by_index (current_sa_index);
 
@@ -167,7 +170,8 @@ ah_encrypt_inline (vlib_main_t * vm,
       pd->sa_index = current_sa_index;
       next[0] = AH_ENCRYPT_NEXT_DROP;
 
-      if (PREDICT_FALSE ((u16) ~0 == ort->thread_index))
+      if (PREDICT_FALSE ((u16) ~0 == ort->thread_index &&
+			 !ort->is_multi_worker))
 	{
 	  /* this is the first packet to use this SA, claim the SA
 	   * for this thread. this could happen simultaneously on
@@ -176,14 +180,16 @@ ah_encrypt_inline (vlib_main_t * vm,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_TRUE (thread_index != ort->thread_index))
+      /* a multi-worker SA is used by all the workers, there's no handoff */
+      if (PREDICT_TRUE (thread_index != ort->thread_index &&
+			!ort->is_multi_worker))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = ort->thread_index;
 	  next[0] = AH_ENCRYPT_NEXT_HANDOFF;
 	  goto next;
 	}
 
-      if (PREDICT_FALSE (esp_seq_advance (ort)))
+      if (PREDICT_FALSE (esp_seq_advance (ort, thread_index, &seq64)))
 	{
 	  ah_encrypt_set_next_index (b[0], node, vm->thread_index,
 				     AH_ENCRYPT_ERROR_SEQ_CYCLED, 0, next,
@@ -260,7 +266,7 @@ ah_encrypt_inline (vlib_main_t * vm,
 	  oh6_0->ah.reserved = 0;
 	  oh6_0->ah.nexthdr = next_hdr_type;
 	  oh6_0->ah.spi = ort->spi_be;
-	  oh6_0->ah.seq_no = clib_net_to_host_u32 (ort->seq64);
+	  oh6_0->ah.seq_no = clib_net_to_host_u32 (seq64);
 	  oh6_0->ip6.payload_length =
 	    clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, b[0]) -
 				  sizeof (ip6_header_t));
@@ -314,7 +320,7 @@ ah_encrypt_inline (vlib_main_t * vm,
 	  oh0->ip4.length =
 	    clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, b[0]));
 	  oh0->ah.spi = ort->spi_be;
-	  oh0->ah.seq_no = clib_net_to_host_u32 (ort->seq64);
+	  oh0->ah.seq_no = clib_net_to_host_u32 (seq64);
 	  oh0->ah.nexthdr = next_hdr_type;
 	  oh0->ah.hdrlen =
 	    (sizeof (ah_header_t) + icv_size + padding_len) / 4 - 2;
@@ -352,7 +358,7 @@ ah_encrypt_inline (vlib_main_t * vm,
 	  if (ort->use_esn)
 	    {
 	      *(u32u *) (op->src + b[0]->current_length) =
-		clib_host_to_net_u32 (ort->seq64 >> 32);
+		clib_host_to_net_u32 (seq64 >> 32);
 	      op->len += sizeof (u32);
 	    }
 	}
@@ -367,12 +373,10 @@ ah_encrypt_inline (vlib_main_t * vm,
       if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
 	{
 	  ipsec_sa_t *sa = ipsec_sa_get (pd->sa_index);
-	  ipsec_sa_outb_rt_t *ort =
-	    ipsec_sa_get_outb_rt_by_index (pd->sa_index);
 	  ah_encrypt_trace_t *tr =
 	    vlib_add_trace (vm, node, b[0], sizeof (*tr));
 	  tr->spi = sa->spi;
-	  tr->seq = ort->seq64;
+	  tr->seq = seq64;
 	  tr->integ_alg = sa->integ_alg;
 	  tr->sa_index = pd->sa_index;
 	}
@@ -383,6 +387,9 @@ ah_encrypt_inline (vlib_main_t * vm,
       b += 1;
     }
 
+  if (ort)
+    esp_seq_release (ort, thread_index);
+
   n_left = frame->n_vectors;
   next = nexts;
   pd = pkt_data;
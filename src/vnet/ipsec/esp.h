@@ -81,17 +81,74 @@ typedef struct esp_aead_t_
 
 u8 *format_esp_header (u8 * s, va_list * args);
 
-/* TODO seq increment should be atomic to be accessed by multiple workers */
+/*
+ * Allocates the packet's sequence number. A multi-worker SA is used by all
+ * the workers at once, each of them reserves a block of sequence numbers
+ * with a single atomic update and numbers its packets from it. The block is
+ * given up with esp_seq_release() at the end of each run of packets for the
+ * SA, so a worker never holds on to numbers which the other workers have
+ * long since passed.
+ */
 always_inline int
-esp_seq_advance (ipsec_sa_outb_rt_t *ort)
+esp_seq_advance (ipsec_sa_outb_rt_t *ort, clib_thread_index_t thread_index,
+		 u64 *seq)
 {
   u64 max = ort->use_esn ? CLIB_U64_MAX : CLIB_U32_MAX;
+
+  if (PREDICT_FALSE (ort->is_multi_worker))
+    {
+      ipsec_sa_seq_block_t *sb = ort->seq_blocks + thread_index;
+
+      if (PREDICT_FALSE (sb->n_left == 0))
+	{
+	  u64 first = clib_atomic_load_relax_n (&ort->seq64);
+	  u32 n;
+
+	  /* never move seq64 past the end of the sequence number space */
+	  do
+	    {
+	      if (first >= max)
+		return 1;
+	      n = clib_min (max - first, IPSEC_SA_SEQ_BLOCK_SIZE);
+	    }
+	  while (!clib_atomic_cmp_and_swap_acq_relax_n (&ort->seq64, &first,
+							 first + n, 0));
+	  sb->next = first + 1;
+	  sb->n_left = n;
+	}
+      sb->n_left--;
+      *seq = sb->next++;
+      return 0;
+    }
+
   if (ort->seq64 == max)
     return 1;
-  ort->seq64++;
+  *seq = ++ort->seq64;
   return 0;
 }
 
+/*
+ * Gives up the rest of the worker's block of sequence numbers. If no other
+ * worker has reserved a block since, the numbers are handed back to the SA,
+ * otherwise they are skipped and the peer sees them as lost.
+ */
+always_inline void
+esp_seq_release (ipsec_sa_outb_rt_t *ort, clib_thread_index_t thread_index)
+{
+  ipsec_sa_seq_block_t *sb;
+
+  if (PREDICT_TRUE (!ort->is_multi_worker))
+    return;
+
+  sb = ort->seq_blocks + thread_index;
+  if (sb->n_left == 0)
+    return;
+
+  clib_atomic_cmp_and_swap (&ort->seq64, sb->next - 1 + sb->n_left,
+			    sb->next - 1);
+  sb->n_left = 0;
+}
+
 always_inline u16
 esp_aad_fill (u8 *data, const esp_header_t *esp, int use_esn, u32 seq_hi)
 {
@@ -187,6 +244,51 @@ esp_decrypt_set_next_index (vlib_buffer_t *b, vlib_node_runtime_t *node,
 			drop_next, sa_index);
 }
 
+/*
+ * vnet_crypto_process_ops () calls the engine once for each run of ops of
+ * the same type. When the SAs of a frame use different algorithms their ops
+ * interleave and the engines' multi-buffer paths only see short runs, so
+ * regroup the ops by type, keeping the frame order within each type, and
+ * have every algorithm submitted as a single batch.
+ */
+always_inline vnet_crypto_op_t *
+esp_group_ops_by_type (ipsec_per_thread_data_t *ptd, vnet_crypto_op_t *ops)
+{
+  u32 n_ops = vec_len (ops), n_grouped = 0, first, i;
+  vnet_crypto_op_id_t type = ops[0].op;
+  u8 grouped[VLIB_FRAME_SIZE];
+
+  for (first = 1; first < n_ops; first++)
+    if (ops[first].op != type)
+      break;
+
+  /* the common case, a single algorithm in the frame */
+  if (first == n_ops)
+    return ops;
+
+  ASSERT (n_ops <= VLIB_FRAME_SIZE);
+  vec_validate_aligned (ptd->grouped_ops, n_ops - 1, CLIB_CACHE_LINE_BYTES);
+  vec_set_len (ptd->grouped_ops, n_ops);
+  clib_memset_u8 (grouped, 0, n_ops);
+
+  for (first = 0; first < n_ops; first++)
+    {
+      if (grouped[first])
+	continue;
+
+      type = ops[first].op;
+      for (i = first; i < n_ops; i++)
+	if (!grouped[i] && ops[i].op == type)
+	  {
+	    clib_memcpy_fast (ptd->grouped_ops + n_grouped++, ops + i,
+			      sizeof (ops[0]));
+	    grouped[i] = 1;
+	  }
+    }
+
+  return ptd->grouped_ops;
+}
+
 /**
  * The post data structure to for esp_encrypt/decrypt_inline to write to
  * vib_buffer_t opaque unused field, and for post nodes to pick up after
@@ -90,16 +90,17 @@ format_esp_decrypt_trace (u8 * s, va_list * args)
 #define ESP_ENCRYPT_PD_F_FD_TRANSPORT (1 << 2)
 
 static_always_inline void
-esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
-		 vnet_crypto_op_t * ops, vlib_buffer_t * b[], u16 * nexts,
-		 int e)
+esp_process_ops (vlib_main_t *vm, vlib_node_runtime_t *node,
+		 ipsec_per_thread_data_t *ptd, vnet_crypto_op_t *ops,
+		 vlib_buffer_t *b[], u16 *nexts, int e)
 {
-  vnet_crypto_op_t *op = ops;
+  vnet_crypto_op_t *op;
   u32 n_fail, n_ops = vec_len (ops);
 
   if (n_ops == 0)
     return;
 
+  op = ops = esp_group_ops_by_type (ptd, ops);
   n_fail = n_ops - vnet_crypto_process_ops (vm, op, n_ops);
 
   while (n_fail)
@@ -122,17 +123,19 @@ esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
 }
 
 static_always_inline void
-esp_process_chained_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
-			 vnet_crypto_op_t * ops, vlib_buffer_t * b[],
-			 u16 * nexts, vnet_crypto_op_chunk_t * chunks, int e)
+esp_process_chained_ops (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 ipsec_per_thread_data_t *ptd, vnet_crypto_op_t *ops,
+			 vlib_buffer_t *b[], u16 *nexts,
+			 vnet_crypto_op_chunk_t *chunks, int e)
 {
 
-  vnet_crypto_op_t *op = ops;
+  vnet_crypto_op_t *op;
   u32 n_fail, n_ops = vec_len (ops);
 
   if (PREDICT_TRUE (n_ops == 0))
     return;
 
+  op = ops = esp_group_ops_by_type (ptd, ops);
   n_fail = n_ops - vnet_crypto_process_chained_ops (vm, op, chunks, n_ops);
 
   while (n_fail)
@@ -778,14 +781,14 @@ esp_decrypt_post_crypto (vlib_main_t *vm, vlib_node_runtime_t *node,
 			 const esp_decrypt_packet_data_t *pd,
 			 const esp_decrypt_packet_data2_t *pd2,
 			 vlib_buffer_t *b, u16 *next, int is_ip6, int is_tun,
-			 int is_async)
+			 int is_async, int anti_replay_done)
 {
   ipsec_sa_inb_rt_t *irt = ipsec_sa_get_inb_rt_by_index (pd->sa_index);
   vlib_buffer_t *lb = b;
   const u8 esp_sz = sizeof (esp_header_t);
   u8 pad_length = 0, next_header = 0;
   u16 icv_sz;
-  u64 n_lost;
+  u64 n_lost = 0;
 
   /*
    * redo the anti-reply check
@@ -809,16 +812,25 @@ esp_decrypt_post_crypto (vlib_main_t *vm, vlib_node_runtime_t *node,
    * a sequence s, s+1, s+2, s+3, ... s+n and nothing will prevent any
    * implementation, sequential or batching, from decrypting these.
    */
-  if (ipsec_sa_anti_replay_and_sn_advance (irt, pd->seq, pd->seq_hi, true,
-					   NULL))
+  if (anti_replay_done)
+    /* the window was advanced for the packet's run, see
+     * esp_decrypt_anti_replay_run */
+    ;
+  else if (ipsec_sa_anti_replay_and_sn_advance (irt, pd->seq, pd->seq_hi,
+						true, NULL) ||
+	   /* other workers decrypt the SA's packets at the same time, the
+	    * window is checked again as it is updated */
+	   (irt->is_multi_worker &&
+	    ipsec_sa_anti_replay_mw_advance (irt, pd->seq, pd->seq_hi)))
     {
       esp_decrypt_set_next_index (b, node, vm->thread_index,
 				  ESP_DECRYPT_ERROR_REPLAY, 0, next,
 				  ESP_DECRYPT_NEXT_DROP, pd->sa_index);
       return;
     }
-  n_lost =
-    ipsec_sa_anti_replay_advance (irt, vm->thread_index, pd->seq, pd->seq_hi);
+  else if (!irt->is_multi_worker)
+    n_lost = ipsec_sa_anti_replay_advance (irt, vm->thread_index, pd->seq,
+					   pd->seq_hi);
 
   vlib_prefetch_simple_counter (&ipsec_sa_err_counters[IPSEC_SA_ERROR_LOST],
 				vm->thread_index, pd->sa_index);
@@ -1066,6 +1078,47 @@ esp_decrypt_post_crypto (vlib_main_t *vm, vlib_node_runtime_t *node,
 				   vm->thread_index, pd->sa_index, n_lost);
 }
 
+/*
+ * Advance the replay window at once for the leading packets of the frame's
+ * next run of packets of the same SA, when they are in order and ahead of
+ * the window, as they mostly are. Returns how many of the SA's next
+ * decrypted packets need no further replay check.
+ */
+static_always_inline u32
+esp_decrypt_anti_replay_run (vlib_main_t *vm,
+			     const esp_decrypt_packet_data_t *pd,
+			     const u16 *nexts, u32 n_left)
+{
+  ipsec_sa_inb_rt_t *irt = ipsec_sa_get_inb_rt_by_index (pd->sa_index);
+  u32 seqs[VLIB_FRAME_SIZE], n_seqs = 0, n_done, n, i;
+  u32 sa_index = pd->sa_index, hi_seq = pd->seq_hi;
+  u64 n_lost = 0;
+
+  for (i = 0; i < n_left && pd[i].sa_index == sa_index; i++)
+    if (nexts[i] >= ESP_DECRYPT_N_NEXT)
+      {
+	if (pd[i].seq_hi != hi_seq)
+	  break;
+	seqs[n_seqs++] = pd[i].seq;
+      }
+
+  for (n_done = 0; n_done < n_seqs; n_done += n)
+    {
+      n = ipsec_sa_anti_replay_run_len (irt, seqs + n_done, n_seqs - n_done,
+					hi_seq);
+      /* a lone packet takes the usual path */
+      if (n < 2)
+	break;
+      n_lost += ipsec_sa_anti_replay_advance_run (irt, seqs + n_done, n);
+    }
+
+  if (PREDICT_FALSE (n_lost))
+    vlib_increment_simple_counter (&ipsec_sa_err_counters[IPSEC_SA_ERROR_LOST],
+				   vm->thread_index, sa_index, n_lost);
+
+  return n_done;
+}
+
 always_inline uword
 esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 		    vlib_frame_t *from_frame, int is_ip6, int is_tun,
@@ -1088,6 +1141,7 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   esp_decrypt_packet_data2_t pkt_data2[VLIB_FRAME_SIZE], *pd2 = pkt_data2;
   esp_decrypt_packet_data_t cpd = { };
   u32 current_sa_index = ~0, current_sa_bytes = 0, current_sa_pkts = 0;
+  u32 n_anti_replay_done = 0;
   const u8 esp_sz = sizeof (esp_header_t);
   ipsec_sa_inb_rt_t *irt = 0;
   bool anti_replay_result;
@@ -1152,7 +1206,8 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  is_async = irt->is_async;
 	}
 
-      if (PREDICT_FALSE ((u16) ~0 == irt->thread_index))
+      if (PREDICT_FALSE ((u16) ~0 == irt->thread_index &&
+			 !irt->is_multi_worker))
 	{
 	  /* this is the first packet to use this SA, claim the SA
 	   * for this thread. this could happen simultaneously on
@@ -1161,7 +1216,9 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_FALSE (thread_index != irt->thread_index))
+      /* a multi-worker SA is used by all the workers, there's no handoff */
+      if (PREDICT_FALSE (thread_index != irt->thread_index &&
+			 !irt->is_multi_worker))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = irt->thread_index;
 	  err = ESP_DECRYPT_ERROR_HANDOFF;
@@ -1314,16 +1371,16 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   if (n_sync)
     {
-      esp_process_ops (vm, node, ptd->integ_ops, sync_bufs, sync_nexts,
+      esp_process_ops (vm, node, ptd, ptd->integ_ops, sync_bufs, sync_nexts,
 		       ESP_DECRYPT_ERROR_INTEG_ERROR);
-      esp_process_chained_ops (vm, node, ptd->chained_integ_ops, sync_bufs,
-			       sync_nexts, ptd->chunks,
+      esp_process_chained_ops (vm, node, ptd, ptd->chained_integ_ops,
+			       sync_bufs, sync_nexts, ptd->chunks,
 			       ESP_DECRYPT_ERROR_INTEG_ERROR);
 
-      esp_process_ops (vm, node, ptd->crypto_ops, sync_bufs, sync_nexts,
+      esp_process_ops (vm, node, ptd, ptd->crypto_ops, sync_bufs, sync_nexts,
 		       ESP_DECRYPT_ERROR_DECRYPTION_FAILED);
-      esp_process_chained_ops (vm, node, ptd->chained_crypto_ops, sync_bufs,
-			       sync_nexts, ptd->chunks,
+      esp_process_chained_ops (vm, node, ptd, ptd->chained_crypto_ops,
+			       sync_bufs, sync_nexts, ptd->chunks,
 			       ESP_DECRYPT_ERROR_DECRYPTION_FAILED);
     }
 
@@ -1338,6 +1395,10 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   while (n_left)
     {
+      if (pd == pkt_data || pd[0].sa_index != pd[-1].sa_index)
+	n_anti_replay_done =
+	  esp_decrypt_anti_replay_run (vm, pd, sync_next, n_left);
+
       if (n_left >= 2)
 	{
 	  void *data = b[1]->data + pd[1].current_data;
@@ -1359,8 +1420,13 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	current_sa_index = vnet_buffer (b[0])->ipsec.sad_index;
 
       if (sync_next[0] >= ESP_DECRYPT_N_NEXT)
-	esp_decrypt_post_crypto (vm, node, next_by_next_header, pd, pd2, b[0],
-				 sync_next, is_ip6, is_tun, 0);
+	{
+	  esp_decrypt_post_crypto (vm, node, next_by_next_header, pd, pd2,
+				   b[0], sync_next, is_ip6, is_tun, 0,
+				   n_anti_replay_done != 0);
+	  if (n_anti_replay_done)
+	    n_anti_replay_done--;
+	}
 
       /* trace: */
       if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
@@ -1422,12 +1488,12 @@ esp_decrypt_post_inline (vlib_main_t * vm,
 
       if (!pd->is_chain)
 	esp_decrypt_post_crypto (vm, node, next_by_next_header, pd, 0, b[0],
-				 next, is_ip6, is_tun, 1);
+				 next, is_ip6, is_tun, 1, 0);
       else
 	{
 	  esp_decrypt_packet_data2_t *pd2 = esp_post_data2 (b[0]);
 	  esp_decrypt_post_crypto (vm, node, next_by_next_header, pd, pd2,
-				   b[0], next, is_ip6, is_tun, 1);
+				   b[0], next, is_ip6, is_tun, 1, 0);
 	}
 
       /*trace: */
@@ -230,17 +230,18 @@ esp_generate_iv (ipsec_sa_outb_rt_t *ort, void *payload, int iv_sz)
 }
 
 static_always_inline void
-esp_process_chained_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
-			 vnet_crypto_op_t * ops, vlib_buffer_t * b[],
-			 u16 * nexts, vnet_crypto_op_chunk_t * chunks,
-			 u16 drop_next)
+esp_process_chained_ops (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 ipsec_per_thread_data_t *ptd, vnet_crypto_op_t *ops,
+			 vlib_buffer_t *b[], u16 *nexts,
+			 vnet_crypto_op_chunk_t *chunks, u16 drop_next)
 {
   u32 n_fail, n_ops = vec_len (ops);
-  vnet_crypto_op_t *op = ops;
+  vnet_crypto_op_t *op;
 
   if (n_ops == 0)
     return;
 
+  op = ops = esp_group_ops_by_type (ptd, ops);
   n_fail = n_ops - vnet_crypto_process_chained_ops (vm, op, chunks, n_ops);
 
   while (n_fail)
@@ -261,16 +262,17 @@ esp_process_chained_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
 }
 
 static_always_inline void
-esp_process_ops (vlib_main_t * vm, vlib_node_runtime_t * node,
-		 vnet_crypto_op_t * ops, vlib_buffer_t * b[], u16 * nexts,
-		 u16 drop_next)
+esp_process_ops (vlib_main_t *vm, vlib_node_runtime_t *node,
+		 ipsec_per_thread_data_t *ptd, vnet_crypto_op_t *ops,
+		 vlib_buffer_t *b[], u16 *nexts, u16 drop_next)
 {
   u32 n_fail, n_ops = vec_len (ops);
-  vnet_crypto_op_t *op = ops;
+  vnet_crypto_op_t *op;
 
   if (n_ops == 0)
     return;
 
+  op = ops = esp_group_ops_by_type (ptd, ops);
   n_fail = n_ops - vnet_crypto_process_ops (vm, op, n_ops);
 
   while (n_fail)
@@ -328,7 +330,7 @@ esp_encrypt_chain_crypto (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 
 static_always_inline u32
 esp_encrypt_chain_integ (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
-			 ipsec_sa_outb_rt_t *ort, vlib_buffer_t *b,
+			 ipsec_sa_outb_rt_t *ort, u32 seq_hi, vlib_buffer_t *b,
 			 vlib_buffer_t *lb, u8 icv_sz, u8 *start,
 			 u32 start_len, u8 *digest, u16 *n_ch)
 {
@@ -350,7 +352,7 @@ esp_encrypt_chain_integ (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	  total_len += ch->len = cb->current_length - icv_sz;
 	  if (ort->use_esn)
 	    {
-	      *(u32u *) digest = clib_net_to_host_u32 (ort->seq64 >> 32);
+	      *(u32u *) digest = clib_net_to_host_u32 (seq_hi);
 	      ch->len += sizeof (u32);
 	      total_len += sizeof (u32);
 	    }
@@ -470,7 +472,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	  op->chunk_index = vec_len (ptd->chunks);
 	  op->digest = vlib_buffer_get_tail (lb) - icv_sz;
 
-	  esp_encrypt_chain_integ (vm, ptd, ort, b[0], lb, icv_sz,
+	  esp_encrypt_chain_integ (vm, ptd, ort, seq_hi, b[0], lb, icv_sz,
 				   payload - iv_sz - sizeof (esp_header_t),
 				   payload_len + iv_sz + sizeof (esp_header_t),
 				   op->digest, &op->n_chunks);
@@ -487,7 +489,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 static_always_inline void
 esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 			 vnet_crypto_async_frame_t *async_frame,
-			 ipsec_sa_outb_rt_t *ort, vlib_buffer_t *b,
+			 ipsec_sa_outb_rt_t *ort, u32 seq_hi, vlib_buffer_t *b,
 			 esp_header_t *esp, u8 *payload, u32 payload_len,
 			 u8 iv_sz, u8 icv_sz, u32 bi, u16 next, u32 hdr_len,
 			 u16 async_next, vlib_buffer_t *lb)
@@ -518,7 +520,7 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	{
 	  /* constuct aad in a scratch space in front of the nonce */
 	  aad = (u8 *) nonce - sizeof (esp_aead_t);
-	  esp_aad_fill (aad, esp, ort->use_esn, ort->seq64 >> 32);
+	  esp_aad_fill (aad, esp, ort->use_esn, seq_hi);
 	  if (PREDICT_FALSE (ort->is_null_gmac))
 	    {
 	      /* RFC-4543 ENCR_NULL_AUTH_AES_GMAC: IV is part of AAD */
@@ -563,13 +565,13 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
       if (b != lb)
 	{
 	  integ_total_len = esp_encrypt_chain_integ (
-	    vm, ptd, ort, b, lb, icv_sz,
+	    vm, ptd, ort, seq_hi, b, lb, icv_sz,
 	    payload - iv_sz - sizeof (esp_header_t),
 	    payload_len + iv_sz + sizeof (esp_header_t), tag, 0);
 	}
       else if (ort->use_esn)
 	{
-	  *(u32u *) tag = clib_net_to_host_u32 (ort->seq64 >> 32);
+	  *(u32u *) tag = clib_net_to_host_u32 (seq_hi);
 	  integ_total_len += sizeof (u32);
 	}
     }
@@ -653,6 +655,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       u8 *payload, *next_hdr_ptr;
       u16 payload_len, payload_len_total, n_bufs;
       u32 hdr_len;
+      u64 seq64 = 0;
 
       err = ESP_ENCRYPT_ERROR_RX_PKTS;
 
@@ -699,6 +702,8 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      current_sa_packets, current_sa_bytes);
 	  current_sa_packets = current_sa_bytes = 0;
 
+	  if (ort)
+	    esp_seq_release (ort, thread_index);
 	  ort = ipsec_sa_get_outb_rt_by_index (sa_index0);
 	  current_sa_index = sa_index0;
 
@@ -720,7 +725,8 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  goto trace;
 	}
 
-      if (PREDICT_FALSE ((u16) ~0 == ort->thread_index))
+      if (PREDICT_FALSE ((u16) ~0 == ort->thread_index &&
+			 !ort->is_multi_worker))
 	{
 	  /* this is the first packet to use this SA, claim the SA
 	   * for this thread. this could happen simultaneously on
@@ -729,7 +735,9 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 				    ipsec_sa_assign_thread (thread_index));
 	}
 
-      if (PREDICT_FALSE (thread_index != ort->thread_index))
+      /* a multi-worker SA is used by all the workers, there's no handoff */
+      if (PREDICT_FALSE (thread_index != ort->thread_index &&
+			 !ort->is_multi_worker))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = ort->thread_index;
 	  err = ESP_ENCRYPT_ERROR_HANDOFF;
@@ -756,7 +764,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    lb = vlib_get_buffer (vm, lb->next_buffer);
 	}
 
-      if (PREDICT_FALSE (esp_seq_advance (ort)))
+      if (PREDICT_FALSE (esp_seq_advance (ort, thread_index, &seq64)))
 	{
 	  err = ESP_ENCRYPT_ERROR_SEQ_CYCLED;
 	  esp_encrypt_set_next_index (b[0], node, thread_index, err, n_noop,
@@ -1016,7 +1024,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
 
       esp->spi = spi;
-      esp->seq = clib_net_to_host_u32 (ort->seq64);
+      esp->seq = clib_net_to_host_u32 (seq64);
 
       if (is_async)
 	{
@@ -1043,15 +1051,15 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      vec_add1 (ptd->async_frames, async_frames[async_op]);
 	    }
 
-	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], ort, b[0],
-				   esp, payload, payload_len, iv_sz, icv_sz,
-				   from[b - bufs], sync_next[0], hdr_len,
-				   async_next_node, lb);
+	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], ort,
+				   seq64 >> 32, b[0], esp, payload,
+				   payload_len, iv_sz, icv_sz, from[b - bufs],
+				   sync_next[0], hdr_len, async_next_node, lb);
 	}
       else
-	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, ort,
-			     ort->seq64 >> 32, payload, payload_len, iv_sz,
-			     icv_sz, n_sync, b, lb, hdr_len, esp);
+	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, ort, seq64 >> 32,
+			     payload, payload_len, iv_sz, icv_sz, n_sync, b,
+			     lb, hdr_len, esp);
 
       vlib_buffer_advance (b[0], 0LL - hdr_len);
 
@@ -1070,7 +1078,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      ipsec_sa_t *sa = ipsec_sa_get (sa_index0);
 	      tr->sa_index = sa_index0;
 	      tr->spi = sa->spi;
-	      tr->seq = ort->seq64;
+	      tr->seq = seq64;
 	      tr->udp_encap = ort->udp_encap;
 	      tr->crypto_alg = sa->crypto_alg;
 	      tr->integ_alg = sa->integ_alg;
@@ -1102,17 +1110,19 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
     vlib_increment_combined_counter (&ipsec_sa_counters, thread_index,
 				     current_sa_index, current_sa_packets,
 				     current_sa_bytes);
+  if (ort)
+    esp_seq_release (ort, thread_index);
   if (n_sync)
     {
-      esp_process_ops (vm, node, ptd->crypto_ops, sync_bufs, sync_nexts,
+      esp_process_ops (vm, node, ptd, ptd->crypto_ops, sync_bufs, sync_nexts,
 		       drop_next);
-      esp_process_chained_ops (vm, node, ptd->chained_crypto_ops, sync_bufs,
-			       sync_nexts, ptd->chunks, drop_next);
+      esp_process_chained_ops (vm, node, ptd, ptd->chained_crypto_ops,
+			       sync_bufs, sync_nexts, ptd->chunks, drop_next);
 
-      esp_process_ops (vm, node, ptd->integ_ops, sync_bufs, sync_nexts,
+      esp_process_ops (vm, node, ptd, ptd->integ_ops, sync_bufs, sync_nexts,
 		       drop_next);
-      esp_process_chained_ops (vm, node, ptd->chained_integ_ops, sync_bufs,
-			       sync_nexts, ptd->chunks, drop_next);
+      esp_process_chained_ops (vm, node, ptd, ptd->chained_integ_ops,
+			       sync_bufs, sync_nexts, ptd->chunks, drop_next);
 
       vlib_buffer_enqueue_to_next (vm, node, sync_bi, sync_nexts, n_sync);
     }
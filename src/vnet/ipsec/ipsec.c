@@ -36,6 +36,12 @@
  */
 #define IPSEC4_SPD_DEFAULT_HASH_NUM_BUCKETS (1 << 22)
 
+/* Flow cache is sized for 256 thousand flows with a load factor of .25,
+ * ip6 entries are twice the size of the ip4 ones.
+ */
+#define IPSEC6_OUT_SPD_DEFAULT_HASH_NUM_BUCKETS (1 << 20)
+#define IPSEC6_SPD_DEFAULT_HASH_NUM_BUCKETS (1 << 20)
+
 esp_async_post_next_t esp_encrypt_async_next;
 esp_async_post_next_t esp_decrypt_async_next;
 
@@ -473,19 +479,20 @@ ipsec_init (vlib_main_t * vm)
   im->async_mode = 0;
   crypto_engine_backend_register_post_node (vm);
 
-  im->ipsec4_out_spd_hash_tbl = NULL;
   im->output_flow_cache_flag = 0;
-  im->ipsec4_out_spd_flow_cache_entries = 0;
-  im->epoch_count = 0;
   im->ipsec4_out_spd_hash_num_buckets =
     IPSEC4_OUT_SPD_DEFAULT_HASH_NUM_BUCKETS;
 
-  im->ipsec4_in_spd_hash_tbl = NULL;
   im->input_flow_cache_flag = 0;
-  im->ipsec4_in_spd_flow_cache_entries = 0;
-  im->input_epoch_count = 0;
   im->ipsec4_in_spd_hash_num_buckets = IPSEC4_SPD_DEFAULT_HASH_NUM_BUCKETS;
 
+  im->output6_flow_cache_flag = 0;
+  im->ipsec6_out_spd_hash_num_buckets =
+    IPSEC6_OUT_SPD_DEFAULT_HASH_NUM_BUCKETS;
+
+  im->input6_flow_cache_flag = 0;
+  im->ipsec6_in_spd_hash_num_buckets = IPSEC6_SPD_DEFAULT_HASH_NUM_BUCKETS;
+
   vec_validate_init_empty_aligned (im->next_header_registrations, 255, ~0,
 				   CLIB_CACHE_LINE_BYTES);
 
@@ -509,6 +516,10 @@ ipsec_config (vlib_main_t *vm, unformat_input_t *input)
 
   u32 ipsec4_out_spd_hash_num_buckets;
   u32 ipsec4_in_spd_hash_num_buckets;
+  u32 ipsec6_out_spd_hash_num_buckets;
+  u32 ipsec6_in_spd_hash_num_buckets;
+  ipsec_per_thread_data_t *ptd;
+  u32 n_threads;
   u32 ipsec_spd_fp_num_buckets;
   bool fp_spd_ip4_enabled = false;
   bool fp_spd_ip6_enabled = false;
@@ -519,6 +530,7 @@ ipsec_config (vlib_main_t *vm, unformat_input_t *input)
       if (unformat (input, "ipv6-outbound-spd-fast-path on"))
 	{
 	  im->fp_spd_ipv6_out_is_enabled = 1;
+	  im->output6_flow_cache_flag = 0;
 	  fp_spd_ip6_enabled = true;
 	}
       else if (unformat (input, "ipv6-outbound-spd-fast-path off"))
@@ -534,6 +546,7 @@ ipsec_config (vlib_main_t *vm, unformat_input_t *input)
       else if (unformat (input, "ipv6-inbound-spd-fast-path on"))
 	{
 	  im->fp_spd_ipv6_in_is_enabled = 1;
+	  im->input6_flow_cache_flag = 0;
 	  fp_spd_ip6_enabled = true;
 	}
       else if (unformat (input, "ipv6-inbound-spd-fast-path off"))
@@ -574,6 +587,26 @@ ipsec_config (vlib_main_t *vm, unformat_input_t *input)
 	  im->ipsec4_in_spd_hash_num_buckets =
 	    1ULL << max_log2 (ipsec4_in_spd_hash_num_buckets);
 	}
+      else if (unformat (input, "ipv6-outbound-spd-flow-cache on"))
+	im->output6_flow_cache_flag = im->fp_spd_ipv6_out_is_enabled ? 0 : 1;
+      else if (unformat (input, "ipv6-outbound-spd-flow-cache off"))
+	im->output6_flow_cache_flag = 0;
+      else if (unformat (input, "ipv6-outbound-spd-hash-buckets %d",
+			 &ipsec6_out_spd_hash_num_buckets))
+	{
+	  im->ipsec6_out_spd_hash_num_buckets =
+	    1ULL << max_log2 (ipsec6_out_spd_hash_num_buckets);
+	}
+      else if (unformat (input, "ipv6-inbound-spd-flow-cache on"))
+	im->input6_flow_cache_flag = im->fp_spd_ipv6_in_is_enabled ? 0 : 1;
+      else if (unformat (input, "ipv6-inbound-spd-flow-cache off"))
+	im->input6_flow_cache_flag = 0;
+      else if (unformat (input, "ipv6-inbound-spd-hash-buckets %d",
+			 &ipsec6_in_spd_hash_num_buckets))
+	{
+	  im->ipsec6_in_spd_hash_num_buckets =
+	    1ULL << max_log2 (ipsec6_in_spd_hash_num_buckets);
+	}
       else if (unformat (input, "ip4 %U", unformat_vlib_cli_sub_input,
 			 &sub_input))
 	{
@@ -617,15 +650,44 @@ ipsec_config (vlib_main_t *vm, unformat_input_t *input)
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
     }
-  if (im->output_flow_cache_flag)
-    {
-      vec_add2 (im->ipsec4_out_spd_hash_tbl, im->ipsec4_out_spd_hash_tbl,
-		im->ipsec4_out_spd_hash_num_buckets);
-    }
-  if (im->input_flow_cache_flag)
+
+  /*
+   * Each thread that forwards has its own flow caches: the workers, or the
+   * main thread when there are none. The configured number of buckets is
+   * the total, shared out between them (rounded down to a power of 2 each),
+   * so the memory used stays close to that of a single table. Packets sent
+   * by the main thread while there are workers skip the cache.
+   */
+  n_threads = clib_max (vlib_num_workers (), 1);
+  im->ipsec4_out_spd_hash_num_buckets = clib_max (
+    im->ipsec4_out_spd_hash_num_buckets >> max_log2 (n_threads), 1);
+  im->ipsec4_in_spd_hash_num_buckets = clib_max (
+    im->ipsec4_in_spd_hash_num_buckets >> max_log2 (n_threads), 1);
+  im->ipsec6_out_spd_hash_num_buckets = clib_max (
+    im->ipsec6_out_spd_hash_num_buckets >> max_log2 (n_threads), 1);
+  im->ipsec6_in_spd_hash_num_buckets = clib_max (
+    im->ipsec6_in_spd_hash_num_buckets >> max_log2 (n_threads), 1);
+
+  vec_foreach (ptd, im->ptd)
     {
-      vec_add2 (im->ipsec4_in_spd_hash_tbl, im->ipsec4_in_spd_hash_tbl,
-		im->ipsec4_in_spd_hash_num_buckets);
+      if (ptd == im->ptd && vlib_num_workers ())
+	continue;
+      if (im->output_flow_cache_flag)
+	vec_validate_aligned (ptd->ipsec4_out_spd_hash_tbl,
+			      im->ipsec4_out_spd_hash_num_buckets - 1,
+			      CLIB_CACHE_LINE_BYTES);
+      if (im->input_flow_cache_flag)
+	vec_validate_aligned (ptd->ipsec4_in_spd_hash_tbl,
+			      im->ipsec4_in_spd_hash_num_buckets - 1,
+			      CLIB_CACHE_LINE_BYTES);
+      if (im->output6_flow_cache_flag)
+	vec_validate_aligned (ptd->ipsec6_out_spd_hash_tbl,
+			      im->ipsec6_out_spd_hash_num_buckets - 1,
+			      CLIB_CACHE_LINE_BYTES);
+      if (im->input6_flow_cache_flag)
+	vec_validate_aligned (ptd->ipsec6_in_spd_hash_tbl,
+			      im->ipsec6_in_spd_hash_num_buckets - 1,
+			      CLIB_CACHE_LINE_BYTES);
     }
 
   if (fp_spd_ip4_enabled)
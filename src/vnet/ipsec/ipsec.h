@@ -41,10 +41,14 @@ typedef struct
 {
   u64 key[2]; // 16 bytes
   u64 value;
-  i32 bucket_lock;
-  u32 un_used;
 } ipsec4_hash_kv_16_8_t;
 
+typedef struct
+{
+  u64 key[5]; // 40 bytes
+  u64 value;
+} ipsec6_hash_kv_40_8_t;
+
 typedef union
 {
   struct
@@ -69,6 +73,38 @@ typedef union
   ipsec4_hash_kv_16_8_t kv_16_8;
 } ipsec4_inbound_spd_tuple_t;
 
+typedef union
+{
+  struct
+  {
+    ip6_address_t ip6_addr[2];
+    u16 port[2];
+    u8 proto;
+    u8 pad[3];
+  };
+  ipsec6_hash_kv_40_8_t kv_40_8;
+} ipsec6_spd_5tuple_t;
+
+typedef union
+{
+  struct
+  {
+    ip6_address_t ip6_src_addr;
+    ip6_address_t ip6_dest_addr;
+    ipsec_spd_policy_type_t policy_type;
+    u8 pad[4];
+  }; // 40 bytes total
+  ipsec6_hash_kv_40_8_t kv_40_8;
+} ipsec6_inbound_spd_tuple_t;
+
+/*
+ * The value of an SPD flow cache entry holds the index of the matched
+ * policy in the upper 32 bits. The low bit is always set so that a zero
+ * value marks an empty bucket.
+ */
+#define IPSEC_SPD_FLOW_CACHE_VALUE(pol_id) ((((u64) (pol_id)) << 32) | 1)
+#define IPSEC_SPD_FLOW_CACHE_POLICY(value) ((u32) ((value) >> 32))
+
 typedef struct
 {
   u8 *name;
@@ -137,8 +173,23 @@ typedef struct
   vnet_crypto_op_t *integ_ops;
   vnet_crypto_op_t *chained_crypto_ops;
   vnet_crypto_op_t *chained_integ_ops;
+  /* the ops of a frame regrouped by op type before submission */
+  vnet_crypto_op_t *grouped_ops;
   vnet_crypto_op_chunk_t *chunks;
   vnet_crypto_async_frame_t **async_frames;
+
+  /* SPD flow caches, private to the thread so lookups take no lock */
+  ipsec4_hash_kv_16_8_t *ipsec4_out_spd_hash_tbl;
+  ipsec4_hash_kv_16_8_t *ipsec4_in_spd_hash_tbl;
+  ipsec6_hash_kv_40_8_t *ipsec6_out_spd_hash_tbl;
+  ipsec6_hash_kv_40_8_t *ipsec6_in_spd_hash_tbl;
+
+  /* indices of the occupied buckets of each flow cache, so a policy
+   * change only visits the entries that exist */
+  u32 *ipsec4_out_spd_hash_used;
+  u32 *ipsec4_in_spd_hash_used;
+  u32 *ipsec6_out_spd_hash_used;
+  u32 *ipsec6_in_spd_hash_used;
 } ipsec_per_thread_data_t;
 
 typedef struct
@@ -181,8 +232,6 @@ typedef struct
   uword *ipsec_if_real_dev_by_show_dev;
   uword *ipsec_if_by_sw_if_index;
 
-  ipsec4_hash_kv_16_8_t *ipsec4_out_spd_hash_tbl;
-  ipsec4_hash_kv_16_8_t *ipsec4_in_spd_hash_tbl;
   clib_bihash_8_16_t tun4_protect_by_key;
   clib_bihash_24_16_t tun6_protect_by_key;
 
@@ -253,17 +302,19 @@ typedef struct
 
   u32 handoff_queue_size;
 
-  /* Number of buckets for flow cache */
+  /* Number of buckets in each thread's flow cache */
   u32 ipsec4_out_spd_hash_num_buckets;
-  u32 ipsec4_out_spd_flow_cache_entries;
-  u32 epoch_count;
   u8 output_flow_cache_flag;
 
   u32 ipsec4_in_spd_hash_num_buckets;
-  u32 ipsec4_in_spd_flow_cache_entries;
-  u32 input_epoch_count;
   u8 input_flow_cache_flag;
 
+  u32 ipsec6_out_spd_hash_num_buckets;
+  u8 output6_flow_cache_flag;
+
+  u32 ipsec6_in_spd_hash_num_buckets;
+  u8 input6_flow_cache_flag;
+
   u8 async_mode;
   u16 msg_id_base;
 
@@ -286,6 +337,9 @@ clib_error_t *ipsec_add_del_sa_sess_cb (ipsec_main_t * im, u32 sa_index,
 
 clib_error_t *ipsec_check_support_cb (ipsec_main_t * im, ipsec_sa_t * sa);
 
+u32 ipsec_spd_flow_cache_n_entries (ipsec_main_t *im, int is_ipv6,
+				    int is_outbound);
+
 extern vlib_node_registration_t ipsec4_tun_input_node;
 extern vlib_node_registration_t ipsec6_tun_input_node;
 
@@ -332,28 +386,38 @@ ipsec4_hash_key_compare_16_8 (u64 *a, u64 *b)
 #endif
 }
 
-/* clib_spinlock_lock is not used to save another memory indirection */
-static_always_inline void
-ipsec_spinlock_lock (i32 *lock)
+static_always_inline u64
+ipsec6_hash_40_8 (ipsec6_hash_kv_40_8_t *v)
 {
-  i32 free = 0;
-  while (!clib_atomic_cmp_and_swap_acq_relax_n (lock, &free, 1, 0))
-    {
-      /* atomic load limits number of compare_exchange executions */
-      while (clib_atomic_load_relax_n (lock))
-	CLIB_PAUSE ();
-      /* on failure, compare_exchange writes lock into free */
-      free = 0;
-    }
+#ifdef clib_crc32c_uses_intrinsics
+  return clib_crc32c ((u8 *) v->key, 40);
+#else
+  u64 tmp = v->key[0] ^ v->key[1] ^ v->key[2] ^ v->key[3] ^ v->key[4];
+  return clib_xxhash (tmp);
+#endif
 }
 
-static_always_inline void
-ipsec_spinlock_unlock (i32 *lock)
+static_always_inline int
+ipsec6_hash_key_compare_40_8 (u64 *a, u64 *b)
 {
-  /* Make sure all reads/writes are complete before releasing the lock */
-  clib_atomic_release (lock);
+  return ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3]) |
+	  (a[4] ^ b[4])) == 0;
 }
 
+/* Store an entry in the calling thread's flow cache, noting the bucket
+ * as occupied when it was empty. A collision overwrites the entry. The
+ * main thread has no cache when there are workers. */
+#define ipsec_spd_flow_cache_store(tbl, used, hash, kv)                      \
+  do                                                                          \
+    {                                                                         \
+      if (PREDICT_FALSE ((tbl) == 0))                                         \
+	break;                                                                \
+      if ((tbl)[hash].value == 0)                                             \
+	vec_add1 (used, hash);                                                \
+      clib_memcpy_fast (&(tbl)[hash], kv, sizeof ((tbl)[0]));                 \
+    }                                                                         \
+  while (0)
+
 /* Special case to drop or hand off packets for sync/async modes.
  *
  * Different than sync mode, async mode only enqueue drop or hand-off packets
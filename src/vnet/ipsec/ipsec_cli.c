@@ -166,6 +166,8 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	flags |= IPSEC_SA_FLAG_UDP_ENCAP;
       else if (unformat (line_input, "async"))
 	flags |= IPSEC_SA_FLAG_IS_ASYNC;
+      else if (unformat (line_input, "multi-worker"))
+	flags |= IPSEC_SA_FLAG_MULTI_WORKER;
       else
 	{
 	  error = clib_error_return (0, "parse error: '%U'",
@@ -489,11 +491,11 @@ ipsec_spd_show_all (vlib_main_t * vm, ipsec_main_t * im)
     vlib_cli_output(vm, "%U", format_ipsec_spd, spdi);
   }
 
-  if (im->output_flow_cache_flag)
+  if (im->output_flow_cache_flag || im->output6_flow_cache_flag)
     {
       vlib_cli_output (vm, "%U", format_ipsec_out_spd_flow_cache);
     }
-  if (im->input_flow_cache_flag)
+  if (im->input_flow_cache_flag || im->input6_flow_cache_flag)
     {
       vlib_cli_output (vm, "%U", format_ipsec_in_spd_flow_cache);
     }
@@ -386,8 +386,12 @@ format_ipsec_out_spd_flow_cache (u8 *s, va_list *args)
 {
   ipsec_main_t *im = &ipsec_main;
 
-  s = format (s, "\nipv4-outbound-spd-flow-cache-entries: %u",
-	      im->ipsec4_out_spd_flow_cache_entries);
+  if (im->output6_flow_cache_flag)
+    s = format (s, "\nipv6-outbound-spd-flow-cache-entries: %u",
+		ipsec_spd_flow_cache_n_entries (im, 1, 1));
+  if (im->output_flow_cache_flag)
+    s = format (s, "\nipv4-outbound-spd-flow-cache-entries: %u",
+		ipsec_spd_flow_cache_n_entries (im, 0, 1));
 
   return (s);
 }
@@ -397,8 +401,12 @@ format_ipsec_in_spd_flow_cache (u8 *s, va_list *args)
 {
   ipsec_main_t *im = &ipsec_main;
 
-  s = format (s, "\nipv4-inbound-spd-flow-cache-entries: %u",
-	      im->ipsec4_in_spd_flow_cache_entries);
+  if (im->input6_flow_cache_flag)
+    s = format (s, "\nipv6-inbound-spd-flow-cache-entries: %u",
+		ipsec_spd_flow_cache_n_entries (im, 1, 0));
+  if (im->input_flow_cache_flag)
+    s = format (s, "\nipv4-inbound-spd-flow-cache-entries: %u",
+		ipsec_spd_flow_cache_n_entries (im, 0, 0));
 
   return (s);
 }
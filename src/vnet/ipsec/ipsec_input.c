@@ -79,8 +79,9 @@ ipsec4_input_spd_add_flow_cache_entry (ipsec_main_t *im, u32 sa, u32 da,
 				       ipsec_spd_policy_type_t policy_type,
 				       u32 pol_id)
 {
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
   u64 hash;
-  u8 is_overwrite = 0, is_stale_overwrite = 0;
   /* Store in network byte order to avoid conversion on lookup */
   ipsec4_inbound_spd_tuple_t ip4_tuple = {
     .ip4_src_addr = (ip4_address_t) clib_host_to_net_u32 (sa),
@@ -88,68 +89,96 @@ ipsec4_input_spd_add_flow_cache_entry (ipsec_main_t *im, u32 sa, u32 da,
     .policy_type = policy_type
   };
 
-  ip4_tuple.kv_16_8.value =
-    (((u64) pol_id) << 32) | ((u64) im->input_epoch_count);
+  ip4_tuple.kv_16_8.value = IPSEC_SPD_FLOW_CACHE_VALUE (pol_id);
 
   hash = ipsec4_hash_16_8 (&ip4_tuple.kv_16_8);
   hash &= (im->ipsec4_in_spd_hash_num_buckets - 1);
 
-  ipsec_spinlock_lock (&im->ipsec4_in_spd_hash_tbl[hash].bucket_lock);
-  /* Check if we are overwriting an existing entry so we know
-    whether to increment the flow cache counter. Since flow
-    cache counter is reset on any policy add/remove, but
-    hash table values are not, we need to check if the entry
-    we are overwriting is stale or not. If it's a stale entry
-    overwrite, we still want to increment flow cache counter */
-  is_overwrite = (im->ipsec4_in_spd_hash_tbl[hash].value != 0);
-  /* Check if we are overwriting a stale entry by comparing
-     with current epoch count */
-  if (PREDICT_FALSE (is_overwrite))
-    is_stale_overwrite =
-      (im->input_epoch_count !=
-       ((u32) (im->ipsec4_in_spd_hash_tbl[hash].value & 0xFFFFFFFF)));
-  clib_memcpy_fast (&im->ipsec4_in_spd_hash_tbl[hash], &ip4_tuple.kv_16_8,
-		    sizeof (ip4_tuple.kv_16_8));
-  ipsec_spinlock_unlock (&im->ipsec4_in_spd_hash_tbl[hash].bucket_lock);
-
-  /* Increment the counter to track active flow cache entries
-    when entering a fresh entry or overwriting a stale one */
-  if (!is_overwrite || is_stale_overwrite)
-    clib_atomic_fetch_add_relax (&im->ipsec4_in_spd_flow_cache_entries, 1);
-
-  return;
+  ipsec_spd_flow_cache_store (ptd->ipsec4_in_spd_hash_tbl,
+			      ptd->ipsec4_in_spd_hash_used, hash,
+			      &ip4_tuple.kv_16_8);
 }
 
 always_inline ipsec_policy_t *
 ipsec4_input_spd_find_flow_cache_entry (ipsec_main_t *im, u32 sa, u32 da,
 					ipsec_spd_policy_type_t policy_type)
 {
-  ipsec_policy_t *p = NULL;
-  ipsec4_hash_kv_16_8_t kv_result;
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec4_hash_kv_16_8_t *kv_result;
   u64 hash;
   ipsec4_inbound_spd_tuple_t ip4_tuple = { .ip4_src_addr = (ip4_address_t) sa,
 					   .ip4_dest_addr = (ip4_address_t) da,
 					   .policy_type = policy_type };
 
+  if (PREDICT_FALSE (!ptd->ipsec4_in_spd_hash_tbl))
+    return 0;
+
   hash = ipsec4_hash_16_8 (&ip4_tuple.kv_16_8);
   hash &= (im->ipsec4_in_spd_hash_num_buckets - 1);
 
-  ipsec_spinlock_lock (&im->ipsec4_in_spd_hash_tbl[hash].bucket_lock);
-  kv_result = im->ipsec4_in_spd_hash_tbl[hash];
-  ipsec_spinlock_unlock (&im->ipsec4_in_spd_hash_tbl[hash].bucket_lock);
+  kv_result = &ptd->ipsec4_in_spd_hash_tbl[hash];
 
-  if (ipsec4_hash_key_compare_16_8 ((u64 *) &ip4_tuple.kv_16_8,
-				    (u64 *) &kv_result))
-    {
-      if (im->input_epoch_count == ((u32) (kv_result.value & 0xFFFFFFFF)))
-	{
-	  /* Get the policy based on the index */
-	  p =
-	    pool_elt_at_index (im->policies, ((u32) (kv_result.value >> 32)));
-	}
-    }
+  /* an empty bucket never matches, its value is zero */
+  if (kv_result->value &&
+      ipsec4_hash_key_compare_16_8 ((u64 *) &ip4_tuple.kv_16_8,
+				    kv_result->key))
+    return pool_elt_at_index (im->policies,
+			      IPSEC_SPD_FLOW_CACHE_POLICY (kv_result->value));
 
-  return p;
+  return 0;
+}
+
+always_inline void
+ipsec6_input_spd_add_flow_cache_entry (ipsec_main_t *im, ip6_address_t *sa,
+				       ip6_address_t *da,
+				       ipsec_spd_policy_type_t policy_type,
+				       u32 pol_id)
+{
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec6_inbound_spd_tuple_t ip6_tuple = { .ip6_src_addr = *sa,
+					   .ip6_dest_addr = *da,
+					   .policy_type = policy_type };
+  u64 hash;
+
+  ip6_tuple.kv_40_8.value = IPSEC_SPD_FLOW_CACHE_VALUE (pol_id);
+
+  hash = ipsec6_hash_40_8 (&ip6_tuple.kv_40_8);
+  hash &= (im->ipsec6_in_spd_hash_num_buckets - 1);
+
+  ipsec_spd_flow_cache_store (ptd->ipsec6_in_spd_hash_tbl,
+			      ptd->ipsec6_in_spd_hash_used, hash,
+			      &ip6_tuple.kv_40_8);
+}
+
+always_inline ipsec_policy_t *
+ipsec6_input_spd_find_flow_cache_entry (ipsec_main_t *im, ip6_address_t *sa,
+					ip6_address_t *da,
+					ipsec_spd_policy_type_t policy_type)
+{
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec6_hash_kv_40_8_t *kv_result;
+  ipsec6_inbound_spd_tuple_t ip6_tuple = { .ip6_src_addr = *sa,
+					   .ip6_dest_addr = *da,
+					   .policy_type = policy_type };
+  u64 hash;
+
+  if (PREDICT_FALSE (!ptd->ipsec6_in_spd_hash_tbl))
+    return 0;
+
+  hash = ipsec6_hash_40_8 (&ip6_tuple.kv_40_8);
+  hash &= (im->ipsec6_in_spd_hash_num_buckets - 1);
+
+  kv_result = &ptd->ipsec6_in_spd_hash_tbl[hash];
+
+  if (kv_result->value &&
+      ipsec6_hash_key_compare_40_8 (ip6_tuple.kv_40_8.key, kv_result->key))
+    return pool_elt_at_index (im->policies,
+			      IPSEC_SPD_FLOW_CACHE_POLICY (kv_result->value));
+
+  return 0;
 }
 
 always_inline void
@@ -239,6 +268,12 @@ ipsec6_input_policy_match (ipsec_spd_t *spd, ip6_address_t *sa,
 
     if (!ip6_addr_match_range (da, &p->laddr.start.ip6, &p->laddr.stop.ip6))
       continue;
+
+    if (im->input6_flow_cache_flag)
+      {
+	/* Add an Entry in Flow cache */
+	ipsec6_input_spd_add_flow_cache_entry (im, sa, da, policy_type, *i);
+      }
     return p;
   }
   return 0;
@@ -688,7 +723,7 @@ ipsec6_input_protect_policy_match (ipsec_spd_t * spd,
 	if (!ip6_address_is_equal (da, &s->tunnel.t_dst.ip.ip6))
 	  continue;
 
-	return p;
+	goto return_policy;
       }
 
     if (!ip6_addr_match_range (sa, &p->raddr.start.ip6, &p->raddr.stop.ip6))
@@ -697,6 +732,14 @@ ipsec6_input_protect_policy_match (ipsec_spd_t * spd,
     if (!ip6_addr_match_range (da, &p->laddr.start.ip6, &p->laddr.stop.ip6))
       continue;
 
+  return_policy:
+    if (im->input6_flow_cache_flag)
+      {
+	/* Add an Entry in Flow cache */
+	ipsec6_input_spd_add_flow_cache_entry (
+	  im, sa, da, IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT, *i);
+      }
+
     return p;
   }
   return 0;
@@ -848,6 +891,9 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
   ipsec_policy_t *policies[1];
   ipsec_fp_5tuple_t tuples[1];
   bool ip_v6 = true;
+  /* as for ip4, search the flow cache first and fall back to a linear
+   * search of the SPD when no rule type is found in it */
+  bool search_flow_cache = im->input6_flow_cache_flag;
 
   if (im->fp_spd_ipv6_in_is_enabled &&
       PREDICT_TRUE (INDEX_INVALID != spd0->fp_spd.ip6_in_lookup_hash_idx))
@@ -855,6 +901,7 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
       &tuples[0], &ip0->src_address, &ip0->dst_address,
       clib_net_to_host_u32 (esp0->spi), IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT);
 
+lookup:
   if (esp0->spi != 0)
     {
       if (im->fp_spd_ipv6_in_is_enabled &&
@@ -864,6 +911,12 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
 				      1);
 	  p0 = policies[0];
 	}
+      else if (search_flow_cache)
+	{
+	  p0 = ipsec6_input_spd_find_flow_cache_entry (
+	    im, &ip0->src_address, &ip0->dst_address,
+	    IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT);
+	}
       else /* linear search if fast path is not enabled */
 	{
 	  p0 = ipsec6_input_protect_policy_match (
@@ -896,6 +949,12 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
       ipsec_fp_in_policy_match_n (&spd0->fp_spd, ip_v6, tuples, policies, 1);
       p0 = policies[0];
     }
+  else if (search_flow_cache)
+    {
+      p0 = ipsec6_input_spd_find_flow_cache_entry (
+	im, &ip0->src_address, &ip0->dst_address,
+	IPSEC_SPD_POLICY_IP6_INBOUND_BYPASS);
+    }
   else
     {
       p0 =
@@ -926,6 +985,12 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
       ipsec_fp_in_policy_match_n (&spd0->fp_spd, ip_v6, tuples, policies, 1);
       p0 = policies[0];
     }
+  else if (search_flow_cache)
+    {
+      p0 = ipsec6_input_spd_find_flow_cache_entry (
+	im, &ip0->src_address, &ip0->dst_address,
+	IPSEC_SPD_POLICY_IP6_INBOUND_DISCARD);
+    }
   else
     {
       p0 =
@@ -950,6 +1015,13 @@ ipsec6_esp_packet_process (vlib_main_t *vm, ipsec_main_t *im,
       pi0 = ~0;
     }
 
+  /* flow cache search failed, try again with linear search */
+  if (search_flow_cache)
+    {
+      search_flow_cache = false;
+      goto lookup;
+    }
+
   /* Drop by default if no match on PROTECT, BYPASS or DISCARD */
   *ipsec_unprocessed += 1;
   next[0] = IPSEC_INPUT_NEXT_DROP;
@@ -1045,9 +1117,14 @@ VLIB_NODE_FN (ipsec6_input_node) (vlib_main_t * vm,
 	    {
 	    ah_header_t *ah0 = (ah_header_t *) ((u8 *) ip0 + header_size);
 
-	    p0 = ipsec6_input_protect_policy_match (
-	      spd0, &ip0->src_address, &ip0->dst_address,
-	      clib_net_to_host_u32 (ah0->spi));
+	    if (im->input6_flow_cache_flag)
+	      p0 = ipsec6_input_spd_find_flow_cache_entry (
+		im, &ip0->src_address, &ip0->dst_address,
+		IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT);
+	    if (p0 == 0)
+	      p0 = ipsec6_input_protect_policy_match (
+		spd0, &ip0->src_address, &ip0->dst_address,
+		clib_net_to_host_u32 (ah0->spi));
 
 	    if (PREDICT_TRUE (p0 != 0))
 	      {
@@ -135,13 +135,22 @@ ipsec_output_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	     spd0->id);
 #endif
 
-	  p0 = ipsec6_output_policy_match (spd0,
-					   &ip6_0->src_address,
-					   &ip6_0->dst_address,
-					   clib_net_to_host_u16
-					   (udp0->src_port),
-					   clib_net_to_host_u16
-					   (udp0->dst_port), ip6_0->protocol);
+	  if (im->output6_flow_cache_flag)
+	    {
+	      p0 = ipsec6_out_spd_find_flow_cache_entry (
+		im, ip6_0->protocol, &ip6_0->src_address, &ip6_0->dst_address,
+		clib_net_to_host_u16 (udp0->src_port),
+		clib_net_to_host_u16 (udp0->dst_port));
+	    }
+
+	  /* Fall back to linear search if flow cache lookup fails */
+	  if (p0 == NULL)
+	    {
+	      p0 = ipsec6_output_policy_match (
+		spd0, &ip6_0->src_address, &ip6_0->dst_address,
+		clib_net_to_host_u16 (udp0->src_port),
+		clib_net_to_host_u16 (udp0->dst_port), ip6_0->protocol);
+	    }
 	}
       else
 	{
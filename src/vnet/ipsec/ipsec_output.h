@@ -26,41 +26,22 @@ always_inline void
 ipsec4_out_spd_add_flow_cache_entry (ipsec_main_t *im, u8 pr, u32 la, u32 ra,
 				     u16 lp, u16 rp, u32 pol_id)
 {
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
   u64 hash;
-  u8 overwrite = 0, stale_overwrite = 0;
   ipsec4_spd_5tuple_t ip4_5tuple = { .ip4_addr = { (ip4_address_t) la,
 						   (ip4_address_t) ra },
 				     .port = { lp, rp },
 				     .proto = pr };
 
-  ip4_5tuple.kv_16_8.value = (((u64) pol_id) << 32) | ((u64) im->epoch_count);
+  ip4_5tuple.kv_16_8.value = IPSEC_SPD_FLOW_CACHE_VALUE (pol_id);
 
   hash = ipsec4_hash_16_8 (&ip4_5tuple.kv_16_8);
   hash &= (im->ipsec4_out_spd_hash_num_buckets - 1);
 
-  ipsec_spinlock_lock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
-  /* Check if we are overwriting an existing entry so we know
-  whether to increment the flow cache counter. Since flow
-  cache counter is reset on any policy add/remove, but
-  hash table values are not, we also need to check if the entry
-  we are overwriting is stale or not. If it's a stale entry
-  overwrite, we still want to increment flow cache counter */
-  overwrite = (im->ipsec4_out_spd_hash_tbl[hash].value != 0);
-  /* Check for stale entry by comparing with current epoch count */
-  if (PREDICT_FALSE (overwrite))
-    stale_overwrite =
-      (im->epoch_count !=
-       ((u32) (im->ipsec4_out_spd_hash_tbl[hash].value & 0xFFFFFFFF)));
-  clib_memcpy_fast (&im->ipsec4_out_spd_hash_tbl[hash], &ip4_5tuple.kv_16_8,
-		    sizeof (ip4_5tuple.kv_16_8));
-  ipsec_spinlock_unlock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
-
-  /* Increment the counter to track active flow cache entries
-    when entering a fresh entry or overwriting a stale one */
-  if (!overwrite || stale_overwrite)
-    clib_atomic_fetch_add_relax (&im->ipsec4_out_spd_flow_cache_entries, 1);
-
-  return;
+  ipsec_spd_flow_cache_store (ptd->ipsec4_out_spd_hash_tbl,
+			      ptd->ipsec4_out_spd_hash_used, hash,
+			      &ip4_5tuple.kv_16_8);
 }
 
 always_inline void
@@ -68,37 +49,18 @@ ipsec4_out_spd_add_flow_cache_entry_n (ipsec_main_t *im,
 				       ipsec4_spd_5tuple_t *ip4_5tuple,
 				       u32 pol_id)
 {
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
   u64 hash;
-  u8 overwrite = 0, stale_overwrite = 0;
 
-  ip4_5tuple->kv_16_8.value = (((u64) pol_id) << 32) | ((u64) im->epoch_count);
+  ip4_5tuple->kv_16_8.value = IPSEC_SPD_FLOW_CACHE_VALUE (pol_id);
 
   hash = ipsec4_hash_16_8 (&ip4_5tuple->kv_16_8);
   hash &= (im->ipsec4_out_spd_hash_num_buckets - 1);
 
-  ipsec_spinlock_lock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
-  /* Check if we are overwriting an existing entry so we know
-  whether to increment the flow cache counter. Since flow
-  cache counter is reset on any policy add/remove, but
-  hash table values are not, we also need to check if the entry
-  we are overwriting is stale or not. If it's a stale entry
-  overwrite, we still want to increment flow cache counter */
-  overwrite = (im->ipsec4_out_spd_hash_tbl[hash].value != 0);
-  /* Check for stale entry by comparing with current epoch count */
-  if (PREDICT_FALSE (overwrite))
-    stale_overwrite =
-      (im->epoch_count !=
-       ((u32) (im->ipsec4_out_spd_hash_tbl[hash].value & 0xFFFFFFFF)));
-  clib_memcpy_fast (&im->ipsec4_out_spd_hash_tbl[hash], &ip4_5tuple->kv_16_8,
-		    sizeof (ip4_5tuple->kv_16_8));
-  ipsec_spinlock_unlock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
-
-  /* Increment the counter to track active flow cache entries
-    when entering a fresh entry or overwriting a stale one */
-  if (!overwrite || stale_overwrite)
-    clib_atomic_fetch_add_relax (&im->ipsec4_out_spd_flow_cache_entries, 1);
-
-  return;
+  ipsec_spd_flow_cache_store (ptd->ipsec4_out_spd_hash_tbl,
+			      ptd->ipsec4_out_spd_hash_used, hash,
+			      &ip4_5tuple->kv_16_8);
 }
 
 always_inline void
@@ -280,8 +242,9 @@ always_inline ipsec_policy_t *
 ipsec4_out_spd_find_flow_cache_entry (ipsec_main_t *im, u8 pr, u32 la, u32 ra,
 				      u16 lp, u16 rp)
 {
-  ipsec_policy_t *p = NULL;
-  ipsec4_hash_kv_16_8_t kv_result;
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec4_hash_kv_16_8_t *kv_result;
   u64 hash;
 
   if (PREDICT_FALSE ((pr != IP_PROTOCOL_TCP) && (pr != IP_PROTOCOL_UDP) &&
@@ -295,25 +258,22 @@ ipsec4_out_spd_find_flow_cache_entry (ipsec_main_t *im, u8 pr, u32 la, u32 ra,
 				     .port = { lp, rp },
 				     .proto = pr };
 
+  if (PREDICT_FALSE (!ptd->ipsec4_out_spd_hash_tbl))
+    return 0;
+
   hash = ipsec4_hash_16_8 (&ip4_5tuple.kv_16_8);
   hash &= (im->ipsec4_out_spd_hash_num_buckets - 1);
 
-  ipsec_spinlock_lock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
-  kv_result = im->ipsec4_out_spd_hash_tbl[hash];
-  ipsec_spinlock_unlock (&im->ipsec4_out_spd_hash_tbl[hash].bucket_lock);
+  kv_result = &ptd->ipsec4_out_spd_hash_tbl[hash];
 
-  if (ipsec4_hash_key_compare_16_8 ((u64 *) &ip4_5tuple.kv_16_8,
-				    (u64 *) &kv_result))
-    {
-      if (im->epoch_count == ((u32) (kv_result.value & 0xFFFFFFFF)))
-	{
-	  /* Get the policy based on the index */
-	  p =
-	    pool_elt_at_index (im->policies, ((u32) (kv_result.value >> 32)));
-	}
-    }
+  /* an empty bucket never matches, its value is zero */
+  if (kv_result->value &&
+      ipsec4_hash_key_compare_16_8 ((u64 *) &ip4_5tuple.kv_16_8,
+				    kv_result->key))
+    return pool_elt_at_index (im->policies,
+			      IPSEC_SPD_FLOW_CACHE_POLICY (kv_result->value));
 
-  return p;
+  return 0;
 }
 
 always_inline ipsec_policy_t *
@@ -424,6 +384,64 @@ ipsec_fp_5tuple_from_ip6_range (ipsec_fp_5tuple_t *tuple, ip6_address_t *la,
   tuple->is_ipv6 = 1;
 }
 
+always_inline void
+ipsec6_out_spd_add_flow_cache_entry (ipsec_main_t *im, u8 pr,
+				     ip6_address_t *la, ip6_address_t *ra,
+				     u16 lp, u16 rp, u32 pol_id)
+{
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec6_spd_5tuple_t ip6_5tuple = { .ip6_addr = { *la, *ra },
+				     .port = { lp, rp },
+				     .proto = pr };
+  u64 hash;
+
+  ip6_5tuple.kv_40_8.value = IPSEC_SPD_FLOW_CACHE_VALUE (pol_id);
+
+  hash = ipsec6_hash_40_8 (&ip6_5tuple.kv_40_8);
+  hash &= (im->ipsec6_out_spd_hash_num_buckets - 1);
+
+  ipsec_spd_flow_cache_store (ptd->ipsec6_out_spd_hash_tbl,
+			      ptd->ipsec6_out_spd_hash_used, hash,
+			      &ip6_5tuple.kv_40_8);
+}
+
+always_inline ipsec_policy_t *
+ipsec6_out_spd_find_flow_cache_entry (ipsec_main_t *im, u8 pr,
+				      ip6_address_t *la, ip6_address_t *ra,
+				      u16 lp, u16 rp)
+{
+  ipsec_per_thread_data_t *ptd =
+    vec_elt_at_index (im->ptd, vlib_get_thread_index ());
+  ipsec6_hash_kv_40_8_t *kv_result;
+  u64 hash;
+
+  if (PREDICT_FALSE ((pr != IP_PROTOCOL_TCP) && (pr != IP_PROTOCOL_UDP) &&
+		     (pr != IP_PROTOCOL_SCTP)))
+    {
+      lp = 0;
+      rp = 0;
+    }
+  ipsec6_spd_5tuple_t ip6_5tuple = { .ip6_addr = { *la, *ra },
+				     .port = { lp, rp },
+				     .proto = pr };
+
+  if (PREDICT_FALSE (!ptd->ipsec6_out_spd_hash_tbl))
+    return 0;
+
+  hash = ipsec6_hash_40_8 (&ip6_5tuple.kv_40_8);
+  hash &= (im->ipsec6_out_spd_hash_num_buckets - 1);
+
+  kv_result = &ptd->ipsec6_out_spd_hash_tbl[hash];
+
+  if (kv_result->value &&
+      ipsec6_hash_key_compare_40_8 (ip6_5tuple.kv_40_8.key, kv_result->key))
+    return pool_elt_at_index (im->policies,
+			      IPSEC_SPD_FLOW_CACHE_POLICY (kv_result->value));
+
+  return 0;
+}
+
 always_inline ipsec_policy_t *
 ipsec6_output_policy_match (ipsec_spd_t *spd, ip6_address_t *la,
 			    ip6_address_t *ra, u16 lp, u16 rp, u8 pr)
@@ -466,7 +484,11 @@ ipsec6_output_policy_match (ipsec_spd_t *spd, ip6_address_t *la,
 
       if (PREDICT_FALSE ((pr != IP_PROTOCOL_TCP) && (pr != IP_PROTOCOL_UDP) &&
 			 (pr != IP_PROTOCOL_SCTP)))
-	return p;
+	{
+	  lp = 0;
+	  rp = 0;
+	  goto add_flow_cache;
+	}
 
       if (lp < p->lport.start)
 	continue;
@@ -480,6 +502,13 @@ ipsec6_output_policy_match (ipsec_spd_t *spd, ip6_address_t *la,
       if (rp > p->rport.stop)
 	continue;
 
+    add_flow_cache:
+      if (im->output6_flow_cache_flag)
+	{
+	  /* Add an Entry in Flow cache */
+	  ipsec6_out_spd_add_flow_cache_entry (im, pr, la, ra, lp, rp, *i);
+	}
+
       return p;
     }
 
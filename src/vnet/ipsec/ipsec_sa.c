@@ -227,6 +227,7 @@ ipsec_sa_init_runtime (ipsec_sa_t *sa)
       irt->integ_icv_size = integ_icv_size;
       irt->salt = sa->salt;
       irt->async_op_id = sa->crypto_async_dec_op_id;
+      irt->is_multi_worker = ipsec_sa_is_set_MULTI_WORKER (sa);
       ASSERT (irt->cipher_iv_size <= ESP_MAX_IV_SIZE);
     }
 
@@ -235,6 +236,7 @@ ipsec_sa_init_runtime (ipsec_sa_t *sa)
       ipsec_sa_outb_rt_t *ort = ipsec_sa_get_outb_rt (sa);
       ort->use_anti_replay = ipsec_sa_is_set_USE_ANTI_REPLAY (sa);
       ort->use_esn = ipsec_sa_is_set_USE_ESN (sa);
+      ort->is_multi_worker = ipsec_sa_is_set_MULTI_WORKER (sa);
       ort->is_ctr = alg->is_ctr;
       ort->is_aead = alg->is_aead;
       ort->is_null_gmac = alg->is_null_gmac;
@@ -452,7 +454,11 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
   vec_validate (im->outb_sa_runtimes, sa_index);
 
   irt_sz = sizeof (ipsec_sa_inb_rt_t);
-  irt_sz += anti_replay_window_size / 8;
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    irt_sz += ipsec_sa_anti_replay_mw_n_cells (anti_replay_window_size) *
+	      sizeof (u64);
+  else
+    irt_sz += anti_replay_window_size / 8;
   irt_sz = round_pow2 (irt_sz, CLIB_CACHE_LINE_BYTES);
 
   irt = clib_mem_alloc_aligned (irt_sz, alignof (ipsec_sa_inb_rt_t));
@@ -472,6 +478,11 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 
   clib_pcg64i_srandom_r (&ort->iv_prng, rand[0], rand[1]);
 
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    /* every thread takes its sequence numbers from its own block */
+    vec_validate_aligned (ort->seq_blocks, vlib_get_n_threads () - 1,
+			  CLIB_CACHE_LINE_BYTES);
+
   fib_node_init (&sa->node, FIB_NODE_TYPE_IPSEC_SA);
   fib_node_lock (&sa->node);
 
@@ -610,8 +621,11 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 	ipsec_register_udp_port (dst_port, !ipsec_sa_is_set_IS_TUNNEL_V6 (sa));
     }
 
-  for (u32 i = 0; i < anti_replay_window_size / uword_bits; i++)
-    irt->replay_window[i] = ~0ULL;
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    ipsec_sa_anti_replay_mw_reset (irt);
+  else
+    for (u32 i = 0; i < anti_replay_window_size / uword_bits; i++)
+      irt->replay_window[i] = ~0ULL;
 
   hash_set (im->sa_index_by_sa_id, sa->id, sa_index);
 
@@ -652,6 +666,7 @@ ipsec_sa_del (ipsec_sa_t * sa)
     vnet_crypto_key_del (vm, sa->crypto_sync_key_index);
   if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
     vnet_crypto_key_del (vm, sa->integ_sync_key_index);
+  vec_free (ort->seq_blocks);
   foreach_pointer (p, irt, ort)
     if (p)
       clib_mem_free (p);
@@ -680,6 +695,10 @@ ipsec_sa_bind (u32 id, u32 worker, bool bind)
   irt = ipsec_sa_get_inb_rt (sa);
   ort = ipsec_sa_get_outb_rt (sa);
 
+  /* a multi-worker SA is used by all the workers */
+  if (ipsec_sa_is_set_MULTI_WORKER (sa))
+    return VNET_API_ERROR_UNSUPPORTED;
+
   if (!bind)
     {
       thread_index = ~0;
@@ -100,7 +100,8 @@ typedef struct ipsec_key_t_
   _ (32, IS_PROTECT, "Protect")                                               \
   _ (64, IS_INBOUND, "inbound")                                               \
   _ (512, IS_ASYNC, "async")                                                  \
-  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")
+  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")                                \
+  _ (2048, MULTI_WORKER, "multi-worker")
 
 typedef enum ipsec_sad_flags_t_
 {
@@ -140,6 +141,18 @@ typedef enum
     IPSEC_SA_N_ERRORS,
 } __clib_packed ipsec_sa_err_t;
 
+/*
+ * Sequence numbers a worker reserves at once from a multi-worker SA
+ */
+#define IPSEC_SA_SEQ_BLOCK_SIZE 32
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 next;
+  u32 n_left;
+} ipsec_sa_seq_block_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -152,6 +165,7 @@ typedef struct
   u16 is_tunnel : 1;
   u16 is_transport : 1;
   u16 is_async : 1;
+  u16 is_multi_worker : 1;
   u16 cipher_op_id;
   u16 integ_op_id;
   u8 cipher_iv_size;
@@ -180,6 +194,7 @@ typedef struct
   u16 use_anti_replay : 1;
   u16 drop_no_crypto : 1;
   u16 is_async : 1;
+  u16 is_multi_worker : 1;
   u16 cipher_op_id;
   u16 integ_op_id;
   u8 cipher_iv_size;
@@ -194,6 +209,8 @@ typedef struct
   u64 seq64;
   dpo_id_t dpo;
   clib_pcg64i_random_t iv_prng;
+  /* per-thread sequence number blocks of a multi-worker SA */
+  ipsec_sa_seq_block_t *seq_blocks;
   vnet_crypto_key_index_t cipher_key_index;
   vnet_crypto_key_index_t integ_key_index;
   union
@@ -326,6 +343,76 @@ extern uword unformat_ipsec_key (unformat_input_t *input, va_list *args);
 
 #define IPSEC_UDP_PORT_NONE ((u16) ~0)
 
+/*
+ * The replay window of a multi-worker SA is shared by all the workers and
+ * updated lock-free. It is an array of 64 bit cells, each holding the
+ * index of a block of 32 sequence numbers (seq >> 5) in its upper half and
+ * the bitmap of the block's sequence numbers seen so far in its lower half.
+ * A block's cell is recycled, with a single compare-and-swap, by the first
+ * packet of a later block that maps onto it. There are twice as many cells
+ * as the window needs so that a block still in the window is never
+ * recycled.
+ */
+#define IPSEC_SA_MW_BLOCK_LOG2 5
+
+always_inline u32
+ipsec_sa_anti_replay_mw_n_cells (u32 window_size)
+{
+  return 2 * (window_size >> IPSEC_SA_MW_BLOCK_LOG2);
+}
+
+always_inline u64 *
+ipsec_sa_anti_replay_mw_cell (const ipsec_sa_inb_rt_t *irt, u32 seq)
+{
+  u32 n_cells =
+    ipsec_sa_anti_replay_mw_n_cells (irt->anti_replay_window_size);
+
+  return (u64 *) irt->replay_window +
+	 ((seq >> IPSEC_SA_MW_BLOCK_LOG2) & (n_cells - 1));
+}
+
+/* is the cell's block newer than the block of seq */
+always_inline int
+ipsec_sa_anti_replay_mw_is_newer (u64 cell, u32 seq)
+{
+  u32 blk = seq >> IPSEC_SA_MW_BLOCK_LOG2;
+
+  /* block indices are 27 bits, compare them modulo 2^27 */
+  return (i32) ((blk - (u32) (cell >> 32)) << IPSEC_SA_MW_BLOCK_LOG2) < 0;
+}
+
+always_inline int
+ipsec_sa_anti_replay_mw_check (const ipsec_sa_inb_rt_t *irt, u32 seq)
+{
+  u64 *cell = ipsec_sa_anti_replay_mw_cell (irt, seq);
+  u64 v = clib_atomic_load_relax_n (cell);
+
+  if ((u32) (v >> 32) == seq >> IPSEC_SA_MW_BLOCK_LOG2)
+    return (v >> (seq & pow2_mask (IPSEC_SA_MW_BLOCK_LOG2))) & 1;
+
+  /* the cell has moved on to a later block, seq is out of the window */
+  return ipsec_sa_anti_replay_mw_is_newer (v, seq);
+}
+
+/*
+ * Empty the window. Each cell is given the block one lap of the cells
+ * behind the blocks up to the SA's sequence number, which has no packets
+ * seen and is recycled by the first packet that maps onto the cell.
+ */
+always_inline void
+ipsec_sa_anti_replay_mw_reset (ipsec_sa_inb_rt_t *irt)
+{
+  u32 n_cells =
+    ipsec_sa_anti_replay_mw_n_cells (irt->anti_replay_window_size);
+  u32 blk = (u32) irt->seq64 >> IPSEC_SA_MW_BLOCK_LOG2;
+  u64 *cells = (u64 *) irt->replay_window;
+
+  for (u32 i = 0; i < n_cells; i++, blk--)
+    cells[blk & (n_cells - 1)] =
+      (u64) ((blk - n_cells) & pow2_mask (32 - IPSEC_SA_MW_BLOCK_LOG2))
+      << 32;
+}
+
 always_inline u64
 ipsec_sa_anti_replay_get_64b_window (const ipsec_sa_inb_rt_t *irt)
 {
@@ -334,6 +421,15 @@ ipsec_sa_anti_replay_get_64b_window (const ipsec_sa_inb_rt_t *irt)
   u32 tl_win_index = irt->seq64 & (window_size - 1);
   uword *bmp = (uword *) irt->replay_window;
 
+  if (irt->is_multi_worker)
+    {
+      w = 0;
+      for (u32 i = 0; i < 64; i++)
+	if (ipsec_sa_anti_replay_mw_check (irt, (u32) irt->seq64 - i))
+	  w |= 1ULL << (63 - i);
+      return w;
+    }
+
   if (PREDICT_TRUE (tl_win_index >= 63))
     return uword_bitmap_get_multiple (bmp, tl_win_index - 63, 64);
 
@@ -353,6 +449,9 @@ ipsec_sa_anti_replay_check (const ipsec_sa_inb_rt_t *irt, u32 window_size,
    * if the packet falls left (sa->seq - seq >= window size),
    * the result is wrong */
 
+  if (irt->is_multi_worker)
+    return ipsec_sa_anti_replay_mw_check (irt, seq);
+
   return uword_bitmap_is_bit_set ((uword *) irt->replay_window,
 				  seq & (window_size - 1));
 }
@@ -732,6 +831,122 @@ ipsec_sa_anti_replay_advance (ipsec_sa_inb_rt_t *irt,
   return n_lost;
 }
 
+/*
+ * Anti replay runs.
+ * The packets of an in order stream arrive ahead of the window and in
+ * ascending order. The window is moved once for a run of them, to the last
+ * one, and the bits of the others are set a word at a time. The result is
+ * the same as advancing the window for each packet in turn.
+ *
+ * Returns the number of packets, from the first of seqs, that form a run:
+ * strictly ascending, ahead of the window but less than a window beyond its
+ * top, and with the SA's high sequence number.
+ */
+always_inline u32
+ipsec_sa_anti_replay_run_len (const ipsec_sa_inb_rt_t *irt, const u32 *seqs,
+			      u32 n_seqs, u32 hi_seq)
+{
+  u32 window_size = irt->anti_replay_window_size;
+  u32 exp_lo = irt->seq64, prev = exp_lo, i;
+
+  if (irt->is_multi_worker || hi_seq != (u32) (irt->seq64 >> 32))
+    return 0;
+
+  for (i = 0; i < n_seqs; i++)
+    {
+      if (seqs[i] <= prev || seqs[i] - exp_lo >= window_size)
+	break;
+      prev = seqs[i];
+    }
+
+  return i;
+}
+
+always_inline u64
+ipsec_sa_anti_replay_advance_run (ipsec_sa_inb_rt_t *irt, const u32 *seqs,
+				  u32 n_seqs)
+{
+  u32 window_size = irt->anti_replay_window_size;
+  u32 last = seqs[n_seqs - 1], pos, n, i, j;
+  u64 n_lost;
+
+  n_lost = ipsec_sa_anti_replay_window_shift (irt, window_size,
+					      last - (u32) irt->seq64);
+
+  /* set the bits of each stretch of consecutive sequence numbers */
+  for (i = 0; i < n_seqs; i = j)
+    {
+      for (j = i + 1; j < n_seqs && seqs[j] == seqs[j - 1] + 1; j++)
+	;
+      pos = seqs[i] & (window_size - 1);
+      n = j - i;
+      if (pos + n > window_size)
+	{
+	  uword_bitmap_set_bits_at_index (irt->replay_window, 0,
+					  pos + n - window_size);
+	  n = window_size - pos;
+	}
+      uword_bitmap_set_bits_at_index (irt->replay_window, pos, n);
+    }
+
+  irt->seq64 = (irt->seq64 >> 32) << 32 | last;
+
+  return n_lost;
+}
+
+/*
+ * Anti replay window advance of a multi-worker SA.
+ * The check and the update of the packet's bit are a single atomic step,
+ * so of the packets with the same sequence number decrypted concurrently
+ * on several workers only one is accepted. Returns non-zero if the packet
+ * is a replay. The sequence number only moves forward, lost packets are
+ * not counted.
+ */
+always_inline int
+ipsec_sa_anti_replay_mw_advance (ipsec_sa_inb_rt_t *irt, u32 seq, u32 hi_seq)
+{
+  u64 seq64 = (u64) hi_seq << 32 | seq;
+  u64 *cell, old, new, top;
+
+  if (irt->use_anti_replay)
+    {
+      cell = ipsec_sa_anti_replay_mw_cell (irt, seq);
+      old = clib_atomic_load_relax_n (cell);
+
+      while (1)
+	{
+	  u64 bit = 1ULL << (seq & pow2_mask (IPSEC_SA_MW_BLOCK_LOG2));
+	  u32 blk = seq >> IPSEC_SA_MW_BLOCK_LOG2;
+
+	  if ((u32) (old >> 32) == blk)
+	    {
+	      if (old & bit)
+		return 1;
+	      new = old | bit;
+	    }
+	  else if (ipsec_sa_anti_replay_mw_is_newer (old, seq))
+	    return 1;
+	  else
+	    new = (u64) blk << 32 | bit;
+
+	  top = clib_atomic_cmp_and_swap (cell, old, new);
+	  if (top == old)
+	    break;
+	  old = top;
+	}
+    }
+
+  top = clib_atomic_load_relax_n (&irt->seq64);
+  while (seq64 > top)
+    {
+      old = clib_atomic_cmp_and_swap (&irt->seq64, top, seq64);
+      if (old == top)
+	break;
+      top = old;
+    }
+
+  return 0;
+}
 
 /*
  * Makes choice for thread_id should be assigned.
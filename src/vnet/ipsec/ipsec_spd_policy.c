@@ -102,6 +102,201 @@ ipsec_is_fp_enabled (ipsec_main_t *im, ipsec_spd_t *spd,
   return 0;
 }
 
+static_always_inline int
+ipsec4_spd_flow_cache_addr_match (ip4_address_t *a, ip46_address_t *start,
+				  ip46_address_t *stop)
+{
+  u32 h = clib_net_to_host_u32 (a->as_u32);
+
+  return (h >= clib_net_to_host_u32 (start->ip4.as_u32) &&
+	  h <= clib_net_to_host_u32 (stop->ip4.as_u32));
+}
+
+static_always_inline int
+ipsec6_spd_flow_cache_addr_match (ip6_address_t *a, ip46_address_t *start,
+				  ip46_address_t *stop)
+{
+  return (memcmp (a, &start->ip6, sizeof (*a)) >= 0 &&
+	  memcmp (a, &stop->ip6, sizeof (*a)) <= 0);
+}
+
+static_always_inline int
+ipsec_spd_flow_cache_port_match (ipsec_policy_t *p, u8 pr, u16 lp, u16 rp)
+{
+  if ((pr != IP_PROTOCOL_TCP) && (pr != IP_PROTOCOL_UDP) &&
+      (pr != IP_PROTOCOL_SCTP))
+    return 1;
+
+  return (lp >= p->lport.start && lp <= p->lport.stop &&
+	  rp >= p->rport.start && rp <= p->rport.stop);
+}
+
+/*
+ * Whether a new inbound policy could match the flow of a cached entry. The
+ * cached rule type does not matter: a new bypass rule must replace a cached
+ * discard, and the flow cache does not key protect entries on the SPI.
+ */
+static_always_inline int
+ipsec4_in_spd_flow_cache_match (ipsec_policy_t *p, ipsec_sa_t *sa,
+				ipsec4_inbound_spd_tuple_t *t)
+{
+  if (sa && ipsec_sa_is_set_IS_TUNNEL (sa) &&
+      t->ip4_src_addr.as_u32 == sa->tunnel.t_src.ip.ip4.as_u32 &&
+      t->ip4_dest_addr.as_u32 == sa->tunnel.t_dst.ip.ip4.as_u32)
+    return 1;
+
+  return (ipsec4_spd_flow_cache_addr_match (&t->ip4_dest_addr,
+					    &p->laddr.start, &p->laddr.stop) &&
+	  ipsec4_spd_flow_cache_addr_match (&t->ip4_src_addr, &p->raddr.start,
+					    &p->raddr.stop));
+}
+
+static_always_inline int
+ipsec6_in_spd_flow_cache_match (ipsec_policy_t *p, ipsec_sa_t *sa,
+				ipsec6_inbound_spd_tuple_t *t)
+{
+  if (sa && ipsec_sa_is_set_IS_TUNNEL (sa) &&
+      ip6_address_is_equal (&t->ip6_src_addr, &sa->tunnel.t_src.ip.ip6) &&
+      ip6_address_is_equal (&t->ip6_dest_addr, &sa->tunnel.t_dst.ip.ip6))
+    return 1;
+
+  return (ipsec6_spd_flow_cache_addr_match (&t->ip6_dest_addr,
+					    &p->laddr.start, &p->laddr.stop) &&
+	  ipsec6_spd_flow_cache_addr_match (&t->ip6_src_addr, &p->raddr.start,
+					    &p->raddr.stop));
+}
+
+static_always_inline int
+ipsec4_out_spd_flow_cache_match (ipsec_policy_t *p, ipsec4_spd_5tuple_t *t)
+{
+  if (p->protocol != IPSEC_POLICY_PROTOCOL_ANY && p->protocol != t->proto)
+    return 0;
+
+  if (!ipsec4_spd_flow_cache_addr_match (&t->ip4_addr[0], &p->laddr.start,
+					 &p->laddr.stop) ||
+      !ipsec4_spd_flow_cache_addr_match (&t->ip4_addr[1], &p->raddr.start,
+					 &p->raddr.stop))
+    return 0;
+
+  /* the ip4 entries hold the ports in network order */
+  return ipsec_spd_flow_cache_port_match (
+    p, t->proto, clib_net_to_host_u16 (t->port[0]),
+    clib_net_to_host_u16 (t->port[1]));
+}
+
+static_always_inline int
+ipsec6_out_spd_flow_cache_match (ipsec_policy_t *p, ipsec6_spd_5tuple_t *t)
+{
+  if (p->protocol != IPSEC_POLICY_PROTOCOL_ANY && p->protocol != t->proto)
+    return 0;
+
+  if (!ipsec6_spd_flow_cache_addr_match (&t->ip6_addr[0], &p->laddr.start,
+					 &p->laddr.stop) ||
+      !ipsec6_spd_flow_cache_addr_match (&t->ip6_addr[1], &p->raddr.start,
+					 &p->raddr.stop))
+    return 0;
+
+  return ipsec_spd_flow_cache_port_match (p, t->proto, t->port[0],
+					  t->port[1]);
+}
+
+/*
+ * Drop the flow cache entries of every thread that a policy change makes
+ * stale, keeping the rest. Removing a policy only affects the flows that
+ * were cached against it. Adding one affects the flows it could match,
+ * whichever policy they were cached against, since it may have the higher
+ * priority. Policy changes run with the workers stopped at the barrier.
+ */
+#define ipsec_spd_flow_cache_walk(ptd, tbl, used, entry_t, match)            \
+  do                                                                          \
+    {                                                                         \
+      u32 *_bi, _n = 0;                                                       \
+      vec_foreach (_bi, (ptd)->used)                                          \
+	{                                                                     \
+	  entry_t *e = (entry_t *) &(ptd)->tbl[*_bi];                         \
+	  if (is_add ? (match) :                                              \
+		       IPSEC_SPD_FLOW_CACHE_POLICY ((ptd)->tbl[*_bi].value) == \
+			 policy_index)                                        \
+	    clib_memset (e, 0, sizeof ((ptd)->tbl[0]));                       \
+	  else                                                                \
+	    (ptd)->used[_n++] = *_bi;                                         \
+	}                                                                     \
+      vec_set_len ((ptd)->used, _n);                                          \
+    }                                                                         \
+  while (0)
+
+static void
+ipsec_spd_flow_cache_invalidate (ipsec_main_t *im, ipsec_policy_t *p,
+				 u32 policy_index, int is_add)
+{
+  ipsec_per_thread_data_t *ptd;
+  ipsec_sa_t *sa = 0;
+
+  if (p->policy == IPSEC_POLICY_ACTION_PROTECT && INDEX_INVALID != p->sa_index)
+    sa = ipsec_sa_get (p->sa_index);
+
+  vec_foreach (ptd, im->ptd)
+    {
+      switch (p->type)
+	{
+	case IPSEC_SPD_POLICY_IP4_OUTBOUND:
+	  if (im->output_flow_cache_flag)
+	    ipsec_spd_flow_cache_walk (ptd, ipsec4_out_spd_hash_tbl,
+				       ipsec4_out_spd_hash_used,
+				       ipsec4_spd_5tuple_t,
+				       ipsec4_out_spd_flow_cache_match (p, e));
+	  break;
+	case IPSEC_SPD_POLICY_IP4_INBOUND_PROTECT:
+	case IPSEC_SPD_POLICY_IP4_INBOUND_BYPASS:
+	case IPSEC_SPD_POLICY_IP4_INBOUND_DISCARD:
+	  if (im->input_flow_cache_flag)
+	    ipsec_spd_flow_cache_walk (
+	      ptd, ipsec4_in_spd_hash_tbl, ipsec4_in_spd_hash_used,
+	      ipsec4_inbound_spd_tuple_t,
+	      ipsec4_in_spd_flow_cache_match (p, sa, e));
+	  break;
+	case IPSEC_SPD_POLICY_IP6_OUTBOUND:
+	  if (im->output6_flow_cache_flag)
+	    ipsec_spd_flow_cache_walk (ptd, ipsec6_out_spd_hash_tbl,
+				       ipsec6_out_spd_hash_used,
+				       ipsec6_spd_5tuple_t,
+				       ipsec6_out_spd_flow_cache_match (p, e));
+	  break;
+	case IPSEC_SPD_POLICY_IP6_INBOUND_PROTECT:
+	case IPSEC_SPD_POLICY_IP6_INBOUND_BYPASS:
+	case IPSEC_SPD_POLICY_IP6_INBOUND_DISCARD:
+	  if (im->input6_flow_cache_flag)
+	    ipsec_spd_flow_cache_walk (
+	      ptd, ipsec6_in_spd_hash_tbl, ipsec6_in_spd_hash_used,
+	      ipsec6_inbound_spd_tuple_t,
+	      ipsec6_in_spd_flow_cache_match (p, sa, e));
+	  break;
+	default:
+	  break;
+	}
+    }
+}
+
+u32
+ipsec_spd_flow_cache_n_entries (ipsec_main_t *im, int is_ipv6,
+				int is_outbound)
+{
+  ipsec_per_thread_data_t *ptd;
+  u32 n_entries = 0;
+
+  vec_foreach (ptd, im->ptd)
+    {
+      if (is_ipv6)
+	n_entries += is_outbound ? vec_len (ptd->ipsec6_out_spd_hash_used) :
+				   vec_len (ptd->ipsec6_in_spd_hash_used);
+      else
+	n_entries += is_outbound ? vec_len (ptd->ipsec4_out_spd_hash_used) :
+				   vec_len (ptd->ipsec4_in_spd_hash_used);
+    }
+
+  return n_entries;
+}
+
 int
 ipsec_add_del_policy (vlib_main_t * vm,
 		      ipsec_policy_t * policy, int is_add, u32 * stat_index)
@@ -122,54 +317,6 @@ ipsec_add_del_policy (vlib_main_t * vm,
   if (!spd)
     return VNET_API_ERROR_SYSCALL_ERROR_1;
 
-  if (im->output_flow_cache_flag && !policy->is_ipv6 &&
-      policy->type == IPSEC_SPD_POLICY_IP4_OUTBOUND)
-    {
-      /*
-       * Flow cache entry is valid only when epoch_count value in control
-       * plane and data plane match. Otherwise, flow cache entry is considered
-       * stale. To avoid the race condition of using old epoch_count value
-       * in data plane after the roll over of epoch_count in control plane,
-       * entire flow cache is reset.
-       */
-      if (im->epoch_count == 0xFFFFFFFF)
-	{
-	  /* Reset all the entries in flow cache */
-	  clib_memset_u8 (im->ipsec4_out_spd_hash_tbl, 0,
-			  im->ipsec4_out_spd_hash_num_buckets *
-			    (sizeof (*(im->ipsec4_out_spd_hash_tbl))));
-	}
-      /* Increment epoch counter by 1 */
-      clib_atomic_fetch_add_relax (&im->epoch_count, 1);
-      /* Reset spd flow cache counter since all old entries are stale */
-      clib_atomic_store_relax_n (&im->ipsec4_out_spd_flow_cache_entries, 0);
-    }
-
-  if ((policy->type == IPSEC_SPD_POLICY_IP4_INBOUND_PROTECT ||
-       policy->type == IPSEC_SPD_POLICY_IP4_INBOUND_BYPASS ||
-       policy->type == IPSEC_SPD_POLICY_IP4_INBOUND_DISCARD) &&
-      im->input_flow_cache_flag && !policy->is_ipv6)
-    {
-      /*
-       * Flow cache entry is valid only when input_epoch_count value in control
-       * plane and data plane match. Otherwise, flow cache entry is considered
-       * stale. To avoid the race condition of using old input_epoch_count
-       * value in data plane after the roll over of input_epoch_count in
-       * control plane, entire flow cache is reset.
-       */
-      if (im->input_epoch_count == 0xFFFFFFFF)
-	{
-	  /* Reset all the entries in flow cache */
-	  clib_memset_u8 (im->ipsec4_in_spd_hash_tbl, 0,
-			  im->ipsec4_in_spd_hash_num_buckets *
-			    (sizeof (*(im->ipsec4_in_spd_hash_tbl))));
-	}
-      /* Increment epoch counter by 1 */
-      clib_atomic_fetch_add_relax (&im->input_epoch_count, 1);
-      /* Reset spd flow cache counter since all old entries are stale */
-      im->ipsec4_in_spd_flow_cache_entries = 0;
-    }
-
   if (is_add)
     {
       u32 policy_index;
@@ -215,6 +362,8 @@ ipsec_add_del_policy (vlib_main_t * vm,
 
       vec_insert_elts (spd->policies[policy->type], &policy_index, 1, i);
 
+      ipsec_spd_flow_cache_invalidate (im, vp, policy_index, 1);
+
       *stat_index = policy_index;
     }
   else
@@ -251,6 +400,7 @@ ipsec_add_del_policy (vlib_main_t * vm,
 				spd->policies[policy->type][ii]);
 	if (ipsec_policy_is_equal (vp, policy))
 	  {
+	    ipsec_spd_flow_cache_invalidate (im, vp, vp - im->policies, 0);
 	    vec_delete (spd->policies[policy->type], 1, ii);
 	    ipsec_sa_unlock (vp->sa_index);
 	    pool_put (im->policies, vp);
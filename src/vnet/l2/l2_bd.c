@@ -61,6 +61,7 @@ bd_validate (l2_bridge_domain_t * bd_config)
   bd_config->tun_master_count = 0;
   bd_config->tun_normal_count = 0;
   bd_config->no_flood_count = 0;
+  bd_config->flood_lists = 0;
   bd_config->mac_by_ip4 = 0;
   bd_config->mac_by_ip6 = hash_create_mem (0, sizeof (ip6_address_t),
 					   sizeof (uword));
@@ -109,6 +110,16 @@ bd_free_ip_mac_tables (l2_bridge_domain_t * bd)
   hash_free (bd->mac_by_ip6);
 }
 
+static void
+bd_free_flood_lists (l2_bridge_domain_t * bd_config)
+{
+  u32 **list;
+
+  vec_foreach (list, bd_config->flood_lists)
+    vec_free (*list);
+  vec_free (bd_config->flood_lists);
+}
+
 static int
 bd_delete (bd_main_t * bdm, u32 bd_index)
 {
@@ -133,11 +144,47 @@ bd_delete (bd_main_t * bdm, u32 bd_index)
 
   /* free memory used by BD */
   vec_free (bd->members);
+  bd_free_flood_lists (bd);
   bd_free_ip_mac_tables (bd);
 
   return 0;
 }
 
+/*
+ * Precompute, for each split horizon group from 0 to the highest in use,
+ * the interfaces a packet received in that group is flooded to, so that
+ * l2-flood does not have to walk and filter the member vector for every
+ * packet. Group 0 (no group) floods to all members; the lists walk the
+ * flooded members in reverse so that the BVI comes last. Groups above
+ * the highest are served group 0's list by bd_flood_list().
+ */
+static void
+update_flood_lists (l2_bridge_domain_t * bd_config)
+{
+  l2_flood_member_t *member;
+  u32 shg, max_shg = 0;
+  i32 mi;
+
+  for (mi = 0; mi < (i32) bd_config->flood_count; mi++)
+    max_shg = clib_max (max_shg, bd_config->members[mi].shg);
+
+  bd_free_flood_lists (bd_config);
+  vec_validate (bd_config->flood_lists, max_shg);
+
+  for (shg = 0; shg <= max_shg; shg++)
+    {
+      u32 *list = 0;
+
+      for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
+	{
+	  member = &bd_config->members[mi];
+	  if (shg == 0 || member->shg != shg)
+	    vec_add1 (list, member->sw_if_index);
+	}
+      bd_config->flood_lists[shg] = list;
+    }
+}
+
 static void
 update_flood_count (l2_bridge_domain_t * bd_config)
 {
@@ -145,6 +192,7 @@ update_flood_count (l2_bridge_domain_t * bd_config)
 			    (bd_config->tun_master_count ?
 			     bd_config->tun_normal_count : 0));
   bd_config->flood_count -= bd_config->no_flood_count;
+  update_flood_lists (bd_config);
 }
 
 void
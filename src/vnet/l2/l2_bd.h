@@ -98,6 +98,12 @@ typedef struct
   /* Interface on which packets are not flooded */
   u32 no_flood_count;
 
+  /*
+   * Flood replication lists, indexed by the split horizon group of the
+   * input interface. Rebuilt whenever the members change.
+   */
+  u32 **flood_lists;
+
   /* hash ip4/ip6 -> mac for arp/nd termination */
   uword *mac_by_ip4;
   uword *mac_by_ip6;
@@ -151,6 +157,22 @@ bd_add_member (l2_bridge_domain_t * bd_config, l2_flood_member_t * member);
 
 u32 bd_remove_member (l2_bridge_domain_t * bd_config, u32 sw_if_index);
 
+/**
+ * Get the flood list for packets received in split horizon group shg.
+ * The list holds the sw_if_index of each member to flood to, with the
+ * members of group shg left out, in the order the copies are sent; the
+ * BVI, if flooded, is last. Every group up to the highest one in use has
+ * a list of its own, even if it has no flooded members; a group above
+ * that has none, so it floods like group 0 and gets group 0's list.
+ */
+always_inline u32 *
+bd_flood_list (l2_bridge_domain_t * bd_config, u8 shg)
+{
+  if (shg < vec_len (bd_config->flood_lists))
+    return bd_config->flood_lists[shg];
+  return vec_len (bd_config->flood_lists) ? bd_config->flood_lists[0] : 0;
+}
+
 typedef enum bd_flags_t_
 {
   L2_NONE = 0,
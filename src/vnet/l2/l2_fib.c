@@ -316,6 +316,35 @@ show_l2fib (vlib_main_t * vm,
 		       "Last scan time: %.4esec  Learn limit: %d ",
 		       ctx.total_entries, lm->global_learn_count,
 		       msm->age_scan_duration, lm->global_learn_limit);
+      l2learn_per_thread_t *ptd;
+      u64 n_batches = 0, n_applied = 0, n_refreshed = 0, clocks = 0;
+      u64 max_clocks = 0, n_handed_off = 0, n_handoffs = 0, latency = 0;
+      u64 max_latency = 0;
+
+      vec_foreach (ptd, lm->per_thread)
+	{
+	  n_batches += ptd->n_batches;
+	  n_applied += ptd->n_applied;
+	  n_refreshed += ptd->n_refreshed;
+	  clocks += ptd->apply_clocks;
+	  max_clocks = clib_max (max_clocks, ptd->max_apply_clocks);
+	  n_handed_off += ptd->n_handed_off;
+	  n_handoffs += ptd->n_handoff_batches;
+	  latency += ptd->latency_clocks;
+	  max_latency = clib_max (max_latency, ptd->max_latency_clocks);
+	}
+      if (n_batches)
+	vlib_cli_output (vm, "L2 learn updates: %llu in %llu batches, "
+			 "%llu refreshed in place  Apply time: %.0f clocks "
+			 "per update, %llu max per batch",
+			 n_applied, n_batches, n_refreshed,
+			 (f64) clocks / n_applied, max_clocks);
+      if (n_handoffs)
+	vlib_cli_output (vm, "L2 learns added by the main thread: %llu in "
+			 "%llu batches  Learn latency: %.0f clocks mean, "
+			 "%llu max per batch",
+			 n_handed_off, n_handoffs, (f64) latency / n_handoffs,
+			 max_latency);
       if (lm->client_pid)
 	vlib_cli_output (vm, "L2MAC events client PID: %d  "
 			 "Last e-scan time: %.4esec  Delay: %.2esec  "
@@ -358,6 +387,55 @@ VLIB_CLI_COMMAND (show_l2fib_cli, static) = {
   .function = show_l2fib,
 };
 
+/**
+ * Update the age and sequence number of an entry in place, without
+ * taking the bucket lock. The result is swapped only if the entry still
+ * holds old_result. Fails, and the caller falls back to an add, if the
+ * entry changed or its bucket was split or locked meanwhile.
+ */
+int
+l2fib_entry_refresh (BVT (clib_bihash) * mac_table, u64 key,
+		     u64 old_result, u64 new_result)
+{
+  BVT (clib_bihash_bucket) * b, localb;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_kv) kv = {.key = key };
+  u64 hash;
+  int i, limit;
+
+  hash = BV (clib_bihash_hash) (&kv);
+  b = BV (clib_bihash_get_bucket) (mac_table, hash);
+  localb.as_u64 = clib_atomic_load_acq_n (&b->as_u64);
+
+  if (localb.lock || BV (clib_bihash_bucket_is_empty) (&localb))
+    return -1;
+
+  v = BV (clib_bihash_get_value) (mac_table, localb.offset);
+  limit = BIHASH_KVP_PER_PAGE;
+  if (localb.linear_search)
+    limit <<= localb.log2_pages;
+  else
+    v += extract_bits (hash, mac_table->log2_nbuckets, localb.log2_pages);
+
+  for (i = 0; i < limit; i++)
+    {
+      if (v->kvp[i].key != key)
+	continue;
+
+      if (!clib_atomic_bool_cmp_and_swap (&v->kvp[i].value, old_result,
+					  new_result))
+	return -1;
+
+      /* a split may have copied the page before the swap */
+      if (clib_atomic_load_acq_n (&b->as_u64) != localb.as_u64)
+	return -1;
+
+      return 0;
+    }
+
+  return -1;
+}
+
 void
 l2fib_table_init (void)
 {
@@ -439,6 +439,9 @@ l2fib_add_filter_entry (const u8 * mac, u32 bd_index)
 
 u32 l2fib_del_entry (const u8 * mac, u32 bd_index, u32 sw_if_index);
 
+int l2fib_entry_refresh (BVT (clib_bihash) * mac_table, u64 key,
+			 u64 old_result, u64 new_result);
+
 void l2fib_start_ager_scan (vlib_main_t * vm);
 
 void l2fib_flush_int_mac (vlib_main_t * vm, u32 sw_if_index);
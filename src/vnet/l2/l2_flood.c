@@ -32,15 +32,10 @@
  * @file
  * @brief Ethernet Flooding.
  *
- * Flooding uses the packet replication infrastructure to send a copy of the
- * packet to each member interface. Logically the replication infrastructure
- * expects two graph nodes: a prep node that initiates replication and sends the
- * packet to the first destination, and a recycle node that is passed the packet
- * after it has been transmitted.
- *
- * To decrease the amount of code, l2 flooding implements both functions in
- * the same graph node. This node can tell if is it being called as the "prep"
- * or "recycle" using replication_is_recycled().
+ * Flooding clones the packet once for each interface on the bridge
+ * domain's flood list for the input split horizon group, see
+ * bd_flood_list(). Clones copy only the packet head and share the
+ * payload with the original.
  */
 
 
@@ -57,9 +52,9 @@ typedef struct
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
 
-  /* per-cpu vector of cloned packets */
+  /* per-cpu vectors of cloned packets and their next nodes */
   u32 **clones;
-  l2_flood_member_t ***members;
+  u16 **nexts;
 } l2flood_main_t;
 
 typedef struct
@@ -120,207 +115,149 @@ typedef enum
   L2FLOOD_N_NEXT,
 } l2flood_next_t;
 
+always_inline void
+l2flood_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
+	       vlib_buffer_t * c0, u32 sw_if_index0)
+{
+  ethernet_header_t *h0;
+  l2flood_trace_t *t;
+
+  t = vlib_add_trace (vm, node, c0, sizeof (*t));
+  h0 = vlib_buffer_get_current (c0);
+  t->sw_if_index = sw_if_index0;
+  t->bd_index = vnet_buffer (c0)->l2.bd_index;
+  clib_memcpy_fast (t->src, h0->src_address, 6);
+  clib_memcpy_fast (t->dst, h0->dst_address, 6);
+}
+
 /*
- * Perform flooding on one packet
+ * Perform flooding
  *
  * Due to the way BVI processing can modify the packet, the BVI interface
- * (if present) must be processed last in the replication. The member vector
- * is arranged so that the BVI interface is always the first element.
- * Flooding walks the vector in reverse.
+ * (if present) must be processed last in the replication. The bridge
+ * domain's flood lists are arranged so that the BVI interface is always
+ * the last element.
  *
  * BVI processing causes the packet to go to L3 processing. This strips the
- * L2 header, which is fine because the replication infrastructure restores
- * it. However L3 processing can trigger larger changes to the packet. For
- * example, an ARP request could be turned into an ARP reply, an ICMP request
- * could be turned into an ICMP reply. If BVI processing is not performed
- * last, the modified packet would be replicated to the remaining members.
+ * L2 header. However L3 processing can trigger larger changes to the
+ * packet. For example, an ARP request could be turned into an ARP reply, an
+ * ICMP request could be turned into an ICMP reply. Each clone has a private
+ * copy of the first VLIB_BUFFER_CLONE_HEAD_SIZE bytes, which covers the
+ * headers BVI processing may touch, and shares the rest of the payload with
+ * the other clones.
+ *
+ * The clones of all packets in the frame, with their next nodes, are
+ * collected and then enqueued in bulk.
  */
 VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 			     vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, *to_next;
-  l2flood_next_t next_index;
+  u32 n_left_from, *from, **clones;
   l2flood_main_t *msm = &l2flood_main;
   clib_thread_index_t thread_index = vm->thread_index;
+  u16 **nexts;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+
+  clones = &msm->clones[thread_index];
+  nexts = &msm->nexts[thread_index];
 
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      u16 n_clones, n_cloned, clone0;
+      l2_bridge_domain_t *bd_config;
+      u32 sw_if_index0, bi0, ci0, skip0;
+      u32 *flood_list, *to_clone, mi;
+      vlib_buffer_t *b0, *c0;
+      u16 *to_next;
+      u8 in_shg;
+
+      bi0 = from[0];
+      from += 1;
+      n_left_from -= 1;
+
+      b0 = vlib_get_buffer (vm, bi0);
+
+      /* Get config for the bridge domain interface */
+      bd_config = vec_elt_at_index (l2input_main.bd_configs,
+				    vnet_buffer (b0)->l2.bd_index);
+      in_shg = vnet_buffer (b0)->l2.shg;
+      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+
+      /*
+       * The list already leaves out the input's split horizon group. With
+       * no group the input interface itself is in the list and must not
+       * be flooded back to.
+       */
+      flood_list = bd_flood_list (bd_config, in_shg);
+      n_clones = vec_len (flood_list);
+      skip0 = ~0;
+
+      if (0 == in_shg)
 	{
-	  u16 n_clones, n_cloned, clone0;
-	  l2_bridge_domain_t *bd_config;
-	  u32 sw_if_index0, bi0, ci0;
-	  l2_flood_member_t *member;
-	  vlib_buffer_t *b0, *c0;
-	  u16 next0;
-	  u8 in_shg;
-	  i32 mi;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  next0 = L2FLOOD_NEXT_L2_OUTPUT;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  /* Get config for the bridge domain interface */
-	  bd_config = vec_elt_at_index (l2input_main.bd_configs,
-					vnet_buffer (b0)->l2.bd_index);
-	  in_shg = vnet_buffer (b0)->l2.shg;
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-
-	  vec_validate (msm->members[thread_index],
-			vec_len (bd_config->members));
-
-	  vec_reset_length (msm->members[thread_index]);
-
-	  /* Find first members that passes the reflection and SHG checks */
-	  for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
-	    {
-	      member = &bd_config->members[mi];
-	      if ((member->sw_if_index != sw_if_index0) &&
-		  (!in_shg || (member->shg != in_shg)))
-		{
-		  vec_add1 (msm->members[thread_index], member);
-		}
-	    }
-
-	  n_clones = vec_len (msm->members[thread_index]);
-
-	  if (0 == n_clones)
-	    {
-	      /* No members to flood to */
-	      to_next[0] = bi0;
-	      to_next += 1;
-	      n_left_to_next -= 1;
-
-	      b0->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
-	      vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					       to_next, n_left_to_next,
-					       bi0, L2FLOOD_NEXT_DROP);
-	      continue;
-	    }
-	  else if (n_clones > 1)
-	    {
-	      vec_validate (msm->clones[thread_index], n_clones);
-
-	      /*
-	       * the header offset needs to be large enough to incorporate
-	       * all the L3 headers that could be touched when doing BVI
-	       * processing. So take the current l2 length plus 2 * IPv6
-	       * headers (for tunnel encap)
-	       */
-	      n_cloned = vlib_buffer_clone (vm, bi0,
-					    msm->clones[thread_index],
-					    n_clones,
-					    VLIB_BUFFER_CLONE_HEAD_SIZE);
-
-	      vec_set_len (msm->clones[thread_index], n_cloned);
-
-	      if (PREDICT_FALSE (n_cloned != n_clones))
-		{
-		  b0->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
-		  /* Worst-case, no clones, consume the original buf */
-		  if (n_cloned == 0)
-		    {
-		      ci0 = bi0;
-		      member = msm->members[thread_index][0];
-		      goto use_original_buffer;
-		    }
-		}
-
-	      /*
-	       * for all but the last clone, these are not BVI bound
-	       */
-	      for (clone0 = 0; clone0 < n_cloned - 1; clone0++)
-		{
-		  member = msm->members[thread_index][clone0];
-		  ci0 = msm->clones[thread_index][clone0];
-		  c0 = vlib_get_buffer (vm, ci0);
+	  for (mi = 0; mi < n_clones; mi++)
+	    if (flood_list[mi] == sw_if_index0)
+	      {
+		skip0 = mi;
+		n_clones -= 1;
+		break;
+	      }
+	}
 
-		  to_next[0] = ci0;
-		  to_next += 1;
-		  n_left_to_next -= 1;
+      if (0 == n_clones)
+	{
+	  /* No members to flood to */
+	  b0->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
+	  vec_add1 (*clones, bi0);
+	  vec_add1 (*nexts, L2FLOOD_NEXT_DROP);
+	  continue;
+	}
 
-		  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
-				     (b0->flags & VLIB_BUFFER_IS_TRACED)))
-		    {
-		      ethernet_header_t *h0;
-		      l2flood_trace_t *t;
-
-		      t = vlib_add_trace (vm, node, c0, sizeof (*t));
-		      h0 = vlib_buffer_get_current (c0);
-		      t->sw_if_index = sw_if_index0;
-		      t->bd_index = vnet_buffer (c0)->l2.bd_index;
-		      clib_memcpy_fast (t->src, h0->src_address, 6);
-		      clib_memcpy_fast (t->dst, h0->dst_address, 6);
-		    }
+      mi = vec_len (*clones);
+      vec_add2 (*clones, to_clone, n_clones);
+      vec_add2 (*nexts, to_next, n_clones);
 
-		  /* Do normal L2 forwarding */
-		  vnet_buffer (c0)->sw_if_index[VLIB_TX] =
-		    member->sw_if_index;
+      n_cloned = vlib_buffer_clone (vm, bi0, to_clone, n_clones,
+				    VLIB_BUFFER_CLONE_HEAD_SIZE);
 
-		  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-						   to_next, n_left_to_next,
-						   ci0, next0);
-		  if (PREDICT_FALSE (0 == n_left_to_next))
-		    {
-		      vlib_put_next_frame (vm, node, next_index,
-					   n_left_to_next);
-		      vlib_get_next_frame (vm, node, next_index, to_next,
-					   n_left_to_next);
-		    }
-		}
-	      member = msm->members[thread_index][clone0];
-	      ci0 = msm->clones[thread_index][clone0];
-	    }
-	  else
+      if (PREDICT_FALSE (n_cloned != n_clones))
+	{
+	  b0->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
+	  /* Worst-case, no clones, consume the original buf */
+	  if (n_cloned == 0)
 	    {
-	      /* one clone */
-	      ci0 = bi0;
-	      member = msm->members[thread_index][0];
+	      to_clone[0] = bi0;
+	      n_cloned = 1;
 	    }
+	  vec_set_len (*clones, mi + n_cloned);
+	  vec_set_len (*nexts, mi + n_cloned);
+	}
 
-	use_original_buffer:
-	  /*
-	   * the last clone that might go to a BVI
-	   */
-	  c0 = vlib_get_buffer (vm, ci0);
+      for (clone0 = 0, mi = 0; clone0 < n_cloned; clone0++, mi++)
+	{
+	  u32 member_sw_if_index;
 
-	  to_next[0] = ci0;
-	  to_next += 1;
-	  n_left_to_next -= 1;
+	  if (PREDICT_FALSE (mi == skip0))
+	    mi++;
+	  member_sw_if_index = flood_list[mi];
+	  ci0 = to_clone[clone0];
+	  c0 = vlib_get_buffer (vm, ci0);
 
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
 			     (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      ethernet_header_t *h0;
-	      l2flood_trace_t *t;
-
-	      t = vlib_add_trace (vm, node, c0, sizeof (*t));
-	      h0 = vlib_buffer_get_current (c0);
-	      t->sw_if_index = sw_if_index0;
-	      t->bd_index = vnet_buffer (c0)->l2.bd_index;
-	      clib_memcpy_fast (t->src, h0->src_address, 6);
-	      clib_memcpy_fast (t->dst, h0->dst_address, 6);
-	    }
+	    l2flood_trace (vm, node, c0, sw_if_index0);
+
 	  /* Forward packet to the current member */
-	  if (PREDICT_FALSE (member->flags & L2_FLOOD_MEMBER_BVI))
+	  if (PREDICT_FALSE (member_sw_if_index == bd_config->bvi_sw_if_index))
 	    {
 	      /* Do BVI processing */
 	      u32 rc;
+	      u16 next0;
+
 	      rc = l2_to_bvi (vm,
 			      msm->vnet_main,
-			      c0, member->sw_if_index, &msm->l3_next, &next0);
+			      c0, member_sw_if_index, &msm->l3_next, &next0);
 
 	      if (PREDICT_FALSE (rc != TO_BVI_ERR_OK))
 		{
@@ -334,25 +271,35 @@ VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 		    }
 		  next0 = L2FLOOD_NEXT_DROP;
 		}
+	      to_next[clone0] = next0;
 	    }
 	  else
 	    {
 	      /* Do normal L2 forwarding */
-	      vnet_buffer (c0)->sw_if_index[VLIB_TX] = member->sw_if_index;
+	      vnet_buffer (c0)->sw_if_index[VLIB_TX] = member_sw_if_index;
+	      to_next[clone0] = L2FLOOD_NEXT_L2_OUTPUT;
 	    }
+	}
 
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   ci0, next0);
-	  if (PREDICT_FALSE (0 == n_left_to_next))
-	    {
-	      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-	      vlib_get_next_frame (vm, node, next_index,
-				   to_next, n_left_to_next);
-	    }
+      /*
+       * don't let the pending set grow unbounded for bridge domains with
+       * many members
+       */
+      if (vec_len (*clones) >= VLIB_FRAME_SIZE)
+	{
+	  vlib_buffer_enqueue_to_next_vec (vm, node, clones, nexts,
+					   vec_len (*clones));
+	  vec_reset_length (*clones);
+	  vec_reset_length (*nexts);
 	}
+    }
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+  if (vec_len (*clones))
+    {
+      vlib_buffer_enqueue_to_next_vec (vm, node, clones, nexts,
+				       vec_len (*clones));
+      vec_reset_length (*clones);
+      vec_reset_length (*nexts);
     }
 
   vlib_node_increment_counter (vm, node->node_index,
@@ -390,7 +337,7 @@ l2flood_init (vlib_main_t * vm)
   mp->vnet_main = vnet_get_main ();
 
   vec_validate (mp->clones, vlib_num_workers ());
-  vec_validate (mp->members, vlib_num_workers ());
+  vec_validate (mp->nexts, vlib_num_workers ());
 
   /* Initialize the feature next-node indexes */
   feat_bitmap_init_next_nodes (vm,
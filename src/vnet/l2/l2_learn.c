@@ -82,7 +82,10 @@ _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
-_(FILTER_DROP,       "L2 filter mac drops")
+_(FILTER_DROP,       "L2 filter mac drops")		\
+_(COALESCED,         "L2 learn events coalesced")	\
+_(REFRESH,           "L2 learn in-place age refreshes")	\
+_(HANDOFF,           "L2 learns handed to the writer")
 
 typedef enum
 {
@@ -106,25 +109,142 @@ typedef enum
 } l2learn_next_t;
 
 
+/**
+ * Queue an update of the mac table. A second update of the same mac in
+ * the frame replaces the first, so each mac is written once per frame.
+ */
+static_always_inline void
+l2learn_queue_event (l2learn_per_thread_t * ptd, u64 * counter_base,
+		     l2fib_entry_key_t * key0, l2fib_entry_result_t * result0,
+		     u64 table_result)
+{
+  l2learn_event_t *e;
+  uword *p;
+
+  p = hash_get (ptd->event_by_key, key0->raw);
+  if (p)
+    {
+      e = vec_elt_at_index (ptd->events, p[0]);
+      e->result = result0->raw;
+      /* only a refresh of a refresh can still be done in place */
+      if (table_result == ~0ULL)
+	e->table_result = ~0ULL;
+      counter_base[L2LEARN_ERROR_COALESCED] += 1;
+      return;
+    }
+
+  hash_set (ptd->event_by_key, key0->raw, vec_len (ptd->events));
+  vec_add2 (ptd->events, e, 1);
+  e->key = key0->raw;
+  e->result = result0->raw;
+  e->table_result = table_result;
+}
+
+/**
+ * Apply the queued updates to the mac table. Age refreshes are written
+ * in place. Learns and moves are added by the main thread, the single
+ * writer of the table: a worker stages them and wakes l2-learn-apply up.
+ * Until then packets to a new mac are flooded, as they were before it
+ * was learned, and the worker finds the staged result in its pending
+ * table rather than learning the mac again.
+ */
+static_always_inline void
+l2learn_apply_events (vlib_main_t * vm, l2learn_main_t * msm,
+		      l2learn_per_thread_t * ptd, u64 * counter_base)
+{
+  BVT (clib_bihash_kv) kv;
+  l2learn_event_t *e;
+  u32 n_staged = 0, i;
+  u64 t0, dt;
+
+  t0 = clib_cpu_time_now ();
+
+  vec_foreach (e, ptd->events)
+    {
+      hash_unset (ptd->event_by_key, e->key);
+
+      if (e->table_result != ~0ULL &&
+	  0 == l2fib_entry_refresh (msm->mac_table, e->key, e->table_result,
+				    e->result))
+	{
+	  counter_base[L2LEARN_ERROR_REFRESH] += 1;
+	  ptd->n_refreshed++;
+	  continue;
+	}
+
+      /* the main thread is the writer, it adds its own learns */
+      if (vm->thread_index == 0)
+	{
+	  kv.key = e->key;
+	  kv.value = e->result;
+	  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+	  continue;
+	}
+
+      /* compact the learns to stage at the front */
+      ptd->events[n_staged++] = *e;
+    }
+
+  if (n_staged)
+    {
+      clib_spinlock_lock (&ptd->staged_lock);
+      if (vec_len (ptd->staged) == 0)
+	ptd->staged_time = t0;
+      vec_add (ptd->staged, ptd->events, n_staged);
+      ptd->staged_seq++;
+      clib_spinlock_unlock (&ptd->staged_lock);
+
+      for (i = 0; i < n_staged; i++)
+	hash_set (ptd->pending, ptd->events[i].key, ptd->events[i].result);
+
+      counter_base[L2LEARN_ERROR_HANDOFF] += n_staged;
+      vlib_node_set_interrupt_pending (vlib_get_main_by_index (0),
+				       l2learn_apply_node.index);
+    }
+
+  dt = clib_cpu_time_now () - t0;
+  ptd->n_batches++;
+  ptd->n_applied += vec_len (ptd->events);
+  ptd->apply_clocks += dt;
+  ptd->max_apply_clocks = clib_max (ptd->max_apply_clocks, dt);
+
+  vec_reset_length (ptd->events);
+}
+
 /** Perform learning on one packet based on the mac table lookup result. */
 
 static_always_inline void
 l2learn_process (vlib_node_runtime_t * node,
 		 l2learn_main_t * msm,
+		 l2learn_per_thread_t * ptd,
 		 u64 * counter_base,
 		 vlib_buffer_t * b0,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
-		 l2fib_entry_key_t * cached_key,
 		 u32 * count,
 		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp)
 {
   l2_bridge_domain_t *bd_config =
     vec_elt_at_index (l2input_main.bd_configs, vnet_buffer (b0)->l2.bd_index);
+  u64 table_result = result0->raw;
+
   /* Set up the default next node (typically L2FWD) */
   *next0 = vnet_l2_feature_next (b0, msm->feat_next_node_index,
 				 L2INPUT_FEAT_LEARN);
 
+  /*
+   * An update queued earlier in the frame, or staged for the writer and
+   * not added yet, is newer than the table
+   */
+  if (PREDICT_FALSE (vec_len (ptd->events) != 0 || ptd->pending != 0))
+    {
+      uword *p = hash_get (ptd->event_by_key, key0->raw);
+      if (p)
+	result0->raw = ptd->events[p[0]].result;
+      else if ((p = hash_get (ptd->pending, key0->raw)))
+	result0->raw = p[0];
+    }
+
   /* Check mac table lookup result */
   if (PREDICT_TRUE (result0->fields.sw_if_index == sw_if_index0))
     {
@@ -213,6 +333,7 @@ l2learn_process (vlib_node_runtime_t * node,
        * TODO: may want to rate limit mac moves
        * TODO: check global/bridge domain/interface learn limits
        */
+      table_result = ~0ULL;
       result0->fields.sw_if_index = sw_if_index0;
       if (l2fib_entry_result_is_set_AGE_NOT (result0))
 	{
@@ -240,13 +361,7 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn = vnet_buffer (b0)->l2.l2fib_sn;
 
-  BVT (clib_bihash_kv) kv;
-  kv.key = key0->raw;
-  kv.value = result0->raw;
-  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
-
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  l2learn_queue_event (ptd, counter_base, key0, result0, table_result);
 }
 
 
@@ -259,6 +374,8 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_node_t *n = vlib_get_node (vm, l2learn_node.index);
   u32 node_counter_base_index = n->error_heap_index;
   vlib_error_main_t *em = &vm->error_main;
+  l2learn_per_thread_t *ptd =
+    vec_elt_at_index (msm->per_thread, vm->thread_index);
   l2fib_entry_key_t cached_key;
   l2fib_entry_result_t cached_result;
   u8 timestamp = (u8) (vlib_time_now (vm) / 60);
@@ -276,6 +393,11 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   cached_key.raw = ~0;
   cached_result.raw = ~0;	/* warning be gone */
 
+  /* the writer added everything staged so far */
+  if (PREDICT_FALSE (ptd->pending != 0) &&
+      clib_atomic_load_acq_n (&ptd->applied_seq) == ptd->staged_seq)
+    hash_free (ptd->pending);
+
   while (n_left > 8)
     {
       u32 sw_if_index0, sw_if_index1, sw_if_index2, sw_if_index3;
@@ -367,21 +489,24 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      &key0, &key1, &key2, &key3,
 		      &result0, &result1, &result2, &result3);
 
-      l2learn_process (node, msm, &em->counters[node_counter_base_index],
-		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+      l2learn_process (node, msm, ptd,
+		       &em->counters[node_counter_base_index], b[0],
+		       sw_if_index0, &key0, &count, &result0, next, timestamp);
 
-      l2learn_process (node, msm, &em->counters[node_counter_base_index],
-		       b[1], sw_if_index1, &key1, &cached_key,
-		       &count, &result1, next + 1, timestamp);
+      l2learn_process (node, msm, ptd,
+		       &em->counters[node_counter_base_index], b[1],
+		       sw_if_index1, &key1, &count, &result1, next + 1,
+		       timestamp);
 
-      l2learn_process (node, msm, &em->counters[node_counter_base_index],
-		       b[2], sw_if_index2, &key2, &cached_key,
-		       &count, &result2, next + 2, timestamp);
+      l2learn_process (node, msm, ptd,
+		       &em->counters[node_counter_base_index], b[2],
+		       sw_if_index2, &key2, &count, &result2, next + 2,
+		       timestamp);
 
-      l2learn_process (node, msm, &em->counters[node_counter_base_index],
-		       b[3], sw_if_index3, &key3, &cached_key,
-		       &count, &result3, next + 3, timestamp);
+      l2learn_process (node, msm, ptd,
+		       &em->counters[node_counter_base_index], b[3],
+		       sw_if_index3, &key3, &count, &result3, next + 3,
+		       timestamp);
 
       next += 4;
       b += 4;
@@ -417,15 +542,19 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      h0->src_address, vnet_buffer (b[0])->l2.bd_index,
 		      &key0, &result0);
 
-      l2learn_process (node, msm, &em->counters[node_counter_base_index],
-		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+      l2learn_process (node, msm, ptd,
+		       &em->counters[node_counter_base_index], b[0],
+		       sw_if_index0, &key0, &count, &result0, next, timestamp);
 
       next += 1;
       b += 1;
       n_left -= 1;
     }
 
+  if (vec_len (ptd->events))
+    l2learn_apply_events (vm, msm, ptd,
+			  &em->counters[node_counter_base_index]);
+
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
 
   return frame->n_vectors;
@@ -458,10 +587,71 @@ VLIB_REGISTER_NODE (l2learn_node) = {
 };
 
 #ifndef CLIB_MARCH_VARIANT
+/**
+ * The single writer of learned macs: add the learns and moves the workers
+ * staged. Runs on the main thread when a worker raises its interrupt.
+ */
+static uword
+l2learn_apply_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+		       vlib_frame_t * frame)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  l2learn_per_thread_t *ptd, *wptd;
+  BVT (clib_bihash_kv) kv;
+  l2learn_event_t *e, *events;
+  u64 staged_time, dt;
+  u32 seq;
+
+  wptd = vec_elt_at_index (msm->per_thread, vm->thread_index);
+
+  vec_foreach (ptd, msm->per_thread)
+    {
+      /* hand the thread an empty vector and take its staged learns */
+      clib_spinlock_lock (&ptd->staged_lock);
+      events = ptd->staged;
+      ptd->staged = msm->apply_events;
+      msm->apply_events = events;
+      staged_time = ptd->staged_time;
+      seq = ptd->staged_seq;
+      clib_spinlock_unlock (&ptd->staged_lock);
+
+      if (vec_len (events) == 0)
+	continue;
+
+      vec_foreach (e, events)
+	{
+	  kv.key = e->key;
+	  kv.value = e->result;
+	  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+	}
+
+      /* the thread may forget what it staged up to here */
+      clib_atomic_store_rel_n (&ptd->applied_seq, seq);
+
+      dt = clib_cpu_time_now () - staged_time;
+      wptd->n_handed_off += vec_len (events);
+      wptd->n_handoff_batches++;
+      wptd->latency_clocks += dt;
+      wptd->max_latency_clocks = clib_max (wptd->max_latency_clocks, dt);
+
+      vec_reset_length (msm->apply_events);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (l2learn_apply_node) = {
+  .function = l2learn_apply_node_fn,
+  .name = "l2-learn-apply",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+};
+
 clib_error_t *
 l2learn_init (vlib_main_t * vm)
 {
   l2learn_main_t *mp = &l2learn_main;
+  l2learn_per_thread_t *ptd;
 
   mp->vlib_main = vm;
   mp->vnet_main = vnet_get_main ();
@@ -476,6 +666,11 @@ l2learn_init (vlib_main_t * vm)
   /* init the hash table ptr */
   mp->mac_table = get_mac_table ();
 
+  vec_validate_aligned (mp->per_thread, vlib_num_workers (),
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, mp->per_thread)
+    clib_spinlock_init (&ptd->staged_lock);
+
   /*
    * Set the default number of dynamically learned macs to the number
    * of buckets.
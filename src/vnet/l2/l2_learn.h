@@ -20,15 +20,85 @@
 
 #include <vlib/vlib.h>
 #include <vppinfra/bihash_8_8.h>
+#include <vppinfra/lock.h>
 #include <vnet/ethernet/ethernet.h>
 
 
+/**
+ * A learn, move or age refresh of one mac, waiting for the end of the
+ * frame to be applied to the mac table.
+ */
+typedef struct
+{
+  u64 key;
+  u64 result;
+  /* entry as found in the table for an in-place age refresh, else ~0 */
+  u64 table_result;
+} l2learn_event_t;
+
+/**
+ * Learns and moves are added to the mac table by a single writer, the
+ * main thread, so workers learning at the same time don't contend on the
+ * bihash locks. Workers stage them, the l2-learn-apply node on the main
+ * thread adds them. Age refreshes are still written in place by the
+ * worker, without a lock.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* events of the current frame, one per mac */
+  l2learn_event_t *events;
+
+  /* index in events by mac table key */
+  uword *event_by_key;
+
+  /* result by key of the learns staged but not yet known to be added,
+     so later frames don't learn them again */
+  uword *pending;
+
+  /* statistics */
+  u64 n_batches;
+  u64 n_applied;
+  u64 n_refreshed;
+  u64 apply_clocks;
+  u64 max_apply_clocks;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+
+  /* shared with the writer */
+  clib_spinlock_t staged_lock;
+
+  /* learns and moves waiting for the writer */
+  l2learn_event_t *staged;
+
+  /* when the oldest staged learn was staged */
+  u64 staged_time;
+
+  /* batches staged, and staged batches added to the table */
+  u32 staged_seq;
+  u32 applied_seq;
+
+  /* writer statistics, on the main thread's queue, the latency is from
+     the oldest learn of a staged batch being staged to the batch added */
+  u64 n_handed_off;
+  u64 n_handoff_batches;
+  u64 latency_clocks;
+  u64 max_latency_clocks;
+} l2learn_per_thread_t;
+
 typedef struct
 {
 
   /* Hash table */
   BVT (clib_bihash) * mac_table;
 
+  /* per thread learn queues */
+  l2learn_per_thread_t *per_thread;
+
+  /* staged learns waiting to be added, swapped with a thread's staged */
+  l2learn_event_t *apply_events;
+
   /* number of dynamically learned mac entries */
   u32 global_learn_count;
 
@@ -55,6 +125,7 @@ typedef struct
 extern l2learn_main_t l2learn_main;
 
 extern vlib_node_registration_t l2fib_mac_age_scanner_process_node;
+extern vlib_node_registration_t l2learn_apply_node;
 
 typedef enum
 {
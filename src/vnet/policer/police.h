@@ -66,6 +66,11 @@ typedef enum
 // The lock field should be used for a spin-lock on the struct. Alternatively,
 // a thread index field is provided so that policed packets may be handed
 // off to a single worker thread.
+//
+// A distributed policer is not tied to a thread. Each worker instead draws
+// conform tokens from the buckets in batches, under a per-policer lock, and
+// spends them locally. The burst error is bounded by one batch per worker.
+// A policer bound to a worker can't be distributed until it is unbound.
 
 #define POLICER_TICKS_PER_PERIOD_SHIFT 17
 #define POLICER_TICKS_PER_PERIOD       (1 << POLICER_TICKS_PER_PERIOD_SHIFT)
@@ -78,7 +83,8 @@ typedef struct
   u32 scale;			// power-of-2 shift amount for lower rates
   qos_action_type_en action[3];
   ip_dscp_t mark_dscp[3];
-  u8 pad[2];
+  u8 distributed;		// police on every worker against local credit
+  u8 bound;			// thread_index set by policer_bind_worker
 
   // Fields are marked as 2R if they are only used for a 2-rate policer,
   // and MOD if they are modified as part of the update operation.
@@ -16,6 +16,7 @@
 #define __POLICE_INLINES_H__
 
 #include <vnet/policer/police.h>
+#include <vnet/policer/policer.h>
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 
@@ -55,6 +56,56 @@ vnet_policer_mark (vlib_buffer_t *b, ip_dscp_t dscp)
     }
 }
 
+/*
+ * Fraction of the committed burst a worker may draw into local credit in one
+ * go. Together with the number of workers this bounds the burst error of a
+ * distributed policer.
+ */
+#define POLICER_CREDIT_BATCH_SHIFT 4
+
+static_always_inline policer_result_e
+vnet_policer_police_distributed (vnet_policer_main_t *pm, policer_t *pol,
+				 u32 policer_index,
+				 clib_thread_index_t thread_index, u32 len,
+				 policer_result_e packet_color, u64 time)
+{
+  policer_result_e col;
+  u32 *credit, batch;
+
+  credit = &pm->credits[thread_index][policer_index];
+
+  /* Spend locally held tokens without touching the shared buckets */
+  if (PREDICT_TRUE ((!pol->color_aware || packet_color == POLICE_CONFORM) &&
+		    *credit >= (len << pol->scale)))
+    {
+      *credit -= len << pol->scale;
+      return POLICE_CONFORM;
+    }
+
+  clib_spinlock_lock (&pm->locks[policer_index]);
+
+  /* TSCs of different cores may be slightly apart, never go backwards */
+  time = clib_max (time, pol->last_update_time);
+  col = vnet_police_packet (pol, len, packet_color, time);
+
+  /* Conforming traffic is likely to continue, draw a batch of credit */
+  if (col == POLICE_CONFORM)
+    {
+      batch = clib_min (pol->cir_tokens_per_period,
+			pol->current_limit >> POLICER_CREDIT_BATCH_SHIFT);
+      if (pol->current_bucket >= batch && pol->extended_bucket >= batch)
+	{
+	  pol->current_bucket -= batch;
+	  pol->extended_bucket -= batch;
+	  *credit += batch;
+	}
+    }
+
+  clib_spinlock_unlock (&pm->locks[policer_index]);
+
+  return col;
+}
+
 static_always_inline u8
 vnet_policer_police (vlib_main_t *vm, vlib_buffer_t *b, u32 policer_index,
 		     u64 time_in_policer_periods,
@@ -72,24 +123,38 @@ vnet_policer_police (vlib_main_t *vm, vlib_buffer_t *b, u32 policer_index,
 
   pol = &pm->policers[policer_index];
 
-  if (handoff)
+  if (pol->distributed)
     {
-      if (PREDICT_FALSE (pol->thread_index == CLIB_INVALID_THREAD_INDEX))
-	/*
-	 * This is the first packet to use this policer. Set the
-	 * thread index in the policer to this thread and any
-	 * packets seen by this node on other threads will
-	 * be handed off to this one.
-	 *
-	 * This could happen simultaneously on another thread.
-	 */
-	clib_atomic_cmp_and_swap (&pol->thread_index, ~0, vm->thread_index);
-      else if (PREDICT_FALSE (pol->thread_index != vm->thread_index))
-	return QOS_ACTION_HANDOFF;
+      len = vlib_buffer_length_in_chain (vm, b);
+      col = vnet_policer_police_distributed (pm, pol, policer_index,
+					     vm->thread_index, len,
+					     packet_color,
+					     time_in_policer_periods);
+    }
+  else
+    {
+      if (handoff)
+	{
+	  if (PREDICT_FALSE (pol->thread_index == CLIB_INVALID_THREAD_INDEX))
+	    /*
+	     * This is the first packet to use this policer. Set the
+	     * thread index in the policer to this thread and any
+	     * packets seen by this node on other threads will
+	     * be handed off to this one.
+	     *
+	     * This could happen simultaneously on another thread.
+	     */
+	    clib_atomic_cmp_and_swap (&pol->thread_index, ~0,
+				      vm->thread_index);
+	  else if (PREDICT_FALSE (pol->thread_index != vm->thread_index))
+	    return QOS_ACTION_HANDOFF;
+	}
+
+      len = vlib_buffer_length_in_chain (vm, b);
+      col =
+	vnet_police_packet (pol, len, packet_color, time_in_policer_periods);
     }
 
-  len = vlib_buffer_length_in_chain (vm, b);
-  col = vnet_police_packet (pol, len, packet_color, time_in_policer_periods);
   act = pol->action[col];
   vlib_increment_combined_counter (&policer_counters[col], vm->thread_index,
 				   policer_index, 1, len);
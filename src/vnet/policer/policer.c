@@ -49,6 +49,15 @@ vlib_combined_counter_main_t policer_counters[] = {
   },
 };
 
+static void
+policer_credits_zero (vnet_policer_main_t *pm, u32 policer_index)
+{
+  u32 **credits;
+
+  vec_foreach (credits, pm->credits)
+    (*credits)[policer_index] = 0;
+}
+
 int
 policer_add (vlib_main_t *vm, const u8 *name, const qos_pol_cfg_params_st *cfg,
 	     u32 *policer_index)
@@ -94,6 +103,15 @@ policer_add (vlib_main_t *vm, const u8 *name, const qos_pol_cfg_params_st *cfg,
       vlib_zero_combined_counter (&policer_counters[i], pi);
     }
 
+  vec_validate (pm->locks, pi);
+  if (!pm->locks[pi])
+    clib_spinlock_init (&pm->locks[pi]);
+
+  vec_validate (pm->credits, vlib_get_n_threads () - 1);
+  for (i = 0; i < vec_len (pm->credits); i++)
+    vec_validate (pm->credits[i], pi);
+  policer_credits_zero (pm, pi);
+
   return 0;
 }
 
@@ -136,6 +154,7 @@ policer_update (vlib_main_t *vm, u32 policer_index,
   qos_pol_cfg_params_st *cp;
   uword *p;
   u8 *name;
+  u8 distributed;
   int rv;
   int i;
 
@@ -164,12 +183,16 @@ policer_update (vlib_main_t *vm, u32 policer_index,
     }
 
   name = policer->name;
+  distributed = policer->distributed;
 
   clib_memcpy (cp, cfg, sizeof (*cp));
   clib_memcpy (policer, &test_policer, sizeof (*policer));
 
   policer->name = name;
+  policer->distributed = distributed;
   policer->thread_index = ~0;
+  policer->bound = 0;
+  policer_credits_zero (pm, policer_index);
 
   for (i = 0; i < NUM_POLICE_RESULTS; i++)
     vlib_zero_combined_counter (&policer_counters[i], policer_index);
@@ -190,6 +213,7 @@ policer_reset (vlib_main_t *vm, u32 policer_index)
 
   policer->current_bucket = policer->current_limit;
   policer->extended_bucket = policer->extended_limit;
+  policer_credits_zero (pm, policer_index);
 
   return 0;
 }
@@ -213,14 +237,44 @@ policer_bind_worker (u32 policer_index, u32 worker, bool bind)
 	}
 
       policer->thread_index = vlib_get_worker_thread_index (worker);
+      policer->distributed = 0;
+      policer->bound = 1;
     }
   else
     {
       policer->thread_index = ~0;
+      policer->bound = 0;
     }
   return 0;
 }
 
+int
+policer_distribute (u32 policer_index, bool enable)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_t *policer;
+
+  if (pool_is_free_index (pm->policers, policer_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  policer = &pm->policers[policer_index];
+
+  /* an explicit binding to a worker is kept until it is undone */
+  if (policer->bound)
+    return enable ? VNET_API_ERROR_INSTANCE_IN_USE : 0;
+
+  /*
+   * Credit still held by the workers is dropped rather than returned, the
+   * buckets refill at the configured rate anyway. The thread the policer
+   * was tied to by its first packet, if any, is forgotten.
+   */
+  policer_credits_zero (pm, policer_index);
+  policer->distributed = enable;
+  policer->thread_index = ~0;
+
+  return 0;
+}
+
 int
 policer_input (u32 policer_index, u32 sw_if_index, vlib_dir_t dir, bool apply)
 {
@@ -278,6 +332,15 @@ format_policer_instance (u8 * s, va_list * va)
 	      i->current_limit,
 	      i->current_bucket, i->extended_limit, i->extended_bucket);
   s = format (s, "last update %llu\n", i->last_update_time);
+  if (i->distributed)
+    {
+      u64 credit = 0;
+      u32 **credits;
+
+      vec_foreach (credits, pm->credits)
+	credit += (*credits)[policer_index];
+      s = format (s, "distributed, %llu tok held by workers\n", credit);
+    }
   s = format (s, "conform %llu packets, %llu bytes\n",
 	      counts[POLICE_CONFORM].packets, counts[POLICE_CONFORM].bytes);
   s = format (s, "exceed %llu packets, %llu bytes\n",
@@ -764,6 +827,63 @@ done:
   return error;
 }
 
+static clib_error_t *
+policer_distribute_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = NULL;
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  u8 enable = 1;
+  u8 *name = 0;
+  u32 policer_index = ~0;
+  uword *p;
+  int rv;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "name %s", &name))
+	;
+      else if (unformat (line_input, "index %u", &policer_index))
+	;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (~0 == policer_index && 0 != name)
+    {
+      p = hash_get_mem (pm->policer_index_by_name, name);
+      if (p != NULL)
+	policer_index = p[0];
+    }
+
+  rv = VNET_API_ERROR_NO_SUCH_ENTRY;
+  if (~0 != policer_index)
+    rv = policer_distribute (policer_index, enable);
+
+  if (rv == VNET_API_ERROR_INSTANCE_IN_USE)
+    error = clib_error_return (0, "policer is bound to a worker, unbind it "
+			       "first");
+  else if (rv)
+    error = clib_error_return (0, "failed: `%d'", rv);
+
+done:
+  unformat_free (line_input);
+  vec_free (name);
+
+  return error;
+}
+
 static clib_error_t *
 policer_input_command_fn (vlib_main_t *vm, unformat_input_t *input,
 			  vlib_cli_command_t *cmd)
@@ -923,6 +1043,13 @@ VLIB_CLI_COMMAND (policer_bind_command, static) = {
   .function = policer_bind_command_fn,
 };
 
+VLIB_CLI_COMMAND (policer_distribute_command, static) = {
+  .path = "policer distribute",
+  .short_help =
+    "policer distribute [disable] [name <name> | index <index>]",
+  .function = policer_distribute_command_fn,
+};
+
 VLIB_CLI_COMMAND (policer_input_command, static) = {
   .path = "policer input",
   .short_help =
@@ -41,6 +41,12 @@ typedef struct
   /* Policer by sw_if_index vector */
   u32 *policer_index_by_sw_if_index[VLIB_N_RX_TX];
 
+  /* per-policer lock, taken by distributed policers to refill credit */
+  clib_spinlock_t *locks;
+
+  /* per-thread, per-policer scaled conform tokens of distributed policers */
+  u32 **credits;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -79,6 +85,7 @@ int policer_update (vlib_main_t *vm, u32 policer_index,
 int policer_del (vlib_main_t *vm, u32 policer_index);
 int policer_reset (vlib_main_t *vm, u32 policer_index);
 int policer_bind_worker (u32 policer_index, u32 worker, bool bind);
+int policer_distribute (u32 policer_index, bool enable);
 int policer_input (u32 policer_index, u32 sw_if_index, vlib_dir_t dir,
 		   bool apply);
 
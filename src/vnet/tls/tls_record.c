@@ -2,6 +2,7 @@
  * Copyright(c) 2024 Cisco Systems, Inc.
  */
 
+#include <vlib/vlib.h>
 #include <vnet/tls/tls_record.h>
 
 /*
@@ -277,3 +278,259 @@ tls_handshake_ext_free (tls_handshake_ext_t *ext)
 
   tls_handshake_ext_free_fns[ext->type](ext);
 }
+
+typedef struct tls_record_per_thread_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  vnet_crypto_op_t *ops;
+  u8 *ivs;
+} tls_record_per_thread_t;
+
+static tls_record_per_thread_t *tls_record_per_thread;
+
+u8 *
+format_tls_record_error (u8 *s, va_list *args)
+{
+  tls_record_error_t err = va_arg (*args, tls_record_error_t);
+  static char *strings[] = {
+#define _(sym, str) [TLS_RECORD_ERR_##sym] = str,
+    foreach_tls_record_error
+#undef _
+  };
+
+  if (err >= ARRAY_LEN (strings))
+    return format (s, "unknown %u", err);
+  return format (s, "%s", strings[err]);
+}
+
+tls_record_error_t
+tls_record_crypto_init (vlib_main_t *vm, tls_record_crypto_t *rc,
+			vnet_crypto_alg_t alg, u8 is_enc, u8 *key, u8 *iv,
+			u64 seq)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_op_type_t type;
+
+  switch (alg)
+    {
+    case VNET_CRYPTO_ALG_AES_128_GCM:
+    case VNET_CRYPTO_ALG_AES_256_GCM:
+    case VNET_CRYPTO_ALG_CHACHA20_POLY1305:
+      break;
+    default:
+      return TLS_RECORD_ERR_UNSUPPORTED;
+    }
+
+  type = is_enc ? VNET_CRYPTO_OP_TYPE_ENCRYPT : VNET_CRYPTO_OP_TYPE_DECRYPT;
+  rc->op_id = cm->algs[alg].op_by_type[type];
+  rc->key_index =
+    vnet_crypto_key_add (vm, alg, key, cm->algs[alg].key_length);
+  if (rc->key_index == ~0)
+    return TLS_RECORD_ERR_UNSUPPORTED;
+
+  rc->seq = seq;
+  clib_memcpy_fast (rc->static_iv, iv, TLS_RECORD_IV_LEN);
+
+  return TLS_RECORD_ERR_OK;
+}
+
+void
+tls_record_crypto_free (vlib_main_t *vm, tls_record_crypto_t *rc)
+{
+  vnet_crypto_key_del (vm, rc->key_index);
+  clib_memset (rc, 0, sizeof (*rc));
+  rc->key_index = ~0;
+}
+
+/* rfc8446#section-5.3, the padded sequence number xored with the iv */
+static_always_inline void
+tls_record_nonce (tls_record_crypto_t *rc, u64 seq, u8 *iv)
+{
+  clib_memcpy_fast (iv, rc->static_iv, TLS_RECORD_IV_LEN);
+  *(u64u *) (iv + TLS_RECORD_IV_LEN - 8) ^= clib_host_to_net_u64 (seq);
+}
+
+static_always_inline vnet_crypto_op_t *
+tls_record_op_add (tls_record_per_thread_t *ptd, tls_record_crypto_t *rc,
+		   tls_record_header_t *hdr, u8 *src, u8 *dst, u32 len)
+{
+  vnet_crypto_op_t *op;
+
+  vec_add2_aligned (ptd->ops, op, 1, CLIB_CACHE_LINE_BYTES);
+  vnet_crypto_op_init (op, rc->op_id);
+  op->key_index = rc->key_index;
+  /* the record header is the additional data */
+  op->aad = (u8 *) hdr;
+  op->aad_len = TLS_RECORD_HDR_LEN;
+  op->src = src;
+  op->dst = dst;
+  op->len = len;
+  op->tag = src + len;
+  op->tag_len = TLS_RECORD_TAG_LEN;
+
+  return op;
+}
+
+/* ivs are set once the batch is built, the vector may have moved */
+static_always_inline void
+tls_record_ops_set_ivs (tls_record_per_thread_t *ptd, tls_record_crypto_t *rc)
+{
+  u32 i, n_ops = vec_len (ptd->ops);
+
+  vec_validate (ptd->ivs, n_ops * TLS_RECORD_IV_LEN);
+  for (i = 0; i < n_ops; i++)
+    {
+      ptd->ops[i].iv = ptd->ivs + i * TLS_RECORD_IV_LEN;
+      tls_record_nonce (rc, rc->seq + i, ptd->ops[i].iv);
+    }
+}
+
+tls_record_error_t
+tls_record_encrypt (vlib_main_t *vm, tls_record_crypto_t *rc,
+		    tls_record_type_t type, u8 *src, u32 len, u8 *dst,
+		    u32 dst_len, u32 max_fragment, u32 *n_read, u32 *n_written)
+{
+  tls_record_per_thread_t *ptd = tls_record_per_thread + vm->thread_index;
+  u32 read = 0, wrote = 0, frag, n_ops;
+  tls_record_header_t *hdr;
+
+  max_fragment = clib_min (max_fragment, TLS_FRAGMENT_MAX_LEN);
+  vec_reset_length (ptd->ops);
+
+  while (read < len && wrote + TLS13_RECORD_OVERHEAD < dst_len)
+    {
+      frag = clib_min (len - read, max_fragment);
+      frag = clib_min (frag, dst_len - wrote - TLS13_RECORD_OVERHEAD);
+
+      /* outer type and version are fixed, rfc8446#section-5.2 */
+      hdr = (tls_record_header_t *) (dst + wrote);
+      hdr->type = TLS_REC_APPLICATION_DATA;
+      hdr->version.major = TLS_MAJOR_VERSION;
+      hdr->version.minor = 3;
+      hdr->length = clib_host_to_net_u16 (frag + 1 + TLS_RECORD_TAG_LEN);
+
+      /* content and inner type are encrypted in place */
+      clib_memcpy_fast (hdr->fragment, src + read, frag);
+      hdr->fragment[frag] = type;
+      tls_record_op_add (ptd, rc, hdr, hdr->fragment, hdr->fragment,
+			 frag + 1);
+
+      read += frag;
+      wrote += frag + TLS13_RECORD_OVERHEAD;
+    }
+
+  *n_read = read;
+  *n_written = wrote;
+
+  n_ops = vec_len (ptd->ops);
+  if (!n_ops)
+    return TLS_RECORD_ERR_OK;
+
+  tls_record_ops_set_ivs (ptd, rc);
+  rc->seq += n_ops;
+
+  if (vnet_crypto_process_ops (vm, ptd->ops, n_ops) != n_ops)
+    return TLS_RECORD_ERR_CRYPTO;
+
+  return TLS_RECORD_ERR_OK;
+}
+
+tls_record_error_t
+tls_record_decrypt (vlib_main_t *vm, tls_record_crypto_t *rc, u8 *src,
+		    u32 len, u8 *dst, u32 dst_len, u32 *n_read,
+		    tls_record_desc_t *descs, u32 *n_descs)
+{
+  tls_record_per_thread_t *ptd = tls_record_per_thread + vm->thread_index;
+  u32 read = 0, wrote = 0, out = 0, rec_len, i, n_ops;
+  tls_record_header_t *hdr;
+  tls_record_desc_t *desc;
+  vnet_crypto_op_t *op;
+  u8 *p;
+
+  vec_reset_length (ptd->ops);
+  *n_read = 0;
+
+  while (read + TLS_RECORD_HDR_LEN <= len && vec_len (ptd->ops) < *n_descs)
+    {
+      hdr = (tls_record_header_t *) (src + read);
+      rec_len = clib_net_to_host_u16 (hdr->length);
+
+      if (hdr->type != TLS_REC_APPLICATION_DATA ||
+	  !tls_record_hdr_is_valid (*hdr) ||
+	  rec_len > TLS13_FRAGMENT_MAX_ENC_LEN ||
+	  rec_len <= TLS_RECORD_TAG_LEN)
+	{
+	  /* decrypt what comes before it, the error is for the next call */
+	  if (vec_len (ptd->ops))
+	    break;
+	  *n_descs = 0;
+	  return TLS_RECORD_ERR_INVALID;
+	}
+
+      if (read + TLS_RECORD_HDR_LEN + rec_len > len ||
+	  wrote + rec_len - TLS_RECORD_TAG_LEN > dst_len)
+	break;
+
+      op = tls_record_op_add (ptd, rc, hdr, hdr->fragment, dst + wrote,
+			      rec_len - TLS_RECORD_TAG_LEN);
+      op->user_data = read + TLS_RECORD_HDR_LEN + rec_len;
+
+      read += TLS_RECORD_HDR_LEN + rec_len;
+      wrote += rec_len - TLS_RECORD_TAG_LEN;
+    }
+
+  n_ops = vec_len (ptd->ops);
+  *n_descs = 0;
+  if (!n_ops)
+    return TLS_RECORD_ERR_OK;
+
+  tls_record_ops_set_ivs (ptd, rc);
+  vnet_crypto_process_ops (vm, ptd->ops, n_ops);
+
+  /* drop the padding and the inner type, and pack the content of the
+   * records the caller gets, rfc8446#section-5.4 */
+  for (i = 0; i < n_ops; i++)
+    {
+      op = ptd->ops + i;
+      if (op->status != VNET_CRYPTO_OP_STATUS_COMPLETED)
+	return TLS_RECORD_ERR_BAD_RECORD_MAC;
+
+      p = op->dst + op->len;
+      while (p > op->dst && p[-1] == 0)
+	p--;
+      if (p == op->dst)
+	return TLS_RECORD_ERR_INVALID;
+
+      p--;
+      if (out != op->dst - dst)
+	memmove (dst + out, op->dst, p - op->dst);
+
+      desc = descs + i;
+      desc->type = p[0];
+      desc->offset = out;
+      desc->len = p - op->dst;
+      out += desc->len;
+
+      rc->seq++;
+      *n_read = op->user_data;
+      *n_descs = i + 1;
+
+      /* may change the keys of the records that follow */
+      if (desc->type != TLS_REC_APPLICATION_DATA)
+	break;
+    }
+
+  return TLS_RECORD_ERR_OK;
+}
+
+static clib_error_t *
+tls_record_init (vlib_main_t *vm)
+{
+  vlib_thread_main_t *vtm = vlib_get_thread_main ();
+
+  vec_validate_aligned (tls_record_per_thread, vtm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (tls_record_init);
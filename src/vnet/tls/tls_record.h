@@ -8,6 +8,7 @@
 
 #include <vppinfra/clib.h>
 #include <vppinfra/error.h>
+#include <vnet/crypto/crypto.h>
 
 /**
  * TLS record types as per rfc8446#appendix-B.1
@@ -232,6 +233,123 @@ tls_record_hdr_is_valid (tls_record_header_t rec_hdr)
   return 1;
 }
 
+/*
+ * TLS 1.3 record protection, rfc8446#section-5.2, done with vnet_crypto
+ * for engines that hand over their traffic keys. Records are protected a
+ * batch at a time, one crypto op per record and one call into the crypto
+ * engines per batch, so multi-buffer handlers work on several records at
+ * once instead of on the one a library call hands them.
+ */
+#define TLS_RECORD_IV_LEN  12
+#define TLS_RECORD_TAG_LEN 16
+#define TLS_RECORD_HDR_LEN sizeof (tls_record_header_t)
+/** header, inner content type and tag */
+#define TLS13_RECORD_OVERHEAD (TLS_RECORD_HDR_LEN + 1 + TLS_RECORD_TAG_LEN)
+
+#define foreach_tls_record_error                                              \
+  _ (OK, "ok")                                                                \
+  _ (UNSUPPORTED, "unsupported cipher")                                       \
+  _ (INVALID, "invalid record")                                               \
+  _ (BAD_RECORD_MAC, "bad record mac")                                        \
+  _ (CRYPTO, "crypto op failed")
+
+typedef enum tls_record_error_
+{
+#define _(sym, str) TLS_RECORD_ERR_##sym,
+  foreach_tls_record_error
+#undef _
+} tls_record_error_t;
+
+typedef struct tls_record_crypto_
+{
+  vnet_crypto_op_id_t op_id;
+  u32 key_index;
+  u64 seq; /**< sequence number of the next record */
+  u8 static_iv[TLS_RECORD_IV_LEN];
+} tls_record_crypto_t;
+
+/**
+ * Set up protection of one direction with an AES-GCM or ChaCha20-Poly1305
+ * traffic key. Adds a vnet_crypto key, so callers on workers serialize
+ * this the way they do their other key adds.
+ */
+tls_record_error_t tls_record_crypto_init (vlib_main_t *vm,
+					   tls_record_crypto_t *rc,
+					   vnet_crypto_alg_t alg, u8 is_enc,
+					   u8 *key, u8 *iv, u64 seq);
+void tls_record_crypto_free (vlib_main_t *vm, tls_record_crypto_t *rc);
+
+/**
+ * Protect up to len bytes of src as records of at most max_fragment bytes
+ * of content, as many as fit in dst_len bytes of dst.
+ */
+tls_record_error_t tls_record_encrypt (vlib_main_t *vm,
+				       tls_record_crypto_t *rc,
+				       tls_record_type_t type, u8 *src,
+				       u32 len, u8 *dst, u32 dst_len,
+				       u32 max_fragment, u32 *n_read,
+				       u32 *n_written);
+
+/** content of a decrypted record, at offset in the caller's dst */
+typedef struct tls_record_desc_
+{
+  tls_record_type_t type;
+  u32 offset;
+  u32 len;
+} tls_record_desc_t;
+
+/**
+ * Decrypt the whole records in the len bytes of src that fit in dst_len
+ * bytes of dst, a record needs room for its content and inner type, and
+ * at most n_descs records. Their content is packed in dst and described
+ * in descs, n_descs is set to the number decrypted. Stops after a record
+ * that is not application data, so the caller can act on it, e.g. on a
+ * key update, before the records that follow.
+ */
+tls_record_error_t tls_record_decrypt (vlib_main_t *vm,
+				       tls_record_crypto_t *rc, u8 *src,
+				       u32 len, u8 *dst, u32 dst_len,
+				       u32 *n_read, tls_record_desc_t *descs,
+				       u32 *n_descs);
+
+format_function_t format_tls_record_error;
+
+/**
+ * Record coalescing: only whole records of the n_pending bytes are sent,
+ * the rest is held until a whole record's worth is pending or the oldest
+ * held byte has waited budget seconds, so a stream of small app writes
+ * goes out as full records instead of many short ones. Returns how many
+ * bytes to send now, hold_start is the caller's per connection state.
+ */
+static inline u32
+tls_record_coalesce (f64 *hold_start, u32 n_pending, u32 record_size,
+		     f64 budget, f64 now)
+{
+  u32 n_whole;
+
+  if (budget <= 0)
+    return n_pending;
+
+  if (n_pending >= record_size)
+    {
+      n_whole = n_pending - n_pending % record_size;
+      *hold_start = n_whole < n_pending ? now : 0;
+      return n_whole;
+    }
+
+  if (*hold_start == 0)
+    {
+      *hold_start = now;
+      return 0;
+    }
+
+  if (now - *hold_start < budget)
+    return 0;
+
+  *hold_start = 0;
+  return n_pending;
+}
+
 tls_handshake_parse_error_t
 tls_handshake_message_try_parse (u8 *msg, int len,
 				 tls_handshake_msg_info_t *info);
@@ -53,6 +53,8 @@ typedef struct
 {
   aes_gcm_op_t operation;
   int last;
+  /* encrypt, ghash of the last 4 blocks of ciphertext is still to do */
+  int ghash_pending;
   u8 rounds;
   uword data_bytes;
   uword aad_bytes;
@@ -638,68 +640,48 @@ aes_gcm_calc_last (aes_gcm_ctx_t *ctx, aes_data_t *d, int n_blocks,
   aes_gcm_enc_ctr0_round (ctx, i);
 }
 
+/*
+ * Data can be passed in pieces, aes_gcm_*_update takes whole groups of
+ * 4 * N_AES_BYTES and aes_gcm_*_final the remaining bytes, fewer than a
+ * group, so chained buffers go through the same kernels as flat ones.
+ */
+
 static_always_inline void
-aes_gcm_enc (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, u32 n_left)
+aes_gcm_enc_update (aes_gcm_ctx_t *ctx, aes_data_t *d, const u8 *src, u8 *dst,
+		    uword n_left)
 {
-  aes_data_t d[4];
+  if (n_left == 0)
+    return;
 
-  if (PREDICT_FALSE (n_left == 0))
+  if (ctx->ghash_pending == 0)
     {
-      int i;
-      for (i = 0; i < ctx->rounds + 1; i++)
-	aes_gcm_enc_ctr0_round (ctx, i);
-      return;
-    }
+      aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 0);
 
-  if (n_left < 4 * N_AES_BYTES)
-    {
-      ctx->last = 1;
-      if (n_left > 3 * N_AES_BYTES)
-	{
-	  aes_gcm_calc (ctx, d, src, dst, 4, n_left, /* with_ghash */ 0);
-	  aes_gcm_calc_last (ctx, d, 4, n_left);
-	}
-      else if (n_left > 2 * N_AES_BYTES)
-	{
-	  aes_gcm_calc (ctx, d, src, dst, 3, n_left, /* with_ghash */ 0);
-	  aes_gcm_calc_last (ctx, d, 3, n_left);
-	}
-      else if (n_left > N_AES_BYTES)
-	{
-	  aes_gcm_calc (ctx, d, src, dst, 2, n_left, /* with_ghash */ 0);
-	  aes_gcm_calc_last (ctx, d, 2, n_left);
-	}
-      else
-	{
-	  aes_gcm_calc (ctx, d, src, dst, 1, n_left, /* with_ghash */ 0);
-	  aes_gcm_calc_last (ctx, d, 1, n_left);
-	}
-      return;
+      /* next */
+      n_left -= 4 * N_AES_BYTES;
+      dst += 4 * N_AES_BYTES;
+      src += 4 * N_AES_BYTES;
+      ctx->ghash_pending = 1;
     }
 
-  aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 0);
-
-  /* next */
-  n_left -= 4 * N_AES_BYTES;
-  dst += 4 * N_AES_BYTES;
-  src += 4 * N_AES_BYTES;
-
   for (int n = 8 * N_AES_BYTES; n_left >= n; n_left -= n, src += n, dst += n)
     aes_gcm_calc_double (ctx, d, src, dst);
 
   if (n_left >= 4 * N_AES_BYTES)
-    {
-      aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 1);
-
-      /* next */
-      n_left -= 4 * N_AES_BYTES;
-      dst += 4 * N_AES_BYTES;
-      src += 4 * N_AES_BYTES;
-    }
+    aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 1);
+}
 
+static_always_inline void
+aes_gcm_enc_final_inline (aes_gcm_ctx_t *ctx, aes_data_t *d, const u8 *src,
+			  u8 *dst, u32 n_left, int with_ghash)
+{
   if (n_left == 0)
     {
-      aes_gcm_calc_last (ctx, d, 4, 4 * N_AES_BYTES);
+      if (with_ghash)
+	aes_gcm_calc_last (ctx, d, 4, 4 * N_AES_BYTES);
+      else
+	for (int i = 0; i < ctx->rounds + 1; i++)
+	  aes_gcm_enc_ctr0_round (ctx, i);
       return;
     }
 
@@ -707,45 +689,64 @@ aes_gcm_enc (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, u32 n_left)
 
   if (n_left > 3 * N_AES_BYTES)
     {
-      aes_gcm_calc (ctx, d, src, dst, 4, n_left, /* with_ghash */ 1);
+      aes_gcm_calc (ctx, d, src, dst, 4, n_left, with_ghash);
       aes_gcm_calc_last (ctx, d, 4, n_left);
     }
   else if (n_left > 2 * N_AES_BYTES)
     {
-      aes_gcm_calc (ctx, d, src, dst, 3, n_left, /* with_ghash */ 1);
+      aes_gcm_calc (ctx, d, src, dst, 3, n_left, with_ghash);
       aes_gcm_calc_last (ctx, d, 3, n_left);
     }
   else if (n_left > N_AES_BYTES)
     {
-      aes_gcm_calc (ctx, d, src, dst, 2, n_left, /* with_ghash */ 1);
+      aes_gcm_calc (ctx, d, src, dst, 2, n_left, with_ghash);
       aes_gcm_calc_last (ctx, d, 2, n_left);
     }
   else
     {
-      aes_gcm_calc (ctx, d, src, dst, 1, n_left, /* with_ghash */ 1);
+      aes_gcm_calc (ctx, d, src, dst, 1, n_left, with_ghash);
       aes_gcm_calc_last (ctx, d, 1, n_left);
     }
 }
 
 static_always_inline void
-aes_gcm_dec (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, uword n_left)
+aes_gcm_enc_final (aes_gcm_ctx_t *ctx, aes_data_t *d, const u8 *src, u8 *dst,
+		   u32 n_left)
 {
-  aes_data_t d[4] = {};
-  ghash_ctx_t gd;
+  if (ctx->ghash_pending)
+    aes_gcm_enc_final_inline (ctx, d, src, dst, n_left, /* with_ghash */ 1);
+  else
+    aes_gcm_enc_final_inline (ctx, d, src, dst, n_left, /* with_ghash */ 0);
+}
 
+static_always_inline void
+aes_gcm_enc (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, u32 n_left)
+{
+  uword n_groups_bytes = n_left & ~(4 * N_AES_BYTES - 1);
+  aes_data_t d[4];
+
+  aes_gcm_enc_update (ctx, d, src, dst, n_groups_bytes);
+  aes_gcm_enc_final (ctx, d, src + n_groups_bytes, dst + n_groups_bytes,
+		     n_left - n_groups_bytes);
+}
+
+static_always_inline void
+aes_gcm_dec_update (aes_gcm_ctx_t *ctx, aes_data_t *d, const u8 *src, u8 *dst,
+		    uword n_left)
+{
   /* main encryption loop */
   for (int n = 8 * N_AES_BYTES; n_left >= n; n_left -= n, dst += n, src += n)
     aes_gcm_calc_double (ctx, d, src, dst);
 
   if (n_left >= 4 * N_AES_BYTES)
-    {
-      aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 1);
+    aes_gcm_calc (ctx, d, src, dst, 4, 4 * N_AES_BYTES, /* with_ghash */ 1);
+}
 
-      /* next */
-      n_left -= 4 * N_AES_BYTES;
-      dst += N_AES_BYTES * 4;
-      src += N_AES_BYTES * 4;
-    }
+static_always_inline void
+aes_gcm_dec_final (aes_gcm_ctx_t *ctx, aes_data_t *d, const u8 *src, u8 *dst,
+		   u32 n_left)
+{
+  ghash_ctx_t gd;
 
   if (n_left)
     {
@@ -792,22 +793,31 @@ aes_gcm_dec (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, uword n_left)
     aes_gcm_enc_ctr0_round (ctx, i);
 }
 
-static_always_inline int
-aes_gcm (const u8 *src, u8 *dst, const u8 *aad, u8 *ivp, u8 *tag,
-	 u32 data_bytes, u32 aad_bytes, u8 tag_len,
-	 const aes_gcm_key_data_t *kd, int aes_rounds, aes_gcm_op_t op)
+static_always_inline void
+aes_gcm_dec (aes_gcm_ctx_t *ctx, const u8 *src, u8 *dst, uword n_left)
+{
+  uword n_groups_bytes = n_left & ~(4 * N_AES_BYTES - 1);
+  aes_data_t d[4] = {};
+
+  aes_gcm_dec_update (ctx, d, src, dst, n_groups_bytes);
+  aes_gcm_dec_final (ctx, d, src + n_groups_bytes, dst + n_groups_bytes,
+		     n_left - n_groups_bytes);
+}
+
+static_always_inline void
+aes_gcm_init (aes_gcm_ctx_t *ctx, const u8 *ivp, u32 data_bytes,
+	      u32 aad_bytes, const aes_gcm_key_data_t *kd, int aes_rounds,
+	      aes_gcm_op_t op)
 {
-  u8 *addt = (u8 *) aad;
   u32x4 Y0;
 
-  aes_gcm_ctx_t _ctx = { .counter = 2,
-			 .rounds = aes_rounds,
-			 .operation = op,
-			 .data_bytes = data_bytes,
-			 .aad_bytes = aad_bytes,
-			 .Ke = kd->Ke,
-			 .Hi = kd->Hi },
-		*ctx = &_ctx;
+  *ctx = (aes_gcm_ctx_t){ .counter = 2,
+			  .rounds = aes_rounds,
+			  .operation = op,
+			  .data_bytes = data_bytes,
+			  .aad_bytes = aad_bytes,
+			  .Ke = kd->Ke,
+			  .Hi = kd->Hi };
 
   /* initalize counter */
   Y0 = (u32x4) (u64x2){ *(u64u *) ivp, 0 };
@@ -825,23 +835,20 @@ aes_gcm (const u8 *src, u8 *dst, const u8 *aad, u8 *ivp, u8 *tag,
 #else
   ctx->Y = Y0 + (u32x4){ 0, 0, 0, 1 << 24 };
 #endif
+}
 
-  /* calculate ghash for AAD */
-  aes_gcm_ghash (ctx, addt, aad_bytes);
-
-  /* ghash and encrypt/edcrypt  */
-  if (op == AES_GCM_OP_ENCRYPT)
-    aes_gcm_enc (ctx, src, dst, data_bytes);
-  else if (op == AES_GCM_OP_DECRYPT)
-    aes_gcm_dec (ctx, src, dst, data_bytes);
-
+/* stores the tag, or checks it for decrypt, returns 0 on mismatch */
+static_always_inline int
+aes_gcm_tag (aes_gcm_ctx_t *ctx, u8 *tag, u8 tag_len)
+{
   /* final tag is */
   ctx->T = u8x16_reflect (ctx->T) ^ ctx->EY0;
 
   /* tag_len 16 -> 0 */
   tag_len &= 0xf;
 
-  if (op == AES_GCM_OP_ENCRYPT || op == AES_GCM_OP_GMAC)
+  if (ctx->operation == AES_GCM_OP_ENCRYPT ||
+      ctx->operation == AES_GCM_OP_GMAC)
     {
       /* store tag */
       if (tag_len)
@@ -868,6 +875,28 @@ aes_gcm (const u8 *src, u8 *dst, const u8 *aad, u8 *ivp, u8 *tag,
   return 0;
 }
 
+static_always_inline int
+aes_gcm (const u8 *src, u8 *dst, const u8 *aad, u8 *ivp, u8 *tag,
+	 u32 data_bytes, u32 aad_bytes, u8 tag_len,
+	 const aes_gcm_key_data_t *kd, int aes_rounds, aes_gcm_op_t op)
+{
+  u8 *addt = (u8 *) aad;
+  aes_gcm_ctx_t _ctx, *ctx = &_ctx;
+
+  aes_gcm_init (ctx, ivp, data_bytes, aad_bytes, kd, aes_rounds, op);
+
+  /* calculate ghash for AAD */
+  aes_gcm_ghash (ctx, addt, aad_bytes);
+
+  /* ghash and encrypt/edcrypt  */
+  if (op == AES_GCM_OP_ENCRYPT)
+    aes_gcm_enc (ctx, src, dst, data_bytes);
+  else if (op == AES_GCM_OP_DECRYPT)
+    aes_gcm_dec (ctx, src, dst, data_bytes);
+
+  return aes_gcm_tag (ctx, tag, tag_len);
+}
+
 static_always_inline void
 clib_aes_gcm_key_expand (aes_gcm_key_data_t *kd, const u8 *key,
 			 aes_key_size_t ks)
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#ifndef __clib_chacha20_h__
+#define __clib_chacha20_h__
+
+#include <vppinfra/clib.h>
+#include <vppinfra/vector.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/string.h>
+
+/* implementation of DJB's chacha20 (RFC 8439) block function computed for
+ * multiple independent blocks at once. Each vector lane carries one block,
+ * so lanes may use different keys, nonces and counters, which allows callers
+ * to pack blocks of multiple packets into a single pass */
+
+#define CHACHA20_KEY_BYTES   32
+#define CHACHA20_NONCE_BYTES 12
+#define CHACHA20_BLOCK_BYTES 64
+
+#if defined(CLIB_HAVE_VEC512)
+#define CHACHA20_N_LANES 16
+typedef u32x16 chacha20_lanes_t;
+#elif defined(CLIB_HAVE_VEC256)
+#define CHACHA20_N_LANES 8
+typedef u32x8 chacha20_lanes_t;
+#else
+#define CHACHA20_N_LANES 4
+typedef u32x4 chacha20_lanes_t;
+#endif
+
+#define CHACHA20_N_PARTS (16 / CHACHA20_N_LANES)
+
+typedef union
+{
+  u32 as_u32[16];
+  u8 as_u8[CHACHA20_BLOCK_BYTES];
+  chacha20_lanes_t as_lanes[CHACHA20_N_PARTS];
+} __clib_aligned (CHACHA20_BLOCK_BYTES) chacha20_block_t;
+
+typedef struct
+{
+  u32 key[8];
+} chacha20_key_t;
+
+static_always_inline void
+clib_chacha20_key_init (chacha20_key_t *k, const u8 key[CHACHA20_KEY_BYTES])
+{
+  clib_memcpy_fast (k->key, key, CHACHA20_KEY_BYTES);
+}
+
+/* fill block with initial state for given key, nonce and block counter */
+static_always_inline void
+clib_chacha20_block_init (chacha20_block_t *b, const chacha20_key_t *k,
+			  const u8 nonce[CHACHA20_NONCE_BYTES], u32 counter)
+{
+  /* "expand 32-byte k" */
+  b->as_u32[0] = 0x61707865;
+  b->as_u32[1] = 0x3320646e;
+  b->as_u32[2] = 0x79622d32;
+  b->as_u32[3] = 0x6b206574;
+  clib_memcpy_fast (b->as_u32 + 4, k->key, CHACHA20_KEY_BYTES);
+  b->as_u32[12] = counter;
+  clib_memcpy_fast (b->as_u32 + 13, nonce, CHACHA20_NONCE_BYTES);
+}
+
+static_always_inline chacha20_lanes_t
+_chacha20_rotl (chacha20_lanes_t x, const int n)
+{
+#if !defined(__AVX512VL__)
+  /* rotations by whole bytes are single byte shuffles */
+  if (n == 16)
+    {
+#if CHACHA20_N_LANES == 8
+      return (chacha20_lanes_t) u8x32_shuffle (
+	x, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 18, 19, 16,
+	17, 22, 23, 20, 21, 26, 27, 24, 25, 30, 31, 28, 29);
+#else
+      return (chacha20_lanes_t) u8x16_shuffle (x, 2, 3, 0, 1, 6, 7, 4, 5, 10,
+					       11, 8, 9, 14, 15, 12, 13);
+#endif
+    }
+  if (n == 8)
+    {
+#if CHACHA20_N_LANES == 8
+      return (chacha20_lanes_t) u8x32_shuffle (
+	x, 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 19, 16, 17,
+	18, 23, 20, 21, 22, 27, 24, 25, 26, 31, 28, 29, 30);
+#else
+      return (chacha20_lanes_t) u8x16_shuffle (x, 3, 0, 1, 2, 7, 4, 5, 6, 11,
+					       8, 9, 10, 15, 12, 13, 14);
+#endif
+    }
+#endif
+  return (x << n) | (x >> (32 - n));
+}
+
+static_always_inline void
+_chacha20_quarter_round (chacha20_lanes_t x[16], int a, int b, int c, int d)
+{
+  x[a] += x[b];
+  x[d] = _chacha20_rotl (x[d] ^ x[a], 16);
+  x[c] += x[d];
+  x[b] = _chacha20_rotl (x[b] ^ x[c], 12);
+  x[a] += x[b];
+  x[d] = _chacha20_rotl (x[d] ^ x[a], 8);
+  x[c] += x[d];
+  x[b] = _chacha20_rotl (x[b] ^ x[c], 7);
+}
+
+static_always_inline void
+_chacha20_transpose (chacha20_lanes_t m[CHACHA20_N_LANES])
+{
+#if CHACHA20_N_LANES == 16
+  u32x16_transpose (m);
+#elif CHACHA20_N_LANES == 8
+  u32x8_transpose (m);
+#else
+  u32x4 t0 = __builtin_shufflevector (m[0], m[1], 0, 4, 1, 5);
+  u32x4 t1 = __builtin_shufflevector (m[0], m[1], 2, 6, 3, 7);
+  u32x4 t2 = __builtin_shufflevector (m[2], m[3], 0, 4, 1, 5);
+  u32x4 t3 = __builtin_shufflevector (m[2], m[3], 2, 6, 3, 7);
+  m[0] = __builtin_shufflevector (t0, t2, 0, 1, 4, 5);
+  m[1] = __builtin_shufflevector (t0, t2, 2, 3, 6, 7);
+  m[2] = __builtin_shufflevector (t1, t3, 0, 1, 4, 5);
+  m[3] = __builtin_shufflevector (t1, t3, 2, 3, 6, 7);
+#endif
+}
+
+/* computes CHACHA20_N_LANES keystream blocks at once, on input each block
+ * holds initial state (see clib_chacha20_block_init), on return it holds
+ * keystream. Unused blocks are processed too, their content doesn't matter */
+static_always_inline void
+clib_chacha20_blocks (chacha20_block_t b[CHACHA20_N_LANES])
+{
+  chacha20_lanes_t x[16], *t;
+
+  /* transpose so that x[i] holds word i of all blocks */
+  for (int p = 0; p < CHACHA20_N_PARTS; p++)
+    {
+      t = x + p * CHACHA20_N_LANES;
+      for (int i = 0; i < CHACHA20_N_LANES; i++)
+	t[i] = b[i].as_lanes[p];
+      _chacha20_transpose (t);
+    }
+
+  for (int r = 0; r < 10; r++)
+    {
+      /* column round */
+      _chacha20_quarter_round (x, 0, 4, 8, 12);
+      _chacha20_quarter_round (x, 1, 5, 9, 13);
+      _chacha20_quarter_round (x, 2, 6, 10, 14);
+      _chacha20_quarter_round (x, 3, 7, 11, 15);
+
+      /* diagonal round */
+      _chacha20_quarter_round (x, 0, 5, 10, 15);
+      _chacha20_quarter_round (x, 1, 6, 11, 12);
+      _chacha20_quarter_round (x, 2, 7, 8, 13);
+      _chacha20_quarter_round (x, 3, 4, 9, 14);
+    }
+
+  /* transpose back and add initial state */
+  for (int p = 0; p < CHACHA20_N_PARTS; p++)
+    {
+      t = x + p * CHACHA20_N_LANES;
+      _chacha20_transpose (t);
+      for (int i = 0; i < CHACHA20_N_LANES; i++)
+	b[i].as_lanes[p] += t[i];
+    }
+}
+
+/* xor up to one block of keystream into data */
+static_always_inline void
+clib_chacha20_xor (const chacha20_block_t *ks, u32 ks_off, const u8 *src,
+		   u8 *dst, u32 n_bytes)
+{
+  const u8 *k = ks->as_u8 + ks_off;
+
+  if (n_bytes == CHACHA20_BLOCK_BYTES)
+    {
+      for (int i = 0; i < CHACHA20_BLOCK_BYTES; i += 16)
+	u8x16_store_unaligned (u8x16_load_unaligned ((u8 *) src + i) ^
+				 u8x16_load_unaligned ((u8 *) k + i),
+			       dst + i);
+      return;
+    }
+
+  for (; n_bytes >= 16; n_bytes -= 16, k += 16, src += 16, dst += 16)
+    u8x16_store_unaligned (u8x16_load_unaligned ((u8 *) src) ^
+			     u8x16_load_unaligned ((u8 *) k),
+			   dst);
+
+  for (; n_bytes; n_bytes--)
+    *dst++ = *src++ ^ *k++;
+}
+
+/* encrypt or decrypt single buffer, starting at given block counter */
+static_always_inline void
+clib_chacha20 (const chacha20_key_t *k, const u8 nonce[CHACHA20_NONCE_BYTES],
+	       u32 counter, const u8 *src, u8 *dst, uword n_bytes)
+{
+  chacha20_block_t b[CHACHA20_N_LANES];
+
+  while (n_bytes)
+    {
+      for (int i = 0; i < CHACHA20_N_LANES; i++)
+	clib_chacha20_block_init (b + i, k, nonce, counter + i);
+      clib_chacha20_blocks (b);
+      counter += CHACHA20_N_LANES;
+
+      for (int i = 0; i < CHACHA20_N_LANES && n_bytes; i++)
+	{
+	  u32 n = clib_min (n_bytes, CHACHA20_BLOCK_BYTES);
+	  clib_chacha20_xor (b + i, 0, src, dst, n);
+	  src += n;
+	  dst += n;
+	  n_bytes -= n;
+	}
+    }
+}
+
+#endif /* __clib_chacha20_h__ */
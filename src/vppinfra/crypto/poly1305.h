@@ -175,6 +175,7 @@ clib_poly1305_update (clib_poly1305_ctx *ctx, const u8 *msg, uword len)
       ctx->n_partial_bytes = 0;
       n_left -= missing_bytes;
       msg += missing_bytes;
+      len -= missing_bytes;
     }
 
   n_left = _clib_poly1305_add_blocks (ctx, msg, n_left, 1);
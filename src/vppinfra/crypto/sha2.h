@@ -460,6 +460,82 @@ clib_sha512_block (clib_sha2_state_t *st, const u8 *msg, uword n_blocks)
   st->h = h;
 }
 
+/*
+ * Multi-buffer block functions, one block from each of up to
+ * CLIB_SHA256_MB_LANES (CLIB_SHA512_MB_LANES) independent messages per
+ * call, one message in each vector lane. The hash state stays transposed
+ * between calls, h[i] holds word i of every lane.
+ */
+
+#if defined(CLIB_HAVE_VEC512)
+#define CLIB_SHA256_MB_LANES 16
+#define CLIB_SHA512_MB_LANES 8
+typedef u32x16 clib_sha256_mb_t;
+typedef u64x8 clib_sha512_mb_t;
+#elif defined(CLIB_HAVE_VEC256)
+#define CLIB_SHA256_MB_LANES 8
+#define CLIB_SHA512_MB_LANES 4
+typedef u32x8 clib_sha256_mb_t;
+typedef u64x4 clib_sha512_mb_t;
+#endif
+
+#ifdef CLIB_SHA256_MB_LANES
+#define CLIB_SHA2_MB
+#define CLIB_SHA2_MB_MAX_LANES CLIB_SHA256_MB_LANES
+
+static_always_inline void
+clib_sha256_mb_block (clib_sha256_mb_t h[8], const u8 *msg[])
+{
+  clib_sha256_mb_t w[64], s[8];
+  int i, l;
+
+  for (i = 0; i < 16; i++)
+    for (l = 0; l < CLIB_SHA256_MB_LANES; l++)
+      w[i][l] = clib_net_to_host_u32 (((u32u *) msg[l])[i]);
+
+  for (i = 0; i < 8; i++)
+    s[i] = h[i];
+
+  for (i = 0; i < 16; i++)
+    SHA256_TRANSFORM (s, w, i, clib_sha2_256_k[i]);
+
+  for (i = 16; i < 64; i++)
+    {
+      SHA256_MSG_SCHED (w, i);
+      SHA256_TRANSFORM (s, w, i, clib_sha2_256_k[i]);
+    }
+
+  for (i = 0; i < 8; i++)
+    h[i] += s[i];
+}
+
+static_always_inline void
+clib_sha512_mb_block (clib_sha512_mb_t h[8], const u8 *msg[])
+{
+  clib_sha512_mb_t w[80], s[8];
+  int i, l;
+
+  for (i = 0; i < 16; i++)
+    for (l = 0; l < CLIB_SHA512_MB_LANES; l++)
+      w[i][l] = clib_net_to_host_u64 (((u64u *) msg[l])[i]);
+
+  for (i = 0; i < 8; i++)
+    s[i] = h[i];
+
+  for (i = 0; i < 16; i++)
+    SHA512_TRANSFORM (s, w, i, clib_sha2_512_k[i]);
+
+  for (i = 16; i < 80; i++)
+    {
+      SHA512_MSG_SCHED (w, i);
+      SHA512_TRANSFORM (s, w, i, clib_sha2_512_k[i]);
+    }
+
+  for (i = 0; i < 8; i++)
+    h[i] += s[i];
+}
+#endif
+
 static_always_inline void
 clib_sha2_update_internal (clib_sha2_state_t *st, u8 block_size, const u8 *msg,
 			   uword n_bytes)
@@ -522,12 +598,14 @@ clib_sha2_final_internal (clib_sha2_state_t *st, u8 block_size, u8 digest_size,
   int i;
 
   st->total_bytes += st->n_pending;
+  /* padding ends with the message length in bits, 64 bits wide for sha-256
+   * and 128 bits wide for sha-512 */
   if (st->n_pending == 0)
     {
       clib_memset (st->pending.as_u8, 0, block_size);
       st->pending.as_u8[0] = 0x80;
     }
-  else if (st->n_pending + sizeof (u64) + sizeof (u8) > block_size)
+  else if (st->n_pending + block_size / 8 + sizeof (u8) > block_size)
     {
       st->pending.as_u8[st->n_pending] = 0x80;
       if (block_size == CLIB_SHA2_512_BLOCK_SIZE)
@@ -712,4 +790,242 @@ clib_sha2_hmac (clib_sha2_type_t type, const u8 *key, uword key_len,
 #define clib_hmac_sha512_256(...)                                             \
   clib_sha2_hmac (CLIB_SHA2_512_256, __VA_ARGS__)
 
+/*
+ *  Multi-buffer HMAC
+ *
+ *  Each lane walks one message through its whole blocks, the one or two
+ *  padded tail blocks of the inner hash and the single block of the outer
+ *  hash, and takes the next message as soon as it is done. Once no
+ *  messages are left and fewer than half of the lanes are busy, the rest
+ *  are finished one at a time with the single buffer block function.
+ */
+
+typedef struct
+{
+  const u8 *msg;
+  const u8 *pad_blk;
+  u32 n_blocks;
+  u8 n_pad;
+  u8 outer;
+  u8 *digest;
+  const clib_sha2_hmac_key_data_t *kd;
+  u8 pad[2 * SHA2_MAX_BLOCK_SIZE];
+} clib_sha2_mb_lane_t;
+
+static_always_inline void
+clib_sha2_mb_lane_init (clib_sha2_mb_lane_t *l, u8 block_size, const u8 *msg,
+			u32 len, u8 *digest,
+			const clib_sha2_hmac_key_data_t *kd)
+{
+  u32 n_tail = len % block_size;
+
+  l->msg = msg;
+  l->n_blocks = len / block_size;
+  l->outer = 0;
+  l->digest = digest;
+  l->kd = kd;
+  l->pad_blk = l->pad;
+  l->n_pad = n_tail + block_size / 8 + sizeof (u8) > block_size ? 2 : 1;
+
+  clib_memset_u8 (l->pad, 0, l->n_pad * block_size);
+  clib_memcpy_fast (l->pad, msg + len - n_tail, n_tail);
+  l->pad[n_tail] = 0x80;
+  /* ipad block is already in the key data */
+  ((u64u *) (l->pad + l->n_pad * block_size))[-1] =
+    clib_net_to_host_u64 ((u64) (block_size + len) * 8);
+}
+
+/* lane is through its last block of the inner or the outer hash, starts
+ * the outer one or writes the digest, returns 1 when the lane is free */
+static_always_inline int
+clib_sha2_mb_lane_done (clib_sha2_mb_lane_t *l, clib_sha2_h_t *h,
+			u8 block_size, u8 digest_size)
+{
+  u8 d[SHA2_MAX_DIGEST_SIZE];
+  int i;
+
+  if (block_size == CLIB_SHA2_512_BLOCK_SIZE)
+    for (i = 0; i < 8; i++)
+      ((u64u *) d)[i] = clib_net_to_host_u64 (h->h64[i]);
+  else
+    for (i = 0; i < 8; i++)
+      ((u32u *) d)[i] = clib_net_to_host_u32 (h->h32[i]);
+
+  if (l->outer)
+    {
+      clib_memcpy_fast (l->digest, d, digest_size);
+      return 1;
+    }
+
+  clib_memset_u8 (l->pad, 0, block_size);
+  clib_memcpy_fast (l->pad, d, digest_size);
+  l->pad[digest_size] = 0x80;
+  ((u64u *) (l->pad + block_size))[-1] =
+    clib_net_to_host_u64 ((u64) (block_size + digest_size) * 8);
+  l->pad_blk = l->pad;
+  l->n_pad = 1;
+  l->outer = 1;
+  *h = l->kd->opad_h;
+  return 0;
+}
+
+static_always_inline void
+clib_sha2_mb_lane_finish (clib_sha2_mb_lane_t *l, clib_sha2_h_t *h,
+			  u8 block_size, u8 digest_size)
+{
+  clib_sha2_state_t st;
+
+  st.h = *h;
+  do
+    {
+      if (block_size == CLIB_SHA2_512_BLOCK_SIZE)
+	{
+	  clib_sha512_block (&st, l->msg, l->n_blocks);
+	  clib_sha512_block (&st, l->pad_blk, l->n_pad);
+	}
+      else
+	{
+	  clib_sha256_block (&st, l->msg, l->n_blocks);
+	  clib_sha256_block (&st, l->pad_blk, l->n_pad);
+	}
+      l->n_blocks = 0;
+      l->n_pad = 0;
+    }
+  while (!clib_sha2_mb_lane_done (l, &st.h, block_size, digest_size));
+}
+
+#ifdef CLIB_SHA2_MB
+static_always_inline void
+clib_sha2_mb_lane_get (clib_sha256_mb_t *h256, clib_sha512_mb_t *h512,
+		       u32 lane, clib_sha2_h_t *h, int is_512)
+{
+  for (int i = 0; i < 8; i++)
+    if (is_512)
+      h->h64[i] = h512[i][lane];
+    else
+      h->h32[i] = h256[i][lane];
+}
+
+static_always_inline void
+clib_sha2_mb_lane_set (clib_sha256_mb_t *h256, clib_sha512_mb_t *h512,
+		       u32 lane, const clib_sha2_h_t *h, int is_512)
+{
+  for (int i = 0; i < 8; i++)
+    if (is_512)
+      h512[i][lane] = h->h64[i];
+    else
+      h256[i][lane] = h->h32[i];
+}
+#endif
+
+/* HMAC of n_msgs independent messages, each with its own key */
+static_always_inline void
+clib_sha2_hmac_mb (clib_sha2_type_t type, clib_sha2_hmac_key_data_t *kd[],
+		   const u8 *msg[], const u32 len[], u8 *digest[], u32 n_msgs)
+{
+  u8 block_size = clib_sha2_variants[type].block_size;
+  u8 digest_size = clib_sha2_variants[type].digest_size;
+  clib_sha2_mb_lane_t _l, *l = &_l;
+  u32 next = 0;
+
+#ifdef CLIB_SHA2_MB
+  int is_512 = block_size == CLIB_SHA2_512_BLOCK_SIZE;
+  u32 n_lanes = is_512 ? CLIB_SHA512_MB_LANES : CLIB_SHA256_MB_LANES;
+  clib_sha2_mb_lane_t lanes[CLIB_SHA2_MB_MAX_LANES];
+  const u8 *blk[CLIB_SHA2_MB_MAX_LANES];
+  u8 idle[SHA2_MAX_BLOCK_SIZE] = {};
+  clib_sha256_mb_t h256[8];
+  clib_sha512_mb_t h512[8];
+  u32 n_active = 0, i;
+  clib_sha2_h_t h;
+
+  if (n_msgs * 2 < n_lanes)
+    goto single;
+
+#ifdef CLIB_SHA256_ISA
+  /* eight lanes are no match for the sha extensions */
+  if (!is_512 && n_lanes < 16)
+    goto single;
+#endif
+
+  for (i = 0; i < n_lanes; i++)
+    {
+      lanes[i].digest = 0;
+      blk[i] = idle;
+    }
+
+  while (1)
+    {
+      for (i = 0; i < n_lanes && next < n_msgs; i++)
+	if (lanes[i].digest == 0)
+	  {
+	    clib_sha2_mb_lane_init (lanes + i, block_size, msg[next],
+				    len[next], digest[next], kd[next]);
+	    clib_sha2_mb_lane_set (h256, h512, i, &kd[next]->ipad_h, is_512);
+	    n_active++;
+	    next++;
+	  }
+
+      if (next == n_msgs && n_active * 2 < n_lanes)
+	break;
+
+      for (i = 0; i < n_lanes; i++)
+	{
+	  l = lanes + i;
+	  if (l->digest == 0)
+	    blk[i] = idle;
+	  else if (l->n_blocks)
+	    {
+	      blk[i] = l->msg;
+	      l->msg += block_size;
+	      l->n_blocks--;
+	    }
+	  else
+	    {
+	      blk[i] = l->pad_blk;
+	      l->pad_blk += block_size;
+	      l->n_pad--;
+	    }
+	}
+
+      if (is_512)
+	clib_sha512_mb_block (h512, blk);
+      else
+	clib_sha256_mb_block (h256, blk);
+
+      for (i = 0; i < n_lanes; i++)
+	{
+	  l = lanes + i;
+	  if (l->digest == 0 || l->n_blocks || l->n_pad)
+	    continue;
+	  clib_sha2_mb_lane_get (h256, h512, i, &h, is_512);
+	  if (clib_sha2_mb_lane_done (l, &h, block_size, digest_size))
+	    {
+	      l->digest = 0;
+	      n_active--;
+	    }
+	  else
+	    clib_sha2_mb_lane_set (h256, h512, i, &h, is_512);
+	}
+    }
+
+  for (i = 0; i < n_lanes; i++)
+    if (lanes[i].digest)
+      {
+	clib_sha2_mb_lane_get (h256, h512, i, &h, is_512);
+	clib_sha2_mb_lane_finish (lanes + i, &h, block_size, digest_size);
+      }
+  return;
+
+single:
+#endif
+  for (; next < n_msgs; next++)
+    {
+      clib_sha2_h_t ih = kd[next]->ipad_h;
+      clib_sha2_mb_lane_init (l, block_size, msg[next], len[next],
+			      digest[next], kd[next]);
+      clib_sha2_mb_lane_finish (l, &ih, block_size, digest_size);
+    }
+}
+
 #endif /* included_sha2_h */
@@ -0,0 +1,232 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2024 Cisco Systems, Inc.
+ */
+
+#include <vppinfra/format.h>
+#include <vppinfra/test/test.h>
+#include <vppinfra/crypto/chacha20.h>
+
+static const u8 text1[] =
+  "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+  "tip for the future, sunscreen would be it.";
+
+static const u8 text2[] =
+  "Any submission to the IETF intended by the Contributor for publication as "
+  "all or part of an IETF Internet-Draft or RFC and any statement made within "
+  "the context of an IETF activity is considered an \"IETF Contribution\". "
+  "Such statements include oral statements in IETF sessions, as well as "
+  "written and electronic communications made at any time or place, which "
+  "are addressed to";
+
+const static struct
+{
+  char *name;
+  u32 len;
+  u32 counter;
+  const u8 key[32];
+  const u8 nonce[12];
+  const u8 *in;
+  const u8 *out;
+} test_cases[] = {
+  {
+    .name = "RFC8439 2.3.2",
+    .len = 64,
+    .counter = 1,
+    .key = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+	     0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+	     0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f },
+    .nonce = { 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00,
+	       0x00 },
+    .in = (u8[64]){},
+    .out =
+      (u8[64]){
+	     0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd,
+	     0x1f, 0xa3, 0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0,
+	     0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2,
+	     0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05,
+	     0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e,
+	     0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e },
+  },
+  {
+    .name = "RFC8439 2.4.2",
+    .len = sizeof (text1) - 1,
+    .counter = 1,
+    .key = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+	     0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+	     0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f },
+    .nonce = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00,
+	       0x00 },
+    .in = text1,
+    .out =
+      (u8[sizeof (text1) - 1]){
+		      0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80, 0x41, 0xba,
+		      0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81, 0xe9, 0x7e, 0x7a, 0xec,
+		      0x1d, 0x43, 0x60, 0xc2, 0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f,
+		      0xae, 0x0b, 0xf9, 0x1b, 0x65, 0xc5, 0x52, 0x47, 0x33, 0xab,
+		      0x8f, 0x59, 0x3d, 0xab, 0xcd, 0x62, 0xb3, 0x57, 0x16, 0x39,
+		      0xd6, 0x24, 0xe6, 0x51, 0x52, 0xab, 0x8f, 0x53, 0x0c, 0x35,
+		      0x9f, 0x08, 0x61, 0xd8, 0x07, 0xca, 0x0d, 0xbf, 0x50, 0x0d,
+		      0x6a, 0x61, 0x56, 0xa3, 0x8e, 0x08, 0x8a, 0x22, 0xb6, 0x5e,
+		      0x52, 0xbc, 0x51, 0x4d, 0x16, 0xcc, 0xf8, 0x06, 0x81, 0x8c,
+		      0xe9, 0x1a, 0xb7, 0x79, 0x37, 0x36, 0x5a, 0xf9, 0x0b, 0xbf,
+		      0x74, 0xa3, 0x5b, 0xe6, 0xb4, 0x0b, 0x8e, 0xed, 0xf2, 0x78,
+		      0x5e, 0x42, 0x87, 0x4d },
+  },
+  {
+    .name = "RFC8439 A2 TV2",
+    .len = sizeof (text2) - 1,
+    .counter = 1,
+    .key = { [31] = 0x01 },
+    .nonce = { [11] = 0x02 },
+    .in = text2,
+    .out =
+      (u8[sizeof (text2) - 1]){
+		      0xa3, 0xfb, 0xf0, 0x7d, 0xf3, 0xfa, 0x2f, 0xde, 0x4f, 0x37,
+		      0x6c, 0xa2, 0x3e, 0x82, 0x73, 0x70, 0x41, 0x60, 0x5d, 0x9f,
+		      0x4f, 0x4f, 0x57, 0xbd, 0x8c, 0xff, 0x2c, 0x1d, 0x4b, 0x79,
+		      0x55, 0xec, 0x2a, 0x97, 0x94, 0x8b, 0xd3, 0x72, 0x29, 0x15,
+		      0xc8, 0xf3, 0xd3, 0x37, 0xf7, 0xd3, 0x70, 0x05, 0x0e, 0x9e,
+		      0x96, 0xd6, 0x47, 0xb7, 0xc3, 0x9f, 0x56, 0xe0, 0x31, 0xca,
+		      0x5e, 0xb6, 0x25, 0x0d, 0x40, 0x42, 0xe0, 0x27, 0x85, 0xec,
+		      0xec, 0xfa, 0x4b, 0x4b, 0xb5, 0xe8, 0xea, 0xd0, 0x44, 0x0e,
+		      0x20, 0xb6, 0xe8, 0xdb, 0x09, 0xd8, 0x81, 0xa7, 0xc6, 0x13,
+		      0x2f, 0x42, 0x0e, 0x52, 0x79, 0x50, 0x42, 0xbd, 0xfa, 0x77,
+		      0x73, 0xd8, 0xa9, 0x05, 0x14, 0x47, 0xb3, 0x29, 0x1c, 0xe1,
+		      0x41, 0x1c, 0x68, 0x04, 0x65, 0x55, 0x2a, 0xa6, 0xc4, 0x05,
+		      0xb7, 0x76, 0x4d, 0x5e, 0x87, 0xbe, 0xa8, 0x5a, 0xd0, 0x0f,
+		      0x84, 0x49, 0xed, 0x8f, 0x72, 0xd0, 0xd6, 0x62, 0xab, 0x05,
+		      0x26, 0x91, 0xca, 0x66, 0x42, 0x4b, 0xc8, 0x6d, 0x2d, 0xf8,
+		      0x0e, 0xa4, 0x1f, 0x43, 0xab, 0xf9, 0x37, 0xd3, 0x25, 0x9d,
+		      0xc4, 0xb2, 0xd0, 0xdf, 0xb4, 0x8a, 0x6c, 0x91, 0x39, 0xdd,
+		      0xd7, 0xf7, 0x69, 0x66, 0xe9, 0x28, 0xe6, 0x35, 0x55, 0x3b,
+		      0xa7, 0x6c, 0x5c, 0x87, 0x9d, 0x7b, 0x35, 0xd4, 0x9e, 0xb2,
+		      0xe6, 0x2b, 0x08, 0x71, 0xcd, 0xac, 0x63, 0x89, 0x39, 0xe2,
+		      0x5e, 0x8a, 0x1e, 0x0e, 0xf9, 0xd5, 0x28, 0x0f, 0xa8, 0xca,
+		      0x32, 0x8b, 0x35, 0x1c, 0x3c, 0x76, 0x59, 0x89, 0xcb, 0xcf,
+		      0x3d, 0xaa, 0x8b, 0x6c, 0xcc, 0x3a, 0xaf, 0x9f, 0x39, 0x79,
+		      0xc9, 0x2b, 0x37, 0x20, 0xfc, 0x88, 0xdc, 0x95, 0xed, 0x84,
+		      0xa1, 0xbe, 0x05, 0x9c, 0x64, 0x99, 0xb9, 0xfd, 0xa2, 0x36,
+		      0xe7, 0xe8, 0x18, 0xb0, 0x4b, 0x0b, 0xc3, 0x9c, 0x1e, 0x87,
+		      0x6b, 0x19, 0x3b, 0xfe, 0x55, 0x69, 0x75, 0x3f, 0x88, 0x12,
+		      0x8c, 0xc0, 0x8a, 0xaa, 0x9b, 0x63, 0xd1, 0xa1, 0x6f, 0x80,
+		      0xef, 0x25, 0x54, 0xd7, 0x18, 0x9c, 0x41, 0x1f, 0x58, 0x69,
+		      0xca, 0x52, 0xc5, 0xb8, 0x3f, 0xa3, 0x6f, 0xf2, 0x16, 0xb9,
+		      0xc1, 0xd3, 0x00, 0x62, 0xbe, 0xbc, 0xfd, 0x2d, 0xc5, 0xbc,
+		      0xe0, 0x91, 0x19, 0x34, 0xfd, 0xa7, 0x9a, 0x86, 0xf6, 0xe6,
+		      0x98, 0xce, 0xd7, 0x59, 0xc3, 0xff, 0x9b, 0x64, 0x77, 0x33,
+		      0x8f, 0x3d, 0xa4, 0xf9, 0xcd, 0x85, 0x14, 0xea, 0x99, 0x82,
+		      0xcc, 0xaf, 0xb3, 0x41, 0xb2, 0x38, 0x4d, 0xd9, 0x02, 0xf3,
+		      0xd1, 0xab, 0x7a, 0xc6, 0x1d, 0xd2, 0x9c, 0x6f, 0x21, 0xba,
+		      0x5b, 0x86, 0x2f, 0x37, 0x30, 0xe3, 0x7c, 0xfd, 0xc4, 0xfd,
+		      0x80, 0x6c, 0x22, 0xf2, 0x21 },
+  },
+};
+
+static clib_error_t *
+test_clib_chacha20 (clib_error_t *err)
+{
+  u8 out[512] = {};
+  chacha20_key_t k;
+
+  FOREACH_ARRAY_ELT (tc, test_cases)
+    {
+      clib_chacha20_key_init (&k, tc->key);
+      clib_chacha20 (&k, tc->nonce, tc->counter, tc->in, out, tc->len);
+      if (memcmp (out, tc->out, tc->len) != 0)
+	err = clib_error_return (
+	  err,
+	  "\ntest:     %s"
+	  "\nkey:      %U"
+	  "\nexp out:  %U"
+	  "\ncalc out: %U\n",
+	  tc->name, format_hexdump, tc->key, 32, format_hexdump, tc->out,
+	  tc->len, format_hexdump, out, tc->len);
+    }
+  return err;
+}
+
+REGISTER_TEST (clib_chacha20) = {
+  .name = "clib_chacha20",
+  .fn = test_clib_chacha20,
+};
+
+static clib_error_t *
+test_clib_chacha20_lanes (clib_error_t *err)
+{
+  chacha20_block_t b[CHACHA20_N_LANES];
+  chacha20_key_t k;
+  u32 n_tc = ARRAY_LEN (test_cases);
+
+  /* each lane takes its key, nonce and block from different test case */
+  for (int i = 0; i < CHACHA20_N_LANES; i++)
+    {
+      typeof (test_cases[0]) *tc = test_cases + i % n_tc;
+      u32 blk = (i / n_tc) % (tc->len / CHACHA20_BLOCK_BYTES);
+      clib_chacha20_key_init (&k, tc->key);
+      clib_chacha20_block_init (b + i, &k, tc->nonce, tc->counter + blk);
+    }
+
+  clib_chacha20_blocks (b);
+
+  for (int i = 0; i < CHACHA20_N_LANES; i++)
+    {
+      typeof (test_cases[0]) *tc = test_cases + i % n_tc;
+      u32 blk = (i / n_tc) % (tc->len / CHACHA20_BLOCK_BYTES);
+      u32 off = blk * CHACHA20_BLOCK_BYTES;
+      for (int j = 0; j < CHACHA20_BLOCK_BYTES; j++)
+	if ((tc->in[off + j] ^ tc->out[off + j]) != b[i].as_u8[j])
+	  return clib_error_return (err, "lane %u (%s, block %u) mismatch", i,
+				    tc->name, blk);
+    }
+  return err;
+}
+
+void __test_perf_fn
+perftest_64byte (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  u8 *m = test_mem_alloc_and_fill_inc_u8 (n * 64, 0, 0);
+  u8 *k = test_mem_alloc_and_fill_inc_u8 (32, 0, 0);
+  chacha20_block_t b[CHACHA20_N_LANES];
+  chacha20_key_t key;
+
+  clib_chacha20_key_init (&key, k);
+
+  test_perf_event_enable (tp);
+  for (int i = 0; i < n; i += CHACHA20_N_LANES)
+    {
+      for (int j = 0; j < CHACHA20_N_LANES; j++)
+	clib_chacha20_block_init (b + j, &key, k + j, 0);
+      clib_chacha20_blocks (b);
+      for (int j = 0; j < CHACHA20_N_LANES; j++, m += 64)
+	clib_chacha20_xor (b + j, 0, m, m, 64);
+    }
+  test_perf_event_disable (tp);
+}
+
+void __test_perf_fn
+perftest_byte (test_perf_t *tp)
+{
+  u32 n = tp->n_ops;
+  u8 *m = test_mem_alloc_and_fill_inc_u8 (n, 0, 0);
+  u8 *k = test_mem_alloc_and_fill_inc_u8 (32, 0, 0);
+  chacha20_key_t key;
+
+  clib_chacha20_key_init (&key, k);
+
+  test_perf_event_enable (tp);
+  clib_chacha20 (&key, k, 1, m, m, n);
+  test_perf_event_disable (tp);
+}
+
+REGISTER_TEST (clib_chacha20_lanes) = {
+  .name = "clib_chacha20_lanes",
+  .fn = test_clib_chacha20_lanes,
+  .perf_tests = PERF_TESTS (
+    { .name = "single block per packet (64 bytes)",
+      .n_ops = 1024,
+      .fn = perftest_64byte },
+    { .name = "variable size (per byte)",
+      .n_ops = 16384,
+      .fn = perftest_byte }),
+};
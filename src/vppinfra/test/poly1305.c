@@ -229,6 +229,37 @@ test_clib_poly1305 (clib_error_t *err)
   return err;
 }
 
+static clib_error_t *
+test_clib_poly1305_update (clib_error_t *err)
+{
+  u8 out[16] = {};
+
+  /* feed data in odd sized pieces, so partial blocks get carried over */
+  FOREACH_ARRAY_ELT (tc, test_cases)
+    for (u32 step = 1; step < 34; step += 3)
+      {
+	clib_poly1305_ctx ctx;
+	clib_poly1305_init (&ctx, tc->key);
+	for (u32 off = 0; off < tc->len; off += step)
+	  clib_poly1305_update (&ctx, tc->msg + off,
+				clib_min (step, tc->len - off));
+	clib_poly1305_final (&ctx, out);
+	if (memcmp (out, tc->out, 16) != 0)
+	  err = clib_error_return (err,
+				   "\ntest:     %s (update step %u)"
+				   "\nexp out:  %U"
+				   "\ncalc out: %U\n",
+				   tc->name, step, format_hexdump, tc->out, 16,
+				   format_hexdump, out, 16);
+      }
+  return err;
+}
+
+REGISTER_TEST (clib_poly1305_update) = {
+  .name = "clib_poly1305_update",
+  .fn = test_clib_poly1305_update,
+};
+
 void __test_perf_fn
 perftest_64byte (test_perf_t *tp)
 {
@@ -72,6 +72,9 @@ static const u8 msg7[153] =
   "This is a test using a larger than block-size key and a larger than "
   "block-size data. The key needs to be hashed before being used by the "
   "HMAC algorithm.";
+static const u8 msg8[119] =
+  "A message of 118 bytes puts the padding byte of the last sha-512 block "
+  "into the high half of its 128 bit length field.";
 
 const sha2_test_t sha2_tests[] = {
   {
@@ -252,6 +255,33 @@ const sha2_test_t sha2_tests[] = {
 		    0x76, 0xfb, 0x6d, 0xe0, 0x44, 0x60, 0x65, 0xc9, 0x74, 0x40,
 		    0xfa, 0x8c, 0x6a, 0x58 },
   },
+  {
+    /* padding byte inside the sha-512 length field */
+    .tc = 8,
+    .key = key2,
+    .key_len = sizeof (key2),
+    .msg = msg8,
+    .msg_len = sizeof (msg8) - 1,
+    .digest_224 = { 0x47, 0x47, 0x2f, 0x0b, 0x06, 0x95, 0xbe, 0x51, 0x75, 0x17,
+		    0x49, 0x34, 0x56, 0xa3, 0x96, 0xed, 0xdd, 0x2c, 0x4a, 0xe9,
+		    0x61, 0xcd, 0x06, 0xcf, 0xa5, 0x0f, 0xea, 0x3d },
+    .digest_256 = { 0x98, 0x37, 0xf8, 0xf1, 0x52, 0x58, 0x31, 0x60,
+		    0x03, 0xb4, 0xca, 0xd4, 0xa3, 0x09, 0x71, 0x99,
+		    0x8e, 0x46, 0xf9, 0xe2, 0x10, 0x8c, 0x85, 0x74,
+		    0x1a, 0x73, 0x86, 0x71, 0x90, 0x8a, 0x9e, 0xb0 },
+    .digest_384 = { 0x17, 0x5b, 0xdb, 0x51, 0xe9, 0xca, 0x24, 0x57, 0x38, 0x53,
+		    0x84, 0x1b, 0x89, 0x69, 0x3c, 0x8c, 0x6c, 0x7a, 0x0f, 0x80,
+		    0x7d, 0xa0, 0x29, 0x53, 0xf7, 0xe9, 0x30, 0x55, 0xf5, 0x29,
+		    0x43, 0x9c, 0x5a, 0x45, 0xd5, 0xb3, 0xc0, 0xea, 0x2e, 0x6a,
+		    0x98, 0x1b, 0x48, 0x5c, 0x75, 0xa4, 0x9f, 0xd5 },
+    .digest_512 = { 0xf3, 0x75, 0x7e, 0x2f, 0x10, 0x4d, 0xd0, 0x2c, 0xfa, 0xf8,
+		    0x81, 0x9b, 0x98, 0x69, 0x6a, 0x20, 0xa2, 0x36, 0x47, 0x4d,
+		    0xbe, 0xb2, 0xd0, 0xa9, 0xab, 0x3c, 0x14, 0x9b, 0x9d, 0x02,
+		    0xbe, 0x81, 0xb5, 0xe2, 0xbb, 0x75, 0x3e, 0x9c, 0x63, 0x95,
+		    0x87, 0x14, 0x54, 0xbc, 0x34, 0x23, 0x41, 0x6b, 0xea, 0xb2,
+		    0xb3, 0x8e, 0x67, 0x9e, 0x93, 0x11, 0x98, 0x23, 0x2c, 0xbe,
+		    0x2e, 0x3b, 0x55, 0x56 },
+  },
   {}
 };
 #else
@@ -320,3 +350,86 @@ _ (256);
 _ (384);
 _ (512);
 #undef _
+
+#define SHA2_MB_TEST_N_MSGS 37
+
+#define _(bits)                                                               \
+  static clib_error_t *test_clib_hmac_sha##bits##_mb (clib_error_t *err)      \
+  {                                                                           \
+    clib_sha2_type_t type = CLIB_SHA2_##bits;                                 \
+    u8 digest_size = clib_sha2_variants[type].digest_size;                    \
+    clib_sha2_hmac_key_data_t kd[SHA2_MB_TEST_N_MSGS];                        \
+    clib_sha2_hmac_key_data_t *kdp[SHA2_MB_TEST_N_MSGS];                      \
+    const u8 *msg[SHA2_MB_TEST_N_MSGS];                                       \
+    u32 len[SHA2_MB_TEST_N_MSGS];                                             \
+    u8 *digest[SHA2_MB_TEST_N_MSGS];                                          \
+    u8 d[SHA2_MB_TEST_N_MSGS][64], expected[64];                              \
+    u8 *data = test_mem_alloc_and_fill_inc_u8 (1024, 0, 0);                   \
+    u8 *key = test_mem_alloc_and_fill_inc_u8 (256, 1, 0);                     \
+                                                                              \
+    /* lengths around block and padding boundaries, one key per message */    \
+    for (int n = 1; n <= SHA2_MB_TEST_N_MSGS; n++)                            \
+      {                                                                       \
+	for (int i = 0; i < n; i++)                                           \
+	  {                                                                   \
+	    clib_sha2_hmac_key_data (type, key + i, 16 + i * 5, kd + i);      \
+	    kdp[i] = kd + i;                                                  \
+	    msg[i] = data + i;                                                \
+	    len[i] = (i * 29 + n * 7) % 300;                                  \
+	    digest[i] = d[i];                                                 \
+	  }                                                                   \
+	clib_sha2_hmac_mb (type, kdp, msg, len, digest, n);                   \
+	for (int i = 0; i < n; i++)                                           \
+	  {                                                                   \
+	    clib_hmac_sha##bits (key + i, 16 + i * 5, msg[i], len[i],         \
+				 expected);                                   \
+	    if ((err = check_digest (err, i, d[i], expected, digest_size)))   \
+	      return err;                                                     \
+	  }                                                                   \
+      }                                                                       \
+                                                                              \
+    return err;                                                               \
+  }                                                                           \
+                                                                              \
+  void __test_perf_fn perftest_sha##bits##_mb_byte (test_perf_t *tp)          \
+  {                                                                           \
+    volatile uword *np = &tp->n_ops;                                          \
+    volatile uword *ml = &tp->arg0;                                           \
+    u32 n_msgs = *np / *ml;                                                   \
+    clib_sha2_hmac_key_data_t kd;                                             \
+    clib_sha2_hmac_key_data_t **kdp;                                          \
+    const u8 **msg = test_mem_alloc (n_msgs * sizeof (msg[0]));               \
+    u32 *len = test_mem_alloc (n_msgs * sizeof (len[0]));                     \
+    u8 **digest = test_mem_alloc (n_msgs * sizeof (digest[0]));               \
+    u8 *data = test_mem_alloc_and_fill_inc_u8 (*np, 0, 0);                    \
+    u8 *d = test_mem_alloc (n_msgs * 64);                                     \
+    u8 *key = test_mem_alloc_and_fill_inc_u8 (20, 32, 0);                     \
+                                                                              \
+    kdp = test_mem_alloc (n_msgs * sizeof (kdp[0]));                          \
+    clib_sha2_hmac_key_data (CLIB_SHA2_##bits, key, 20, &kd);                 \
+    for (u32 i = 0; i < n_msgs; i++)                                          \
+      {                                                                       \
+	kdp[i] = &kd;                                                         \
+	msg[i] = data + i * *ml;                                              \
+	len[i] = *ml;                                                         \
+	digest[i] = d + i * 64;                                               \
+      }                                                                       \
+                                                                              \
+    test_perf_event_enable (tp);                                              \
+    clib_sha2_hmac_mb (CLIB_SHA2_##bits, kdp, msg, len, digest, n_msgs);      \
+    test_perf_event_disable (tp);                                             \
+  }                                                                           \
+  REGISTER_TEST (clib_hmac_sha##bits##_mb) = {                                \
+    .name = "clib_hmac_sha" #bits "_mb",                                      \
+    .fn = test_clib_hmac_sha##bits##_mb,                                      \
+    .perf_tests = PERF_TESTS ({ .name = "byte",                               \
+				.n_ops = 16384,                               \
+				.arg0 = 1024,                                 \
+				.fn = perftest_sha##bits##_mb_byte })         \
+  }
+
+_ (224);
+_ (256);
+_ (384);
+_ (512);
+#undef _
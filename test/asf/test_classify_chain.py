@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from asfframework import VppAsfTestCase, VppTestRunner
+
+
+class TestClassifyChain(VppAsfTestCase):
+    """Classifier Chain Lookup Test Cases"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestClassifyChain, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestClassifyChain, cls).tearDownClass()
+
+    def test_classify_chain(self):
+        """Staged and per-packet chain lookups agree"""
+        error = self.vapi.cli("test classify chain tables 4 iterations 10")
+        if error.find("failed") != -1:
+            self.logger.critical("FAILURE in the classify chain test")
+        self.assertNotIn("failed", error)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
@@ -24,6 +24,43 @@ class TestCrypto(VppAsfTestCase):
             self.logger.critical(error)
         self.assertNotIn("FAIL", error)
 
+    def test_crypto_bench(self):
+        """Crypto engine benchmark sweep"""
+        reply = self.vapi.cli(
+            "test crypto bench alg aes-128-gcm size 64 size 1500 "
+            "batch 1 batch 32 chunk-size 256 bytes 65536 async"
+        )
+
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("engine,op,mode,data,size,batch,gbps", reply)
+        self.assertIn(",encrypt-aes-128-gcm,sync,flat,1500,32,", reply)
+        # native gcm walks the chunks itself
+        self.assertIn("native,decrypt-aes-128-gcm,sync,chained,1500,32,", reply)
+
+
+class TestCryptoCalibrate(VppAsfTestCase):
+    """Crypto Engine Calibration Test Case"""
+
+    extra_vpp_config = ["crypto-engines { calibrate per-size }"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestCryptoCalibrate, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestCryptoCalibrate, cls).tearDownClass()
+
+    def test_crypto_calibrate(self):
+        """Calibrated handlers are shown"""
+        reply = self.vapi.cli("show crypto handlers")
+
+        self.logger.info(reply)
+        self.assertIn("calibrated, simple handler clocks/byte at 64/1500", reply)
+        # ops with more than one engine have their handlers timed
+        self.assertRegex(reply, r"\(\d*\.\d+/\d*\.\d+\)")
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
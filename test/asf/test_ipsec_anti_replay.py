@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from asfframework import VppAsfTestCase, VppTestRunner
+
+
+class TestIpsecAntiReplay(VppAsfTestCase):
+    """IPsec Anti-replay Test Cases"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIpsecAntiReplay, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIpsecAntiReplay, cls).tearDownClass()
+
+    def test_ipsec_anti_replay_multi_worker(self):
+        """Multi-worker replay window matches the single worker one"""
+        for window in [64, 1024]:
+            error = self.vapi.cli(
+                "test ipsec anti-replay multi-worker packets 65536 "
+                "window %d threads 4" % window
+            )
+            if error.find("failed") != -1:
+                self.logger.critical("FAILURE in the ipsec anti-replay test")
+            self.assertNotIn("failed", error)
+
+    def test_ipsec_anti_replay_batch(self):
+        """Batched replay window advance matches the per-packet one"""
+        for loss in [0, 1, 20]:
+            error = self.vapi.cli(
+                "test ipsec anti-replay batch frames 1024 loss %d" % loss
+            )
+            if error.find("failed") != -1:
+                self.logger.critical("FAILURE in the ipsec anti-replay test")
+            self.assertNotIn("failed", error)
+
+    def test_ipsec_seq_multi_worker(self):
+        """Idle worker's sequence numbers stay in the window"""
+        error = self.vapi.cli("test ipsec seq multi-worker workers 4 runs 4096")
+        if error.find("failed") != -1:
+            self.logger.critical("FAILURE in the ipsec sequence number test")
+        self.assertNotIn("failed", error)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
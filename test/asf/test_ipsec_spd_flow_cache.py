@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from asfframework import VppAsfTestCase, VppTestRunner
+
+
+class TestIpsecSpdFlowCache(VppAsfTestCase):
+    """IPsec SPD Flow Cache Test Cases"""
+
+    @classmethod
+    def setUpConstants(cls):
+        super(TestIpsecSpdFlowCache, cls).setUpConstants()
+        cls.vpp_cmdline.extend(
+            [
+                "ipsec",
+                "{",
+                "ipv4-outbound-spd-flow-cache on",
+                "ipv4-outbound-spd-hash-buckets 65536",
+                "}",
+            ]
+        )
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIpsecSpdFlowCache, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIpsecSpdFlowCache, cls).tearDownClass()
+
+    def test_ipsec_spd_flow_cache(self):
+        """Flow cache agrees with the SPD under policy churn"""
+        error = self.vapi.cli("test ipsec spd flow-cache policies 64 iterations 10")
+        if error.find("failed") != -1:
+            self.logger.critical("FAILURE in the ipsec spd flow cache test")
+        self.assertNotIn("failed", error)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
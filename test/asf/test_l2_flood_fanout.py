@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from asfframework import VppAsfTestCase, VppTestRunner
+
+
+class TestL2FloodFanout(VppAsfTestCase):
+    """L2 Flood Fanout Test Cases"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestL2FloodFanout, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestL2FloodFanout, cls).tearDownClass()
+
+    def test_l2_flood_fanout(self):
+        """Flood lists agree with the bridge domain members"""
+        error = self.vapi.cli("test l2 flood fanout members 64 iterations 10")
+        if error.find("failed") != -1:
+            self.logger.critical("FAILURE in the l2 flood fanout test")
+        self.assertNotIn("failed", error)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
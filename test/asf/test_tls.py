@@ -155,6 +155,90 @@ class TestTLS(VppAsfTestCase):
         ip_t01.remove_vpp_config()
         ip_t10.remove_vpp_config()
 
+    def test_tls_vnet_crypto_records(self):
+        """TLS echo client/server transfer with vnet crypto records"""
+
+        # Add inter-table routes
+        ip_t01 = VppIpRoute(
+            self,
+            self.loop1.local_ip4,
+            32,
+            [VppRoutePath("0.0.0.0", 0xFFFFFFFF, nh_table_id=1)],
+        )
+
+        ip_t10 = VppIpRoute(
+            self,
+            self.loop0.local_ip4,
+            32,
+            [VppRoutePath("0.0.0.0", 0xFFFFFFFF, nh_table_id=0)],
+            table_id=1,
+        )
+        ip_t01.add_vpp_config()
+        ip_t10.add_vpp_config()
+
+        self.vapi.cli("tls openssl set-tls vnet-crypto-records")
+
+        # Start builtin server and client, data is checked by the client
+        uri = "tls://" + self.loop0.local_ip4 + "/1235"
+        error = self.vapi.cli(
+            "test echo server appns 0 fifo-size 64k tls-engine 1 uri " + uri
+        )
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn("failed", error)
+
+        error = self.vapi.cli(
+            "test echo client bytes 1m appns 1 "
+            "fifo-size 64k test-bytes "
+            "tls-engine 1 "
+            "syn-timeout 2 uri " + uri
+        )
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn("failed", error)
+
+        # Both ends of the connection were handed over after the handshake
+        reply = self.vapi.cli("show tls openssl records")
+        self.logger.info(reply)
+        n_started = int(re.search(r"handed over: (\d+)", reply).group(1))
+        self.assertGreaterEqual(n_started, 2)
+
+        # Delete inter-table routes
+        ip_t01.remove_vpp_config()
+        ip_t10.remove_vpp_config()
+
+
+class TestTLSRecord(VppAsfTestCase):
+    """TLS Record Protection Test Case"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestTLSRecord, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestTLSRecord, cls).tearDownClass()
+
+    def test_tls_record(self):
+        """Batched record protection matches per record protection"""
+        reply = self.vapi.cli(
+            "test tls record alg aes-128-gcm alg chacha20-poly1305 bytes 65536"
+        )
+
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("aes-128-gcm,batch,encrypt,16384,4,", reply)
+        self.assertIn("aes-128-gcm,record,decrypt,16384,4,", reply)
+        # mixed size writes coalesce into full records
+        self.assertIn("aes-128-gcm,coalesce,4,16384.00,", reply)
+
+        reply = self.vapi.cli(
+            "test tls record record-size 1000 bytes 65536 "
+            "write-size 100 write-size 3000 coalesce-time 10"
+        )
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
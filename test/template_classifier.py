@@ -366,16 +366,26 @@ class TestClassifier(VppTestCase):
                 "didn't arrive" % (dst_if.name, i.name),
             )
 
-    def create_classify_table(self, key, mask, data_offset=0, next_table_index=None):
+    def create_classify_table(
+        self,
+        key,
+        mask,
+        data_offset=0,
+        next_table_index=None,
+        table_type=None,
+        nbuckets=2,
+    ):
         """Create Classify Table
 
         :param str key: key for classify table (ex, ACL name).
         :param str mask: mask value for interested traffic.
         :param int data_offset:
         :param str next_table_index
+        :param table_type: session storage, paged by default
+        :param int nbuckets: number of hash buckets
         """
         mask_match, mask_match_len = self._resolve_mask_match(mask)
-        r = self.vapi.classify_add_del_table(
+        args = dict(
             is_add=1,
             mask=mask_match,
             mask_len=mask_match_len,
@@ -384,7 +394,12 @@ class TestClassifier(VppTestCase):
             current_data_flag=1,
             current_data_offset=data_offset,
             next_table_index=next_table_index,
+            nbuckets=nbuckets,
         )
+        if table_type is None:
+            r = self.vapi.classify_add_del_table(**args)
+        else:
+            r = self.vapi.classify_add_del_table_v2(table_type=table_type, **args)
         self.assertIsNotNone(r, "No response msg for add_del_table")
         self.acl_tbl_idx[key] = r.new_table_index
 
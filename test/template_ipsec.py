@@ -3318,5 +3318,35 @@ class IPSecIPv6Fwd(VppTestCase):
         self.assert_equal(pkt_count, matched_pkts)
 
 
+class SpdFlowCacheIPv6Template(IPSecIPv6Fwd):
+    def get_spd_flow_cache_entries(self, outbound):
+        """'show ipsec spd' output:
+        ipv6-inbound-spd-flow-cache-entries: 0
+        ipv6-outbound-spd-flow-cache-entries: 0
+        """
+        show_ipsec_reply = self.vapi.cli("show ipsec spd")
+        direction = "outbound" if outbound else "inbound"
+        regex_match = re.search(
+            "ipv6-%s-spd-flow-cache-entries: ([0-9]+)" % direction, show_ipsec_reply
+        )
+        if regex_match is None:
+            raise Exception(
+                "Unable to find spd flow cache entries \
+                in 'show ipsec spd' CLI output - regex failed to match"
+            )
+        self.logger.info("%s", regex_match.group(0))
+        return int(regex_match.group(1))
+
+    def verify_num_outbound_flow_cache_entries(self, expected_elements):
+        self.assertEqual(
+            self.get_spd_flow_cache_entries(outbound=True), expected_elements
+        )
+
+    def verify_num_inbound_flow_cache_entries(self, expected_elements):
+        self.assertEqual(
+            self.get_spd_flow_cache_entries(outbound=False), expected_elements
+        )
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -1,7 +1,9 @@
 #!/usr/bin/env python3
 
+import re
 import socket
 import unittest
+from ipaddress import ip_address
 
 from asfframework import VppTestRunner
 from scapy.packet import Raw
@@ -120,6 +122,78 @@ class TestClassifierIP(TestClassifier):
         self.pg2.assert_nothing_captured(remark="packets forwarded")
         self.pg3.assert_nothing_captured(remark="packets forwarded")
 
+    def test_iacl_src_ip_cuckoo(self):
+        """Source IP iACL test, cuckoo session storage
+
+        Test scenario for IP ACL on a table with cuckoo session storage
+            - Create IPv4 stream for pg0 -> pg1 interface.
+            - Create a small cuckoo table and fill most of it, so that
+              sessions are displaced to their alternate bucket.
+            - Send and verify received packets on pg1 interface.
+        """
+
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+
+        key = "ip_src_cuckoo"
+        self.create_classify_table(
+            key,
+            self.build_ip_mask(src_ip="ffffffff"),
+            table_type=VppEnum.vl_api_classify_table_type_t.CLASSIFY_API_TABLE_TYPE_CUCKOO,
+            nbuckets=8,
+        )
+        # 8 buckets of 8 sessions, fill them to 7/8. These addresses fill
+        # both buckets of some of them, which then displace a session
+        fillers = [str(ip_address("10.255.0.0") + 6 * i) for i in range(55)]
+        for src_ip in fillers:
+            self.create_classify_session(
+                self.acl_tbl_idx.get(key), self.build_ip_match(src_ip=src_ip)
+            )
+        self.create_classify_session(
+            self.acl_tbl_idx.get(key), self.build_ip_match(src_ip=self.pg0.remote_ip4)
+        )
+        self.input_acl_set_interface(self.pg0, self.acl_tbl_idx.get(key))
+        self.acl_active_table = key
+
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        pkts = self.pg1.get_capture(len(pkts))
+        self.verify_capture(self.pg1, pkts)
+        self.pg0.assert_nothing_captured(remark="packets forwarded")
+        self.pg2.assert_nothing_captured(remark="packets forwarded")
+        self.pg3.assert_nothing_captured(remark="packets forwarded")
+
+        reply = self.vapi.cli(
+            "show classify tables index %d verbose" % self.acl_tbl_idx.get(key)
+        )
+        self.assertIn("cuckoo", reply)
+        self.assertIn("56 active elements", reply)
+        self.assertIn("0 failed inserts", reply)
+        displacements = int(re.search(r"(\d+) displacements", reply).group(1))
+        self.assertGreater(displacements, 0)
+
+        # delete every other filler session, the rest must still be found
+        for src_ip in fillers[::2]:
+            self.create_classify_session(
+                self.acl_tbl_idx.get(key),
+                self.build_ip_match(src_ip=src_ip),
+                is_add=0,
+            )
+        reply = self.vapi.cli(
+            "show classify tables index %d verbose" % self.acl_tbl_idx.get(key)
+        )
+        self.assertIn("28 active elements", reply)
+
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        pkts = self.pg1.get_capture(len(pkts))
+        self.verify_capture(self.pg1, pkts)
+        self.pg0.assert_nothing_captured(remark="packets forwarded")
+
 
 class TestClassifierUDP(TestClassifier):
     """Classifier UDP proto Test Case"""
@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+
+import re
+import unittest
+
+from config import config
+from framework import VppTestCase
+from asfframework import VppTestRunner
+from vpp_ip_route import VppIpRoute, VppRoutePath
+from vpp_papi_provider import CliFailedCommandError
+from vpp_sub_interface import VppDot1QSubint
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
+NUM_PKTS = 30
+
+
+class TestHQoS(VppTestCase):
+    """Hierarchical QoS Scheduler Test Case"""
+
+    def setUp(self):
+        super(TestHQoS, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        self.vapi.cli("set interface hqos pg1 disable")
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestHQoS, self).tearDown()
+
+    def create_stream(self, count, tos=0, dst=None):
+        return [
+            (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=self.pg0.remote_ip4, dst=dst or self.pg1.remote_ip4, tos=tos)
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+            for i in range(count)
+        ]
+
+    def test_hqos_forward(self):
+        """Forward through 64k pipes"""
+        self.vapi.cli(
+            "set interface hqos pg1 rate 10 gbps subports 16 pipes 4096 "
+            "pipe-rate 100 mbps"
+        )
+        self.assertIn("16 subports", self.vapi.cli("show hqos pg1"))
+
+        self.send_and_expect(self.pg0, self.create_stream(NUM_PKTS), self.pg1)
+
+        self.assertEqual(
+            self.statistics.get_err_counter("/err/hqos-enqueue/queued"), NUM_PKTS
+        )
+        self.assertIn(
+            "tx %d packets" % NUM_PKTS, self.vapi.cli("show hqos pg1 verbose")
+        )
+
+    def test_hqos_config_errors(self):
+        """Configuration errors are reported"""
+
+        def assert_cli_error(cmd, msg):
+            with self.assertRaises(CliFailedCommandError) as e:
+                self.vapi.cli(cmd)
+            self.assertIn(msg, str(e.exception))
+
+        sub_if = VppDot1QSubint(self, self.pg1, 10)
+        sub_if.admin_up()
+
+        assert_cli_error("set interface hqos pg1", "rate required")
+        assert_cli_error(
+            "set interface hqos pg1 rate 1 gbps subports 0", "must be non-zero"
+        )
+        assert_cli_error(
+            "set interface hqos pg1.10 rate 1 gbps", "shape the parent interface"
+        )
+        assert_cli_error("set interface hqos pipe pg1 0 rate 1 mbps", "not enabled")
+
+        self.vapi.cli("set interface hqos pg1 rate 1 gbps pipes 4")
+        assert_cli_error("set interface hqos pg1 rate 1 gbps", "already enabled")
+        assert_cli_error("set interface hqos pipe pg1 4 rate 1 mbps", "out of range")
+        self.vapi.cli("set interface hqos pipe pg1 3 rate 1 mbps weight 2")
+
+        sub_if.remove_vpp_config()
+
+    def test_hqos_api(self):
+        """Configure through the binary API"""
+        self.vapi.hqos_port_enable_disable(
+            sw_if_index=self.pg1.sw_if_index,
+            rate=10**9,
+            n_subports=2,
+            n_pipes_per_subport=8,
+            queue_size=16,
+        )
+        reply = self.vapi.cli("show hqos pg1")
+        self.assertIn("rate 1.00 gbps", reply)
+        self.assertIn("2 subports at 1.00 gbps, 8 pipes each", reply)
+        self.assertIn("queue size 16", reply)
+
+        self.vapi.hqos_pipe_config(
+            sw_if_index=self.pg1.sw_if_index, pipe=3, rate=10**6, weight=2
+        )
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.hqos_pipe_config(
+                sw_if_index=self.pg1.sw_if_index, pipe=16, rate=10**6
+            )
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.hqos_dscp_tc_set(dscp=64, tc=0)
+
+        # CS1 as network control
+        self.vapi.hqos_dscp_tc_set(dscp=8, tc=0)
+        pkts = self.create_stream(NUM_PKTS) + self.create_stream(NUM_PKTS, tos=8 << 2)
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+        self.assertEqual([p[IP].tos for p in rx[:NUM_PKTS]], [8 << 2] * NUM_PKTS)
+        self.vapi.hqos_dscp_tc_set(dscp=8, tc=3)
+
+        self.vapi.hqos_port_enable_disable(
+            sw_if_index=self.pg1.sw_if_index, enable=False
+        )
+        self.assertEqual(self.vapi.cli("show hqos pg1"), "")
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.hqos_port_enable_disable(
+                sw_if_index=self.pg1.sw_if_index, enable=False
+            )
+
+        # leave it enabled for tearDown
+        self.vapi.hqos_port_enable_disable(sw_if_index=self.pg1.sw_if_index, rate=10**9)
+
+    def test_hqos_priority(self):
+        """Strict priority between traffic classes"""
+        self.vapi.cli("set interface hqos pg1 rate 10 gbps")
+
+        # best effort first, then network control (CS6) in the same frame
+        pkts = self.create_stream(NUM_PKTS) + self.create_stream(NUM_PKTS, tos=48 << 2)
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # the higher class overtakes the queued best effort traffic
+        self.assertEqual([p[IP].tos for p in rx[:NUM_PKTS]], [48 << 2] * NUM_PKTS)
+        self.assertEqual([p[IP].tos for p in rx[NUM_PKTS:]], [0] * NUM_PKTS)
+
+    def test_hqos_queue_limit(self):
+        """Tail drop on a full traffic class queue"""
+        self.vapi.cli("set interface hqos pg1 rate 10 gbps queue-size 8")
+
+        self.pg0.add_stream(self.create_stream(NUM_PKTS))
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        drops = self.statistics.get_err_counter("/err/hqos-enqueue/queue_full")
+        self.assertGreater(drops, 0)
+        self.pg1.get_capture(NUM_PKTS - drops)
+
+    def test_hqos_shaping(self):
+        """Low rate port shaper over several pipes"""
+        # 4 consecutive addresses land in the 4 pipes
+        self.pg1.generate_remote_hosts(4)
+        self.pg1.configure_ipv4_neighbors()
+        self.vapi.cli("set interface hqos pg1 rate 10 kbps pipes 4 queue-size 8")
+
+        # 142 bytes on the wire plus HQOS_FRAME_OVERHEAD
+        wire_len = 142 + 24
+        pkts = []
+        for h in self.pg1.remote_hosts:
+            pkts += self.create_stream(2 * 8, dst=h.ip4)
+
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        # half of each pipe's packets don't fit its queue
+        drops = self.statistics.get_err_counter("/err/hqos-enqueue/queue_full")
+        self.assertEqual(drops, 4 * 8)
+
+        # the first burst goes at once, the rest at 1250 bytes/s
+        rx = self.pg1.get_capture(4 * 8, timeout=10)
+
+        for h in self.pg1.remote_hosts:
+            self.assertEqual(len([p for p in rx if p[IP].dst == h.ip4]), 8)
+
+        reply = self.vapi.cli("show hqos pg1 verbose")
+        tx = re.findall(r"tx (\d+) packets (\d+) bytes", reply)
+        self.assertEqual(sum(int(b) for p, b in tx), 4 * 8 * wire_len)
+
+        # the backlog past the burst was held back by the port shaper, and
+        # the dequeue slept until tokens were due, at least one packet per
+        # wake up, instead of polling for them
+        waits = self.statistics.get_err_counter("/err/hqos-dequeue/shaper_wait")
+        self.assertGreater(waits, 0)
+        self.assertLessEqual(waits, 4 * 8)
+
+    @unittest.skipUnless(config.extended, "part of extended tests")
+    def test_hqos_perf(self):
+        """pg benchmark: Mpps and shaping accuracy over 64k pipes"""
+        n_pipes = 16 * 4096
+        rate_mbps = 50
+        # 128 byte frames offered at about 55 Mbps, so the port shaper is
+        # the bottleneck for the whole run
+        pps = 45000
+
+        self.vapi.hqos_port_enable_disable(
+            sw_if_index=self.pg1.sw_if_index,
+            rate=rate_mbps * 10**6,
+            n_subports=16,
+            n_pipes_per_subport=4096,
+        )
+        route = VppIpRoute(
+            self,
+            "10.0.0.0",
+            16,
+            [VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)],
+        ).add_vpp_config()
+
+        # one packet to each of the 64k pipes
+        self.vapi.cli(
+            "packet-generator new {\n"
+            "  name hqos-perf\n"
+            "  limit %d\n"
+            "  rate %d\n"
+            "  size 128-128\n"
+            "  node ethernet-input\n"
+            "  source pg0\n"
+            "  data {\n"
+            "    IP4: %s -> %s\n"
+            "    UDP: %s -> 10.0.0.0-10.0.255.255\n"
+            "    UDP: 1234 -> 1234\n"
+            "    incrementing 86\n"
+            "  }\n"
+            "}\n"
+            % (
+                n_pipes,
+                pps,
+                self.pg0.remote_mac,
+                self.pg0.local_mac,
+                self.pg0.remote_ip4,
+            )
+        )
+        self.vapi.cli("clear runtime")
+        self.vapi.cli("packet-generator enable-stream hqos-perf")
+
+        # wait for the backlog to drain through the shaper
+        for i in range(300):
+            reply = self.vapi.cli("show hqos pg1 verbose")
+            tx = re.findall(r"tx (\d+) packets", reply)
+            if sum(int(p) for p in tx) == n_pipes:
+                break
+            self.sleep(0.1)
+        self.assertEqual(sum(int(p) for p in tx), n_pipes)
+        self.assertEqual(
+            self.statistics.get_err_counter("/err/hqos-enqueue/queue_full"), 0
+        )
+
+        # clocks per packet of the two hqos nodes, as show runtime has them
+        runtime = self.vapi.cli("show runtime")
+        clocks = 0.0
+        for line in runtime.splitlines():
+            f = line.split()
+            if f and f[0] in ("hqos-enqueue", "hqos-dequeue"):
+                clocks += float(f[-2])
+        ghz = float(
+            re.search(r"Base frequency:\s+([\d.]+) GHz", self.vapi.cli("show cpu"))[1]
+        )
+        shaped = re.search(r"shaped at (\S+ \S+), ([\d.]+)% of the port rate", reply)
+        self.logger.info(
+            "hqos over %d pipes: %.1f clocks/packet, %.2f Mpps, "
+            "shaped at %s (%s%% of %d mbps)"
+            % (n_pipes, clocks, ghz * 1e3 / clocks, shaped[1], shaped[2], rate_mbps)
+        )
+
+        # a token bucket never lets more than its rate through
+        self.assertLessEqual(float(shaped[2]), 101.0)
+        self.assertGreaterEqual(float(shaped[2]), 90.0)
+
+        self.vapi.cli("packet-generator delete hqos-perf")
+        route.remove_vpp_config()
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
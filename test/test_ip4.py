@@ -237,6 +237,23 @@ class TestIPv4(VppTestCase):
             pkts = i.parent.get_capture()
             self.verify_capture(i, pkts)
 
+    def test_rewrite_perf(self):
+        """IPv4 rewrite across many adjacencies"""
+
+        # consecutive packets of a frame use different adjacencies, so
+        # ip4-rewrite cannot rely on the rewrite of the previous packet
+        # being in cache
+        self.pg1.generate_remote_hosts(64)
+        self.pg1.configure_ipv4_neighbors()
+
+        reply = self.vapi.cli(
+            "test ip4 forward perf rx pg0 dst %s dsts 64 frames 16 "
+            "no-fast-forward verbose" % self.pg1.remote_hosts[0].ip4
+        )
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("ip4-rewrite", reply)
+
 
 class TestIPv4RouteLookup(VppTestCase):
     """IPv4 Route Lookup Test Case"""
@@ -2481,6 +2498,120 @@ class TestIPInput(VppTestCase):
         rx = self.send_and_assert_no_replies(self.pg0, p_s0 * 17)
 
 
+class TestIPFastForward(TestIPInput):
+    """IPv4 Fast Forward"""
+
+    def setUp(self):
+        super(TestIPFastForward, self).setUp()
+
+        for i in self.pg_interfaces:
+            self.vapi.cli("set interface ip4-fast-forward %s" % i.name)
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            self.vapi.cli("set interface ip4-fast-forward %s disable" % i.name)
+        super(TestIPFastForward, self).tearDown()
+
+    def test_ip_fast_forward(self):
+        """IP Fast Forward"""
+
+        fwd = "/err/ip4-fast-forward/forwarded"
+        slow = "/err/ip4-fast-forward/slow-path"
+        n_fwd = self.statistics.get_err_counter(fwd)
+        n_slow = self.statistics.get_err_counter(slow)
+
+        #
+        # a plain unicast packet is forwarded by the fast path
+        #
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4, ttl=10)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        rxs = self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        for rx in rxs:
+            self.assertEqual(rx[Ether].src, self.pg1.local_mac)
+            self.assertEqual(rx[Ether].dst, self.pg1.remote_mac)
+            self.assertEqual(rx[IP].ttl, 9)
+            # let scapy recompute the checksum to validate it
+            chksum = rx[IP].chksum
+            del rx[IP].chksum
+            self.assertEqual(chksum, IP(bytes(rx[IP])).chksum)
+
+        self.assertEqual(n_fwd + NUM_PKTS, self.statistics.get_err_counter(fwd))
+
+        #
+        # a packet whose TTL expires takes the full graph, which generates
+        # the ICMP error
+        #
+        p_ttl = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4, ttl=1)
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+
+        rxs = self.send_and_expect_some(self.pg0, p_ttl * NUM_PKTS, self.pg0)
+
+        for rx in rxs:
+            self.assertEqual(icmptypes[rx[ICMP].type], "time-exceeded")
+        self.assertEqual(n_slow + NUM_PKTS, self.statistics.get_err_counter(slow))
+
+        #
+        # and so does a packet for us
+        #
+        p_us = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+            / ICMP(id=4, seq=4)
+            / Raw(load=b"\x0a" * 18)
+        )
+        self.send_and_expect(self.pg0, p_us * NUM_PKTS, self.pg0)
+
+        #
+        # with another device-input feature on the interface, here SPAN
+        # mirroring pg0's input to pg1, every packet takes the full graph
+        #
+        self.vapi.sw_interface_span_enable_disable(
+            self.pg0.sw_if_index, self.pg1.sw_if_index
+        )
+        n_fwd = self.statistics.get_err_counter(fwd)
+        n_slow = self.statistics.get_err_counter(slow)
+
+        rxs = self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1, n_rx=2 * NUM_PKTS)
+
+        self.assertEqual(
+            NUM_PKTS, len([rx for rx in rxs if rx[Ether].src == self.pg1.local_mac])
+        )
+        self.assertEqual(n_fwd, self.statistics.get_err_counter(fwd))
+        self.assertEqual(n_slow + NUM_PKTS, self.statistics.get_err_counter(slow))
+
+        self.vapi.sw_interface_span_enable_disable(
+            self.pg0.sw_if_index, self.pg1.sw_if_index, state=0
+        )
+
+    def test_ip_fast_forward_perf(self):
+        """IP Fast Forward against the full graph"""
+
+        reply = self.vapi.cli(
+            "test ip4 forward perf rx pg0 dst %s frames 16 verbose"
+            % self.pg1.remote_ip4
+        )
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("full graph", reply)
+        self.assertIn("fast forward", reply)
+
+        # the feature is left as it was
+        self.assertIn(
+            "ip4-fast-forward",
+            self.vapi.cli("show interface features pg0"),
+        )
+
+
 class TestIPDirectedBroadcast(VppTestCase):
     """IPv4 Directed Broadcast"""
 
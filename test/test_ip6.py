@@ -433,6 +433,35 @@ class TestIPv6(TestIPv6ND):
             pkts = i.parent.get_capture()
             self.verify_capture(i, pkts)
 
+    def test_rewrite_perf(self):
+        """IPv6 rewrite across many adjacencies"""
+
+        # consecutive packets of a frame use different adjacencies, so
+        # ip6-rewrite cannot rely on the rewrite of the previous packet
+        # being in cache
+        self.pg2.generate_remote_hosts(64)
+        self.pg2.configure_ipv6_neighbors()
+
+        pkts = [
+            (
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IPv6(src=self.pg0.remote_ip6, dst=h.ip6)
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 64)
+            )
+            for h in self.pg2.remote_hosts
+        ] * 16
+
+        self.vapi.cli("clear runtime")
+        rxs = self.send_and_expect(self.pg0, pkts, self.pg2)
+        self.logger.info(self.vapi.cli("show runtime ip6-rewrite"))
+
+        # each packet went out with the rewrite of its own neighbour
+        macs = {h.ip6: h.mac for h in self.pg2.remote_hosts}
+        for rx in rxs:
+            self.assertEqual(rx[Ether].dst, macs[rx[IPv6].dst])
+            self.assertEqual(rx[IPv6].hlim, 63)
+
     def test_ns(self):
         """IPv6 Neighbour Solicitation Exceptions
 
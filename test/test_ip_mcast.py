@@ -53,6 +53,15 @@ class TestMFIB(VppTestCase):
             self.logger.critical(error)
         self.assertNotIn("Failed", error)
 
+    def test_replicate_perf(self):
+        """Replicate fan-out benchmark"""
+        reply = self.vapi.cli("test ip4 replicate perf fanout 300 frames 8")
+
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        # above 255, where the clone count used to be truncated
+        self.assertIn("     300", reply)
+
 
 @tag_fixme_vpp_workers
 class TestIPMcast(VppTestCase):
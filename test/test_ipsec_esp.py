@@ -759,12 +759,73 @@ class TestIpsecEspAsync(TemplateIpsecEsp):
                 rx.show()
                 self.assertTrue(False)
 
+        workers = self.vapi.cli("show sw_scheduler workers")
+        self.logger.info(workers)
+        self.assertIn("Steal-rate", workers)
+
         self.p_sync.spd.remove_vpp_config()
         self.p_sync.sa.remove_vpp_config()
         self.p_async.spd.remove_vpp_config()
         self.p_async.sa.remove_vpp_config()
         self.vapi.ipsec_set_async_mode(async_enable=False)
 
+    def sw_scheduler_workers(self):
+        """per worker counters from show sw_scheduler workers"""
+        workers = {}
+        lines = self.vapi.cli("show sw_scheduler workers").splitlines()
+        for line in lines[1:]:
+            f = line.split()
+            workers[int(f[0])] = {
+                "crypto": f[2],
+                "local": int(f[5]),
+                "stolen": int(f[6]),
+                "steals": int(f[7]),
+            }
+        return workers
+
+    def test_work_stealing(self):
+        """Idle worker steals crypto work"""
+        p = self.p_async
+        self.vapi.ipsec_set_async_mode(async_enable=True)
+
+        # worker 0 queues the frames but does no crypto of its own, so
+        # everything it enqueues has to be taken by worker 1
+        self.vapi.cli("set sw_scheduler worker 0 crypto off")
+        before = self.sw_scheduler_workers()
+
+        pkts = [
+            (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=self.pg1.remote_ip4, dst=p.remote_tun_if_host)
+                / UDP(sport=4444, dport=4444)
+                / Raw(i.to_bytes(2, "big") * 100)
+            )
+            for i in range(NUM_PKTS * 4)
+        ]
+
+        try:
+            rxs = self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        finally:
+            self.vapi.cli("set sw_scheduler worker 0 crypto on")
+
+        after = self.sw_scheduler_workers()
+        self.logger.info(self.vapi.cli("show sw_scheduler workers"))
+
+        self.assertEqual(after[0]["local"], before[0]["local"])
+        self.assertEqual(after[0]["stolen"], before[0]["stolen"])
+        self.assertGreater(after[1]["stolen"], before[1]["stolen"])
+        self.assertGreater(after[1]["steals"], before[1]["steals"])
+
+        # the owner returns stolen frames in order and nothing is lost or
+        # corrupted on the way
+        self.assertEqual(len(rxs), len(pkts))
+        for tx, rx in zip(pkts, rxs):
+            self.assertEqual(rx[ESP].spi, p.vpp_tun_spi)
+            decrypted = p.vpp_tun_sa.decrypt(rx[IP])
+            self.assertEqual(decrypted[Raw].load, tx[Raw].load)
+
+        self.vapi.ipsec_set_async_mode(async_enable=False)
+
     def test_sync_async_noop_stream(self):
         """Alternating SAs sync/async/noop"""
         p = self.params[self.p_sync.addr_type]
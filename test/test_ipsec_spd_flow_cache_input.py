@@ -3,7 +3,7 @@ import unittest
 
 from util import ppp
 from asfframework import VppTestRunner
-from template_ipsec import SpdFlowCacheTemplate
+from template_ipsec import SpdFlowCacheTemplate, SpdFlowCacheIPv6Template
 
 
 class SpdFlowCacheInbound(SpdFlowCacheTemplate):
@@ -15,6 +15,15 @@ class SpdFlowCacheInbound(SpdFlowCacheTemplate):
         cls.logger.info("VPP modified cmdline is %s" % " ".join(cls.vpp_cmdline))
 
 
+class SpdFlowCacheIPv6Inbound(SpdFlowCacheIPv6Template):
+    # Override setUpConstants to enable inbound flow cache in config
+    @classmethod
+    def setUpConstants(cls):
+        super(SpdFlowCacheIPv6Inbound, cls).setUpConstants()
+        cls.vpp_cmdline.extend(["ipsec", "{", "ipv6-inbound-spd-flow-cache on", "}"])
+        cls.logger.info("VPP modified cmdline is %s" % " ".join(cls.vpp_cmdline))
+
+
 class IPSec4SpdTestCaseBypass(SpdFlowCacheInbound):
     """ IPSec/IPv4 inbound: Policy mode test case with flow cache \
         (add bypass)"""
@@ -526,18 +535,15 @@ class IPSec4SpdTestCaseOverwriteStaleInbound(SpdFlowCacheInbound):
         (overwrite stale entries)"""
 
     def test_ipsec_spd_inbound_overwrite(self):
-        # The operation of the flow cache is setup so that the entire cache
-        # is invalidated when adding or removing an SPD policy rule.
-        # For performance, old cache entries are not zero'd, but remain
-        # in the table as "stale" entries. If a flow matches a stale entry,
-        # and the epoch count does NOT match the current count, the entry
-        # is overwritten.
+        # The operation of the flow cache is setup so that adding or
+        # removing an SPD policy rule only invalidates the entries that
+        # the change affects: the flows cached against a removed rule and
+        # the flows an added rule could match.
         # In this test, 3 active rules are created and matched to enter
         # them into the flow cache.
-        # A single entry is removed to invalidate the entire cache.
-        # We then readd the rule and test that overwriting of the previous
-        # stale entries occurs as expected, and that the flow cache entry
-        # counter is updated correctly.
+        # A single rule is removed and readded, which drops its entry only.
+        # We then resend the traffic and test that the entry is added back
+        # and that the flow cache entry counter is updated correctly.
         self.create_interfaces(3)
         pkt_count = 5
         # bind SPD to all interfaces
@@ -641,8 +647,8 @@ class IPSec4SpdTestCaseOverwriteStaleInbound(SpdFlowCacheInbound):
         # check inbound flow cache counter has not been reset
         self.verify_num_inbound_flow_cache_entries(3)
 
-        # remove + readd bypass policy - flow cache counter will be reset,
-        # and there will be 3x stale entries in flow cache
+        # remove + readd bypass policy - only the flow cached against it
+        # is dropped from the flow cache
         self.spd_add_rem_policy(  # inbound, priority 10
             1,
             self.pg1,
@@ -663,8 +669,8 @@ class IPSec4SpdTestCaseOverwriteStaleInbound(SpdFlowCacheInbound):
             priority=10,
             policy_type="bypass",
         )
-        # check counter was reset
-        self.verify_num_inbound_flow_cache_entries(0)
+        # check the other two entries were kept
+        self.verify_num_inbound_flow_cache_entries(2)
 
         # resend the same packets
         self.pg0.add_stream(packets0)
@@ -694,7 +700,7 @@ class IPSec4SpdTestCaseOverwriteStaleInbound(SpdFlowCacheInbound):
         self.verify_policy_match(pkt_count, policy_0)
         self.verify_policy_match(pkt_count * 2, policy_1)
         self.verify_policy_match(pkt_count * 2, policy_2)
-        # we are overwriting 3x stale entries - check flow cache counter
+        # the dropped entry was added back - check flow cache counter
         # is correct
         self.verify_num_inbound_flow_cache_entries(3)
 
@@ -861,5 +867,119 @@ class IPSec4SpdTestCaseCollisionInbound(SpdFlowCacheInbound):
         self.verify_num_inbound_flow_cache_entries(1)
 
 
+class IPSec6SpdTestCaseBypassInbound(SpdFlowCacheIPv6Inbound):
+    """ IPSec/IPv6 inbound: Policy mode test case with flow cache \
+        (add and remove bypass)"""
+
+    def test_ipsec6_spd_inbound_bypass(self):
+        # In this test case, packets in IPv6 FWD path are configured
+        # to go through IPSec inbound SPD policy lookup.
+        #
+        # 2 inbound SPD rules (1 HIGH and 1 LOW) are added.
+        # - High priority rule action is set to DISCARD.
+        # - Low priority rule action is set to BYPASS.
+        #
+        # Since BYPASS rules take precedence over DISCARD
+        # (the order being PROTECT, BYPASS, DISCARD) we expect the
+        # BYPASS rule to match, traffic to be correctly forwarded and
+        # the flow to be cached. Removing the BYPASS rule drops the
+        # flow from the cache and the traffic then matches DISCARD.
+        self.create_interfaces(2)
+        pkt_count = 5
+
+        self.spd_create_and_intf_add(1, [self.pg1, self.pg0])
+
+        policy_0 = self.spd_add_rem_policy(  # inbound, priority 10
+            1,
+            self.pg1,
+            self.pg0,
+            socket.IPPROTO_UDP,
+            is_out=0,
+            priority=10,
+            policy_type="bypass",
+            ip_range=True,
+            local_ip_start=self.pg1.remote_ip6,
+            local_ip_stop=self.pg1.remote_ip6,
+            remote_ip_start=self.pg0.remote_ip6,
+            remote_ip_stop=self.pg0.remote_ip6,
+        )
+        policy_1 = self.spd_add_rem_policy(  # inbound, priority 15
+            1,
+            self.pg1,
+            self.pg0,
+            socket.IPPROTO_UDP,
+            is_out=0,
+            priority=15,
+            policy_type="discard",
+            ip_range=True,
+            local_ip_start=self.pg1.remote_ip6,
+            local_ip_stop=self.pg1.remote_ip6,
+            remote_ip_start=self.pg0.remote_ip6,
+            remote_ip_stop=self.pg0.remote_ip6,
+        )
+
+        # create output rule so we can capture forwarded packets
+        policy_2 = self.spd_add_rem_policy(  # outbound, priority 10
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=10,
+            policy_type="bypass",
+        )
+
+        # check flow cache is empty before sending traffic
+        self.verify_num_inbound_flow_cache_entries(0)
+
+        # create the packet stream
+        packets = self.create_stream(
+            self.pg0, self.pg1, pkt_count, src_prt=500, dst_prt=500
+        )
+        self.pg0.add_stream(packets)
+        self.pg1.enable_capture()
+        self.pg_start()
+
+        # check capture on pg1
+        capture = self.pg1.get_capture(pkt_count)
+        self.verify_capture(self.pg0, self.pg1, capture)
+        self.verify_policy_match(pkt_count, policy_0)
+        self.verify_policy_match(0, policy_1)
+        self.verify_policy_match(pkt_count, policy_2)
+        # check the BYPASS match has been cached
+        self.verify_num_inbound_flow_cache_entries(1)
+
+        # remove the BYPASS rule - its flow is dropped from the cache
+        self.spd_add_rem_policy(  # inbound, priority 10
+            1,
+            self.pg1,
+            self.pg0,
+            socket.IPPROTO_UDP,
+            is_out=0,
+            priority=10,
+            policy_type="bypass",
+            ip_range=True,
+            local_ip_start=self.pg1.remote_ip6,
+            local_ip_stop=self.pg1.remote_ip6,
+            remote_ip_start=self.pg0.remote_ip6,
+            remote_ip_stop=self.pg0.remote_ip6,
+            remove=True,
+        )
+        self.verify_num_inbound_flow_cache_entries(0)
+
+        # resend the same packets - they now match the DISCARD rule
+        packets = self.create_stream(
+            self.pg0, self.pg1, pkt_count, src_prt=500, dst_prt=500
+        )
+        self.pg0.add_stream(packets)
+        self.pg1.enable_capture()
+        self.pg_start()
+
+        self.pg1.assert_nothing_captured()
+        self.verify_policy_match(pkt_count, policy_1)
+        self.verify_policy_match(pkt_count, policy_2)
+        self.verify_num_inbound_flow_cache_entries(1)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -3,7 +3,7 @@ import unittest
 
 from util import ppp
 from asfframework import VppTestRunner
-from template_ipsec import SpdFlowCacheTemplate
+from template_ipsec import SpdFlowCacheTemplate, SpdFlowCacheIPv6Template
 
 
 class SpdFlowCacheOutbound(SpdFlowCacheTemplate):
@@ -15,6 +15,15 @@ class SpdFlowCacheOutbound(SpdFlowCacheTemplate):
         cls.logger.info("VPP modified cmdline is %s" % " ".join(cls.vpp_cmdline))
 
 
+class SpdFlowCacheIPv6Outbound(SpdFlowCacheIPv6Template):
+    # Override setUpConstants to enable outbound flow cache in config
+    @classmethod
+    def setUpConstants(cls):
+        super(SpdFlowCacheIPv6Outbound, cls).setUpConstants()
+        cls.vpp_cmdline.extend(["ipsec", "{", "ipv6-outbound-spd-flow-cache on", "}"])
+        cls.logger.info("VPP modified cmdline is %s" % " ".join(cls.vpp_cmdline))
+
+
 class IPSec4SpdTestCaseAdd(SpdFlowCacheOutbound):
     """ IPSec/IPv4 outbound: Policy mode test case with flow cache \
         (add rule)"""
@@ -465,18 +474,15 @@ class IPSec4SpdTestCaseOverwriteStaleOutbound(SpdFlowCacheOutbound):
         (overwrite stale entries)"""
 
     def test_ipsec_spd_outbound_overwrite(self):
-        # The operation of the flow cache is setup so that the entire cache
-        # is invalidated when adding or removing an SPD policy rule.
-        # For performance, old cache entries are not zero'd, but remain
-        # in the table as "stale" entries. If a flow matches a stale entry,
-        # and the epoch count does NOT match the current count, the entry
-        # is overwritten.
+        # The operation of the flow cache is setup so that adding or
+        # removing an SPD policy rule only invalidates the entries that
+        # the change affects: the flows cached against a removed rule and
+        # the flows an added rule could match.
         # In this test, 3 active rules are created and matched to enter
         # them into the flow cache.
-        # A single entry is removed to invalidate the entire cache.
-        # We then readd the rule and test that overwriting of the previous
-        # stale entries occurs as expected, and that the flow cache entry
-        # counter is updated correctly.
+        # A single rule is removed and readded, which drops its entry only.
+        # We then resend the traffic and test that the entry is added back
+        # and that the flow cache entry counter is updated correctly.
         self.create_interfaces(3)
         pkt_count = 2
         # bind SPD to all interfaces
@@ -580,8 +586,8 @@ class IPSec4SpdTestCaseOverwriteStaleOutbound(SpdFlowCacheOutbound):
         # check flow cache counter has not been reset
         self.verify_num_outbound_flow_cache_entries(3)
 
-        # remove a bypass policy - flow cache counter will be reset, and
-        # there will be 3x stale entries in flow cache
+        # remove a bypass policy - only the flow cached against it is
+        # dropped from the flow cache
         self.spd_add_rem_policy(  # outbound
             1,
             self.pg0,
@@ -602,8 +608,8 @@ class IPSec4SpdTestCaseOverwriteStaleOutbound(SpdFlowCacheOutbound):
             priority=10,
             policy_type="bypass",
         )
-        # check counter was reset with flow cache invalidation
-        self.verify_num_outbound_flow_cache_entries(0)
+        # check the other two entries were kept
+        self.verify_num_outbound_flow_cache_entries(2)
 
         # resend the same packets
         self.pg0.add_stream(packets0)
@@ -633,7 +639,7 @@ class IPSec4SpdTestCaseOverwriteStaleOutbound(SpdFlowCacheOutbound):
         self.verify_policy_match(pkt_count, policy_0)
         self.verify_policy_match(pkt_count * 2, policy_1)
         self.verify_policy_match(pkt_count * 2, policy_2)
-        # we are overwriting 3x stale entries - check flow cache counter
+        # the dropped entry was added back - check flow cache counter
         # is correct
         self.verify_num_outbound_flow_cache_entries(3)
 
@@ -761,5 +767,95 @@ class IPSec4SpdTestCaseCollisionOutbound(SpdFlowCacheOutbound):
         self.verify_num_outbound_flow_cache_entries(1)
 
 
+class IPSec6SpdTestCaseRemoveOutbound(SpdFlowCacheIPv6Outbound):
+    """ IPSec/IPv6 outbound: Policy mode test case with flow cache \
+        (remove and readd rule)"""
+
+    def send_stream(self, pkt_count):
+        packets = self.create_stream(self.pg0, self.pg1, pkt_count)
+        self.pg0.add_stream(packets)
+        self.pg1.enable_capture()
+        self.pg_start()
+
+    def test_ipsec6_spd_outbound_remove(self):
+        # In this test case, packets in IPv6 FWD path are configured
+        # to go through IPSec outbound SPD policy lookup.
+        # 2 SPD rules (1 HIGH and 1 LOW) are added.
+        # High priority rule action is set to BYPASS.
+        # Low priority rule action is set to DISCARD.
+        # The high priority rule is removed and then readded, and each
+        # change must drop the flow that the rule affects from the cache.
+        self.create_interfaces(2)
+        pkt_count = 5
+        self.spd_create_and_intf_add(1, [self.pg1])
+        policy_0 = self.spd_add_rem_policy(  # outbound, priority 10
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=10,
+            policy_type="bypass",
+        )
+        policy_1 = self.spd_add_rem_policy(  # outbound, priority 5
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=5,
+            policy_type="discard",
+        )
+
+        # check flow cache is empty before sending traffic
+        self.verify_num_outbound_flow_cache_entries(0)
+
+        # traffic matches the BYPASS rule and is cached
+        self.send_stream(pkt_count)
+        capture = self.pg1.get_capture(pkt_count)
+        self.verify_capture(self.pg0, self.pg1, capture)
+        self.verify_policy_match(pkt_count, policy_0)
+        self.verify_policy_match(0, policy_1)
+        self.verify_num_outbound_flow_cache_entries(1)
+
+        # remove the BYPASS rule - its flow is dropped from the cache
+        self.spd_add_rem_policy(  # outbound, priority 10
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=10,
+            policy_type="bypass",
+            remove=True,
+        )
+        self.verify_num_outbound_flow_cache_entries(0)
+
+        # traffic now matches the DISCARD rule
+        self.send_stream(pkt_count)
+        self.pg1.assert_nothing_captured()
+        self.verify_policy_match(pkt_count, policy_1)
+        self.verify_num_outbound_flow_cache_entries(1)
+
+        # readd the BYPASS rule - the cached DISCARD flow is dropped
+        policy_0 = self.spd_add_rem_policy(  # outbound, priority 10
+            1,
+            self.pg0,
+            self.pg1,
+            socket.IPPROTO_UDP,
+            is_out=1,
+            priority=10,
+            policy_type="bypass",
+        )
+        self.verify_num_outbound_flow_cache_entries(0)
+
+        # traffic matches the BYPASS rule again
+        self.send_stream(pkt_count)
+        self.pg1.get_capture(pkt_count)
+        self.verify_policy_match(pkt_count, policy_0)
+        self.verify_policy_match(pkt_count, policy_1)
+        self.verify_num_outbound_flow_cache_entries(1)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -1009,6 +1009,120 @@ class TestIpsec4MultiTunIfEsp(TemplateIpsec4TunProtect, TemplateIpsec, IpsecTun4
             self.verify_encrypted(p, p.vpp_tun_sa, [rx])
 
 
+class TestIpsec4MultiAlgTunIfEsp(TemplateIpsec4TunProtect, TemplateIpsec, IpsecTun4):
+    """IPsec IPv4 Multi Tunnel interface with mixed algorithms"""
+
+    encryption_type = ESP
+    tun4_encrypt_node_name = "esp4-encrypt-tun"
+    tun4_decrypt_node_name = ["esp4-decrypt-tun", "esp4-decrypt-tun-post"]
+
+    algos = [
+        (
+            VppEnum.vl_api_ipsec_crypto_alg_t.IPSEC_API_CRYPTO_ALG_AES_GCM_128,
+            VppEnum.vl_api_ipsec_integ_alg_t.IPSEC_API_INTEG_ALG_NONE,
+            "AES-GCM",
+            "NULL",
+            b"JPjyOWBeVEQiMe7h",
+        ),
+        (
+            VppEnum.vl_api_ipsec_crypto_alg_t.IPSEC_API_CRYPTO_ALG_AES_CBC_128,
+            VppEnum.vl_api_ipsec_integ_alg_t.IPSEC_API_INTEG_ALG_SHA1_96,
+            "AES-CBC",
+            "HMAC-SHA1-96",
+            b"JPjyOWBeVEQiMe7h",
+        ),
+        (
+            VppEnum.vl_api_ipsec_crypto_alg_t.IPSEC_API_CRYPTO_ALG_AES_GCM_256,
+            VppEnum.vl_api_ipsec_integ_alg_t.IPSEC_API_INTEG_ALG_NONE,
+            "AES-GCM",
+            "NULL",
+            b"JPjyOWBeVEQiMe7hJPjyOWBeVEQiMe7h",
+        ),
+        (
+            VppEnum.vl_api_ipsec_crypto_alg_t.IPSEC_API_CRYPTO_ALG_AES_CBC_256,
+            VppEnum.vl_api_ipsec_integ_alg_t.IPSEC_API_INTEG_ALG_SHA_256_128,
+            "AES-CBC",
+            "SHA2-256-128",
+            b"JPjyOWBeVEQiMe7hJPjyOWBeVEQiMe7h",
+        ),
+    ]
+
+    def setUp(self):
+        super(TestIpsec4MultiAlgTunIfEsp, self).setUp()
+
+        self.tun_if = self.pg0
+
+        self.multi_params = []
+        self.pg0.generate_remote_hosts(len(self.algos))
+        self.pg0.configure_ipv4_neighbors()
+
+        for ii, algo in enumerate(self.algos):
+            p = copy.copy(self.ipv4_params)
+
+            (
+                p.crypt_algo_vpp_id,
+                p.auth_algo_vpp_id,
+                p.crypt_algo,
+                p.auth_algo,
+                p.crypt_key,
+            ) = algo
+            p.salt = 0
+
+            p.remote_tun_if_host = "1.1.1.%d" % (ii + 1)
+            p.scapy_tun_sa_id = p.scapy_tun_sa_id + ii
+            p.scapy_tun_spi = p.scapy_tun_spi + ii
+            p.vpp_tun_sa_id = p.vpp_tun_sa_id + ii
+            p.vpp_tun_spi = p.vpp_tun_spi + ii
+            p.tun_dst = self.pg0.remote_hosts[ii].ip4
+
+            self.multi_params.append(p)
+            self.config_network(p)
+            self.config_sa_tra(p)
+            self.config_protect(p)
+
+    def tearDown(self):
+        super(TestIpsec4MultiAlgTunIfEsp, self).tearDown()
+
+    def test_tun_rr_44(self):
+        """Round-robin packets across tunnels of different algorithms"""
+        # each frame carries the ops of every algorithm interleaved, which
+        # the ESP nodes regroup by op type before calling the engine
+        n_pkts = 31
+
+        for engine in ["ia32", "ipsecmb", "openssl"]:
+            self.vapi.cli("set crypto handler all %s" % engine)
+
+            tx = []
+            for ii in range(n_pkts):
+                for p in self.multi_params:
+                    tx += self.gen_encrypt_pkts(
+                        p,
+                        p.scapy_tun_sa,
+                        self.tun_if,
+                        src=p.remote_tun_if_host,
+                        dst=self.pg1.remote_ip4,
+                        count=1,
+                    )
+            rxs = self.send_and_expect(self.tun_if, tx, self.pg1)
+
+            for rx, p in zip(rxs, self.multi_params * n_pkts):
+                self.verify_decrypted(p, [rx])
+
+            tx = []
+            for ii in range(n_pkts):
+                for p in self.multi_params:
+                    tx += self.gen_pkts(
+                        self.pg1,
+                        src=self.pg1.remote_ip4,
+                        dst=p.remote_tun_if_host,
+                        count=1,
+                    )
+            rxs = self.send_and_expect(self.pg1, tx, self.tun_if)
+
+            for rx, p in zip(rxs, self.multi_params * n_pkts):
+                self.verify_encrypted(p, p.vpp_tun_sa, [rx])
+
+
 class TestIpsec4TunIfEspAll(TemplateIpsec4TunProtect, TemplateIpsec, IpsecTun4):
     """IPsec IPv4 Tunnel interface all Algos"""
 
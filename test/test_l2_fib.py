@@ -487,6 +487,31 @@ class TestL2fib(VppTestCase):
         self.run_verify_negat_test(bd1, hosts, lhosts)
         self.run_verify_negat_test(bd2, hosts, lhosts)
 
+    def test_l2_fib_learn_repeated(self):
+        """L2 FIB - learn MACs seen several times in a frame"""
+        bd1 = 1
+        hosts = self.create_hosts(10, subnet=45)
+        ifs = [self.pg_interfaces[i] for i in self.bd_ifs(bd1)]
+        n_hosts = sum(len(hosts[i.sw_if_index]) for i in ifs)
+        misses = "/err/l2-learn/L2 learn misses"
+        n_misses = self.statistics.get_err_counter(misses)
+
+        # every mac 3 times in the same frame is learned once
+        self.vapi.bridge_flags(bd_id=bd1, is_set=1, flags=1)
+        for pg_if in ifs:
+            pg_if.add_stream(
+                [
+                    Ether(dst="ff:ff:ff:ff:ff:ff", src=host.mac)
+                    for _ in range(3)
+                    for host in hosts[pg_if.sw_if_index]
+                ]
+            )
+        self.pg_start()
+
+        self.assertEqual(self.statistics.get_err_counter(misses) - n_misses, n_hosts)
+        self.assertIn("L2 learn updates:", self.vapi.cli("show l2fib"))
+        self.run_verify_test(bd1, hosts, hosts)
+
     def test_l2_fib_mac_learn_evs(self):
         """L2 FIB - mac learning events"""
         bd1 = 1
@@ -608,5 +633,43 @@ class TestL2fib(VppTestCase):
         self.assertEqual(len(learned_macs ^ macs), 0)
 
 
+class TestL2fibWorkers(TestL2fib):
+    """L2 FIB Test Case with workers"""
+
+    vpp_worker_count = 2
+
+    def test_l2_fib_learn_workers(self):
+        """L2 FIB - learns staged by workers are added by the main thread"""
+        bd1 = 1
+        hosts = self.create_hosts(10, subnet=46)
+        ifs = [self.pg_interfaces[i] for i in self.bd_ifs(bd1)]
+        n_hosts = sum(len(hosts[i.sw_if_index]) for i in ifs)
+        misses = "/err/l2-learn/L2 learn misses"
+        handoffs = "/err/l2-learn/L2 learns handed to the writer"
+        n_misses = self.statistics.get_err_counter(misses)
+        n_handoffs = self.statistics.get_err_counter(handoffs)
+
+        # both workers learn at once, each mac twice
+        self.vapi.bridge_flags(bd_id=bd1, is_set=1, flags=1)
+        for i, pg_if in enumerate(ifs):
+            pg_if.add_stream(
+                [
+                    Ether(dst="ff:ff:ff:ff:ff:ff", src=host.mac)
+                    for host in hosts[pg_if.sw_if_index]
+                ],
+                nb_replays=2,
+                worker=i % 2,
+            )
+        self.pg_start()
+
+        # every mac is learned once and added by the single writer
+        self.assertIn("L2 learns added by the main thread", self.vapi.cli("show l2fib"))
+        self.assertEqual(self.statistics.get_err_counter(misses) - n_misses, n_hosts)
+        self.assertEqual(
+            self.statistics.get_err_counter(handoffs) - n_handoffs, n_hosts
+        )
+        self.run_verify_test(bd1, hosts, hosts)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
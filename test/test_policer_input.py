@@ -9,6 +9,7 @@ from framework import VppTestCase
 from asfframework import VppTestRunner
 from vpp_papi import VppEnum
 from vpp_policer import VppPolicer, PolicerAction, Dir
+from vpp_papi_provider import CliFailedCommandError
 
 NUM_PKTS = 67
 
@@ -259,6 +260,137 @@ class TestPolicerInput(VppTestCase):
         """Worker thread handoff policer output"""
         self.policer_handoff_test(Dir.TX)
 
+    def policer_distributed_test(self, dir: Dir):
+        pkts = self.pkt * NUM_PKTS
+
+        action_tx = PolicerAction(
+            VppEnum.vl_api_sse2_qos_action_type_t.SSE2_QOS_ACTION_API_TRANSMIT, 0
+        )
+        policer = VppPolicer(
+            self,
+            "pol3",
+            80,
+            0,
+            1000,
+            0,
+            conform_action=action_tx,
+            exceed_action=action_tx,
+            violate_action=action_tx,
+        )
+        policer.add_vpp_config()
+
+        sw_if_index = self.pg0.sw_if_index if dir == Dir.RX else self.pg1.sw_if_index
+
+        # A policer bound to a worker can't be distributed
+        policer.bind_vpp_config(1, True)
+        with self.vapi.assert_negative_api_retval():
+            policer.distribute_vpp_config(True)
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("policer distribute name pol3")
+        self.assertNotIn("distributed", self.vapi.cli("show policer name pol3"))
+
+        policer.bind_vpp_config(1, False)
+        policer.distribute_vpp_config(True)
+
+        # Start policing on pg0
+        policer.apply_vpp_config(sw_if_index, dir, True)
+
+        for worker in [0, 1]:
+            self.send_and_expect(self.pg0, pkts, self.pg1, worker=worker)
+            self.logger.debug(self.vapi.cli("show trace max 100"))
+
+        stats = policer.get_stats()
+        stats0 = policer.get_stats(worker=0)
+        stats1 = policer.get_stats(worker=1)
+
+        # Both workers police their own packets, nothing is handed off
+        for s in [stats0, stats1]:
+            self.assertGreater(s["conform_packets"], 0)
+            self.assertEqual(s["exceed_packets"], 0)
+            self.assertGreater(s["violate_packets"], 0)
+            self.assertEqual(s["conform_packets"] + s["violate_packets"], NUM_PKTS)
+
+        self.assertEqual(
+            stats0["conform_packets"] + stats1["conform_packets"],
+            stats["conform_packets"],
+        )
+        self.assertEqual(
+            stats0["violate_packets"] + stats1["violate_packets"],
+            stats["violate_packets"],
+        )
+
+        # The shared bucket still bounds what the workers admit together
+        self.assertLess(stats["conform_packets"], NUM_PKTS)
+
+        self.assertIn("distributed", self.vapi.cli("show policer name pol3"))
+
+        # Return to single thread policing
+        policer.distribute_vpp_config(False)
+        self.assertNotIn("distributed", self.vapi.cli("show policer name pol3"))
+
+        # Stop policing on pg0
+        policer.apply_vpp_config(sw_if_index, dir, False)
+
+        policer.remove_vpp_config()
+
+    def test_policer_distributed_input(self):
+        """Distributed multi-worker policer input"""
+        self.policer_distributed_test(Dir.RX)
+
+    def test_policer_distributed_output(self):
+        """Distributed multi-worker policer output"""
+        self.policer_distributed_test(Dir.TX)
+
+    def test_policer_distributed_3color(self):
+        """Distributed multi-worker three colour policer"""
+        pkts = self.pkt * NUM_PKTS
+
+        action_tx = PolicerAction(
+            VppEnum.vl_api_sse2_qos_action_type_t.SSE2_QOS_ACTION_API_TRANSMIT, 0
+        )
+        policer = VppPolicer(
+            self,
+            "pol4",
+            80,
+            0,
+            1000,
+            1000,
+            type=VppEnum.vl_api_sse2_qos_policer_type_t.SSE2_QOS_POLICER_TYPE_API_1R3C_RFC_2697,
+            conform_action=action_tx,
+            exceed_action=action_tx,
+            violate_action=action_tx,
+        )
+        policer.add_vpp_config()
+        policer.distribute_vpp_config(True)
+        policer.apply_vpp_config(self.pg0.sw_if_index, Dir.RX, True)
+
+        for worker in [0, 1]:
+            self.send_and_expect(self.pg0, pkts, self.pg1, worker=worker)
+
+        stats = policer.get_stats()
+        per_worker = [policer.get_stats(worker=w) for w in [0, 1]]
+
+        # Every packet is coloured exactly once, on the worker it arrived on
+        for s in per_worker:
+            self.assertEqual(
+                s["conform_packets"] + s["exceed_packets"] + s["violate_packets"],
+                NUM_PKTS,
+            )
+        for colour in ["conform_packets", "exceed_packets", "violate_packets"]:
+            self.assertEqual(sum(s[colour] for s in per_worker), stats[colour])
+
+        # The committed burst is drained before the excess burst is used and
+        # both buckets are shared, so together the workers admit at most
+        # about one of each plus the credit they each hold
+        self.assertGreater(stats["conform_packets"], 0)
+        self.assertGreater(stats["exceed_packets"], 0)
+        self.assertGreater(stats["violate_packets"], 0)
+        self.assertLess(stats["conform_packets"] + stats["exceed_packets"], NUM_PKTS)
+
+        policer.apply_vpp_config(self.pg0.sw_if_index, Dir.RX, False)
+        policer.distribute_vpp_config(False)
+        policer.remove_vpp_config()
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -2718,6 +2718,54 @@ class TestWg(VppTestCase):
         """Large packet (v6, async)"""
         self._test_wg_large_packet_tmpl(is_async=True, is_ip6=True)
 
+    def test_wg_replay_window(self):
+        """Shared receive window matches the single worker one"""
+        reply = self.vapi.cli("test wireguard replay-window packets 65536 threads 4")
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+
+    def wg_handshake_stat(self, name):
+        reply = self.vapi.cli("show wireguard handshake")
+        for line in reply.splitlines():
+            if line.strip().startswith(name + ":"):
+                return int(line.split(":")[1].split()[0])
+        self.fail(f"no {name} in {reply}")
+
+    def test_wg_handshake_queue(self):
+        """Handshakes are processed from the handshake queue"""
+        port = 12323
+
+        wg0 = VppWgInterface(self, self.pg1.local_ip4, port).add_vpp_config()
+        wg0.admin_up()
+        wg0.config_ip4()
+
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        peer_1 = VppWgPeer(
+            self, wg0, self.pg1.remote_ip4, port + 1, ["10.11.3.0/24"]
+        ).add_vpp_config()
+
+        # wait for the peer to send a handshake
+        rx = self.pg1.get_capture(1, timeout=2)
+        resp = peer_1.consume_init(rx[0], self.pg1)
+
+        processed = self.wg_handshake_stat("processed")
+        full = self.wg_handshake_stat("dropped, queue full")
+
+        # the response goes through the queue, the keepalive comes back
+        rxs = self.send_and_expect(self.pg1, [resp], self.pg1)
+        for rx in rxs:
+            self.assertEqual(0, len(peer_1.decrypt_transport(rx)))
+
+        self.assertEqual(processed + 1, self.wg_handshake_stat("processed"))
+        self.assertEqual(full, self.wg_handshake_stat("dropped, queue full"))
+        self.assertEqual(0, self.wg_handshake_stat("depth"))
+        self.logger.info(self.vapi.cli("show wireguard handshake"))
+
+        peer_1.remove_vpp_config()
+        wg0.remove_vpp_config()
+
     def test_wg_lack_of_buf_headroom(self):
         """Lack of buffer's headroom (v6 vxlan over v6 wg)"""
         port = 12323
@@ -2808,7 +2856,22 @@ class WireguardHandoffTests(TestWg):
 
     def test_wg_peer_init(self):
         """Handoff"""
+        self._test_wg_handoff_tmpl()
+
+    def test_wg_multi_worker(self):
+        """Multi-worker, no handoff"""
+        self.vapi.wg_set_multi_worker_mode(multi_worker_enable=True)
+        self.vapi.cli("clear runtime")
+
+        self._test_wg_handoff_tmpl()
+
+        # the data packets were processed on the workers they came in on
+        runtime = self.vapi.cli("show runtime")
+        self.assertNotIn("wg4-input-data-handoff", runtime)
+        self.assertNotIn("wg4-output-tun-handoff", runtime)
+        self.vapi.wg_set_multi_worker_mode(multi_worker_enable=False)
 
+    def _test_wg_handoff_tmpl(self):
         port = 12383
 
         # Create interfaces
@@ -2839,7 +2902,8 @@ class WireguardHandoffTests(TestWg):
         peer_1.consume_response(rx[0])
 
         # send a data packet from the peer through the tunnel
-        # this completes the handshake and pins the peer to worker 0
+        # this completes the handshake and, unless in multi-worker mode,
+        # pins the peer to worker 0
         p = (
             IP(src="10.11.3.1", dst=self.pg0.remote_ip4, ttl=20)
             / UDP(sport=222, dport=223)